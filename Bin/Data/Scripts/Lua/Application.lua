@@ -81,6 +81,95 @@ Application = {
 			end
 		end
 
+		--@brief
+		--  Returns whether or not the application runs within the benchmark mode
+		--
+		--@return
+		--  'true' if the application runs within the benchmark mode (plays a camcorder record at a fixed simulated frame rate and exits), else 'false'
+		function this.IsBenchmarkMode()
+			-- The "IsBenchmarkMode()"-method is implemented within the dungeon executable
+			if cppApplication.IsBenchmarkMode ~= nil then
+				return cppApplication:IsBenchmarkMode()
+			else
+				return false
+			end
+		end
+
+		--@brief
+		--  Returns the name of the camcorder record played within the benchmark mode
+		--
+		--@return
+		--  The name of the camcorder record played within the benchmark mode, empty string if not within the benchmark mode
+		function this.GetBenchmarkRecord()
+			-- The "GetBenchmarkRecord()"-method is implemented within the dungeon executable
+			if cppApplication.GetBenchmarkRecord ~= nil then
+				return cppApplication:GetBenchmarkRecord()
+			else
+				return ""
+			end
+		end
+
+		--@brief
+		--  Returns the physics statistics of the loaded scene
+		--
+		--@return
+		--  The physics statistics of the loaded scene as string of attribute values (e.g. 'Bodies="245" Awake="12" Sleeping="231" PhysicsThreads="0" StepTime="0.412"'), empty string if not available. The step time is only measured with the 'PhysicsThread' configuration disabled, otherwise it's 'n/a (requires PhysicsThread=false)'.
+		function this.GetPhysicsStatistics()
+			-- The "GetPhysicsStatistics()"-method is implemented within the dungeon executable
+			if cppApplication.GetPhysicsStatistics ~= nil then
+				return cppApplication:GetPhysicsStatistics()
+			else
+				return ""
+			end
+		end
+
+		--@brief
+		--  Returns the portal and occlusion culling counters of the last frame
+		--
+		--@return
+		--  The counters as string of attribute values (e.g. 'Cells="3" Portals="4" Tested="412" Visible="128" PVS="0" Occluders="6" ...'), empty string if not available
+		function this.GetCullingStatistics()
+			-- The "GetCullingStatistics()"-method is implemented within the dungeon executable
+			if cppApplication.GetCullingStatistics ~= nil then
+				return cppApplication:GetCullingStatistics()
+			else
+				return ""
+			end
+		end
+
+		--@brief
+		--  Returns the render queue and instance batching counters of the last frame
+		--
+		--@return
+		--  The counters as string of attribute values (e.g. 'Items="420" Materials="64" Meshes="180" SceneMaterialChanges="310" ...'), empty string if not available
+		function this.GetRenderQueueStatistics()
+			-- The "GetRenderQueueStatistics()"-method is implemented within the dungeon executable
+			if cppApplication.GetRenderQueueStatistics ~= nil then
+				return cppApplication:GetRenderQueueStatistics()
+			else
+				return ""
+			end
+		end
+
+		--@brief
+		--  Returns the nearest physics body hit by a ray
+		--
+		--@param[in] origin
+		--  Ray origin within the physics world space as string (e.g. "0 1 0")
+		--@param[in] direction
+		--  Ray direction within the physics world space as string (e.g. "0 0 1")
+		--
+		--@return
+		--  The hit as string of attribute values (e.g. 'Node="Scene.Container.Cell0.Barrel" Distance="4.250" Position="0.000 1.000 4.250"'), empty string if nothing was hit or not available
+		function this.RayQuery(origin, direction)
+			-- The "RayQuery()"-method is implemented within the dungeon executable
+			if cppApplication.RayQuery ~= nil then
+				return cppApplication:RayQuery(origin, direction)
+			else
+				return ""
+			end
+		end
+
 		--@brief
 		--  Returns whether or not this is an internal release
 		--
@@ -130,7 +219,6 @@ Application = {
 		--[ Private class attributes                              ]
 		--[-------------------------------------------------------]
 		local _interaction 	= Interaction.new(cppApplication, this)	-- An instance of the interaction script component class
-		local _loadProgress = 0										-- Current load progress (0.0-1.0)
 
 
 		--[-------------------------------------------------------]
@@ -250,21 +338,6 @@ Application = {
 			end
 		end
 
-		--@brief
-		--  Called on load progress
-		--
-		--@param[in] progress
-		--  Load progress (0.0-1.0)
-		function this.OnLoadProgress(progress)
-			-- Time for an update? (we don't want to redraw & ping the frontend each time a single tiny scene node was loaded *performance*)
-			if (progress - _loadProgress) >= 0.01 then
-				_loadProgress = progress;
-
-				-- Redraw & ping the frontend
-				cppApplication:GetFrontend():RedrawAndPing()
-			end
-		end
-
 		--@brief
 		--  Slot function is called by C++ after a scene has been loaded
 		function this.OnSceneLoadingFinished()
@@ -352,9 +425,6 @@ Application = {
 		-- Use the script function "OnSceneLoadingFinished" as slot and connect it with the RTTI "SignalSceneLoadingFinished"-signal of our RTTI application class instance
 		cppApplication.SignalSceneLoadingFinished.Connect(this.OnSceneLoadingFinished)
 
-		-- Use the script function "OnLoadProgress" as slot and connect it with the RTTI "SignalLoadProgress"-signal of our RTTI scene container class instance
-		cppApplication:GetScene().SignalLoadProgress.Connect(this.OnLoadProgress)
-
 
 		-- Return the created class instance
 		return this
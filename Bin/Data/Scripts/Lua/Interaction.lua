@@ -266,7 +266,10 @@ Interaction = {
 					if _mode == Interaction.Mode.MOVIE then
 						-- Start the playback
 						if camcorder ~= nil then
-							if luaApplication.IsInternalRelease() then
+							if luaApplication.IsBenchmarkMode() then
+								-- Play the camcorder record given by the benchmark mode
+								camcorder:StartPlayback(luaApplication.GetBenchmarkRecord())
+							elseif luaApplication.IsInternalRelease() then
 								-- Just a short movie for the internal release - else we would have to wait to long to test the demo
 								camcorder:StartPlayback("ShortMovie")
 							else
@@ -290,36 +293,67 @@ Interaction = {
 		end
 
 		--@brief
-		--  Slot function is called by C++ after a scene has been loaded
-		function this.OnSceneLoadingFinished()
-			-- Get the input controller of the application
-			local inputController = cppApplication:GetInputController()
-			if inputController ~= nil then
-				-- Use the script function "OnControl" as slot and connect it with the RTTI "SignalOnControl"-signal of our RTTI controller class instance
-				inputController.SignalOnControl.Connect(this.OnControl)
-			end
-
+		--  Gets the references to the camera scene nodes which are not referenced yet
+		local function GetCameraSceneNodes()
 			-- Get the scene container
 			local scene = cppApplication:GetScene()
 			if scene ~= nil then
 				-- Get references to important scene nodes - because they move through the scene, they may
 				-- change their scene container and therefore change their name....
+				-- When the scene is loaded progressively, the cell a camera is in may not have been loaded yet
 
 				-- Walk camera scene node
-				_walkCameraSceneNode = scene:GetByName("Container.kanal3.WalkCamera")
+				if _walkCameraSceneNode == nil then
+					_walkCameraSceneNode = scene:GetByName("Container.kanal3.WalkCamera")
+				end
 
 				-- Free camera scene node
-				_freeCameraSceneNode = scene:GetByName("Container.kanal3.FreeCamera")
+				if _freeCameraSceneNode == nil then
+					_freeCameraSceneNode = scene:GetByName("Container.kanal3.FreeCamera")
+				end
 
 				-- Ghost camera scene node
-				_ghostCameraSceneNode = scene:GetByName("Container.kanal3.GhostCamera")
+				if _ghostCameraSceneNode == nil then
+					_ghostCameraSceneNode = scene:GetByName("Container.kanal3.GhostCamera")
+				end
 
 				-- Making of camera scene node
-				_makingOfCameraSceneNode = scene:GetByName("Container.WineCellar.MakingOfCamera")
+				if _makingOfCameraSceneNode == nil then
+					_makingOfCameraSceneNode = scene:GetByName("Container.WineCellar.MakingOfCamera")
+				end
+			end
+		end
+
+		--@brief
+		--  Slot function is called by C++ after a stage of the progressive scene loading has been finished
+		--@param[in] numOfFinishedStages
+		--  Number of finished stages
+		--@param[in] numOfStages
+		--  Total number of stages
+		function this.OnSceneLoadingStageFinished(numOfFinishedStages, numOfStages)
+			-- Get references to the camera scene nodes within the cells which have just been loaded
+			GetCameraSceneNodes()
+		end
+
+		--@brief
+		--  Slot function is called by C++ after a scene has been loaded
+		function this.OnSceneLoadingFinished()
+			-- Get the input controller of the application
+			local inputController = cppApplication:GetInputController()
+			if inputController ~= nil then
+				-- Use the script function "OnControl" as slot and connect it with the RTTI "SignalOnControl"-signal of our RTTI controller class instance
+				inputController.SignalOnControl.Connect(this.OnControl)
 			end
 
-			-- The offical release should always start with the movie mode
-			if luaApplication.IsInternalRelease() then
+			-- Get references to important scene nodes, forget the ones of the previous scene
+			_walkCameraSceneNode		= nil
+			_freeCameraSceneNode		= nil
+			_ghostCameraSceneNode		= nil
+			_makingOfCameraSceneNode	= nil
+			GetCameraSceneNodes()
+
+			-- The offical release and the benchmark mode should always start with the movie mode
+			if luaApplication.IsInternalRelease() and not luaApplication.IsBenchmarkMode() then
 				-- Internal release
 				this.OnSetMode(Interaction.Mode.WALK, false)
 			else
@@ -331,6 +365,12 @@ Interaction = {
 		--@brief
 		--  Slot function is called by C++ when the camcorder playback has been finished
 		function this.OnMoviePlaybackFinished()
+			-- Within the benchmark mode, we're done as soon as the camcorder record has been played
+			if luaApplication.IsBenchmarkMode() then
+				cppApplication:FinishBenchmark()
+				return
+			end
+
 			-- Change into the making of mode
 			this.OnSetMode(Interaction.Mode.MAKINGOF, true)
 		end
@@ -509,6 +549,11 @@ Interaction = {
 		-- Use the script function "OnSceneLoadingFinished" as slot and connect it with the RTTI "SignalSceneLoadingFinished"-signal of our RTTI application class instance
 		cppApplication.SignalSceneLoadingFinished.Connect(this.OnSceneLoadingFinished)
 
+		-- Use the script function "OnSceneLoadingStageFinished" as slot and connect it with the RTTI "SignalSceneLoadingStageFinished"-signal of our RTTI application class instance
+		if cppApplication.SignalSceneLoadingStageFinished ~= nil then	-- Signal is implemented in the dungeon executable
+			cppApplication.SignalSceneLoadingStageFinished.Connect(this.OnSceneLoadingStageFinished)
+		end
+
 		-- Use the script function "OnSetMode" as slot and connect it with the RTTI "SignalSetMode"-signal of our RTTI application class instance
 		if cppApplication.SignalSetMode ~= nil then	-- Signal is implemented in the dungeon executable
 			cppApplication.SignalSetMode.Connect(this.OnSetMode)
@@ -48,6 +48,27 @@ application = nil	-- An instance of the application script component class
 --[-------------------------------------------------------]
 --[ Global functions                                      ]
 --[-------------------------------------------------------]
+--@brief
+--  Opens a startup trace scope
+--
+--@param[in] name
+--  Scope name
+function TraceBegin(name)
+	-- The "TraceBegin()"-method is implemented within the dungeon executable
+	if this.TraceBegin ~= nil then
+		this:TraceBegin(name)
+	end
+end
+
+--@brief
+--  Closes the startup trace scope which was opened last by using "TraceBegin()"
+function TraceEnd()
+	-- The "TraceEnd()"-method is implemented within the dungeon executable
+	if this.TraceEnd ~= nil then
+		this:TraceEnd()
+	end
+end
+
 --@brief
 --  Called by C++ when the application should initialize itself
 function OnInit()
@@ -60,10 +81,14 @@ function OnInit()
 	-- Scan our project directory for compatible plugins and load them in
 	-- -> This might not always be required, but in case this script was thrown into PLViewer this application has to know about the new plugins
 	-- -> Base directory is "C:/Programs/MyApplication/", for x86 the plugins are in this case within "C:/Programs/MyApplication/x86/"
+	TraceBegin("ScanPlugins")
 	PL.ClassManager.ScanPlugins(this:GetBaseDirectory() .. PL.System.GetPlatformArchitecture(), false, true)
+	TraceEnd()
 
 	-- Create an instance of the application script component class
+	TraceBegin("Application.new")
 	application = Application.new(this)
+	TraceEnd()
 
 	-- Load scene
 	this:LoadScene("Data/Scenes/Dungeon.scene")
@@ -23,14 +23,23 @@
 //[-------------------------------------------------------]
 //[ Includes                                              ]
 //[-------------------------------------------------------]
+#include <PLCore/Log/Log.h>
+#include <PLCore/File/Url.h>
+#include <PLCore/File/File.h>
 #include <PLCore/Base/Class.h>
 #include <PLCore/Script/Script.h>
+#include <PLCore/Script/FuncScriptPtr.h>
 #include <PLCore/System/System.h>
 #include <PLCore/Tools/Timing.h>
 #include <PLCore/Tools/Localization.h>
+#include <PLCore/Tools/LoadableManager.h>
 #include <PLRenderer/RendererContext.h>
+#include <PLRenderer/Texture/TextureManager.h>
 #include <PLRenderer/Material/MaterialManager.h>
 #include <PLRenderer/Material/ParameterManager.h>
+#include <PLMesh/MeshManager.h>
+#include <PLInput/Input/Controls/Button.h>
+#include <PLInput/Input/Virtual/VirtualController.h>
 #include <PLScene/Compositing/SceneRenderer.h>
 #include <PLScene/Scene/SPScene.h>
 #include <PLScene/Scene/SceneContext.h>
@@ -38,6 +47,28 @@
 #include <PLScene/Scene/SceneNodeModifier.h>
 #include <PLEngine/Compositing/Console/SNConsoleBase.h>
 #include <PLEngine/Controller/SNPhysicsMouseInteraction.h>
+#include "Tools/Trace.h"
+#include "Tools/Benchmark.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Loading/BinaryScene.h"
+#include "Loading/ScenePreloader.h"
+#include "Loading/ProgressiveSceneLoader.h"
+#include "Loading/LoadScreenPresenter.h"
+#include "Scene/CellResidencyManager.h"
+#include "Scene/RayQueryService.h"
+#include "Scene/SpatialIndex.h"
+#include "Scene/PortalCuller.h"
+#include "Scene/PotentiallyVisibleSet.h"
+#include "Scene/OcclusionCuller.h"
+#include "Scene/RenderQueue.h"
+#include "Scene/InstanceBatcher.h"
+#include "Physics/PhysicsCacheSources.h"
+#include "Physics/PhysicsCacheArchive.h"
+#include "Physics/PhysicsBodySleep.h"
+#include "Physics/ConvexHullSimplifier.h"
+#include "Physics/PhysicsStatistics.h"
+#include "Physics/StaticCollisionMerger.h"
+#include "SNMCharacterMover.h"
 #include "Application.h"
 
 
@@ -58,6 +89,12 @@ using namespace PLPhysics;
 pl_implement_class(Application)
 
 
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float BenchmarkFramesPerSecond = 24.0f;	/**< Simulated frames per second within the benchmark mode, matches the frames per second of the camcorder records */
+
+
 //[-------------------------------------------------------]
 //[ Public functions                                      ]
 //[-------------------------------------------------------]
@@ -66,7 +103,24 @@ pl_implement_class(Application)
 *    Constructor
 */
 Application::Application(Frontend &cFrontend) : ScriptApplication(cFrontend, "Data/Scripts/Lua/Main.lua", "Dungeon", PLT("PixelLight dungeon demo"), System::GetInstance()->GetDataDirName("PixelLight")),
-	m_fMousePickingPullAnimation(0.0f)
+	SlotOnBenchmarkUpdateBegin(this),
+	SlotOnBenchmarkPhysicsBegin(this),
+	SlotOnBenchmarkPhysicsEnd(this),
+	m_fMousePickingPullAnimation(0.0f),
+	m_pBenchmark(nullptr),
+	m_nPhysicsStepStartTime(0),
+	m_fPhysicsStepTime(0.0f),
+	m_bPhysicsStepMeasured(false),
+	m_pPhysicsStatistics(nullptr),
+	m_pRayQueryService(nullptr),
+	m_pSpatialIndex(nullptr),
+	m_pPortalCuller(nullptr),
+	m_pOcclusionCuller(nullptr),
+	m_pRenderQueue(nullptr),
+	m_pInstanceBatcher(nullptr),
+	m_pPotentiallyVisibleSet(nullptr),
+	m_pCellResidencyManager(nullptr),
+	m_pProgressiveSceneLoader(nullptr)
 {
 	// The demo is published as a simple archive, so, put the log and configuration files in the same directory the executable is
 	// in - as a result, the user only has to remove this directory and the demo is completly gone from the system :D
@@ -76,6 +130,11 @@ Application::Application(Frontend &cFrontend) : ScriptApplication(cFrontend, "Da
 	// base class (such as --help etc.). The last parameter however is the filename to load, so add that.
 	m_cCommandLine.AddFlag("Expert", "-e", "--expert", "Expert mode, no additional help texts", false);
 	m_cCommandLine.AddFlag("Repeat", "-r", "--repeat", "If movie and making of is finished, start the movie again instead of switching to nteractive mode", false);
+	m_cCommandLine.AddFlag("TraceStartup", "-t", "--trace-startup", "Traces the startup and writes the trace in the Chrome trace event format into \"StartupTrace.json\" as soon as the first frame is updated", false);
+	m_cCommandLine.AddFlag("CompileScene", "-c", "--compile-scene", "Compiles the loaded scene into the binary scene format (\"*.bscene\" next to the scene XML file) and exits", false);
+	m_cCommandLine.AddFlag("PackPhysicsCache", "-p", "--pack-physics-cache", "Headless, rebuilds the stale collision trees of the loaded scene by using the null renderer, packs the physics collision cache into the physics cache archive (see \"PhysicsCacheArchive\" configuration) and exits", false);
+	m_cCommandLine.AddFlag("ComputePVS", "-v", "--compute-pvs", "Headless, computes the potentially visible set of the loaded scene by using the null renderer (\"*.pvs\" next to the scene XML file) and exits", false);
+	m_cCommandLine.AddParameter("Benchmark", "-b", "--benchmark", "Benchmark mode, plays the given camcorder record (e.g. \"Movie\") at a fixed simulated frame rate by using the null renderer (within a visible window), writes the per-frame timings and exits", "");
 }
 
 /**
@@ -84,6 +143,43 @@ Application::Application(Frontend &cFrontend) : ScriptApplication(cFrontend, "Da
 */
 Application::~Application()
 {
+	// Destroy the benchmark recorder
+	if (m_pBenchmark)
+		delete m_pBenchmark;
+
+	// Destroy the physics statistics
+	if (m_pPhysicsStatistics)
+		delete m_pPhysicsStatistics;
+
+	// Destroy the ray query service
+	if (m_pRayQueryService) {
+		RayQueryService::SetCurrent(nullptr);
+		delete m_pRayQueryService;
+	}
+
+	// Destroy the instance batcher, the render queue, the occlusion culler, the portal culler and its potentially visible set
+	if (m_pInstanceBatcher)
+		delete m_pInstanceBatcher;
+	if (m_pRenderQueue)
+		delete m_pRenderQueue;
+	if (m_pOcclusionCuller)
+		delete m_pOcclusionCuller;
+	if (m_pPortalCuller)
+		delete m_pPortalCuller;
+	if (m_pPotentiallyVisibleSet)
+		delete m_pPotentiallyVisibleSet;
+
+	// Destroy the spatial index
+	if (m_pSpatialIndex)
+		delete m_pSpatialIndex;
+
+	// Destroy the cell residency manager
+	if (m_pCellResidencyManager)
+		delete m_pCellResidencyManager;
+
+	// Destroy the progressive scene loader
+	if (m_pProgressiveSceneLoader)
+		delete m_pProgressiveSceneLoader;
 }
 
 /**
@@ -92,8 +188,8 @@ Application::~Application()
 */
 bool Application::IsExpertMode() const
 {
-	// Check 'Expert' commando line flag
-	return m_cCommandLine.IsValueSet("Expert");
+	// Check 'Expert' commando line flag, there are no help texts within the benchmark mode as well
+	return (m_cCommandLine.IsValueSet("Expert") || IsBenchmarkMode());
 }
 
 /**
@@ -119,6 +215,153 @@ bool Application::IsInternalRelease() const
 	#endif
 }
 
+/**
+*  @brief
+*    Returns whether or not the application runs within the benchmark mode
+*/
+bool Application::IsBenchmarkMode() const
+{
+	return (m_pBenchmark != nullptr);
+}
+
+/**
+*  @brief
+*    Returns the name of the camcorder record played within the benchmark mode
+*/
+String Application::GetBenchmarkRecord() const
+{
+	return m_pBenchmark ? m_pBenchmark->GetName() : "";
+}
+
+/**
+*  @brief
+*    Finishes the benchmark
+*/
+void Application::FinishBenchmark()
+{
+	if (m_pBenchmark) {
+		// Stop the recording
+		m_pBenchmark->Stop();
+
+		// Write the recorded timings
+		const String sFilename = "Benchmark" + m_pBenchmark->GetName();
+		if (m_pBenchmark->SaveCSV(sFilename + ".csv") && m_pBenchmark->SaveJSON(sFilename + ".json")) {
+			PL_LOG(Info, String("Benchmark: Wrote the timings of ") + m_pBenchmark->GetNumOfFrames() + " frames into \"" + sFilename + ".csv\" and \"" + sFilename + ".json\"")
+		} else {
+			PL_LOG(Error, "Benchmark: Failed to write the timings into \"" + sFilename + ".csv\" and \"" + sFilename + ".json\"")
+		}
+
+		// Exit the application
+		Exit(0);
+	}
+}
+
+/**
+*  @brief
+*    Returns the smoothed duration of a physics world update
+*/
+float Application::GetPhysicsStepTime() const
+{
+	return m_fPhysicsStepTime;
+}
+
+/**
+*  @brief
+*    Returns the physics statistics of the loaded scene as string
+*/
+String Application::GetPhysicsStatistics()
+{
+	SceneContainer *pSceneContainer = GetScene();
+	if (m_pPhysicsStatistics && pSceneContainer) {
+		m_pPhysicsStatistics->Update(*pSceneContainer);
+
+		// Number of own threads stepping the simulation, "None" lets the scene context update step it
+		SceneNode *pSceneNode = pSceneContainer->GetByName("Container");
+		const DynVar *pThreadPriorityClass = pSceneNode ? pSceneNode->GetAttribute("ThreadPriorityClass") : nullptr;
+		const uint32 nPhysicsThreads = (pThreadPriorityClass && pThreadPriorityClass->GetString() != "None") ? 1 : 0;
+
+		// Within an own thread, the physics step can't be bracketed by the probes
+		if (m_bPhysicsStepMeasured)
+			return m_pPhysicsStatistics->ToString() + String::Format(" PhysicsThreads=\"%u\" StepTime=\"%.3f\"", nPhysicsThreads, m_fPhysicsStepTime);
+		else
+			return m_pPhysicsStatistics->ToString() + String::Format(" PhysicsThreads=\"%u\" StepTime=\"n/a (requires PhysicsThread=false)\"", nPhysicsThreads);
+	}
+
+	// Error!
+	return "";
+}
+
+/**
+*  @brief
+*    Returns the nearest physics body hit by a ray
+*/
+String Application::RayQuery(const String &sOrigin, const String &sDirection)
+{
+	if (m_pRayQueryService) {
+		// Get the ray
+		Vector3 vOrigin, vDirection;
+		vOrigin.FromString(sOrigin);
+		vDirection.FromString(sDirection);
+		if (!vDirection.IsNull()) {
+			vDirection.Normalize();
+
+			// Intersect
+			float fDistance = 0.0f;
+			const SceneNode *pSceneNode = m_pRayQueryService->Intersect(vOrigin, vDirection, Math::MaxFloat, fDistance);
+			if (pSceneNode)
+				return "Node=\"" + pSceneNode->GetAbsoluteName() + String::Format("\" Distance=\"%.3f\" Position=\"", fDistance) + (vOrigin + vDirection*fDistance).ToString() + '\"';
+		}
+	}
+
+	// Error!
+	return "";
+}
+
+/**
+*  @brief
+*    Returns the portal culling counters of the last frame as string
+*/
+String Application::GetCullingStatistics() const
+{
+	if (m_pPortalCuller)
+		return m_pOcclusionCuller ? m_pPortalCuller->ToString() + ' ' + m_pOcclusionCuller->ToString() : m_pPortalCuller->ToString();
+	return "";
+}
+
+/**
+*  @brief
+*    Returns the render queue and instance batching counters of the last frame as string
+*/
+String Application::GetRenderQueueStatistics() const
+{
+	if (m_pRenderQueue)
+		return m_pInstanceBatcher ? m_pRenderQueue->ToString() + ' ' + m_pInstanceBatcher->ToString() : m_pRenderQueue->ToString();
+	return "";
+}
+
+/**
+*  @brief
+*    Opens a startup trace scope
+*/
+void Application::TraceBegin(const String &sName)
+{
+	if (Trace::IsEnabled())
+		m_lstTraceScopes.Add(Trace::Begin(sName, "Script"));
+}
+
+/**
+*  @brief
+*    Closes the startup trace scope which was opened last by using "TraceBegin()"
+*/
+void Application::TraceEnd()
+{
+	if (m_lstTraceScopes.GetNumOfElements()) {
+		const uint32 nIndex = m_lstTraceScopes.GetNumOfElements() - 1;
+		Trace::End(m_lstTraceScopes[nIndex]);
+		m_lstTraceScopes.RemoveAtIndex(nIndex);
+	}
+}
+
 
 //[-------------------------------------------------------]
 //[ Private functions                                     ]
@@ -168,11 +411,409 @@ void Application::UpdateMousePickingPullAnimation()
 }
 
 
+/**
+*  @brief
+*    Returns the native filename of a file compiled from a scene XML file
+*/
+String Application::GetCompiledSceneFilename(const String &sFilename, const String &sExtension, bool bUpToDateOnly) const
+{
+	// Get the native filename of the scene XML file
+	File cFile;
+	if (LoadableManager::GetInstance()->OpenFile(cFile, sFilename)) {
+		const String sNativeFilename = cFile.GetUrl().GetNativePath();
+		cFile.Close();
+
+		// The compiled file is next to the scene XML file
+		const String sCompiledFilename = Url(sNativeFilename).CutExtension() + sExtension;
+		if (!bUpToDateOnly)
+			return sCompiledFilename;
+
+		// Is the compiled file newer than the scene XML file? A binary scene must also be of the current format version.
+		const uint64 nCompiledTime = MemoryMappedFile::GetModificationTime(sCompiledFilename);
+		if (nCompiledTime && nCompiledTime >= MemoryMappedFile::GetModificationTime(sNativeFilename)) {
+			if (sExtension != ".bscene" || BinaryScene::IsCompatible(sCompiledFilename))
+				return sCompiledFilename;
+			PL_LOG(Warning, "\"" + sCompiledFilename + "\" was compiled by another binary scene format version, \"" + sFilename + "\" is used instead (recompile it with \"--compile-scene\")")
+		}
+	}
+
+	// Error!
+	return "";
+}
+
+/**
+*  @brief
+*    Creates the cell residency manager
+*/
+void Application::CreateCellResidencyManager()
+{
+	// Get the scene context, the renderer context and the scene container the cells are in
+	SceneContext	*pSceneContext    = GetSceneContext();
+	RendererContext *pRendererContext = GetRendererContext();
+	SceneContainer	*pSceneContainer  = GetScene();
+	if (pSceneContext && pRendererContext && pSceneContainer) {
+		SceneNode *pSceneNode = pSceneContainer->GetByName("Container");
+		if (pSceneNode && pSceneNode->IsContainer()) {
+			// Unused resources must be destroyed, else evicting a cell would not free any memory
+			pSceneContext->GetMeshManager().SetUnloadUnused(true);
+			pRendererContext->GetMaterialManager().SetUnloadUnused(true);
+			pRendererContext->GetTextureManager().SetUnloadUnused(true);
+
+			// Create the cell residency manager
+			const uint32 nMaxHops = GetConfig().GetVar("DungeonConfig", "CellResidencyHops").GetUInt32();
+			const uint64 nBudget  = static_cast<uint64>(GetConfig().GetVar("DungeonConfig", "CellResidencyBudget").GetUInt32())*1024*1024;
+			m_pCellResidencyManager = new CellResidencyManager(&pRendererContext->GetRenderer(), nMaxHops, nBudget);
+			if (!m_pCellResidencyManager->Init(static_cast<SceneContainer&>(*pSceneNode))) {
+				// There are no cells
+				delete m_pCellResidencyManager;
+				m_pCellResidencyManager = nullptr;
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Creates the ray query service for the physics world
+*/
+void Application::CreateRayQueryService()
+{
+	SceneContainer *pSceneContainer = GetScene();
+	SceneNode *pSceneNode = pSceneContainer ? pSceneContainer->GetByName("Container") : nullptr;
+	if (pSceneNode && pSceneNode->IsContainer()) {
+		m_pRayQueryService = new RayQueryService();
+		m_pRayQueryService->Build(static_cast<SceneContainer&>(*pSceneNode));
+		RayQueryService::SetCurrent(m_pRayQueryService);
+	}
+}
+
+/**
+*  @brief
+*    Builds the spatial index over the scene nodes of the cells within the "Container" scene container
+*/
+void Application::CreateSpatialIndex()
+{
+	SceneContainer *pSceneContainer = GetScene();
+	SceneNode *pSceneNode = pSceneContainer ? pSceneContainer->GetByName("Container") : nullptr;
+	if (pSceneNode && pSceneNode->IsContainer()) {
+		m_pSpatialIndex = new SpatialIndex();
+		m_pSpatialIndex->Build(static_cast<SceneContainer&>(*pSceneNode));
+		PL_LOG(Info, String("Indexed ") + m_pSpatialIndex->GetNumOfSceneNodes() + " scene nodes (" + m_pSpatialIndex->GetNumOfMovableSceneNodes() + " movable) within " +
+					 m_pSpatialIndex->GetNumOfOctrees() + " octrees")
+	}
+}
+
+/**
+*  @brief
+*    Builds the portal culler from the cells and cell portals within the "Container" scene container
+*/
+void Application::CreatePortalCuller()
+{
+	SceneContainer *pSceneContainer = GetScene();
+	SceneNode *pSceneNode = pSceneContainer ? pSceneContainer->GetByName("Container") : nullptr;
+	if (m_pSpatialIndex && pSceneNode && pSceneNode->IsContainer() && GetConfig().GetVar("DungeonConfig", "PortalCulling").GetBool()) {
+		m_pPortalCuller = new PortalCuller();
+		if (!m_pPortalCuller->Build(static_cast<SceneContainer&>(*pSceneNode), *m_pSpatialIndex)) {
+			// There are no cells
+			delete m_pPortalCuller;
+			m_pPortalCuller = nullptr;
+		} else {
+			// Use the potentially visible set if it's up-to-date and matches the cells
+			const String sPVSFilename = GetCompiledSceneFilename(m_sSceneFilename, ".pvs", true);
+			if (sPVSFilename.GetLength()) {
+				m_pPotentiallyVisibleSet = new PotentiallyVisibleSet();
+				if (m_pPotentiallyVisibleSet->Load(sPVSFilename, *m_pPortalCuller)) {
+					m_pPortalCuller->SetPotentiallyVisibleSet(m_pPotentiallyVisibleSet);
+					PL_LOG(Info, String("Loaded the potentially visible set of ") + m_pPotentiallyVisibleSet->GetNumOfRegions() + " regions from \"" + sPVSFilename + '\"')
+				} else {
+					PL_LOG(Warning, "The potentially visible set \"" + sPVSFilename + "\" doesn't match the scene, the cell portals are traversed instead (use \"--compute-pvs\" to update it)")
+					delete m_pPotentiallyVisibleSet;
+					m_pPotentiallyVisibleSet = nullptr;
+				}
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Builds the occlusion culler from the occluder meshes within the cells of the portal culler
+*/
+void Application::CreateOcclusionCuller()
+{
+	if (m_pPortalCuller && GetConfig().GetVar("DungeonConfig", "OcclusionCulling").GetBool()) {
+		m_pOcclusionCuller = new OcclusionCuller(GetConfig().GetVar("DungeonConfig", "OcclusionThreads").GetUInt32());
+		const uint32 nNumOfOccluders = m_pOcclusionCuller->Build(*m_pPortalCuller, GetConfig().GetVar("DungeonConfig", "OcclusionOccluders"));
+		if (nNumOfOccluders) {
+			PL_LOG(Info, String("Found ") + nNumOfOccluders + " occluder meshes")
+		} else {
+			// There's nothing to occlude with
+			delete m_pOcclusionCuller;
+			m_pOcclusionCuller = nullptr;
+		}
+	}
+}
+
+/**
+*  @brief
+*    Builds the render queue over the meshes within the cells of the portal culler
+*/
+void Application::CreateRenderQueue()
+{
+	if (m_pPortalCuller && GetConfig().GetVar("DungeonConfig", "RenderQueue").GetBool()) {
+		m_pRenderQueue = new RenderQueue(GetConfig().GetVar("DungeonConfig", "RenderQueueThreads").GetUInt32());
+		PL_LOG(Info, String("Render queue: Found ") + m_pRenderQueue->Build(*m_pPortalCuller) + " meshes")
+	}
+}
+
+/**
+*  @brief
+*    Builds the instance batcher from the repeated static meshes within the cells of the portal culler
+*/
+void Application::CreateInstanceBatcher()
+{
+	if (m_pRenderQueue && GetConfig().GetVar("DungeonConfig", "InstanceBatching").GetBool()) {
+		m_pInstanceBatcher = new InstanceBatcher();
+		const uint32 nNumOfBatches = m_pInstanceBatcher->Build(*m_pPortalCuller, GetConfig().GetVar("DungeonConfig", "InstanceBatchMinInstances").GetUInt32());
+		if (nNumOfBatches) {
+			PL_LOG(Info, String("Built ") + nNumOfBatches + " instance batches of " + m_pInstanceBatcher->GetNumOfInstances() + " meshes")
+		} else {
+			// There's nothing to batch
+			delete m_pInstanceBatcher;
+			m_pInstanceBatcher = nullptr;
+		}
+	}
+}
+
+/**
+*  @brief
+*    Computes the potentially visible set between the cells within the "Container" scene container and writes it next to the scene XML file
+*/
+bool Application::ComputePotentiallyVisibleSet(const String &sFilename)
+{
+	// The portal culler samples the views, it's built here because the portal culling may be disabled within the configuration
+	SceneContainer *pSceneContainer = GetScene();
+	SceneNode *pSceneNode = pSceneContainer ? pSceneContainer->GetByName("Container") : nullptr;
+	const String sPVSFilename = GetCompiledSceneFilename(sFilename, ".pvs", false);
+	if (m_pSpatialIndex && pSceneNode && pSceneNode->IsContainer() && sPVSFilename.GetLength()) {
+		PortalCuller cPortalCuller;
+		if (cPortalCuller.Build(static_cast<SceneContainer&>(*pSceneNode), *m_pSpatialIndex)) {
+			const uint64 nStartTime = System::GetInstance()->GetMilliseconds();
+			PotentiallyVisibleSet cPotentiallyVisibleSet;
+			const uint32 nNumOfRegions = cPotentiallyVisibleSet.Compute(cPortalCuller);
+			if (cPotentiallyVisibleSet.Save(sPVSFilename)) {
+				// Done
+				PL_LOG(Info, String("Computed the potentially visible set of ") + nNumOfRegions + " regions within " + (System::GetInstance()->GetMilliseconds() - nStartTime) +
+							 " ms into \"" + sPVSFilename + '\"')
+				return true;
+			}
+		}
+	}
+
+	// Error!
+	return false;
+}
+
+/**
+*  @brief
+*    Passes the movement controls to the character mover of the camera
+*/
+void Application::UpdateCharacterMover()
+{
+	SceneNode *pCamera = reinterpret_cast<SceneNode*>(GetCamera());
+	SceneNodeModifier *pSceneNodeModifier = pCamera ? pCamera->GetModifier("SNMCharacterMover") : nullptr;
+	PLInput::Controller *pController = GetInputController();
+	if (pSceneNodeModifier && pController) {
+		// Get the state of the movement buttons
+		static const char *pszButtons[] = { "Forward", "Backward", "StrafeLeft", "StrafeRight", "Run", "Jump" };
+		bool bPressed[6];
+		for (uint32 i=0; i<6; i++) {
+			const PLInput::Control *pControl = pController->GetControl(pszButtons[i]);
+			bPressed[i] = (pControl && pControl->GetType() == PLInput::ControlButton && static_cast<const PLInput::Button*>(pControl)->IsPressed());
+		}
+
+		// Set the movement of the next scene update
+		static_cast<SNMCharacterMover*>(pSceneNodeModifier)->SetMovement(static_cast<float>(bPressed[0]) - static_cast<float>(bPressed[1]),
+																		 static_cast<float>(bPressed[2]) - static_cast<float>(bPressed[3]),
+																		 bPressed[4], bPressed[5]);
+	}
+}
+
+/**
+*  @brief
+*    Configures the simulation of the physics world
+*/
+void Application::SetupPhysicsWorld(bool bOwnThread)
+{
+	// Get the physics world scene container
+	SceneContainer *pSceneContainer = GetScene();
+	SceneNode *pSceneNode = pSceneContainer ? pSceneContainer->GetByName("Container") : nullptr;
+	if (pSceneNode && pSceneNode->IsInstanceOf("PLPhysics::SCPhysicsWorld")) {
+		// Fixed time step
+		const float fFrameRate = GetConfig().GetVar("DungeonConfig", "PhysicsFrameRate").GetFloat();
+		if (fFrameRate > 0.0f)
+			pSceneNode->SetAttribute("FrameRate", fFrameRate);
+
+		// Solver quality (1 means best realism, 0 means best performance)
+		pSceneNode->SetAttribute("SimulationQuality", Math::ClampToInterval(GetConfig().GetVar("DungeonConfig", "PhysicsSolverQuality").GetFloat(), 0.0f, 1.0f));
+
+		// Own thread, "None" lets the scene context update step the simulation
+		DynVar *pThreadPriorityClass = pSceneNode->GetAttribute("ThreadPriorityClass");
+		if (pThreadPriorityClass) {
+			pThreadPriorityClass->SetString(bOwnThread ? "Normal" : "None");
+			if (bOwnThread)
+				PL_LOG(Warning, String("The physics simulation is stepped within an own thread at ") + fFrameRate + " Hz, physics bodies changed by the main thread (character mover, progressive scene loading, cell residency) may race with the solver")
+		} else if (bOwnThread) {
+			PL_LOG(Warning, "The physics world can't step the simulation within an own thread, it's stepped by the scene context update")
+		}
+	}
+}
+
+/**
+*  @brief
+*    Installs the benchmark probes measuring the modifier updates and the physics step
+*/
+void Application::InstallBenchmarkProbes()
+{
+	// Get the scene context and the scene container
+	SceneContext   *pSceneContext   = GetSceneContext();
+	SceneContainer *pSceneContainer = GetScene();
+	if (pSceneContext && pSceneContainer) {
+		// Get the physics world scene container
+		SceneNode *pSceneNode = pSceneContainer->GetByName("Container");
+		if (pSceneNode && pSceneNode->IsInstanceOf("PLPhysics::SCPhysicsWorld")) {
+			// Get the update slot of the physics world
+			DynEventHandler *pPhysicsUpdateSlot = pSceneNode->GetSlot("OnUpdate");
+			if (pPhysicsUpdateSlot) {
+				// Move the physics world update to the end of the scene context update event and bracket it by the benchmark probes
+				DynEvent &cEventUpdate = pSceneContext->EventUpdate;
+				cEventUpdate.Disconnect(SlotOnBenchmarkPhysicsBegin);
+				cEventUpdate.Disconnect(SlotOnBenchmarkPhysicsEnd);
+				cEventUpdate.Disconnect(*pPhysicsUpdateSlot);
+				pSceneContext->EventUpdate.Connect(SlotOnBenchmarkPhysicsBegin);
+				cEventUpdate.Connect(*pPhysicsUpdateSlot);
+				pSceneContext->EventUpdate.Connect(SlotOnBenchmarkPhysicsEnd);
+				m_bPhysicsStepMeasured = true;
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Called when the scene context update starts
+*/
+void Application::OnBenchmarkUpdateBegin()
+{
+	if (m_pBenchmark)
+		m_pBenchmark->BeginSection(Benchmark::ModifierUpdate);
+}
+
+/**
+*  @brief
+*    Called before the physics world is updated
+*/
+void Application::OnBenchmarkPhysicsBegin()
+{
+	m_nPhysicsStepStartTime = System::GetInstance()->GetMicroseconds();
+	if (m_pBenchmark) {
+		m_pBenchmark->EndSection(Benchmark::ModifierUpdate);
+		m_pBenchmark->BeginSection(Benchmark::PhysicsStep);
+	}
+}
+
+/**
+*  @brief
+*    Called after the physics world was updated
+*/
+void Application::OnBenchmarkPhysicsEnd()
+{
+	if (m_pBenchmark)
+		m_pBenchmark->EndSection(Benchmark::PhysicsStep);
+
+	// Smooth the measured duration, a single step can be far off
+	const float fTime = static_cast<float>(System::GetInstance()->GetMicroseconds() - m_nPhysicsStepStartTime)/1000.0f;
+	m_fPhysicsStepTime = (m_fPhysicsStepTime > 0.0f) ? m_fPhysicsStepTime*0.9f + fTime*0.1f : fTime;
+}
+
+/**
+*  @brief
+*    Console command writing the physics statistics into the log
+*/
+void Application::ConsoleCommandPhysics(ConsoleCommand &cCommand)
+{
+	const String sStatistics = GetPhysicsStatistics();
+	if (sStatistics.GetLength()) {
+		PL_LOG(Info, "Physics statistics: " + sStatistics)
+	} else {
+		PL_LOG(Info, "Physics statistics: There's no loaded scene")
+	}
+}
+
+/**
+*  @brief
+*    Console command writing the portal culling counters into the log
+*/
+void Application::ConsoleCommandCulling(ConsoleCommand &cCommand)
+{
+	const String sStatistics = GetCullingStatistics();
+	if (sStatistics.GetLength()) {
+		PL_LOG(Info, "Culling statistics: " + sStatistics)
+	} else {
+		PL_LOG(Info, "Culling statistics: The portal culling is not used")
+	}
+}
+
+/**
+*  @brief
+*    Console command writing the render queue counters into the log
+*/
+void Application::ConsoleCommandRenderQueue(ConsoleCommand &cCommand)
+{
+	const String sStatistics = GetRenderQueueStatistics();
+	if (sStatistics.GetLength()) {
+		PL_LOG(Info, "Render queue statistics: " + sStatistics)
+	} else {
+		PL_LOG(Info, "Render queue statistics: The render queue is not used")
+	}
+}
+
+
 //[-------------------------------------------------------]
 //[ Protected virtual PLCore::CoreApplication functions   ]
 //[-------------------------------------------------------]
 void Application::OnInit()
 {
+	// Trace the startup? The trace starts right now.
+	if (m_cCommandLine.IsValueSet("TraceStartup"))
+		Trace::Enable();
+	TraceScope cTraceScope("Application::OnInit", "Startup");
+
+	// Benchmark mode?
+	if (m_cCommandLine.IsValueSet("Benchmark")) {
+		// Create the benchmark recorder
+		m_pBenchmark = new Benchmark(m_cCommandLine.GetValue("Benchmark"), BenchmarkFramesPerSecond);
+
+		// Fixed simulated frame rate: The frames per second limitation ensures that at least the fixed time step has passed
+		// since the previous frame, the maximum time difference clamps the time difference of slower frames to the fixed time
+		// step - so the scene is always updated by exactly the fixed time step, no matter how fast this machine is
+		Timing *pTiming = Timing::GetInstance();
+		pTiming->SetFPSLimit(BenchmarkFramesPerSecond);
+		pTiming->SetMaxTimeDifference(1.0f/BenchmarkFramesPerSecond);
+
+		// Headless: Use the null renderer, the previously configured renderer API is restored when the application shuts down
+		// (the frontend still opens its window, there's no hidden or offscreen frontend window)
+		m_sHeadlessRendererAPI = GetConfig().GetVar("PLRenderer::Config", "RendererAPI");
+		GetConfig().SetVar("PLRenderer::Config", "RendererAPI", "PLRendererNull::Renderer");
+	}
+
+	// Physics cache packing and the PVS computation are headless as well, neither the physics backend building the collision
+	// trees nor the portal culler sampling the views need a renderer
+	if ((m_cCommandLine.IsValueSet("PackPhysicsCache") || m_cCommandLine.IsValueSet("ComputePVS")) && !m_sHeadlessRendererAPI.GetLength()) {
+		m_sHeadlessRendererAPI = GetConfig().GetVar("PLRenderer::Config", "RendererAPI");
+		GetConfig().SetVar("PLRenderer::Config", "RendererAPI", "PLRendererNull::Renderer");
+	}
+
 	// Call base implementation
 	ScriptApplication::OnInit();
 
@@ -180,15 +821,153 @@ void Application::OnInit()
 	SetEditModeEnabled(GetConfig().GetVar("DungeonConfig", "EditModeEnabled").GetBool());
 }
 
+void Application::OnDeInit()
+{
+	// Destroy the cell residency manager while the scene is still there, all cells are made resident again
+	if (m_pCellResidencyManager) {
+		delete m_pCellResidencyManager;
+		m_pCellResidencyManager = nullptr;
+	}
+
+	// Destroy the progressive scene loader, the deferred cells are not going to be loaded anymore
+	if (m_pProgressiveSceneLoader) {
+		delete m_pProgressiveSceneLoader;
+		m_pProgressiveSceneLoader = nullptr;
+	}
+
+	// Restore the renderer API a headless mode replaced by the null renderer, else it would be written into the configuration
+	if (m_sHeadlessRendererAPI.GetLength())
+		GetConfig().SetVar("PLRenderer::Config", "RendererAPI", m_sHeadlessRendererAPI);
+
+	// Call base implementation
+	ScriptApplication::OnDeInit();
+}
+
+
+//[-------------------------------------------------------]
+//[ Protected virtual PLCore::AbstractFrontend functions  ]
+//[-------------------------------------------------------]
+void Application::OnDraw()
+{
+	// Measure the render submission within the benchmark mode
+	if (m_pBenchmark && m_pBenchmark->IsRecording()) {
+		m_pBenchmark->BeginSection(Benchmark::RenderSubmission);
+		ScriptApplication::OnDraw();
+		m_pBenchmark->EndSection(Benchmark::RenderSubmission);
+
+		// Close the frame record, the draw is the last part of a frame
+		m_pBenchmark->EndFrame();
+	} else {
+		// Call base implementation
+		ScriptApplication::OnDraw();
+	}
+}
+
+void Application::OnUpdate()
+{
+	// The startup is finished as soon as the first frame is updated, write the startup trace
+	if (Trace::IsEnabled()) {
+		if (Trace::Save("StartupTrace.json")) {
+			PL_LOG(Info, "Wrote the startup trace into \"StartupTrace.json\"")
+		} else {
+			PL_LOG(Error, "Failed to write the startup trace into \"StartupTrace.json\"")
+		}
+		Trace::Disable();
+		m_lstTraceScopes.Clear();
+	}
+
+	// Load the next deferred cell of the progressive scene loading
+	if (m_pProgressiveSceneLoader) {
+		const bool bStageFinished = m_pProgressiveSceneLoader->Update();
+		const uint32 nNumOfFinishedStages = m_pProgressiveSceneLoader->GetNumOfFinishedStages();
+		const uint32 nNumOfStages		  = m_pProgressiveSceneLoader->GetNumOfStages();
+		if (!m_pProgressiveSceneLoader->IsLoading()) {
+			// All cells are loaded
+			delete m_pProgressiveSceneLoader;
+			m_pProgressiveSceneLoader = nullptr;
+			PL_LOG(Info, "Progressive scene loading finished")
+
+			// Stream the cells in and out depending on their portal distance to the camera? (all cells are required to build the cell graph)
+			if (GetConfig().GetVar("DungeonConfig", "CellResidencyEnabled").GetBool())
+				CreateCellResidencyManager();
+
+			// The ray query service and the spatial index know the cells once all are loaded
+			CreateRayQueryService();
+			CreateSpatialIndex();
+			CreatePortalCuller();
+			CreateOcclusionCuller();
+			CreateRenderQueue();
+			CreateInstanceBatcher();
+		}
+
+		// Emit the scene loading stage finished signal
+		if (bStageFinished)
+			SignalSceneLoadingStageFinished(nNumOfFinishedStages, nNumOfStages);
+	}
+
+	// Stream the cells in and out depending on the camera position
+	if (m_pCellResidencyManager)
+		m_pCellResidencyManager->Update(reinterpret_cast<SceneNode*>(GetCamera()));
+
+	// The character mover of the walk camera moves within the scene update
+	UpdateCharacterMover();
+
+	// The dynamic bodies are going to be moved by the scene update, the ray query service refits to the moved ones on the next query
+	if (m_pRayQueryService)
+		m_pRayQueryService->Invalidate();
+
+	// Measure the scene update and the Lua "OnUpdate" separately within the benchmark mode
+	if (m_pBenchmark && m_pBenchmark->IsRecording()) {
+		// Scene update (the modifier updates and the physics step are measured by the benchmark probes)
+		m_pBenchmark->BeginSection(Benchmark::SceneUpdate);
+		EngineApplication::OnUpdate();
+		m_pBenchmark->EndSection(Benchmark::SceneUpdate);
+
+		// Lua "OnUpdate" - this is what "PLEngine::ScriptApplication::OnUpdate()" does after the scene update
+		m_pBenchmark->BeginSection(Benchmark::ScriptUpdate);
+		Script *pScript = GetScript();
+		if (pScript && pScript->IsGlobalFunction("OnUpdate"))
+			FuncScriptPtr<void>(pScript, "OnUpdate").Call(Params<void>());
+		m_pBenchmark->EndSection(Benchmark::ScriptUpdate);
+	} else {
+		// Call base implementation
+		ScriptApplication::OnUpdate();
+	}
+
+	// Update the bounding boxes of the moved scene nodes within the spatial index, it's queried while drawing
+	if (m_pSpatialIndex)
+		m_pSpatialIndex->Refit();
+
+	// Hide the cells which can't be seen through the cell portals, then the meshes within them which are hidden behind the occluders,
+	// then sort the remaining meshes by render state and gather the visible instances of the batches
+	if (m_pPortalCuller) {
+		Frontend &cFrontend = GetFrontend();
+		const float fAspect = cFrontend.GetHeight() ? static_cast<float>(cFrontend.GetWidth())/cFrontend.GetHeight() : 1.0f;
+		m_pPortalCuller->Update(reinterpret_cast<SceneNode*>(GetCamera()), fAspect);
+		if (m_pOcclusionCuller)
+			m_pOcclusionCuller->Update(reinterpret_cast<SceneNode*>(GetCamera()), fAspect);
+		if (m_pRenderQueue)
+			m_pRenderQueue->Update(reinterpret_cast<SceneNode*>(GetCamera()));
+		if (m_pInstanceBatcher)
+			m_pInstanceBatcher->Update(*m_pRenderQueue);
+	}
+}
+
 
 //[-------------------------------------------------------]
 //[ Protected virtual PLScene::SceneApplication functions ]
 //[-------------------------------------------------------]
 void Application::OnCreateRootScene()
 {
+	TraceScope cTraceScope("Application::OnCreateRootScene", "Startup");
+
 	// Get the scene context
 	SceneContext *pSceneContext = GetSceneContext();
 	if (pSceneContext) {
+		// Within the benchmark mode, we need to be the first listener of the scene context update event to be able to measure the modifier updates
+		if (m_pBenchmark)
+			pSceneContext->EventUpdate.Connect(SlotOnBenchmarkUpdateBegin);
+
 		// First, create the scene root container which holds the scene container with our 'concrete' scene within it
 		SceneContainer *pRootContainer = pSceneContext->GetRoot() ? static_cast<SceneContainer*>(pSceneContext->GetRoot()->Create("PLSound::SCSound", "RootScene", "SoundAPI=\"" + GetConfig().GetVar("DungeonConfig", "SoundAPI") + '"')) : nullptr;
 		if (!pRootContainer)
@@ -226,6 +1005,15 @@ void Application::OnCreateRootScene()
 				pConsole->RegisterCommand(0,	"bye",			"",	"",	Functor<void, ConsoleCommand &>(&EngineApplication::ConsoleCommandQuit, this));
 				pConsole->RegisterCommand(0,	"logout",		"",	"",	Functor<void, ConsoleCommand &>(&EngineApplication::ConsoleCommandQuit, this));
 
+				// Register the physics statistics command
+				pConsole->RegisterCommand(0,	"physics",		"",	"",	Functor<void, ConsoleCommand &>(&Application::ConsoleCommandPhysics, this));
+
+				// Register the portal culling statistics command
+				pConsole->RegisterCommand(0,	"culling",		"",	"",	Functor<void, ConsoleCommand &>(&Application::ConsoleCommandCulling, this));
+
+				// Register the render queue statistics command
+				pConsole->RegisterCommand(0,	"renderqueue",	"",	"",	Functor<void, ConsoleCommand &>(&Application::ConsoleCommandRenderQueue, this));
+
 				// Set active state
 				pConsole->SetActive(m_bEditModeEnabled);
 			}
@@ -242,12 +1030,254 @@ void Application::OnCreateRootScene()
 //[-------------------------------------------------------]
 bool Application::LoadScene(const String &sFilename)
 {
-	// Call base implementation
-	const bool bResult = ScriptApplication::LoadScene(sFilename);
+	TraceScope cTraceScope("Application::LoadScene", "Scene", sFilename);
+
+	// Use the compiled binary scene instead of the scene XML if it's up-to-date (the XML stays the authoring format)
+	const bool bCompileScene = m_cCommandLine.IsValueSet("CompileScene");
+	const String sBinaryFilename = GetCompiledSceneFilename(sFilename, ".bscene", !bCompileScene);
+	const String sLoadFilename = (!bCompileScene && sBinaryFilename.GetLength()) ? sBinaryFilename : sFilename;
+
+	// The cells of the previous scene are going to be destroyed
+	if (m_pRayQueryService) {
+		RayQueryService::SetCurrent(nullptr);
+		delete m_pRayQueryService;
+		m_pRayQueryService = nullptr;
+	}
+	if (m_pInstanceBatcher) {
+		delete m_pInstanceBatcher;
+		m_pInstanceBatcher = nullptr;
+	}
+	if (m_pRenderQueue) {
+		delete m_pRenderQueue;
+		m_pRenderQueue = nullptr;
+	}
+	if (m_pOcclusionCuller) {
+		delete m_pOcclusionCuller;
+		m_pOcclusionCuller = nullptr;
+	}
+	if (m_pPortalCuller) {
+		delete m_pPortalCuller;
+		m_pPortalCuller = nullptr;
+	}
+	if (m_pPotentiallyVisibleSet) {
+		delete m_pPotentiallyVisibleSet;
+		m_pPotentiallyVisibleSet = nullptr;
+	}
+	m_sSceneFilename = sFilename;
+	if (m_pSpatialIndex) {
+		delete m_pSpatialIndex;
+		m_pSpatialIndex = nullptr;
+	}
+	if (m_pCellResidencyManager) {
+		delete m_pCellResidencyManager;
+		m_pCellResidencyManager = nullptr;
+	}
+	if (m_pProgressiveSceneLoader) {
+		delete m_pProgressiveSceneLoader;
+		m_pProgressiveSceneLoader = nullptr;
+	}
+
+	// Restore missing physics collision cache files from the physics cache archive and remove the stale ones, the physics
+	// backend builds the collision trees of removed and missing cache files from the meshes (the packing rebuilds them this way)
+	const bool bPackPhysicsCache = m_cCommandLine.IsValueSet("PackPhysicsCache");
+	const bool bComputePVS		 = m_cCommandLine.IsValueSet("ComputePVS");
+	const String sPhysicsCacheArchive = GetConfig().GetVar("DungeonConfig", "PhysicsCacheArchive");
+	const uint32 nHashingThreads = GetConfig().GetVar("DungeonConfig", "LoadingThreads").GetUInt32();
+	if (sPhysicsCacheArchive.GetLength()) {
+		PhysicsCacheArchive cPhysicsCacheArchive;
+		if (cPhysicsCacheArchive.Open(Url(sPhysicsCacheArchive).GetNativePath())) {
+			uint32 nNumOfStaleEntries = 0;
+			const uint32 nNumOfWrittenFiles = cPhysicsCacheArchive.Extract(Url(sPhysicsCacheArchive).CutExtension(), nHashingThreads, nNumOfStaleEntries);
+			if (nNumOfWrittenFiles)
+				PL_LOG(Info, String("Restored ") + nNumOfWrittenFiles + " of " + cPhysicsCacheArchive.GetNumOfEntries() + " physics collision cache files from \"" + sPhysicsCacheArchive + '\"')
+			if (nNumOfStaleEntries)
+				PL_LOG(Warning, String(nNumOfStaleEntries) + " physics collision cache files are stale because their meshes were changed, they're rebuilt (use \"--pack-physics-cache\" to update \"" + sPhysicsCacheArchive + "\")")
+		}
+	}
+
+	// The physics statistics take note of the physics collision cache files which are existing before the scene is loaded
+	if (m_pPhysicsStatistics)
+		delete m_pPhysicsStatistics;
+	m_pPhysicsStatistics = new PhysicsStatistics(sPhysicsCacheArchive.GetLength() ? Url(sPhysicsCacheArchive).CutExtension() : "");
+
+	// Load the start cell first and the remaining cells in the background? (the compile, physics cache packing, PVS computation and benchmark modes require the whole scene)
+	if (!bCompileScene && !bPackPhysicsCache && !bComputePVS && !m_pBenchmark && sLoadFilename == sBinaryFilename && GetConfig().GetVar("DungeonConfig", "ProgressiveLoading").GetBool())
+		m_pProgressiveSceneLoader = new ProgressiveSceneLoader(GetConfig().GetVar("DungeonConfig", "ProgressiveStartCell"));
+
+	// Present the load screen on load progress reports (limited frame rate) while the scene assets are preloaded and the scene is loaded
+	const uint64 nLoadStartTime = System::GetInstance()->GetMilliseconds();
+	LoadScreenPresenter *pLoadScreenPresenter = nullptr;
+	if (GetScene())
+		pLoadScreenPresenter = new LoadScreenPresenter(GetFrontend(), *GetScene(), GetConfig().GetVar("DungeonConfig", "LoadScreenFramesPerSecond").GetUInt32());
+
+	// Preload the scene assets by using multiple threads, the scene nodes will find them already loaded (not used by the
+	// progressive scene loading because all assets would be read before the first interactive frame)
+	ScenePreloader *pScenePreloader = nullptr;
+	const uint32 nLoadingThreads = GetConfig().GetVar("DungeonConfig", "LoadingThreads").GetUInt32();
+	if (nLoadingThreads && GetSceneContext() && !m_pProgressiveSceneLoader) {
+		const uint64 nStartTime = System::GetInstance()->GetMilliseconds();
+		const uint32 nTraceScope = Trace::Begin("ScenePreloader::Preload", "Scene", sLoadFilename);
+		pScenePreloader = new ScenePreloader(*GetSceneContext(), nLoadingThreads);
+		if (pLoadScreenPresenter)
+			pLoadScreenPresenter->SetPhase(0.0f, 0.5f);
+		pScenePreloader->Preload(sLoadFilename, GetScene());
+		if (pLoadScreenPresenter)
+			pLoadScreenPresenter->SetPhase(0.5f, 1.0f);
+		Trace::End(nTraceScope);
+		PL_LOG(Info, String("Preloaded ") + pScenePreloader->GetNumOfReadFiles() + " asset files (" + pScenePreloader->GetNumOfReadBytes() + " bytes) by using " +
+					 nLoadingThreads + " threads within " + (System::GetInstance()->GetMilliseconds() - nStartTime) + " ms")
+	}
+
+	// Call base implementation, within the progressive scene loading only the first stage is loaded
+	const uint32 nTraceScope = Trace::Begin("ScriptApplication::LoadScene", "Scene", sLoadFilename);
+	ProgressiveSceneLoader::SetCurrent(m_pProgressiveSceneLoader);
+	bool bResult = ScriptApplication::LoadScene(sLoadFilename);
+	ProgressiveSceneLoader::SetCurrent(nullptr);
+	Trace::End(nTraceScope);
+
+	// Fall back to the scene XML if the binary scene can't be loaded (e.g. it's damaged)
+	if (!bResult && sLoadFilename != sFilename) {
+		PL_LOG(Warning, "Failed to load the binary scene \"" + sLoadFilename + "\", \"" + sFilename + "\" is loaded instead")
+		if (m_pProgressiveSceneLoader) {
+			delete m_pProgressiveSceneLoader;
+			m_pProgressiveSceneLoader = nullptr;
+		}
+		TraceScope cFallbackTraceScope("ScriptApplication::LoadScene", "Scene", sFilename);
+		bResult = ScriptApplication::LoadScene(sFilename);
+	}
+
+	// The load screen is no longer presented
+	if (pLoadScreenPresenter) {
+		PL_LOG(Info, String("Presented ") + pLoadScreenPresenter->GetNumOfPresentedFrames() + " load screen frames within " + (System::GetInstance()->GetMilliseconds() - nLoadStartTime) + " ms")
+		delete pLoadScreenPresenter;
+	}
+
+	// The scene nodes are now holding the preloaded resources
+	if (pScenePreloader)
+		delete pScenePreloader;
+
+	// Are there deferred cells to load?
+	if (m_pProgressiveSceneLoader) {
+		if (bResult && m_pProgressiveSceneLoader->IsLoading()) {
+			PL_LOG(Info, String("Loaded the first of ") + m_pProgressiveSceneLoader->GetNumOfStages() + " scene loading stages within " +
+						 (System::GetInstance()->GetMilliseconds() - nLoadStartTime) + " ms, the remaining cells are loaded in the background")
+			SignalSceneLoadingStageFinished(m_pProgressiveSceneLoader->GetNumOfFinishedStages(), m_pProgressiveSceneLoader->GetNumOfStages());
+		} else {
+			// The scene was loaded at once
+			delete m_pProgressiveSceneLoader;
+			m_pProgressiveSceneLoader = nullptr;
+		}
+	}
+
+	// Compile the loaded scene into the binary scene format?
+	if (bCompileScene) {
+		// Merge the static mesh bodies of each cell into a single static body, the compiled scene contains the merged bodies
+		if (bResult && GetScene() && GetSceneContext() && sBinaryFilename.GetLength() && GetConfig().GetVar("DungeonConfig", "MergeStaticCollision").GetBool()) {
+			SceneNode *pSceneNode = GetScene()->GetByName("Container");
+			if (pSceneNode && pSceneNode->IsContainer()) {
+				StaticCollisionMerger cStaticCollisionMerger(GetSceneContext()->GetMeshManager(), Url(sFilename).CutExtension() + '_', Url(sBinaryFilename).CutExtension() + '_');
+				const uint32 nNumOfMergedBodies = cStaticCollisionMerger.Merge(static_cast<SceneContainer&>(*pSceneNode));
+				PL_LOG(Info, String("Merged ") + nNumOfMergedBodies + " static mesh bodies into one static body per cell, kept " + cStaticCollisionMerger.GetNumOfInstancedBodies() +
+							 " static mesh bodies of instanced meshes sharing " + cStaticCollisionMerger.GetNumOfSharedTrees() + " collision trees")
+			}
+		}
+
+		// Let the convex hull bodies use simplified hull meshes instead of their render meshes, the compiled scene references the hull meshes
+		if (bResult && GetScene() && GetSceneContext() && sBinaryFilename.GetLength() && GetConfig().GetVar("DungeonConfig", "SimplifyConvexHulls").GetBool()) {
+			ConvexHullSimplifier cConvexHullSimplifier(GetSceneContext()->GetMeshManager(), Url(sFilename).CutExtension() + '_', Url(sBinaryFilename).CutExtension() + '_',
+													   GetConfig().GetVar("DungeonConfig", "ConvexHullMaxVertices").GetUInt32(),
+													   GetConfig().GetVar("DungeonConfig", "ConvexHullMaxFaces").GetUInt32(),
+													   GetConfig().GetVar("DungeonConfig", "ConvexHullTolerance").GetFloat());
+			const uint32 nNumOfSimplifiedBodies = cConvexHullSimplifier.Simplify(*GetScene());
+			PL_LOG(Info, String("Simplified the convex hulls of ") + nNumOfSimplifiedBodies + " bodies")
+		}
+
+		if (bResult && GetScene() && sBinaryFilename.GetLength() && GetScene()->SaveByFilename(sBinaryFilename)) {
+			PL_LOG(Info, "Compiled \"" + sFilename + "\" into \"" + sBinaryFilename + '\"')
+		} else {
+			PL_LOG(Error, "Failed to compile \"" + sFilename + "\" into the binary scene format")
+		}
+
+		// Exit the application
+		Exit(0);
+		return bResult;
+	}
+
+	// Pack the physics collision cache into the physics cache archive? (loading the whole scene has built all collision trees)
+	if (bPackPhysicsCache) {
+		// Only the collision trees used by the scene are packed, e.g. the per-scale trees of merged static meshes are not
+		Array<String> lstUsedCacheNames;
+		if (GetScene())
+			PhysicsCacheSources::GetUsedCacheNames(*GetScene(), lstUsedCacheNames);
+
+		if (bResult && sPhysicsCacheArchive.GetLength() && PhysicsCacheArchive::Build(Url(sPhysicsCacheArchive).CutExtension(), sPhysicsCacheArchive, nHashingThreads, &lstUsedCacheNames)) {
+			PL_LOG(Info, "Packed the physics collision cache into \"" + sPhysicsCacheArchive + '\"')
+		} else {
+			PL_LOG(Error, "Failed to pack the physics collision cache into \"" + sPhysicsCacheArchive + '\"')
+		}
+
+		// Exit the application
+		Exit(0);
+		return bResult;
+	}
+
+	// Compute the potentially visible set of the cells? (loading the whole scene has placed all scene nodes)
+	if (bComputePVS) {
+		if (bResult)
+			CreateSpatialIndex();
+		if (!bResult || !ComputePotentiallyVisibleSet(sFilename)) {
+			PL_LOG(Error, "Failed to compute the potentially visible set of \"" + sFilename + '\"')
+		}
+
+		// Exit the application
+		Exit(0);
+		return bResult;
+	}
+
+	// Stream the cells in and out depending on their portal distance to the camera?
+	if (bResult && !m_pProgressiveSceneLoader && GetConfig().GetVar("DungeonConfig", "CellResidencyEnabled").GetBool())
+		CreateCellResidencyManager();
+
+	// Build the ray query service and the spatial index (cells loaded in the background are added once all are loaded)
+	if (bResult && !m_pProgressiveSceneLoader) {
+		CreateRayQueryService();
+		CreateSpatialIndex();
+		CreatePortalCuller();
+		CreateOcclusionCuller();
+		CreateRenderQueue();
+		CreateInstanceBatcher();
+	}
+
+	// Put the props to sleep, they're placed at rest and the physics backend would write back their unchanged transforms
+	// until they're frozen automatically (cells loaded in the background are skipped, their bodies may be moving already).
+	// This has to be done before the physics simulation is configured, once it's stepped within an own thread, changing
+	// the bodies would race the solver.
+	if (bResult && GetScene() && !m_pProgressiveSceneLoader && GetConfig().GetVar("DungeonConfig", "PhysicsFreezeBodies").GetBool()) {
+		const uint32 nNumOfFrozenBodies = PhysicsBodySleep::FreezeBodies(*GetScene());
+		PL_LOG(Info, String("Put ") + nNumOfFrozenBodies + " dynamic bodies to sleep")
+	}
+
+	// Configure the physics simulation (the benchmark probes measure the physics step within the scene context update, so there's no own thread within the benchmark mode)
+	const bool bPhysicsThread = !m_pBenchmark && GetConfig().GetVar("DungeonConfig", "PhysicsThread").GetBool();
+	m_fPhysicsStepTime = 0.0f;
+	m_bPhysicsStepMeasured = false;
+	if (bResult)
+		SetupPhysicsWorld(bPhysicsThread);
+
+	// Within the benchmark mode, install the benchmark probes and start the recording (the camcorder playback is started by the script as soon as the scene has been loaded)
+	if (m_pBenchmark && bResult) {
+		InstallBenchmarkProbes();
+		m_pBenchmark->Start();
+	} else if (bResult && !bPhysicsThread) {
+		// Measure the physics step
+		InstallBenchmarkProbes();
+	}
 
 	// Get the renderer context
 	RendererContext *pRendererContext = GetRendererContext();
 	if (pRendererContext) {
+		TraceScope cMaterialTraceScope("Material patches", "Scene");
+
 		// Give the "DoorGlow" material an animated emissive map for a more impressive god rays effect and enhance the diffuse color for more glow
 		Material *pMaterial = pRendererContext->GetMaterialManager().GetByName("Data\\Materials\\Dungeon\\DoorGlow.mat");
 		if (pMaterial) {
@@ -279,8 +1309,9 @@ bool Application::LoadScene(const String &sFilename)
 //[-------------------------------------------------------]
 void Application::OnCreateScene(SceneContainer &cContainer)
 {
-	// Set scene container flags
-	cContainer.SetFlags(SceneNode::NoCulling);
+	// Without the portal culling, all cells are handed to the renderer
+	if (!GetConfig().GetVar("DungeonConfig", "PortalCulling").GetBool())
+		cContainer.SetFlags(SceneNode::NoCulling);
 
 	// Setup scene surface painter
 	SurfacePainter *pPainter = GetPainter();
@@ -31,6 +31,22 @@
 #include <PLEngine/Application/ScriptApplication.h>
 
 
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+class Benchmark;
+class PhysicsStatistics;
+class RayQueryService;
+class SpatialIndex;
+class PortalCuller;
+class PotentiallyVisibleSet;
+class OcclusionCuller;
+class RenderQueue;
+class InstanceBatcher;
+class CellResidencyManager;
+class ProgressiveSceneLoader;
+
+
 //[-------------------------------------------------------]
 //[ Classes                                               ]
 //[-------------------------------------------------------]
@@ -52,8 +68,23 @@ class Application : public PLEngine::ScriptApplication {
 		pl_method_0(IsRepeatMode,						pl_ret_type(bool),	"Returns whether or not the application runs within the repeat mode. Returns 'true' if the application runs within the repeat mode (\"movie -> making of -> movie\" instead of \"movie -> making of -> interactive\"), else 'false'.",	"")
 		pl_method_0(IsInternalRelease,					pl_ret_type(bool),	"Returns whether or not this is an internal release. Returns 'true' if this is an internal release, else 'false'.",																														"")
 		pl_method_0(UpdateMousePickingPullAnimation,	pl_ret_type(void),	"Updates the mouse picking pull animation",																																																"")
+		pl_method_0(IsBenchmarkMode,					pl_ret_type(bool),				"Returns whether or not the application runs within the benchmark mode. Returns 'true' if the application runs within the benchmark mode (camcorder record playback at a fixed simulated frame rate, then exit), else 'false'.",	"")
+		pl_method_0(GetBenchmarkRecord,					pl_ret_type(PLCore::String),	"Returns the name of the camcorder record played within the benchmark mode, empty string if not within the benchmark mode",																"")
+		pl_method_0(FinishBenchmark,					pl_ret_type(void),				"Finishes the benchmark by writing the recorded timings and exiting the application, does nothing if not within the benchmark mode",												"")
+		pl_method_1(TraceBegin,							pl_ret_type(void),	const PLCore::String&,	"Opens a startup trace scope, scope name as first parameter. Does nothing if the startup is not traced.",																							"")
+		pl_method_0(TraceEnd,							pl_ret_type(void),				"Closes the startup trace scope which was opened last by using \"TraceBegin()\". Does nothing if the startup is not traced.",																	"")
+		pl_method_0(GetPhysicsStepTime,					pl_ret_type(float),				"Returns the smoothed duration of a physics world update (in milliseconds), 0 if it's not measured (the simulation is stepped within an own thread)",						"")
+		pl_method_0(GetPhysicsStatistics,				pl_ret_type(PLCore::String),	"Returns the physics statistics of the loaded scene as string of attribute values (bodies, static, awake and sleeping bodies, joints, physics collision cache hits and misses, physics step time), empty string if there's no loaded scene",	"")
+		pl_method_0(GetCullingStatistics,				pl_ret_type(PLCore::String),	"Returns the portal and occlusion culling counters of the last frame as string of attribute values (visited cells, traversed portals, tested and visible scene nodes, rasterized occluders and their triangles, occlusion tested meshes, tile and pixel hits, occluded meshes), empty string if the portal culling is not used",	"")
+		pl_method_0(GetRenderQueueStatistics,			pl_ret_type(PLCore::String),	"Returns the render queue and instance batching counters of the last frame as string of attribute values (items, materials, meshes, material and mesh switches in scene graph order and in sorted order, radix sort passes and time, batches, instances, draw submissions an instanced draw path would need and save, moved instances), empty string if the render queue is not used",	"")
+		pl_method_2(RayQuery,							pl_ret_type(PLCore::String),	const PLCore::String&,	const PLCore::String&,	"Returns the nearest physics body hit by a ray, ray origin as first parameter and ray direction as second parameter (both within the physics world space, e.g. \"0 1 0\"). Returns the hit as string of attribute values (scene node, distance and position), empty string if nothing was hit.",	"")
 		// Signals
+		pl_signal_2(SignalSceneLoadingStageFinished,	PLCore::uint32,	PLCore::uint32,	"Signal indicating that a stage of the progressive scene loading has been finished, number of finished stages as first parameter, total number of stages as second parameter (the first stage is finished right after \"SignalSceneLoadingFinished\")",	"")
 		pl_signal_2(SignalSetMode,	PLCore::uint32,	bool,	"Signal indicating that a new interaction mode has been chosen, mode index as first parameter(0 = Walk mode, 1 = Free mode, 2 = Ghost mode, 3 = Movie mode, 4 = Making of mode), 'true' as second parameter to show mode changed text",	"")
+		// Slots
+		pl_slot_0(OnBenchmarkUpdateBegin,	"Called when the scene context update starts, used to measure the modifier updates within the benchmark mode",	"")
+		pl_slot_0(OnBenchmarkPhysicsBegin,	"Called before the physics world is updated, used to measure the physics step",									"")
+		pl_slot_0(OnBenchmarkPhysicsEnd,	"Called after the physics world was updated, used to measure the physics step",									"")
 	pl_class_end
 
 
@@ -103,6 +134,119 @@ class Application : public PLEngine::ScriptApplication {
 		*/
 		bool IsInternalRelease() const;
 
+		/**
+		*  @brief
+		*    Returns whether or not the application runs within the benchmark mode
+		*
+		*  @return
+		*    'true' if the application runs within the benchmark mode (camcorder record playback at a fixed simulated frame rate, then exit), else 'false'
+		*/
+		bool IsBenchmarkMode() const;
+
+		/**
+		*  @brief
+		*    Returns the name of the camcorder record played within the benchmark mode
+		*
+		*  @return
+		*    The name of the camcorder record played within the benchmark mode (e.g. "Movie"), empty string if not within the benchmark mode
+		*/
+		PLCore::String GetBenchmarkRecord() const;
+
+		/**
+		*  @brief
+		*    Finishes the benchmark
+		*
+		*  @remarks
+		*    Writes the recorded per-frame timings into "Benchmark<record>.csv" and "Benchmark<record>.json"
+		*    and exits the application. Does nothing if not within the benchmark mode.
+		*/
+		void FinishBenchmark();
+
+		/**
+		*  @brief
+		*    Returns the smoothed duration of a physics world update
+		*
+		*  @return
+		*    The smoothed duration of a physics world update (in milliseconds), 0 if it's not measured
+		*
+		*  @note
+		*    - The physics world update is only measured if the simulation is stepped by the scene context update,
+		*      within an own thread the solver doesn't delay the frame (see "PhysicsThread" configuration)
+		*/
+		float GetPhysicsStepTime() const;
+
+		/**
+		*  @brief
+		*    Returns the physics statistics of the loaded scene as string
+		*
+		*  @return
+		*    The physics statistics of the loaded scene as string, empty string if there's no loaded scene
+		*
+		*  @remarks
+		*    The statistics of "PhysicsStatistics::ToString()" followed by the number of own threads stepping the simulation
+		*    ("PhysicsThreads", 0 if the scene context update steps it) and the physics step time (in milliseconds, see
+		*    "GetPhysicsStepTime()"). If the simulation is stepped within an own thread, the step time isn't measured and
+		*    "StepTime" states that it requires "PhysicsThread=false". The statistics are gathered on each call, don't
+		*    call it each frame.
+		*/
+		PLCore::String GetPhysicsStatistics();
+
+		/**
+		*  @brief
+		*    Returns the nearest physics body hit by a ray
+		*
+		*  @param[in] sOrigin
+		*    Ray origin within the physics world space (e.g. "0 1 0")
+		*  @param[in] sDirection
+		*    Ray direction within the physics world space, doesn't need to be normalized (e.g. "0 0 1")
+		*
+		*  @return
+		*    The hit as string of attribute values, empty string if nothing was hit or there's no loaded scene
+		*    (e.g. "Node=\"Scene.Container.Cell0.Barrel\" Distance=\"4.250\" Position=\"0.000 1.000 4.250\"")
+		*
+		*  @remarks
+		*    The ray is intersected with the triangles of the physics body meshes by using the ray query service
+		*    (see "RayQueryService"), not by using a physics backend ray cast.
+		*/
+		PLCore::String RayQuery(const PLCore::String &sOrigin, const PLCore::String &sDirection);
+
+		/**
+		*  @brief
+		*    Returns the portal and occlusion culling counters of the last frame as string
+		*
+		*  @return
+		*    The counters of "PortalCuller::ToString()" followed by the ones of "OcclusionCuller::ToString()", empty string if the portal culling is not used
+		*/
+		PLCore::String GetCullingStatistics() const;
+
+		/**
+		*  @brief
+		*    Returns the render queue and instance batching counters of the last frame as string
+		*
+		*  @return
+		*    The counters of "RenderQueue::ToString()" followed by the ones of "InstanceBatcher::ToString()", empty string if the render queue is not used
+		*/
+		PLCore::String GetRenderQueueStatistics() const;
+
+		/**
+		*  @brief
+		*    Opens a startup trace scope
+		*
+		*  @param[in] sName
+		*    Scope name
+		*
+		*  @note
+		*    - For scripts, within C++ use "TraceScope" instead
+		*    - Does nothing if the startup is not traced
+		*/
+		void TraceBegin(const PLCore::String &sName);
+
+		/**
+		*  @brief
+		*    Closes the startup trace scope which was opened last by using "TraceBegin()"
+		*/
+		void TraceEnd();
+
 
 	//[-------------------------------------------------------]
 	//[ Private functions                                     ]
@@ -114,12 +258,197 @@ class Application : public PLEngine::ScriptApplication {
 		*/
 		void UpdateMousePickingPullAnimation();
 
+		/**
+		*  @brief
+		*    Returns the native filename of a file compiled from a scene XML file
+		*
+		*  @param[in] sFilename
+		*    Filename of the scene XML file
+		*  @param[in] sExtension
+		*    Extension of the compiled file (e.g. ".bscene" for the binary scene)
+		*  @param[in] bUpToDateOnly
+		*    If 'true', an empty string is returned if the compiled file doesn't exist or is older than the scene XML file
+		*
+		*  @return
+		*    The native filename of the compiled file (next to the scene XML file), empty string on error
+		*/
+		PLCore::String GetCompiledSceneFilename(const PLCore::String &sFilename, const PLCore::String &sExtension, bool bUpToDateOnly) const;
+
+		/**
+		*  @brief
+		*    Creates the cell residency manager
+		*
+		*  @note
+		*    - Does nothing if the scene has no cells
+		*/
+		void CreateCellResidencyManager();
+
+		/**
+		*  @brief
+		*    Creates the ray query service for the physics world
+		*
+		*  @note
+		*    - Does nothing if the scene has no physics world
+		*/
+		void CreateRayQueryService();
+
+		/**
+		*  @brief
+		*    Builds the spatial index over the scene nodes of the cells within the "Container" scene container
+		*
+		*  @note
+		*    - Does nothing if the scene has no "Container" scene container
+		*/
+		void CreateSpatialIndex();
+
+		/**
+		*  @brief
+		*    Builds the portal culler from the cells and cell portals within the "Container" scene container
+		*
+		*  @note
+		*    - Does nothing if the portal culling is disabled within the configuration, there's no spatial index or
+		*      the scene has no cells
+		*    - The potentially visible set ("*.pvs" next to the scene XML file) is used if it's up-to-date
+		*/
+		void CreatePortalCuller();
+
+		/**
+		*  @brief
+		*    Computes the potentially visible set between the cells within the "Container" scene container and writes it next to the scene XML file
+		*
+		*  @param[in] sFilename
+		*    Filename of the scene XML file
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool ComputePotentiallyVisibleSet(const PLCore::String &sFilename);
+
+		/**
+		*  @brief
+		*    Builds the occlusion culler from the occluder meshes within the cells of the portal culler
+		*
+		*  @note
+		*    - Does nothing if the occlusion culling is disabled within the configuration, there's no portal culler or
+		*      the scene has no occluder meshes
+		*/
+		void CreateOcclusionCuller();
+
+		/**
+		*  @brief
+		*    Builds the render queue over the meshes within the cells of the portal culler
+		*
+		*  @note
+		*    - Does nothing if the render queue is disabled within the configuration or there's no portal culler
+		*/
+		void CreateRenderQueue();
+
+		/**
+		*  @brief
+		*    Builds the instance batcher from the repeated static meshes within the cells of the portal culler
+		*
+		*  @note
+		*    - Does nothing if the instance batching is disabled within the configuration, there's no render queue or
+		*      the scene has no meshes to batch
+		*/
+		void CreateInstanceBatcher();
+
+		/**
+		*  @brief
+		*    Passes the movement controls to the character mover of the camera
+		*
+		*  @note
+		*    - Does nothing if the camera has no character mover (only the walk camera has one)
+		*/
+		void UpdateCharacterMover();
+
+		/**
+		*  @brief
+		*    Configures the simulation of the physics world
+		*
+		*  @param[in] bOwnThread
+		*    Step the simulation within an own thread?
+		*
+		*  @remarks
+		*    The simulation is stepped with a fixed time step (see "PhysicsFrameRate" configuration), so the
+		*    simulation results don't depend on the frame rate. If it's stepped within an own thread, the scene
+		*    context update no longer waits for the solver - the physics backend hands the body transforms of the
+		*    last completed step over to the scene nodes.
+		*/
+		void SetupPhysicsWorld(bool bOwnThread);
+
+		/**
+		*  @brief
+		*    Installs the benchmark probes measuring the modifier updates and the physics step
+		*
+		*  @remarks
+		*    The modifier updates and the physics step are both emitted by the scene context update event. The
+		*    physics world update slot is moved to the end of the event, bracketed by the benchmark probes, so the
+		*    time between the first listener and the physics world update is the time used for the modifier updates.
+		*    Outside the benchmark mode, the probes just measure the physics step (see "GetPhysicsStepTime()").
+		*/
+		void InstallBenchmarkProbes();
+
+		/**
+		*  @brief
+		*    Called when the scene context update starts
+		*/
+		void OnBenchmarkUpdateBegin();
+
+		/**
+		*  @brief
+		*    Called before the physics world is updated
+		*/
+		void OnBenchmarkPhysicsBegin();
+
+		/**
+		*  @brief
+		*    Called after the physics world was updated
+		*/
+		void OnBenchmarkPhysicsEnd();
+
+		/**
+		*  @brief
+		*    Console command writing the physics statistics into the log
+		*
+		*  @param[in] cCommand
+		*    Console command
+		*/
+		void ConsoleCommandPhysics(PLEngine::ConsoleCommand &cCommand);
+
+		/**
+		*  @brief
+		*    Console command writing the portal culling counters into the log
+		*
+		*  @param[in] cCommand
+		*    Console command
+		*/
+		void ConsoleCommandCulling(PLEngine::ConsoleCommand &cCommand);
+
+		/**
+		*  @brief
+		*    Console command writing the render queue counters into the log
+		*
+		*  @param[in] cCommand
+		*    Console command
+		*/
+		void ConsoleCommandRenderQueue(PLEngine::ConsoleCommand &cCommand);
+
 
 	//[-------------------------------------------------------]
 	//[ Protected virtual PLCore::CoreApplication functions   ]
 	//[-------------------------------------------------------]
 	protected:
 		virtual void OnInit() override;
+		virtual void OnDeInit() override;
+
+
+	//[-------------------------------------------------------]
+	//[ Protected virtual PLCore::AbstractFrontend functions  ]
+	//[-------------------------------------------------------]
+	protected:
+		virtual void OnDraw() override;
+		virtual void OnUpdate() override;
 
 
 	//[-------------------------------------------------------]
@@ -147,7 +476,24 @@ class Application : public PLEngine::ScriptApplication {
 	//[ Private data                                          ]
 	//[-------------------------------------------------------]
 	private:
-		float m_fMousePickingPullAnimation;	/**< Mouse picking pull animation */
+		float							 m_fMousePickingPullAnimation;	/**< Mouse picking pull animation */
+		Benchmark						*m_pBenchmark;					/**< Benchmark recorder, can be a null pointer (only within the benchmark mode) */
+		PLCore::uint64					 m_nPhysicsStepStartTime;		/**< Time the current physics world update started (in microseconds) */
+		float							 m_fPhysicsStepTime;			/**< Smoothed duration of a physics world update (in milliseconds), 0 if not measured */
+		bool							 m_bPhysicsStepMeasured;		/**< Is the physics world update bracketed by the benchmark probes? (not within an own thread) */
+		PhysicsStatistics				*m_pPhysicsStatistics;			/**< Physics statistics of the loaded scene, can be a null pointer (only if no scene was loaded) */
+		RayQueryService					*m_pRayQueryService;			/**< Ray query service for the physics world, can be a null pointer (only if no scene was loaded) */
+		SpatialIndex					*m_pSpatialIndex;				/**< Spatial index over the scene nodes of the cells, can be a null pointer (only if no scene was loaded) */
+		PortalCuller					*m_pPortalCuller;				/**< Portal culler of the cells, can be a null pointer (only if enabled within the configuration) */
+		OcclusionCuller					*m_pOcclusionCuller;			/**< Occlusion culler of the cells, can be a null pointer (only if enabled within the configuration) */
+		RenderQueue						*m_pRenderQueue;				/**< Render queue of the meshes within the cells, can be a null pointer (only if enabled within the configuration) */
+		InstanceBatcher					*m_pInstanceBatcher;			/**< Instance batcher of the repeated static meshes within the cells, can be a null pointer (only if enabled within the configuration) */
+		PotentiallyVisibleSet			*m_pPotentiallyVisibleSet;		/**< Potentially visible set used by the portal culler, can be a null pointer (only if there's an up-to-date one) */
+		PLCore::String					 m_sSceneFilename;				/**< Filename of the loaded scene XML file */
+		CellResidencyManager			*m_pCellResidencyManager;		/**< Cell residency manager, can be a null pointer (only if enabled within the configuration) */
+		ProgressiveSceneLoader			*m_pProgressiveSceneLoader;		/**< Progressive scene loader, can be a null pointer (only while there are deferred cells to load) */
+		PLCore::String					 m_sHeadlessRendererAPI;		/**< Renderer API which was configured before a headless mode (benchmark, physics cache packing, PVS computation) switched to the null renderer, empty if not headless */
+		PLCore::Array<PLCore::uint32>	 m_lstTraceScopes;				/**< Startup trace scopes opened by the scripts */
 
 
 };
@@ -87,7 +87,32 @@ DungeonConfigGroup &DungeonConfigGroup::operator =(const DungeonConfigGroup &cSo
 */
 DungeonConfig::DungeonConfig() :
 	SoundAPI(this),
-	EditModeEnabled(this)
+	EditModeEnabled(this),
+	LoadingThreads(this),
+	LoadScreenFramesPerSecond(this),
+	ProgressiveLoading(this),
+	ProgressiveStartCell(this),
+	CellResidencyEnabled(this),
+	CellResidencyHops(this),
+	CellResidencyBudget(this),
+	PhysicsCacheArchive(this),
+	MergeStaticCollision(this),
+	SimplifyConvexHulls(this),
+	ConvexHullMaxVertices(this),
+	ConvexHullMaxFaces(this),
+	ConvexHullTolerance(this),
+	PhysicsFrameRate(this),
+	PhysicsSolverQuality(this),
+	PhysicsFreezeBodies(this),
+	PhysicsThread(this),
+	PortalCulling(this),
+	OcclusionCulling(this),
+	OcclusionOccluders(this),
+	OcclusionThreads(this),
+	RenderQueue(this),
+	RenderQueueThreads(this),
+	InstanceBatching(this),
+	InstanceBatchMinInstances(this)
 {
 }
 
@@ -109,7 +134,32 @@ DungeonConfig::~DungeonConfig()
 */
 DungeonConfig::DungeonConfig(const DungeonConfig &cSource) :
 	SoundAPI(this),
-	EditModeEnabled(this)
+	EditModeEnabled(this),
+	LoadingThreads(this),
+	LoadScreenFramesPerSecond(this),
+	ProgressiveLoading(this),
+	ProgressiveStartCell(this),
+	CellResidencyEnabled(this),
+	CellResidencyHops(this),
+	CellResidencyBudget(this),
+	PhysicsCacheArchive(this),
+	MergeStaticCollision(this),
+	SimplifyConvexHulls(this),
+	ConvexHullMaxVertices(this),
+	ConvexHullMaxFaces(this),
+	ConvexHullTolerance(this),
+	PhysicsFrameRate(this),
+	PhysicsSolverQuality(this),
+	PhysicsFreezeBodies(this),
+	PhysicsThread(this),
+	PortalCulling(this),
+	OcclusionCulling(this),
+	OcclusionOccluders(this),
+	OcclusionThreads(this),
+	RenderQueue(this),
+	RenderQueueThreads(this),
+	InstanceBatching(this),
+	InstanceBatchMinInstances(this)
 {
 	// No implementation because the copy constructor is never used
 }
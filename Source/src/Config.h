@@ -116,6 +116,31 @@ class DungeonConfig : public DungeonConfigGroup {
 	#else
 		pl_attribute(EditModeEnabled,	bool,			false,							ReadWrite,	DirectValue,	"Edit mode enabled?",			"")
 	#endif
+		pl_attribute(LoadingThreads,	PLCore::uint32,	4,								ReadWrite,	DirectValue,	"Number of worker threads reading the scene assets in parallel while loading a scene, 0 to disable the parallel asset loading",	"")
+		pl_attribute(LoadScreenFramesPerSecond,	PLCore::uint32,	30,						ReadWrite,	DirectValue,	"Maximum number of load screen frames presented per second while a scene is loaded, frames are only presented on load progress reports (0 to present each report)",			"")
+		pl_attribute(ProgressiveLoading,	bool,		false,							ReadWrite,	DirectValue,	"Load the start cell and its neighbours first and the remaining cells in the background? (compiled binary scenes only)",				"")
+		pl_attribute(ProgressiveStartCell,	PLCore::String,	"Container.kanal3",			ReadWrite,	DirectValue,	"Absolute name of the cell the progressive loading starts with (the walk and movie modes start there), empty string for the cell of the scene start camera",	"")
+		pl_attribute(CellResidencyEnabled,	bool,		false,							ReadWrite,	DirectValue,	"Stream the cells in and out depending on their portal distance to the camera? (for systems with low memory)",						"")
+		pl_attribute(CellResidencyHops,	PLCore::uint32,	2,								ReadWrite,	DirectValue,	"Maximum portal distance of a resident cell to the cell the camera is in (at least 1), evicted cells are made resident again one hop closer",													"")
+		pl_attribute(CellResidencyBudget,	PLCore::uint32,	0,							ReadWrite,	DirectValue,	"GPU memory budget for textures, vertex and index buffers (in MB) used by the cell residency, 0 for no budget",							"")
+		pl_attribute(PhysicsCacheArchive,	PLCore::String,	"../_Cache/PLPhysicsNewton.pcache",	ReadWrite,	DirectValue,	"Physics collision cache archive, restores missing files of the physics cache directory (archive filename without extension) before a scene is loaded, empty string to disable",	"")
+		pl_attribute(MergeStaticCollision,	bool,		true,							ReadWrite,	DirectValue,	"Merge the static mesh bodies of each cell into a single static body when compiling a scene? (fewer bodies within the physics broadphase)",	"")
+		pl_attribute(SimplifyConvexHulls,	bool,		true,							ReadWrite,	DirectValue,	"Let the convex hull bodies use simplified hull meshes instead of their render meshes when compiling a scene? (cheaper contacts, no hull building from render meshes)",	"")
+		pl_attribute(ConvexHullMaxVertices,	PLCore::uint32,	32,							ReadWrite,	DirectValue,	"Maximum number of vertices of a simplified convex hull (at least 4)",																	"")
+		pl_attribute(ConvexHullMaxFaces,	PLCore::uint32,	60,							ReadWrite,	DirectValue,	"Maximum number of faces of a simplified convex hull (at least 4)",																		"")
+		pl_attribute(ConvexHullTolerance,	float,		0.005f,							ReadWrite,	DirectValue,	"Maximum distance between the original and the simplified convex hull (in mesh units)",												"")
+		pl_attribute(PhysicsFrameRate,	float,			60.0f,							ReadWrite,	DirectValue,	"Fixed rate the physics simulation is stepped with (in steps per second), the simulation results don't depend on the frame rate",		"")
+		pl_attribute(PhysicsSolverQuality,	float,		1.0f,							ReadWrite,	DirectValue,	"Physics solver quality, 1 means best realism (exact solver and friction model), 0 means best performance (adaptive solver and friction model)",	"")
+		pl_attribute(PhysicsFreezeBodies,	bool,		true,							ReadWrite,	DirectValue,	"Put the dynamic bodies to sleep as soon as the scene has been loaded? (they're woken up when touched, the physics backend doesn't write back transforms of sleeping bodies)",	"")
+		pl_attribute(PhysicsThread,		bool,			false,							ReadWrite,	DirectValue,	"Step the physics simulation within an own thread? (the frame doesn't wait for the solver, the scene sees the last completed step) Unsafe: The character mover, the progressive scene loading and the cell residency manager are changing physics bodies from the main thread without locking the simulation",	"")
+		pl_attribute(PortalCulling,		bool,			true,							ReadWrite,	DirectValue,	"Hide the cells which can't be seen through the cell portals? (else all cells are handed to the renderer each frame)",					"")
+		pl_attribute(OcclusionCulling,	bool,			true,							ReadWrite,	DirectValue,	"Hide the meshes within the visible cells which are hidden behind the occluder meshes? (requires the portal culling)",					"")
+		pl_attribute(OcclusionOccluders,	PLCore::String,	"Cave_Cave Tunnel",				ReadWrite,	DirectValue,	"Space separated parts of the mesh names of the occluder meshes (large closed meshes such as the caves and tunnels)",				"")
+		pl_attribute(OcclusionThreads,	PLCore::uint32,	4,								ReadWrite,	DirectValue,	"Number of worker threads rasterizing the occluder meshes into the occlusion depth buffer",											"")
+		pl_attribute(RenderQueue,		bool,			false,							ReadWrite,	DirectValue,	"Build and radix sort the render queue of the visible meshes once per frame and count its state changes? (measurement only, the scene renderer still draws in scene graph order, requires the portal culling)",	"")
+		pl_attribute(RenderQueueThreads,	PLCore::uint32,	4,								ReadWrite,	DirectValue,	"Number of worker threads sorting large render queues",															"")
+		pl_attribute(InstanceBatching,	bool,			false,							ReadWrite,	DirectValue,	"Batch the mesh scene nodes which are not animated and share a mesh and its materials? (measurement only, the scene renderer still draws each mesh scene node, requires the render queue)",					"")
+		pl_attribute(InstanceBatchMinInstances,	PLCore::uint32,	8,						ReadWrite,	DirectValue,	"Minimum number of mesh scene nodes sharing a mesh and its materials which are batched (at least 2)",									"")
 		// Constructors
 		pl_constructor_0(DefaultConstructor,	"Default constructor",	"")
 	pl_class_end
@@ -0,0 +1,825 @@
+/*********************************************************\
+ *  File: BinaryScene.cpp                                *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <string.h>	// For "strlen()"
+#include <PLCore/File/File.h>
+#include <PLCore/Base/Class.h>
+#include <PLCore/Base/ClassManager.h>
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/Core/MemoryManager.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include "Tools/Trace.h"
+#include "Loading/BinaryScene.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 LoadProgressInterval = 64;	/**< Number of loaded objects between two load progress reports */
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns whether or not a file is a binary scene of the current format version
+*/
+bool BinaryScene::IsCompatible(const String &sFilename)
+{
+	// Open the file
+	File cFile(sFilename);
+	if (!cFile.Open(File::FileRead))
+		return false; // Error!
+
+	// Check the header
+	Header sHeader;
+	return (cFile.Read(&sHeader, sizeof(Header), 1) == 1 && sHeader.nMagic == Magic && sHeader.nVersion == Version);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+BinaryScene::BinaryScene() :
+	m_nNumOfObjects(0),
+	m_pnData(nullptr),
+	m_nSize(0),
+	m_pHeader(nullptr),
+	m_pLoadContainer(nullptr),
+	m_plstDeferredRecords(nullptr)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+BinaryScene::~BinaryScene()
+{
+}
+
+/**
+*  @brief
+*    Compiles a loaded scene into a binary scene file
+*/
+bool BinaryScene::Save(SceneContainer &cContainer, File &cFile)
+{
+	// Reset the compiler state
+	m_lstStrings.Clear();
+	m_mapStrings.Clear();
+	m_lstRecords.Clear();
+	m_nNumOfObjects = 0;
+
+	// Compile the object records, the root record describes the given scene container itself
+	WriteObject(cContainer, ContainerRecord, NoName);
+
+	// Layout: Header, string offsets, zero terminated UTF-8 strings, object records (4 byte aligned)
+	Header sHeader;
+	sHeader.nMagic         = Magic;
+	sHeader.nVersion       = Version;
+	sHeader.nNumOfStrings  = m_lstStrings.GetNumOfElements();
+	sHeader.nStringsOffset = sizeof(Header);
+	sHeader.nRecordsSize   = m_lstRecords.GetNumOfElements();
+	sHeader.nNumOfObjects  = m_nNumOfObjects;
+	Array<uint32> lstStringOffsets;
+	lstStringOffsets.Resize(sHeader.nNumOfStrings);
+	uint32 nOffset = sHeader.nStringsOffset + sHeader.nNumOfStrings*sizeof(uint32);
+	for (uint32 i=0; i<sHeader.nNumOfStrings; i++) {
+		lstStringOffsets[i] = nOffset;
+		nOffset += static_cast<uint32>(strlen(m_lstStrings[i].GetUTF8())) + 1;
+	}
+	const uint32 nPadding = (4 - (nOffset & 3)) & 3;
+	sHeader.nRecordsOffset = nOffset + nPadding;
+
+	// Write the file
+	bool bResult = (cFile.Write(&sHeader, sizeof(Header), 1) == 1);
+	if (bResult && sHeader.nNumOfStrings)
+		bResult = (cFile.Write(lstStringOffsets.GetData(), sizeof(uint32), sHeader.nNumOfStrings) == sHeader.nNumOfStrings);
+	for (uint32 i=0; i<sHeader.nNumOfStrings && bResult; i++) {
+		const char *pszString = m_lstStrings[i].GetUTF8();
+		const uint32 nLength = static_cast<uint32>(strlen(pszString)) + 1;
+		bResult = (cFile.Write(pszString, 1, nLength) == nLength);
+	}
+	if (bResult && nPadding) {
+		static const uint8 nZero[4] = { 0, 0, 0, 0 };
+		bResult = (cFile.Write(nZero, 1, nPadding) == nPadding);
+	}
+	if (bResult)
+		bResult = (cFile.Write(m_lstRecords.GetData(), 1, sHeader.nRecordsSize) == sHeader.nRecordsSize);
+
+	// Cleanup
+	m_lstStrings.Clear();
+	m_mapStrings.Clear();
+	m_lstRecords.Clear();
+
+	// Done
+	return bResult;
+}
+
+/**
+*  @brief
+*    Opens binary scene data
+*/
+bool BinaryScene::Open(const uint8 *pnData, uint32 nSize)
+{
+	// Reset the loader state
+	m_pnData  = nullptr;
+	m_nSize   = 0;
+	m_pHeader = nullptr;
+	m_lstStrings.Clear();
+	m_lstClasses.Clear();
+
+	// Check the header
+	if (!pnData || nSize < sizeof(Header))
+		return false; // Error!
+	const Header *pHeader = reinterpret_cast<const Header*>(pnData);
+	if (pHeader->nMagic != Magic || pHeader->nVersion != Version)
+		return false; // Error!
+	if (pHeader->nStringsOffset > nSize || pHeader->nNumOfStrings > (nSize - pHeader->nStringsOffset)/sizeof(uint32) ||
+		pHeader->nRecordsOffset > nSize || pHeader->nRecordsSize > nSize - pHeader->nRecordsOffset || pHeader->nRecordsSize < sizeof(ObjectRecord))
+		return false; // Error!
+
+	// Get the strings, they're zero terminated and all in front of the object records
+	const uint32 *pnStringOffsets = reinterpret_cast<const uint32*>(pnData + pHeader->nStringsOffset);
+	m_lstStrings.Resize(pHeader->nNumOfStrings);
+	for (uint32 i=0; i<pHeader->nNumOfStrings; i++) {
+		if (pnStringOffsets[i] >= pHeader->nRecordsOffset) {
+			m_lstStrings.Clear();
+			return false; // Error!
+		}
+		m_lstStrings[i] = String::FromUTF8(reinterpret_cast<const char*>(pnData + pnStringOffsets[i]));
+	}
+
+	// The classes are resolved on first use
+	m_lstClasses.Resize(pHeader->nNumOfStrings);
+	for (uint32 i=0; i<pHeader->nNumOfStrings; i++)
+		m_lstClasses[i] = nullptr;
+
+	// Done
+	m_pnData  = pnData;
+	m_nSize   = nSize;
+	m_pHeader = pHeader;
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the number of strings within the string table
+*/
+uint32 BinaryScene::GetNumOfStrings() const
+{
+	return m_lstStrings.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns a string of the string table
+*/
+String BinaryScene::GetString(uint32 nIndex) const
+{
+	return (nIndex < m_lstStrings.GetNumOfElements()) ? m_lstStrings[nIndex] : "";
+}
+
+/**
+*  @brief
+*    Loads the opened binary scene into a scene container
+*/
+bool BinaryScene::Load(SceneContainer &cContainer, const Array<uint32> *plstDeferredRecords)
+{
+	// Is there an opened binary scene?
+	if (!m_pHeader)
+		return false; // Error!
+
+	// Get the root record, it describes the given scene container itself
+	const uint8 *pnRecord = m_pnData + m_pHeader->nRecordsOffset;
+	ObjectRecord sRecord;
+	MemoryManager::Copy(&sRecord, pnRecord, sizeof(ObjectRecord));
+	if (sRecord.nType != ContainerRecord || sRecord.nSize > m_pHeader->nRecordsSize)
+		return false; // Error!
+
+	// Load the scene
+	m_nNumOfObjects		  = 0;
+	m_pLoadContainer	  = &cContainer;
+	m_plstDeferredRecords = plstDeferredRecords;
+	const bool bResult = ReadObject(cContainer, sRecord, pnRecord, true);
+	m_pLoadContainer	  = nullptr;
+	m_plstDeferredRecords = nullptr;
+
+	// Done
+	cContainer.EventLoadProgress(1.0f);
+	return bResult;
+}
+
+/**
+*  @brief
+*    Loads a single object record (and everything below it) of the opened binary scene into a scene container
+*/
+bool BinaryScene::LoadRecord(SceneContainer &cContainer, uint32 nOffset)
+{
+	// Is there an opened binary scene and is the offset within the object records?
+	if (!m_pHeader || nOffset < m_pHeader->nRecordsOffset || nOffset + sizeof(ObjectRecord) > m_pHeader->nRecordsOffset + m_pHeader->nRecordsSize)
+		return false; // Error!
+
+	// Get the object record, it must be a scene node or scene container record
+	const uint8 *pnRecord = m_pnData + nOffset;
+	ObjectRecord sRecord;
+	MemoryManager::Copy(&sRecord, pnRecord, sizeof(ObjectRecord));
+	if (sRecord.nType == ModifierRecord || sRecord.nSize < sizeof(ObjectRecord) || sRecord.nSize > m_pHeader->nRecordsOffset + m_pHeader->nRecordsSize - nOffset)
+		return false; // Error!
+
+	// Create the scene node
+	const Class *pClass = GetClass(sRecord.nClass);
+	String sParameters;
+	if (!pClass || !GetParameters(sRecord, pnRecord, sParameters))
+		return false; // Error!
+	SceneNode *pSceneNode = cContainer.Create(pClass->GetClassName(), GetString(sRecord.nName), sParameters);
+	return (pSceneNode && ReadObject(*pSceneNode, sRecord, pnRecord, false));
+}
+
+/**
+*  @brief
+*    Returns the size of an attribute value
+*/
+uint32 BinaryScene::GetAttributeValueSize(uint32 nType)
+{
+	switch (nType) {
+		case Vector3Attribute:
+			return 12;
+
+		case Int64Attribute:
+		case UInt64Attribute:
+		case DoubleAttribute:
+			return 8;
+
+		default:
+			return 4;
+	}
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+BinaryScene::BinaryScene(const BinaryScene &cSource) :
+	m_nNumOfObjects(0),
+	m_pnData(nullptr),
+	m_nSize(0),
+	m_pHeader(nullptr),
+	m_pLoadContainer(nullptr),
+	m_plstDeferredRecords(nullptr)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+BinaryScene &BinaryScene::operator =(const BinaryScene &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Adds a string to the string table of the binary scene to compile
+*/
+uint32 BinaryScene::AddString(const String &sString)
+{
+	// Is the string already within the string table? (the first string has the index 0, so check the string itself)
+	const uint32 nIndex = m_mapStrings.Get(sString);
+	if (nIndex < m_lstStrings.GetNumOfElements() && m_lstStrings[nIndex] == sString)
+		return nIndex;
+
+	// Add the string
+	m_lstStrings.Add(sString);
+	m_mapStrings.Add(sString, m_lstStrings.GetNumOfElements() - 1);
+	return m_lstStrings.GetNumOfElements() - 1;
+}
+
+/**
+*  @brief
+*    Appends data to the records of the binary scene to compile
+*/
+void BinaryScene::AppendRecordData(const void *pData, uint32 nSize)
+{
+	const uint32 nOffset = m_lstRecords.GetNumOfElements();
+	m_lstRecords.Resize(nOffset + nSize);
+	MemoryManager::Copy(&m_lstRecords[nOffset], pData, nSize);
+}
+
+/**
+*  @brief
+*    Compiles an object and everything below it into object records
+*/
+void BinaryScene::WriteObject(Object &cObject, ERecordType nType, uint32 nName)
+{
+	// Write the object record, the counts and the size are updated as soon as everything below it was written
+	const uint32 nRecordOffset = m_lstRecords.GetNumOfElements();
+	ObjectRecord sRecord;
+	sRecord.nType            = nType;
+	sRecord.nClass           = AddString(cObject.GetClass()->GetClassName());
+	sRecord.nName            = nName;
+	sRecord.nNumOfAttributes = 0;
+	sRecord.nNumOfModifiers  = 0;
+	sRecord.nNumOfChildren   = 0;
+	sRecord.nSize            = 0;
+	AppendRecordData(&sRecord, sizeof(ObjectRecord));
+	m_nNumOfObjects++;
+
+	// Write the attribute records
+	sRecord.nNumOfAttributes = WriteAttributes(cObject, nType != ModifierRecord);
+
+	// Scene node or scene container?
+	if (nType != ModifierRecord) {
+		SceneNode &cSceneNode = static_cast<SceneNode&>(cObject);
+
+		// Write the modifier records, automatically created modifiers are recreated by their owners
+		for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+			SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+			if (pSceneNodeModifier && !(pSceneNodeModifier->GetFlags() & SceneNodeModifier::Automatic)) {
+				WriteObject(*pSceneNodeModifier, ModifierRecord, NoName);
+				sRecord.nNumOfModifiers++;
+			}
+		}
+
+		// Write the child records, automatically created scene nodes are recreated by their owners
+		if (nType == ContainerRecord) {
+			SceneContainer &cSceneContainer = static_cast<SceneContainer&>(cObject);
+			for (uint32 i=0; i<cSceneContainer.GetNumOfElements(); i++) {
+				SceneNode *pSceneNode = cSceneContainer.GetByIndex(i);
+				if (pSceneNode && !(pSceneNode->GetFlags() & SceneNode::Automatic)) {
+					WriteObject(*pSceneNode, pSceneNode->IsContainer() ? ContainerRecord : NodeRecord, AddString(pSceneNode->GetName()));
+					sRecord.nNumOfChildren++;
+				}
+			}
+		}
+	}
+
+	// Update the object record
+	sRecord.nSize = m_lstRecords.GetNumOfElements() - nRecordOffset;
+	MemoryManager::Copy(&m_lstRecords[nRecordOffset], &sRecord, sizeof(ObjectRecord));
+}
+
+/**
+*  @brief
+*    Compiles the non-default attributes of an object into attribute records
+*/
+uint32 BinaryScene::WriteAttributes(Object &cObject, bool bSceneNode)
+{
+	uint32 nNumOfAttributes = 0;
+
+	// Loop through all attributes
+	Iterator<DynVar*> cIterator = cObject.GetAttributes().GetIterator();
+	while (cIterator.HasNext()) {
+		const DynVar *pDynVar = cIterator.Next();
+
+		// Only attributes with a non-default value are stored, just as within the scene XML
+		if (pDynVar->IsDefault())
+			continue;
+
+		// The name is part of the object record, a filename would load another scene into a scene container
+		const String sName = pDynVar->GetDesc()->GetName();
+		if (sName == "Name" || sName == "Filename")
+			continue;
+
+		// Write the attribute record and the value in it's native form
+		AttributeRecord sAttribute;
+		sAttribute.nName = AddString(sName);
+		if (bSceneNode && (sName == "Position" || sName == "Rotation" || sName == "Scale")) {
+			const SceneNode &cSceneNode = static_cast<const SceneNode&>(cObject);
+			const Vector3 vValue = (sName == "Position") ? cSceneNode.GetPosition() : ((sName == "Rotation") ? cSceneNode.GetRotation() : cSceneNode.GetScale());
+			const float fValue[3] = { vValue.x, vValue.y, vValue.z };
+			sAttribute.nType = Vector3Attribute;
+			AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+			AppendRecordData(fValue, sizeof(fValue));
+		} else {
+			switch (pDynVar->GetTypeID()) {
+				case TypeBool:
+				{
+					const uint32 nValue = pDynVar->GetBool() ? 1 : 0;
+					sAttribute.nType = BoolAttribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&nValue, sizeof(nValue));
+					break;
+				}
+
+				case TypeInt8:
+				case TypeInt16:
+				case TypeInt32:
+				{
+					const int32 nValue = pDynVar->GetInt32();
+					sAttribute.nType = Int32Attribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&nValue, sizeof(nValue));
+					break;
+				}
+
+				case TypeUInt8:
+				case TypeUInt16:
+				case TypeUInt32:
+				{
+					// Flags and enumerations are using unsigned integers as well, they're stored by their names just as within the scene XML
+					const uint32 nValue = pDynVar->GetUInt32();
+					const String sValue = pDynVar->GetString();
+					if (sValue == String(nValue)) {
+						sAttribute.nType = UInt32Attribute;
+						AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+						AppendRecordData(&nValue, sizeof(nValue));
+					} else {
+						const uint32 nString = AddString(sValue);
+						sAttribute.nType = StringAttribute;
+						AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+						AppendRecordData(&nString, sizeof(nString));
+					}
+					break;
+				}
+
+				case TypeInt64:
+				{
+					const int64 nValue = pDynVar->GetInt64();
+					sAttribute.nType = Int64Attribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&nValue, sizeof(nValue));
+					break;
+				}
+
+				case TypeUInt64:
+				{
+					const uint64 nValue = pDynVar->GetUInt64();
+					sAttribute.nType = UInt64Attribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&nValue, sizeof(nValue));
+					break;
+				}
+
+				case TypeFloat:
+				{
+					const float fValue = pDynVar->GetFloat();
+					sAttribute.nType = FloatAttribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&fValue, sizeof(fValue));
+					break;
+				}
+
+				case TypeDouble:
+				{
+					const double dValue = pDynVar->GetDouble();
+					sAttribute.nType = DoubleAttribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&dValue, sizeof(dValue));
+					break;
+				}
+
+				default:
+				{
+					// Strings and everything without a native form (e.g. colors)
+					const uint32 nValue = AddString(pDynVar->GetString());
+					sAttribute.nType = StringAttribute;
+					AppendRecordData(&sAttribute, sizeof(AttributeRecord));
+					AppendRecordData(&nValue, sizeof(nValue));
+					break;
+				}
+			}
+		}
+		nNumOfAttributes++;
+	}
+
+	// Done
+	return nNumOfAttributes;
+}
+
+/**
+*  @brief
+*    Returns the RTTI class of a class name string, the class is resolved only once
+*/
+const Class *BinaryScene::GetClass(uint32 nClass)
+{
+	if (nClass >= m_lstClasses.GetNumOfElements())
+		return nullptr; // Error!
+	if (!m_lstClasses[nClass])
+		m_lstClasses[nClass] = ClassManager::GetInstance()->GetClass(m_lstStrings[nClass]);
+	return m_lstClasses[nClass];
+}
+
+/**
+*  @brief
+*    Returns the attribute records following an object record as parameter string
+*/
+bool BinaryScene::GetParameters(const ObjectRecord &sRecord, const uint8 *pnRecord, String &sParameters) const
+{
+	const uint8 *pnData = pnRecord + sizeof(ObjectRecord);
+	const uint8 *pnEnd  = pnRecord + sRecord.nSize;
+	for (uint32 i=0; i<sRecord.nNumOfAttributes; i++) {
+		// Get the attribute record
+		if (pnData + sizeof(AttributeRecord) > pnEnd)
+			return false; // Error!
+		AttributeRecord sAttribute;
+		MemoryManager::Copy(&sAttribute, pnData, sizeof(AttributeRecord));
+		pnData += sizeof(AttributeRecord);
+		const uint32 nValueSize = GetAttributeValueSize(sAttribute.nType);
+		if (pnData + nValueSize > pnEnd || sAttribute.nName >= m_lstStrings.GetNumOfElements())
+			return false; // Error!
+
+		// Get the value in the form of the scene XML, the RTTI parses it again - floats are written with 9 significant digits so they're restored bit-exact
+		String sValue;
+		switch (sAttribute.nType) {
+			case BoolAttribute:
+			{
+				uint32 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = (nValue != 0) ? "true" : "false";
+				break;
+			}
+
+			case Int32Attribute:
+			{
+				int32 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = nValue;
+				break;
+			}
+
+			case UInt32Attribute:
+			{
+				uint32 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = nValue;
+				break;
+			}
+
+			case Int64Attribute:
+			{
+				int64 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = nValue;
+				break;
+			}
+
+			case UInt64Attribute:
+			{
+				uint64 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = nValue;
+				break;
+			}
+
+			case FloatAttribute:
+			{
+				float fValue;
+				MemoryManager::Copy(&fValue, pnData, sizeof(fValue));
+				sValue = String::Format("%.9g", fValue);
+				break;
+			}
+
+			case DoubleAttribute:
+			{
+				double dValue;
+				MemoryManager::Copy(&dValue, pnData, sizeof(dValue));
+				sValue = String::Format("%.17g", dValue);
+				break;
+			}
+
+			case Vector3Attribute:
+			{
+				float fValue[3];
+				MemoryManager::Copy(fValue, pnData, sizeof(fValue));
+				sValue = String::Format("%.9g %.9g %.9g", fValue[0], fValue[1], fValue[2]);
+				break;
+			}
+
+			case StringAttribute:
+			{
+				uint32 nValue;
+				MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+				sValue = GetString(nValue);
+				break;
+			}
+		}
+		sParameters += m_lstStrings[sAttribute.nName] + "=\"" + sValue + "\" ";
+		pnData += nValueSize;
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Applies the attribute, modifier and child records following an object record
+*/
+bool BinaryScene::ReadObject(Object &cObject, const ObjectRecord &sRecord, const uint8 *pnRecord, bool bAttributes)
+{
+	const uint8 *pnData = pnRecord + sizeof(ObjectRecord);
+	const uint8 *pnEnd  = pnRecord + sRecord.nSize;
+	SceneNode *pSceneNode = (sRecord.nType != ModifierRecord) ? static_cast<SceneNode*>(&cObject) : nullptr;
+
+	// Apply the attributes, objects created with their parameter string just skip them
+	for (uint32 i=0; i<sRecord.nNumOfAttributes; i++) {
+		// Get the attribute record
+		if (pnData + sizeof(AttributeRecord) > pnEnd)
+			return false; // Error!
+		AttributeRecord sAttribute;
+		MemoryManager::Copy(&sAttribute, pnData, sizeof(AttributeRecord));
+		pnData += sizeof(AttributeRecord);
+		const uint32 nValueSize = GetAttributeValueSize(sAttribute.nType);
+		if (pnData + nValueSize > pnEnd || sAttribute.nName >= m_lstStrings.GetNumOfElements())
+			return false; // Error!
+		const String &sName = m_lstStrings[sAttribute.nName];
+
+		// Set the value
+		if (bAttributes) {
+			if (sAttribute.nType == Vector3Attribute) {
+				// The scene node position, rotation and scale are set directly
+				if (pSceneNode) {
+					float fValue[3];
+					MemoryManager::Copy(fValue, pnData, sizeof(fValue));
+					const Vector3 vValue(fValue[0], fValue[1], fValue[2]);
+					if (sName == "Position")
+						pSceneNode->SetPosition(vValue);
+					else if (sName == "Rotation")
+						pSceneNode->SetRotation(vValue);
+					else if (sName == "Scale")
+						pSceneNode->SetScale(vValue);
+				}
+			} else {
+				DynVar *pDynVar = cObject.GetAttribute(sName);
+				if (pDynVar) {
+					switch (sAttribute.nType) {
+						case BoolAttribute:
+						{
+							uint32 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetBool(nValue != 0);
+							break;
+						}
+
+						case Int32Attribute:
+						{
+							int32 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetInt32(nValue);
+							break;
+						}
+
+						case UInt32Attribute:
+						{
+							uint32 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetUInt32(nValue);
+							break;
+						}
+
+						case Int64Attribute:
+						{
+							int64 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetInt64(nValue);
+							break;
+						}
+
+						case UInt64Attribute:
+						{
+							uint64 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetUInt64(nValue);
+							break;
+						}
+
+						case FloatAttribute:
+						{
+							float fValue;
+							MemoryManager::Copy(&fValue, pnData, sizeof(fValue));
+							pDynVar->SetFloat(fValue);
+							break;
+						}
+
+						case DoubleAttribute:
+						{
+							double dValue;
+							MemoryManager::Copy(&dValue, pnData, sizeof(dValue));
+							pDynVar->SetDouble(dValue);
+							break;
+						}
+
+						case StringAttribute:
+						{
+							uint32 nValue;
+							MemoryManager::Copy(&nValue, pnData, sizeof(nValue));
+							pDynVar->SetString(GetString(nValue));
+							break;
+						}
+					}
+				}
+			}
+		}
+		pnData += nValueSize;
+	}
+
+	// Add the modifiers
+	for (uint32 i=0; i<sRecord.nNumOfModifiers; i++) {
+		// Get the modifier record
+		if (pnData + sizeof(ObjectRecord) > pnEnd)
+			return false; // Error!
+		ObjectRecord sModifierRecord;
+		MemoryManager::Copy(&sModifierRecord, pnData, sizeof(ObjectRecord));
+		if (sModifierRecord.nSize < sizeof(ObjectRecord) || pnData + sModifierRecord.nSize > pnEnd)
+			return false; // Error!
+
+		// Add the modifier with its attributes, physics bodies are traced as physics because they're reading the physics cache
+		const Class *pClass = GetClass(sModifierRecord.nClass);
+		if (pSceneNode && pClass) {
+			String sParameters;
+			if (!GetParameters(sModifierRecord, pnData, sParameters))
+				return false; // Error!
+			TraceScope cTraceScope(pClass->GetClassName(), (Trace::IsEnabled() && pClass->IsDerivedFrom("PLPhysics::SNMPhysicsBody")) ? "Physics" : "Scene", pSceneNode->GetName());
+			SceneNodeModifier *pSceneNodeModifier = pSceneNode->AddModifier(pClass->GetClassName(), sParameters);
+			if (pSceneNodeModifier && !ReadObject(*pSceneNodeModifier, sModifierRecord, pnData, false))
+				return false; // Error!
+		}
+		pnData += sModifierRecord.nSize;
+	}
+
+	// Create the child scene nodes
+	for (uint32 i=0; i<sRecord.nNumOfChildren; i++) {
+		// Get the child record
+		if (pnData + sizeof(ObjectRecord) > pnEnd)
+			return false; // Error!
+		ObjectRecord sChildRecord;
+		MemoryManager::Copy(&sChildRecord, pnData, sizeof(ObjectRecord));
+		if (sChildRecord.nSize < sizeof(ObjectRecord) || pnData + sChildRecord.nSize > pnEnd)
+			return false; // Error!
+
+		// Create the child scene node with its attributes, deferred object records are skipped
+		const Class *pClass = GetClass(sChildRecord.nClass);
+		if (sRecord.nType == ContainerRecord && pClass && !(m_plstDeferredRecords && m_plstDeferredRecords->IsElement(static_cast<uint32>(pnData - m_pnData)))) {
+			String sParameters;
+			if (!GetParameters(sChildRecord, pnData, sParameters))
+				return false; // Error!
+			TraceScope cTraceScope(pClass->GetClassName(), "Scene", GetString(sChildRecord.nName));
+			SceneNode *pChildSceneNode = static_cast<SceneContainer&>(cObject).Create(pClass->GetClassName(), GetString(sChildRecord.nName), sParameters);
+			if (pChildSceneNode && !ReadObject(*pChildSceneNode, sChildRecord, pnData, false))
+				return false; // Error!
+		}
+		pnData += sChildRecord.nSize;
+	}
+
+	// Report the load progress
+	m_nNumOfObjects++;
+	if (!(m_nNumOfObjects % LoadProgressInterval))
+		UpdateLoadProgress();
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Reports the load progress
+*/
+void BinaryScene::UpdateLoadProgress()
+{
+	if (m_pLoadContainer && m_pHeader && m_pHeader->nNumOfObjects)
+		m_pLoadContainer->EventLoadProgress(static_cast<float>(m_nNumOfObjects)/m_pHeader->nNumOfObjects);
+}
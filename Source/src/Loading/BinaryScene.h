@@ -0,0 +1,425 @@
+/*********************************************************\
+ *  File: BinaryScene.h                                  *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_BINARYSCENE_H__
+#define __DUNGEON_BINARYSCENE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/HashMap.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLCore {
+	class File;
+	class Class;
+	class Object;
+}
+namespace PLScene {
+	class SceneNode;
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Compiled binary scene
+*
+*  @remarks
+*    The binary scene is a flat, compiled form of a scene XML file. It consists of a header, a string table and a
+*    tree of object records (containers, nodes and modifiers) in the order of the scene. Each object record is followed
+*    by its attribute records, modifier records and child records. Class names and attribute names are string table
+*    indices which are resolved only once per class, attribute values are stored in their native form (e.g. floats
+*    and integers). Flags, enumerations and attributes with non-RTTI types (such as colors) are stored as strings.
+*    All data is 4 byte aligned and stored in the byte order of the platform the scene was compiled on.
+*
+*    Just as within the scene XML loader, each scene node and modifier is created with its attributes as parameter
+*    string, so it's initialized only once with its final attributes (e.g. a physics body isn't built with default
+*    attributes first and rebuilt as soon as its attributes are set). The RTTI creates objects only from a parameter
+*    string, the typed values can't be handed over before the object is initialized - so the stored values are turned
+*    back into text and parsed by the RTTI while loading (floats are written with 9 significant digits, which restores
+*    them bit-exact). What the binary scene saves is the XML parsing, the class lookups and the file reading.
+*
+*    The XML stays the authoring format, the binary scene is compiled from a loaded scene and only written by
+*    the compiler - so it can be used directly from a read-only memory mapped file.
+*/
+class BinaryScene {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 Magic   = 0x53424C50;	/**< Binary scene magic number ("PLBS") */
+		static const PLCore::uint32 Version = 2;			/**< Binary scene format version */
+		static const PLCore::uint32 NoName  = 0xFFFFFFFF;	/**< String table index used for unnamed objects */
+
+		/**
+		*  @brief
+		*    Object record types
+		*/
+		enum ERecordType {
+			ContainerRecord = 0,	/**< Scene container, may have child records */
+			NodeRecord      = 1,	/**< Scene node */
+			ModifierRecord  = 2		/**< Scene node modifier */
+		};
+
+		/**
+		*  @brief
+		*    Attribute value types
+		*/
+		enum EAttributeType {
+			BoolAttribute    = 0,	/**< Boolean, stored as 32 bit integer */
+			Int32Attribute   = 1,	/**< Signed 32 bit integer (also used for smaller integers) */
+			UInt32Attribute  = 2,	/**< Unsigned 32 bit integer (also used for smaller integers, flags and enumerations) */
+			Int64Attribute   = 3,	/**< Signed 64 bit integer */
+			UInt64Attribute  = 4,	/**< Unsigned 64 bit integer */
+			FloatAttribute   = 5,	/**< Float */
+			DoubleAttribute  = 6,	/**< Double */
+			Vector3Attribute = 7,	/**< Three floats, used for the scene node position, rotation and scale */
+			StringAttribute  = 8	/**< String table index, used for all other types */
+		};
+
+		/**
+		*  @brief
+		*    File header
+		*/
+		struct Header {
+			PLCore::uint32 nMagic;				/**< Magic number, must be "Magic" */
+			PLCore::uint32 nVersion;			/**< Format version, must be "Version" */
+			PLCore::uint32 nNumOfStrings;		/**< Number of strings within the string table */
+			PLCore::uint32 nStringsOffset;		/**< Offset of the string offsets (one 32 bit offset per string, relative to the file start) */
+			PLCore::uint32 nRecordsOffset;		/**< Offset of the root object record */
+			PLCore::uint32 nRecordsSize;		/**< Size of the object records (in bytes) */
+			PLCore::uint32 nNumOfObjects;		/**< Total number of object records, used for the load progress */
+		};
+
+		/**
+		*  @brief
+		*    Object record
+		*/
+		struct ObjectRecord {
+			PLCore::uint32 nType;				/**< Record type (see "ERecordType") */
+			PLCore::uint32 nClass;				/**< String table index of the class name */
+			PLCore::uint32 nName;				/**< String table index of the object name, "NoName" for modifiers and the root */
+			PLCore::uint32 nNumOfAttributes;	/**< Number of attribute records following this record */
+			PLCore::uint32 nNumOfModifiers;		/**< Number of modifier records following the attribute records */
+			PLCore::uint32 nNumOfChildren;		/**< Number of child records following the modifier records */
+			PLCore::uint32 nSize;				/**< Size of this record including all following attribute, modifier and child records (in bytes) */
+		};
+
+		/**
+		*  @brief
+		*    Attribute record, followed by the value (4, 8 or 12 bytes, depending on the type)
+		*/
+		struct AttributeRecord {
+			PLCore::uint32 nName;				/**< String table index of the attribute name */
+			PLCore::uint32 nType;				/**< Value type (see "EAttributeType") */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns whether or not a file is a binary scene of the current format version
+		*
+		*  @param[in] sFilename
+		*    Binary scene filename
+		*
+		*  @return
+		*    'true' if the file is a binary scene of the current format version, else 'false' (e.g. compiled by an older version)
+		*/
+		static bool IsCompatible(const PLCore::String &sFilename);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		BinaryScene();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~BinaryScene();
+
+		/**
+		*  @brief
+		*    Compiles a loaded scene into a binary scene file
+		*
+		*  @param[in] cContainer
+		*    Scene container to compile, automatically created scene nodes and modifiers are ignored
+		*  @param[in] cFile
+		*    File to write into, must be opened for writing
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool Save(PLScene::SceneContainer &cContainer, PLCore::File &cFile);
+
+		/**
+		*  @brief
+		*    Opens binary scene data
+		*
+		*  @param[in] pnData
+		*    Binary scene data (e.g. a memory mapped binary scene file), must stay valid as long as it's used by this instance
+		*  @param[in] nSize
+		*    Size of the binary scene data (in bytes)
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (invalid binary scene data)
+		*/
+		bool Open(const PLCore::uint8 *pnData, PLCore::uint32 nSize);
+
+		/**
+		*  @brief
+		*    Returns the number of strings within the string table
+		*
+		*  @return
+		*    The number of strings within the string table
+		*/
+		PLCore::uint32 GetNumOfStrings() const;
+
+		/**
+		*  @brief
+		*    Returns a string of the string table
+		*
+		*  @param[in] nIndex
+		*    String table index
+		*
+		*  @return
+		*    The string, empty string on error
+		*/
+		PLCore::String GetString(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Loads the opened binary scene into a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container to load into, receives the attributes and modifiers of the root record
+		*  @param[in] plstDeferredRecords
+		*    Offsets (relative to the data start) of object records which are skipped and can be loaded later on by using "LoadRecord()", can be a null pointer
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool Load(PLScene::SceneContainer &cContainer, const PLCore::Array<PLCore::uint32> *plstDeferredRecords = nullptr);
+
+		/**
+		*  @brief
+		*    Loads a single object record (and everything below it) of the opened binary scene into a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container to create the scene node of the object record in
+		*  @param[in] nOffset
+		*    Offset (relative to the data start) of a scene node or scene container object record, usually a deferred one
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*
+		*  @note
+		*    - No load progress is reported
+		*/
+		bool LoadRecord(PLScene::SceneContainer &cContainer, PLCore::uint32 nOffset);
+
+		/**
+		*  @brief
+		*    Returns the size of an attribute value
+		*
+		*  @param[in] nType
+		*    Attribute value type (see "EAttributeType")
+		*
+		*  @return
+		*    The size of the attribute value following the attribute record (in bytes)
+		*/
+		static PLCore::uint32 GetAttributeValueSize(PLCore::uint32 nType);
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		BinaryScene(const BinaryScene &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		BinaryScene &operator =(const BinaryScene &cSource);
+
+		/**
+		*  @brief
+		*    Adds a string to the string table of the binary scene to compile
+		*
+		*  @param[in] sString
+		*    String to add
+		*
+		*  @return
+		*    String table index, strings are only added once
+		*/
+		PLCore::uint32 AddString(const PLCore::String &sString);
+
+		/**
+		*  @brief
+		*    Appends data to the records of the binary scene to compile
+		*
+		*  @param[in] pData
+		*    Data to append
+		*  @param[in] nSize
+		*    Size of the data to append (in bytes)
+		*/
+		void AppendRecordData(const void *pData, PLCore::uint32 nSize);
+
+		/**
+		*  @brief
+		*    Compiles an object and everything below it into object records
+		*
+		*  @param[in] cObject
+		*    Object to compile (scene container, scene node or scene node modifier)
+		*  @param[in] nType
+		*    Record type
+		*  @param[in] nName
+		*    String table index of the object name, "NoName" for unnamed objects
+		*/
+		void WriteObject(PLCore::Object &cObject, ERecordType nType, PLCore::uint32 nName);
+
+		/**
+		*  @brief
+		*    Compiles the non-default attributes of an object into attribute records
+		*
+		*  @param[in] cObject
+		*    Object to compile the attributes from
+		*  @param[in] bSceneNode
+		*    Is the object a scene node? (the position, rotation and scale are stored as native vectors)
+		*
+		*  @return
+		*    The number of written attribute records
+		*/
+		PLCore::uint32 WriteAttributes(PLCore::Object &cObject, bool bSceneNode);
+
+		/**
+		*  @brief
+		*    Returns the RTTI class of a class name string, the class is resolved only once
+		*
+		*  @param[in] nClass
+		*    String table index of the class name
+		*
+		*  @return
+		*    The RTTI class, null pointer on error
+		*/
+		const PLCore::Class *GetClass(PLCore::uint32 nClass);
+
+		/**
+		*  @brief
+		*    Returns the attribute records following an object record as parameter string
+		*
+		*  @param[in]  sRecord
+		*    Object record
+		*  @param[in]  pnRecord
+		*    Begin of the object record data
+		*  @param[out] sParameters
+		*    Receives the attributes in the form of the scene XML (e.g. "Position=\"1 2 3\" Flags=\"CastShadow\""), the string is not cleared
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (invalid record data)
+		*/
+		bool GetParameters(const ObjectRecord &sRecord, const PLCore::uint8 *pnRecord, PLCore::String &sParameters) const;
+
+		/**
+		*  @brief
+		*    Applies the attribute, modifier and child records following an object record
+		*
+		*  @param[in] cObject
+		*    Object to apply the records to
+		*  @param[in] sRecord
+		*    Object record of the object
+		*  @param[in] pnRecord
+		*    Begin of the object record data
+		*  @param[in] bAttributes
+		*    Apply the attribute records by their typed values? 'false' if the object was already created with them (see "GetParameters()")
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (invalid record data)
+		*/
+		bool ReadObject(PLCore::Object &cObject, const ObjectRecord &sRecord, const PLCore::uint8 *pnRecord, bool bAttributes);
+
+		/**
+		*  @brief
+		*    Reports the load progress
+		*/
+		void UpdateLoadProgress();
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<PLCore::String>					 m_lstStrings;			/**< String table of the binary scene to compile or of the opened binary scene */
+		PLCore::uint32									 m_nNumOfObjects;		/**< Number of compiled or loaded objects */
+		// Compiler
+		PLCore::HashMap<PLCore::String, PLCore::uint32>	 m_mapStrings;			/**< String table indices by string */
+		PLCore::Array<PLCore::uint8>					 m_lstRecords;			/**< Object records of the binary scene to compile */
+		// Loader
+		const PLCore::uint8								*m_pnData;				/**< Opened binary scene data, can be a null pointer */
+		PLCore::uint32									 m_nSize;				/**< Size of the opened binary scene data (in bytes) */
+		const Header									*m_pHeader;				/**< Header of the opened binary scene, can be a null pointer */
+		PLCore::Array<const PLCore::Class*>				 m_lstClasses;			/**< Resolved classes by string table index, null pointer if not resolved yet */
+		PLScene::SceneContainer							*m_pLoadContainer;		/**< Scene container currently loaded into, can be a null pointer */
+		const PLCore::Array<PLCore::uint32>				*m_plstDeferredRecords;	/**< Offsets of the object records to skip while loading, can be a null pointer */
+
+
+};
+
+
+#endif // __DUNGEON_BINARYSCENE_H__
@@ -0,0 +1,153 @@
+/*********************************************************\
+ *  File: LoadScreenPresenter.cpp                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/System/System.h>
+#include <PLCore/Frontend/Frontend.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Loading/LoadScreenPresenter.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+LoadScreenPresenter::LoadScreenPresenter(Frontend &cFrontend, SceneContainer &cContainer, uint32 nFramesPerSecond) :
+	EventHandlerLoadProgress(&LoadScreenPresenter::OnLoadProgress, this),
+	m_pFrontend(&cFrontend),
+	m_nFrameInterval(nFramesPerSecond ? 1000/nFramesPerSecond : 0),
+	m_nLastFrameTime(0),
+	m_fPhaseBegin(0.0f),
+	m_fPhaseEnd(1.0f),
+	m_fProgress(0.0f),
+	m_nNumOfPresentedFrames(0),
+	m_bPresenting(false)
+{
+	// Connect the event handler, it's disconnected automatically as soon as this instance is destroyed
+	cContainer.EventLoadProgress.Connect(EventHandlerLoadProgress);
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+LoadScreenPresenter::~LoadScreenPresenter()
+{
+}
+
+/**
+*  @brief
+*    Returns the last published overall load progress
+*/
+float LoadScreenPresenter::GetProgress() const
+{
+	return m_fProgress;
+}
+
+/**
+*  @brief
+*    Sets the range of the overall load progress the following progress reports are mapped onto
+*/
+void LoadScreenPresenter::SetPhase(float fBegin, float fEnd)
+{
+	m_fPhaseBegin = fBegin;
+	m_fPhaseEnd   = fEnd;
+}
+
+/**
+*  @brief
+*    Returns the number of presented load screen frames
+*/
+uint32 LoadScreenPresenter::GetNumOfPresentedFrames() const
+{
+	return m_nNumOfPresentedFrames;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+LoadScreenPresenter::LoadScreenPresenter(const LoadScreenPresenter &cSource) :
+	EventHandlerLoadProgress(&LoadScreenPresenter::OnLoadProgress, this),
+	m_pFrontend(nullptr),
+	m_nFrameInterval(0),
+	m_nLastFrameTime(0),
+	m_fPhaseBegin(0.0f),
+	m_fPhaseEnd(1.0f),
+	m_fProgress(0.0f),
+	m_nNumOfPresentedFrames(0),
+	m_bPresenting(false)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+LoadScreenPresenter &LoadScreenPresenter::operator =(const LoadScreenPresenter &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Called when the load progress has changed
+*/
+void LoadScreenPresenter::OnLoadProgress(float fProgress)
+{
+	// Map the progress of the current loading phase onto the overall progress
+	const float fOverallProgress = m_fPhaseBegin + fProgress*(m_fPhaseEnd - m_fPhaseBegin);
+	const bool bFinal = (fOverallProgress >= 1.0f && m_fProgress < 1.0f);
+	m_fProgress = fOverallProgress;
+
+	// Time for a frame? (the first and the final progress are always presented)
+	if (!m_bPresenting) {
+		const uint64 nTime = System::GetInstance()->GetMilliseconds();
+		if (!m_nNumOfPresentedFrames || bFinal || nTime - m_nLastFrameTime >= m_nFrameInterval) {
+			m_nLastFrameTime = nTime;
+			m_nNumOfPresentedFrames++;
+
+			// Redraw & ping the frontend
+			m_bPresenting = true;
+			m_pFrontend->RedrawAndPing();
+			m_bPresenting = false;
+		}
+	}
+}
@@ -0,0 +1,181 @@
+/*********************************************************\
+ *  File: LoadScreenPresenter.h                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_LOADSCREENPRESENTER_H__
+#define __DUNGEON_LOADSCREENPRESENTER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Event/EventHandler.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLCore {
+	class Frontend;
+}
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Load screen presenter, limits the number of load screen frames presented while a scene is loaded
+*
+*  @remarks
+*    The scene loader reports the load progress through the load progress event of the scene container it's
+*    loading into, the scene preloader reports the preload progress through the same event before. Both report
+*    0.0-1.0, the presenter maps the report of the current loading phase onto one overall progress (see "SetPhase()",
+*    e.g. preloading 0.0-0.5 and loading 0.5-1.0). On a progress report, a frame is presented only if the last
+*    presented frame is older than the frame interval - the time the loader spends on presenting the load screen is
+*    bounded by the frame rate and no longer depends on the granularity of the progress reports.
+*    The first and the final progress report are always presented.
+*
+*  @note
+*    - The renderer context belongs to the thread which created it, so the load screen is presented by the
+*      loading thread when it publishes progress - there's no timer, the load screen doesn't change between two
+*      progress reports (e.g. while a large mesh is loaded)
+*/
+class LoadScreenPresenter {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] cFrontend
+		*    Frontend to present the load screen in, must stay valid as long as this instance exists
+		*  @param[in] cContainer
+		*    Scene container which is going to be loaded, must stay valid as long as this instance exists
+		*  @param[in] nFramesPerSecond
+		*    Maximum number of presented load screen frames per second, 0 to present each progress report
+		*/
+		LoadScreenPresenter(PLCore::Frontend &cFrontend, PLScene::SceneContainer &cContainer, PLCore::uint32 nFramesPerSecond);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~LoadScreenPresenter();
+
+		/**
+		*  @brief
+		*    Returns the last published overall load progress
+		*
+		*  @return
+		*    The last published overall load progress (0.0-1.0)
+		*/
+		float GetProgress() const;
+
+		/**
+		*  @brief
+		*    Sets the range of the overall load progress the following progress reports are mapped onto
+		*
+		*  @param[in] fBegin
+		*    Overall load progress at the begin of the loading phase (0.0-1.0)
+		*  @param[in] fEnd
+		*    Overall load progress at the end of the loading phase (0.0-1.0), not smaller than "fBegin"
+		*/
+		void SetPhase(float fBegin, float fEnd);
+
+		/**
+		*  @brief
+		*    Returns the number of presented load screen frames
+		*
+		*  @return
+		*    The number of presented load screen frames
+		*/
+		PLCore::uint32 GetNumOfPresentedFrames() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		LoadScreenPresenter(const LoadScreenPresenter &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		LoadScreenPresenter &operator =(const LoadScreenPresenter &cSource);
+
+		/**
+		*  @brief
+		*    Called when the load progress has changed
+		*
+		*  @param[in] fProgress
+		*    Load progress of the current loading phase (0.0-1.0)
+		*/
+		void OnLoadProgress(float fProgress);
+
+
+	//[-------------------------------------------------------]
+	//[ Private event handlers                                ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::EventHandler<float> EventHandlerLoadProgress;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Frontend *m_pFrontend;				/**< Frontend to present the load screen in, always valid */
+		PLCore::uint64	  m_nFrameInterval;			/**< Minimum time between two presented frames (in milliseconds) */
+		PLCore::uint64	  m_nLastFrameTime;			/**< Time the last frame was presented (in milliseconds) */
+		float			  m_fPhaseBegin;			/**< Overall load progress at the begin of the current loading phase (0.0-1.0) */
+		float			  m_fPhaseEnd;				/**< Overall load progress at the end of the current loading phase (0.0-1.0) */
+		float			  m_fProgress;				/**< Last published overall load progress (0.0-1.0) */
+		PLCore::uint32	  m_nNumOfPresentedFrames;	/**< Number of presented load screen frames */
+		bool			  m_bPresenting;			/**< Currently presenting a frame? (the frontend ping may report progress as well) */
+
+
+};
+
+
+#endif // __DUNGEON_LOADSCREENPRESENTER_H__
@@ -0,0 +1,428 @@
+/*********************************************************\
+ *  File: ProgressiveSceneLoader.cpp                     *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/File.h>
+#include <PLCore/Base/Class.h>
+#include <PLCore/Base/ClassManager.h>
+#include <PLCore/Container/Queue.h>
+#include <PLCore/Core/MemoryManager.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Loading/ProgressiveSceneLoader.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Private static data                                   ]
+//[-------------------------------------------------------]
+ProgressiveSceneLoader *ProgressiveSceneLoader::m_pCurrent = nullptr;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the current progressive scene loader
+*/
+ProgressiveSceneLoader *ProgressiveSceneLoader::GetCurrent()
+{
+	return m_pCurrent;
+}
+
+/**
+*  @brief
+*    Sets the current progressive scene loader
+*/
+void ProgressiveSceneLoader::SetCurrent(ProgressiveSceneLoader *pProgressiveSceneLoader)
+{
+	m_pCurrent = pProgressiveSceneLoader;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+ProgressiveSceneLoader::ProgressiveSceneLoader(const String &sStartCell) :
+	m_sStartCell(sStartCell),
+	m_pnData(nullptr),
+	m_nSize(0),
+	m_nNextDeferredCell(0),
+	m_nNumOfStages(0),
+	m_nNumOfFinishedStages(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+ProgressiveSceneLoader::~ProgressiveSceneLoader()
+{
+	// Destroy all cells
+	Clear();
+
+	// Don't leave a dangling current progressive scene loader behind
+	if (m_pCurrent == this)
+		m_pCurrent = nullptr;
+}
+
+/**
+*  @brief
+*    Loads the first stage of a binary scene
+*/
+bool ProgressiveSceneLoader::Load(SceneContainer &cContainer, File &cFile)
+{
+	// Destroy the previous cells and close the previous binary scene
+	Clear();
+
+	// Map the file into memory, the deferred cells are loaded from the mapped data later on
+	if (cFile.GetUrl().IsValidNativePath() && m_cMemoryMappedFile.Open(cFile.GetUrl().GetNativePath())) {
+		m_pnData = m_cMemoryMappedFile.GetData();
+		m_nSize  = m_cMemoryMappedFile.GetSize();
+	} else {
+		// Read the file into memory
+		m_lstData.Resize(cFile.GetSize());
+		if (!m_lstData.GetNumOfElements() || cFile.Read(m_lstData.GetData(), 1, m_lstData.GetNumOfElements()) != m_lstData.GetNumOfElements())
+			return false; // Error!
+		m_pnData = m_lstData.GetData();
+		m_nSize  = m_lstData.GetNumOfElements();
+	}
+	if (!m_cBinaryScene.Open(m_pnData, m_nSize))
+		return false; // Error!
+
+	// Collect the cells, their cell portals and the start camera, the header was already checked by the binary scene
+	const BinaryScene::Header *pHeader = reinterpret_cast<const BinaryScene::Header*>(m_pnData);
+	if (!ScanRecord(pHeader->nRecordsOffset, "", nullptr))
+		return false; // Error!
+
+	// Get the start cell
+	const int nStartCell = GetCellIndex(m_sStartCell.GetLength() ? m_sStartCell : m_sStartCamera);
+	if (nStartCell < 0) {
+		// Load the whole scene at once
+		m_nNumOfStages		   = 1;
+		m_nNumOfFinishedStages = 1;
+		return m_cBinaryScene.Load(cContainer);
+	}
+
+	// Assign the stages and collect the deferred cells
+	AssignStages(nStartCell);
+	Array<uint32> lstDeferredRecords;
+	for (uint32 i=0; i<m_lstDeferredCells.GetNumOfElements(); i++)
+		lstDeferredRecords.Add(m_lstDeferredCells[i]->nOffset);
+
+	// Load the first stage
+	m_cContainer.SetElement(&cContainer);
+	m_nNumOfFinishedStages = 1;
+	return m_cBinaryScene.Load(cContainer, &lstDeferredRecords);
+}
+
+/**
+*  @brief
+*    Returns whether or not there are still deferred cells to load
+*/
+bool ProgressiveSceneLoader::IsLoading() const
+{
+	return (m_nNextDeferredCell < m_lstDeferredCells.GetNumOfElements());
+}
+
+/**
+*  @brief
+*    Returns the total number of stages
+*/
+uint32 ProgressiveSceneLoader::GetNumOfStages() const
+{
+	return m_nNumOfStages;
+}
+
+/**
+*  @brief
+*    Returns the number of finished stages
+*/
+uint32 ProgressiveSceneLoader::GetNumOfFinishedStages() const
+{
+	return m_nNumOfFinishedStages;
+}
+
+/**
+*  @brief
+*    Loads the next deferred cell
+*/
+bool ProgressiveSceneLoader::Update()
+{
+	// Are there still deferred cells to load?
+	if (m_nNextDeferredCell >= m_lstDeferredCells.GetNumOfElements())
+		return false;
+	const Cell &cCell = *m_lstDeferredCells[m_nNextDeferredCell];
+	m_nNextDeferredCell++;
+
+	// Get the scene container the cell is in and load the cell into it
+	SceneContainer *pContainer = static_cast<SceneContainer*>(m_cContainer.GetElement());
+	if (pContainer) {
+		SceneNode *pParent = cCell.sParent.GetLength() ? pContainer->GetByName(cCell.sParent) : pContainer;
+		if (pParent && pParent->IsContainer())
+			m_cBinaryScene.LoadRecord(static_cast<SceneContainer&>(*pParent), cCell.nOffset);
+	}
+
+	// Has the stage been finished?
+	if (m_nNextDeferredCell >= m_lstDeferredCells.GetNumOfElements() || m_lstDeferredCells[m_nNextDeferredCell]->nStage != cCell.nStage) {
+		m_nNumOfFinishedStages++;
+		return true;
+	}
+
+	// Done
+	return false;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+ProgressiveSceneLoader::ProgressiveSceneLoader(const ProgressiveSceneLoader &cSource) :
+	m_pnData(nullptr),
+	m_nSize(0),
+	m_nNextDeferredCell(0),
+	m_nNumOfStages(0),
+	m_nNumOfFinishedStages(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+ProgressiveSceneLoader &ProgressiveSceneLoader::operator =(const ProgressiveSceneLoader &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Destroys all cells
+*/
+void ProgressiveSceneLoader::Clear()
+{
+	// Destroy all cells
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+	m_lstDeferredCells.Clear();
+	m_nNextDeferredCell	   = 0;
+	m_nNumOfStages		   = 0;
+	m_nNumOfFinishedStages = 0;
+	m_sStartCamera		   = "";
+	m_cContainer.SetElement(nullptr);
+
+	// Close the binary scene data
+	m_cMemoryMappedFile.Close();
+	m_lstData.Clear();
+	m_pnData = nullptr;
+	m_nSize  = 0;
+}
+
+/**
+*  @brief
+*    Collects the cells, the cell portals and the start camera of an object record and everything below it
+*/
+bool ProgressiveSceneLoader::ScanRecord(uint32 nOffset, const String &sName, Cell *pCell)
+{
+	// Get the object record
+	if (nOffset > m_nSize || m_nSize - nOffset < sizeof(BinaryScene::ObjectRecord))
+		return false; // Error!
+	BinaryScene::ObjectRecord sRecord;
+	MemoryManager::Copy(&sRecord, m_pnData + nOffset, sizeof(BinaryScene::ObjectRecord));
+	if (sRecord.nSize < sizeof(BinaryScene::ObjectRecord) || sRecord.nSize > m_nSize - nOffset)
+		return false; // Error!
+	const uint32 nEnd = nOffset + sRecord.nSize;
+	uint32 nData = nOffset + sizeof(BinaryScene::ObjectRecord);
+
+	// Look for the start camera key and the cell portal targets, both are string attributes
+	String sKey, sValue;
+	for (uint32 i=0; i<sRecord.nNumOfAttributes; i++) {
+		// Get the attribute record
+		if (nData + sizeof(BinaryScene::AttributeRecord) > nEnd)
+			return false; // Error!
+		BinaryScene::AttributeRecord sAttribute;
+		MemoryManager::Copy(&sAttribute, m_pnData + nData, sizeof(BinaryScene::AttributeRecord));
+		nData += sizeof(BinaryScene::AttributeRecord);
+		const uint32 nValueSize = BinaryScene::GetAttributeValueSize(sAttribute.nType);
+		if (nData + nValueSize > nEnd)
+			return false; // Error!
+
+		// Check the attribute
+		if (sAttribute.nType == BinaryScene::StringAttribute) {
+			uint32 nValue;
+			MemoryManager::Copy(&nValue, m_pnData + nData, sizeof(nValue));
+			const String sAttributeName = m_cBinaryScene.GetString(sAttribute.nName);
+			if (sAttributeName == "Key") {
+				sKey = m_cBinaryScene.GetString(nValue);
+			} else if (sAttributeName == "Value") {
+				sValue = m_cBinaryScene.GetString(nValue);
+			} else if (sAttributeName == "TargetCell" && pCell) {
+				// The target is relative to the scene container the cell portal is in (e.g. "Parent.kanal5")
+				int nIndex = sName.LastIndexOf('.');
+				String sContainer = (nIndex >= 0) ? sName.GetSubstring(0, nIndex) : "";
+				String sTarget = m_cBinaryScene.GetString(nValue);
+				while (sTarget.IndexOf("Parent.") == 0) {
+					sTarget = sTarget.GetSubstring(7);
+					nIndex = sContainer.LastIndexOf('.');
+					sContainer = (nIndex >= 0) ? sContainer.GetSubstring(0, nIndex) : "";
+				}
+				pCell->lstTargets.Add(sContainer.GetLength() ? sContainer + '.' + sTarget : sTarget);
+			}
+		}
+		nData += nValueSize;
+	}
+	if (sKey == "StartCamera")
+		m_sStartCamera = sValue;
+
+	// Skip the modifier records
+	for (uint32 i=0; i<sRecord.nNumOfModifiers; i++) {
+		BinaryScene::ObjectRecord sModifierRecord;
+		if (nData + sizeof(BinaryScene::ObjectRecord) > nEnd)
+			return false; // Error!
+		MemoryManager::Copy(&sModifierRecord, m_pnData + nData, sizeof(BinaryScene::ObjectRecord));
+		if (sModifierRecord.nSize < sizeof(BinaryScene::ObjectRecord) || nData + sModifierRecord.nSize > nEnd)
+			return false; // Error!
+		nData += sModifierRecord.nSize;
+	}
+
+	// Scan the child records
+	for (uint32 i=0; i<sRecord.nNumOfChildren; i++) {
+		BinaryScene::ObjectRecord sChildRecord;
+		if (nData + sizeof(BinaryScene::ObjectRecord) > nEnd)
+			return false; // Error!
+		MemoryManager::Copy(&sChildRecord, m_pnData + nData, sizeof(BinaryScene::ObjectRecord));
+		if (sChildRecord.nSize < sizeof(BinaryScene::ObjectRecord) || nData + sChildRecord.nSize > nEnd)
+			return false; // Error!
+		const String sChildName = sName.GetLength() ? sName + '.' + m_cBinaryScene.GetString(sChildRecord.nName) : m_cBinaryScene.GetString(sChildRecord.nName);
+
+		// Is this a cell? Cells within cells are loaded together with the cell they're in.
+		Cell *pChildCell = pCell;
+		if (!pCell && sChildRecord.nType == BinaryScene::ContainerRecord) {
+			const Class *pClass = ClassManager::GetInstance()->GetClass(m_cBinaryScene.GetString(sChildRecord.nClass));
+			if (pClass && (pClass->GetClassName() == "PLScene::SCCell" || pClass->IsDerivedFrom("PLScene::SCCell"))) {
+				pChildCell = new Cell;
+				pChildCell->nOffset = nData;
+				pChildCell->sParent = sName;
+				pChildCell->sName   = sChildName;
+				pChildCell->nStage  = 0;
+				m_lstCells.Add(pChildCell);
+			}
+		}
+
+		// Scan the child record
+		if (!ScanRecord(nData, sChildName, pChildCell))
+			return false; // Error!
+		nData += sChildRecord.nSize;
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the index of the cell an absolute scene node name is within
+*/
+int ProgressiveSceneLoader::GetCellIndex(const String &sName) const
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		const String &sCellName = m_lstCells[i]->sName;
+		if (sName == sCellName || (sName.GetLength() > sCellName.GetLength() && sName.IndexOf(sCellName + '.') == 0))
+			return static_cast<int>(i);
+	}
+
+	// The scene node is not within a cell
+	return -1;
+}
+
+/**
+*  @brief
+*    Assigns the stages to the cells and collects the deferred cells
+*/
+void ProgressiveSceneLoader::AssignStages(uint32 nStartCell)
+{
+	// Get the portal distances of the cells to the start cell by using a breadth-first search
+	static const uint32 Unreachable = 0xFFFFFFFF;
+	Array<uint32> lstDistances;
+	lstDistances.Resize(m_lstCells.GetNumOfElements());
+	for (uint32 i=0; i<lstDistances.GetNumOfElements(); i++)
+		lstDistances[i] = Unreachable;
+	Queue<uint32> lstOpen;
+	lstDistances[nStartCell] = 0;
+	lstOpen.Push(nStartCell);
+	uint32 nCell = 0;
+	uint32 nMaxDistance = 0;
+	while (lstOpen.Pop(&nCell)) {
+		const Array<String> &lstTargets = m_lstCells[nCell]->lstTargets;
+		for (uint32 i=0; i<lstTargets.GetNumOfElements(); i++) {
+			const int nTarget = GetCellIndex(lstTargets[i]);
+			if (nTarget >= 0 && lstDistances[nTarget] == Unreachable) {
+				lstDistances[nTarget] = lstDistances[nCell] + 1;
+				if (nMaxDistance < lstDistances[nTarget])
+					nMaxDistance = lstDistances[nTarget];
+				lstOpen.Push(nTarget);
+			}
+		}
+	}
+
+	// The first stage holds the start cell and its direct neighbours, each following stage the cells one portal hop
+	// further away - the cells which can't be reached through cell portals are loaded within the last stage
+	const uint32 nUnreachableStage = ((nMaxDistance > 1) ? nMaxDistance - 1 : 0) + 1;
+	m_nNumOfStages = 1;
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		Cell &cCell = *m_lstCells[i];
+		if (lstDistances[i] == Unreachable)
+			cCell.nStage = nUnreachableStage;
+		else
+			cCell.nStage = (lstDistances[i] > 1) ? lstDistances[i] - 1 : 0;
+		if (m_nNumOfStages < cCell.nStage + 1)
+			m_nNumOfStages = cCell.nStage + 1;
+	}
+
+	// Collect the deferred cells in load order
+	for (uint32 nStage=1; nStage<m_nNumOfStages; nStage++) {
+		for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+			if (m_lstCells[i]->nStage == nStage)
+				m_lstDeferredCells.Add(m_lstCells[i]);
+		}
+	}
+}
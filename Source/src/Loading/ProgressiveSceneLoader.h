@@ -0,0 +1,285 @@
+/*********************************************************\
+ *  File: ProgressiveSceneLoader.h                       *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PROGRESSIVESCENELOADER_H__
+#define __DUNGEON_PROGRESSIVESCENELOADER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Tools/MemoryMappedFile.h"
+#include "Loading/BinaryScene.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLCore {
+	class File;
+}
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Progressive scene loader, loads the start cell first and the remaining cells later on
+*
+*  @remarks
+*    The first stage loads everything outside the cells, the start cell and the cells directly connected
+*    to it by a cell portal - this is enough for the first interactive frame. Each following stage loads
+*    the cells one portal hop further away, cells which can't be reached through cell portals are loaded
+*    within the last stage. The deferred cells are loaded one by one by using "Update()", so the loading
+*    is spread over the following frames.
+*
+*    Only compiled binary scenes ("*.bscene") can be loaded progressively because the binary scene data
+*    stays mapped and the deferred cells can be loaded from their object records at any time. While a
+*    progressive scene loader is the current one, "SceneLoaderBinary" forwards the loading to it.
+*/
+class ProgressiveSceneLoader {
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns the current progressive scene loader
+		*
+		*  @return
+		*    The current progressive scene loader, a null pointer if binary scenes are loaded at once
+		*/
+		static ProgressiveSceneLoader *GetCurrent();
+
+		/**
+		*  @brief
+		*    Sets the current progressive scene loader
+		*
+		*  @param[in] pProgressiveSceneLoader
+		*    Progressive scene loader binary scenes are loaded with, can be a null pointer
+		*
+		*  @note
+		*    - Set it just for the scene loading, it's not reset automatically
+		*/
+		static void SetCurrent(ProgressiveSceneLoader *pProgressiveSceneLoader);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] sStartCell
+		*    Absolute name of the cell (or of a scene node within it) to start with, relative to the loaded
+		*    scene container (e.g. "Container.kanal3"), empty string for the cell of the scene start camera
+		*/
+		ProgressiveSceneLoader(const PLCore::String &sStartCell);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~ProgressiveSceneLoader();
+
+		/**
+		*  @brief
+		*    Loads the first stage of a binary scene
+		*
+		*  @param[in] cContainer
+		*    Scene container to load into
+		*  @param[in] cFile
+		*    Binary scene file to load, must be opened for reading
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*
+		*  @note
+		*    - If the start cell can't be found, the whole scene is loaded at once
+		*/
+		bool Load(PLScene::SceneContainer &cContainer, PLCore::File &cFile);
+
+		/**
+		*  @brief
+		*    Returns whether or not there are still deferred cells to load
+		*
+		*  @return
+		*    'true' if there are still deferred cells to load, else 'false'
+		*/
+		bool IsLoading() const;
+
+		/**
+		*  @brief
+		*    Returns the total number of stages
+		*
+		*  @return
+		*    The total number of stages, 0 if nothing was loaded yet
+		*/
+		PLCore::uint32 GetNumOfStages() const;
+
+		/**
+		*  @brief
+		*    Returns the number of finished stages
+		*
+		*  @return
+		*    The number of finished stages
+		*/
+		PLCore::uint32 GetNumOfFinishedStages() const;
+
+		/**
+		*  @brief
+		*    Loads the next deferred cell
+		*
+		*  @return
+		*    'true' if a stage has been finished, else 'false'
+		*/
+		bool Update();
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Cell found within the binary scene
+		*/
+		struct Cell {
+			PLCore::uint32				  nOffset;		/**< Offset of the object record (relative to the data start) */
+			PLCore::String				  sParent;		/**< Name of the scene container the cell is in, relative to the loaded scene container */
+			PLCore::String				  sName;		/**< Absolute name of the cell, relative to the loaded scene container */
+			PLCore::Array<PLCore::String> lstTargets;	/**< Absolute names of the cells the cell portals of this cell are leading to */
+			PLCore::uint32				  nStage;		/**< Stage the cell is loaded within */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		ProgressiveSceneLoader(const ProgressiveSceneLoader &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		ProgressiveSceneLoader &operator =(const ProgressiveSceneLoader &cSource);
+
+		/**
+		*  @brief
+		*    Destroys all cells
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Collects the cells, the cell portals and the start camera of an object record and everything below it
+		*
+		*  @param[in] nOffset
+		*    Offset of the object record (relative to the data start)
+		*  @param[in] sName
+		*    Absolute name of the object, relative to the loaded scene container (empty string for the root)
+		*  @param[in] pCell
+		*    Cell the object is in, can be a null pointer
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (invalid record data)
+		*/
+		bool ScanRecord(PLCore::uint32 nOffset, const PLCore::String &sName, Cell *pCell);
+
+		/**
+		*  @brief
+		*    Returns the index of the cell an absolute scene node name is within
+		*
+		*  @param[in] sName
+		*    Absolute scene node name, relative to the loaded scene container
+		*
+		*  @return
+		*    The index of the cell, -1 if the scene node is not within a cell
+		*/
+		int GetCellIndex(const PLCore::String &sName) const;
+
+		/**
+		*  @brief
+		*    Assigns the stages to the cells and collects the deferred cells
+		*
+		*  @param[in] nStartCell
+		*    Index of the start cell
+		*/
+		void AssignStages(PLCore::uint32 nStartCell);
+
+
+	//[-------------------------------------------------------]
+	//[ Private static data                                   ]
+	//[-------------------------------------------------------]
+	private:
+		static ProgressiveSceneLoader *m_pCurrent;	/**< Current progressive scene loader, can be a null pointer */
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::String				 m_sStartCell;				/**< Absolute name of the cell to start with, empty string for the cell of the scene start camera */
+		MemoryMappedFile			 m_cMemoryMappedFile;		/**< Memory mapped binary scene file */
+		PLCore::Array<PLCore::uint8> m_lstData;					/**< Binary scene data if the file can't be memory mapped */
+		const PLCore::uint8			*m_pnData;					/**< Binary scene data, can be a null pointer */
+		PLCore::uint32				 m_nSize;					/**< Size of the binary scene data (in bytes) */
+		BinaryScene					 m_cBinaryScene;			/**< Opened binary scene */
+		PLScene::SceneNodeHandler	 m_cContainer;				/**< Scene container the scene was loaded into */
+		PLCore::String				 m_sStartCamera;			/**< Absolute name of the scene start camera found within the binary scene */
+		PLCore::Array<Cell*>		 m_lstCells;				/**< All cells of the binary scene */
+		PLCore::Array<Cell*>		 m_lstDeferredCells;		/**< Deferred cells in load order */
+		PLCore::uint32				 m_nNextDeferredCell;		/**< Index of the next deferred cell to load */
+		PLCore::uint32				 m_nNumOfStages;			/**< Total number of stages */
+		PLCore::uint32				 m_nNumOfFinishedStages;	/**< Number of finished stages */
+
+
+};
+
+
+#endif // __DUNGEON_PROGRESSIVESCENELOADER_H__
@@ -0,0 +1,112 @@
+/*********************************************************\
+ *  File: SceneLoaderBinary.cpp                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Log/Log.h>
+#include <PLCore/File/File.h>
+#include <PLCore/Container/Array.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Tools/MemoryMappedFile.h"
+#include "Loading/BinaryScene.h"
+#include "Loading/ProgressiveSceneLoader.h"
+#include "Loading/SceneLoaderBinary.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ RTTI interface                                        ]
+//[-------------------------------------------------------]
+pl_implement_class(SceneLoaderBinary)
+
+
+//[-------------------------------------------------------]
+//[ Public RTTI methods                                   ]
+//[-------------------------------------------------------]
+bool SceneLoaderBinary::Load(SceneContainer &cContainer, File &cFile)
+{
+	// Load the scene progressively? The progressive scene loader keeps the binary scene open for the deferred cells.
+	ProgressiveSceneLoader *pProgressiveSceneLoader = ProgressiveSceneLoader::GetCurrent();
+	if (pProgressiveSceneLoader)
+		return pProgressiveSceneLoader->Load(cContainer, cFile);
+
+	BinaryScene cBinaryScene;
+
+	// Map the file into memory, there's no need to read the file if it's a native file
+	MemoryMappedFile cMemoryMappedFile;
+	if (cFile.GetUrl().IsValidNativePath() && cMemoryMappedFile.Open(cFile.GetUrl().GetNativePath())) {
+		// Load the scene
+		if (!cBinaryScene.Open(cMemoryMappedFile.GetData(), cMemoryMappedFile.GetSize())) {
+			PL_LOG(Warning, "\"" + cFile.GetUrl().GetUrl() + "\" is no valid binary scene of version " + BinaryScene::Version + " (recompile it with \"--compile-scene\")")
+			return false; // Error!
+		}
+		return cBinaryScene.Load(cContainer);
+	}
+
+	// Read the file into memory
+	Array<uint8> lstData;
+	lstData.Resize(cFile.GetSize());
+	if (lstData.GetNumOfElements() && cFile.Read(lstData.GetData(), 1, lstData.GetNumOfElements()) == lstData.GetNumOfElements()) {
+		// Load the scene
+		if (!cBinaryScene.Open(lstData.GetData(), lstData.GetNumOfElements())) {
+			PL_LOG(Warning, "\"" + cFile.GetUrl().GetUrl() + "\" is no valid binary scene of version " + BinaryScene::Version + " (recompile it with \"--compile-scene\")")
+			return false; // Error!
+		}
+		return cBinaryScene.Load(cContainer);
+	}
+
+	// Error!
+	return false;
+}
+
+bool SceneLoaderBinary::Save(SceneContainer &cContainer, File &cFile)
+{
+	BinaryScene cBinaryScene;
+	return cBinaryScene.Save(cContainer, cFile);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Default constructor
+*/
+SceneLoaderBinary::SceneLoaderBinary()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+SceneLoaderBinary::~SceneLoaderBinary()
+{
+}
@@ -0,0 +1,94 @@
+/*********************************************************\
+ *  File: SceneLoaderBinary.h                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_SCENELOADERBINARY_H__
+#define __DUNGEON_SCENELOADERBINARY_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLScene/Scene/SceneLoader/SceneLoader.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Scene loader implementation for the compiled binary scene format ("*.bscene")
+*
+*  @remarks
+*    The binary scene file is memory mapped if possible, else it's read into memory. Saving compiles a loaded scene
+*    into the binary scene format, see "BinaryScene" for details.
+*/
+class SceneLoaderBinary : public PLScene::SceneLoader {
+
+
+	//[-------------------------------------------------------]
+	//[ RTTI interface                                        ]
+	//[-------------------------------------------------------]
+	pl_class(pl_rtti_export, SceneLoaderBinary, "", PLScene::SceneLoader, "Scene loader implementation for the compiled binary scene format")
+		// Properties
+		pl_properties
+			pl_property("Formats",	"bscene,BSCENE")
+			pl_property("Load",		"1")
+			pl_property("Save",		"1")
+		pl_properties_end
+		// Constructors
+		pl_constructor_0(DefaultConstructor,	"Default constructor",	"")
+		// Methods
+		pl_method_2(Load,	pl_ret_type(bool),	PLScene::SceneContainer&,	PLCore::File&,	"Load method",	"")
+		pl_method_2(Save,	pl_ret_type(bool),	PLScene::SceneContainer&,	PLCore::File&,	"Save method",	"")
+	pl_class_end
+
+
+	//[-------------------------------------------------------]
+	//[ Public RTTI methods                                   ]
+	//[-------------------------------------------------------]
+	public:
+		bool Load(PLScene::SceneContainer &cContainer, PLCore::File &cFile);
+		bool Save(PLScene::SceneContainer &cContainer, PLCore::File &cFile);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Default constructor
+		*/
+		SceneLoaderBinary();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		virtual ~SceneLoaderBinary();
+
+
+};
+
+
+#endif // __DUNGEON_SCENELOADERBINARY_H__
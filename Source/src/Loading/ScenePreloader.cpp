@@ -0,0 +1,514 @@
+/*********************************************************\
+ *  File: ScenePreloader.cpp                             *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/Url.h>
+#include <PLCore/File/File.h>
+#include <PLCore/Xml/Xml.h>
+#include <PLCore/Tools/LoadableManager.h>
+#include <PLCore/Tools/ResourceHandler.h>
+#include <PLCore/Tools/ResourceManager.h>
+#include <PLRenderer/RendererContext.h>
+#include <PLRenderer/Texture/Texture.h>
+#include <PLRenderer/Texture/TextureManager.h>
+#include <PLRenderer/Material/Material.h>
+#include <PLRenderer/Material/MaterialManager.h>
+#include <PLMesh/Mesh.h>
+#include <PLMesh/MeshManager.h>
+#include <PLScene/Scene/SceneContext.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Tools/Trace.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Loading/BinaryScene.h"
+#include "Loading/ScenePreloader.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLRenderer;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 MaxSemaphoreValue = 0x7FFFFFFF;	/**< Maximum value of the read semaphore */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Loads a resource from read file data, returns the already loaded resource if there's one
+*
+*  @remarks
+*    The memory file keeps the filename as URL, so the loader is chosen by the filename extension just as if the
+*    file was opened. Returns a null pointer if there's no file data or if it can't be loaded.
+*/
+template <class AType>
+static AType *LoadResourceFromMemory(ResourceManager<AType> &cManager, const String &sFilename, uint8 *pnData, uint32 nSize)
+{
+	AType *pResource = cManager.GetByName(sFilename);
+	if (!pResource && pnData) {
+		File cFile(pnData, nSize, false, sFilename);
+		if (cFile.Open(File::FileRead)) {
+			pResource = cManager.Create(sFilename);
+			if (pResource && !pResource->LoadByFile(cFile)) {
+				// Error!
+				delete pResource;
+				pResource = nullptr;
+			}
+			cFile.Close();
+		}
+	}
+	return pResource;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+ScenePreloader::ScenePreloader(SceneContext &cSceneContext, uint32 nNumOfThreads) :
+	m_pSceneContext(&cSceneContext),
+	m_cWorkerPool(nNumOfThreads),
+	m_cReadSemaphore(0, MaxSemaphoreValue),
+	m_nNumOfReadFiles(0),
+	m_nNumOfReadBytes(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+ScenePreloader::~ScenePreloader()
+{
+	// The worker threads must not touch the assets anymore
+	m_cWorkerPool.WaitForAll();
+
+	// Release the created resources, the resource managers destroy resources which are no longer used
+	for (uint32 i=0; i<m_lstMeshHandlers.GetNumOfElements(); i++)
+		delete m_lstMeshHandlers[i];
+	for (uint32 i=0; i<m_lstMaterialHandlers.GetNumOfElements(); i++)
+		delete m_lstMaterialHandlers[i];
+	for (uint32 i=0; i<m_lstTextureHandlers.GetNumOfElements(); i++)
+		delete m_lstTextureHandlers[i];
+
+	// Destroy the assets, including the file data of assets which were not created
+	for (uint32 i=0; i<m_lstAssets.GetNumOfElements(); i++) {
+		if (m_lstAssets[i]->pnData)
+			delete [] m_lstAssets[i]->pnData;
+		delete m_lstAssets[i];
+	}
+}
+
+/**
+*  @brief
+*    Preloads the assets of a scene
+*/
+bool ScenePreloader::Preload(const String &sFilename, SceneContainer *pContainer)
+{
+	// Build the list of assets referenced by the scene, this starts reading the asset files
+	Array<Asset*> lstAssets;
+	if (Url(sFilename).GetExtension().CompareNoCase("bscene")) {
+		// The string table of a compiled binary scene contains all filenames referenced by the scene, in scene order
+		MemoryMappedFile cMemoryMappedFile;
+		BinaryScene cBinaryScene;
+		if (!cMemoryMappedFile.Open(sFilename) || !cBinaryScene.Open(cMemoryMappedFile.GetData(), cMemoryMappedFile.GetSize()))
+			return false; // Error!
+		for (uint32 i=0; i<cBinaryScene.GetNumOfStrings(); i++) {
+			Asset *pAsset = RequestAsset(cBinaryScene.GetString(i));
+			if (pAsset && !lstAssets.IsElement(pAsset))
+				lstAssets.Add(pAsset);
+		}
+	} else {
+		// Open and parse the scene file
+		File cFile;
+		XmlDocument cDocument;
+		if (!LoadableManager::GetInstance()->OpenFile(cFile, sFilename) || !cDocument.Load(cFile))
+			return false; // Error!
+		cFile.Close();
+		const XmlElement *pSceneElement = cDocument.GetFirstChildElement("Scene");
+		if (!pSceneElement)
+			return false; // Error!
+		CollectSceneAssets(*pSceneElement, lstAssets);
+	}
+
+	// Create the resources in scene order as soon as they're ready, meanwhile the worker threads continue reading
+	for (uint32 i=0; i<lstAssets.GetNumOfElements(); i++) {
+		Asset &cAsset = *lstAssets[i];
+
+		// Wait until the asset and all its dependencies were read
+		for (;;) {
+			m_cMutex.Lock();
+			const bool bReady = IsAssetReady(cAsset);
+			m_cMutex.Unlock();
+			if (bReady)
+				break;
+			m_cReadSemaphore.Lock();
+		}
+
+		// Create the resource
+		CreateResource(cAsset);
+
+		// Report the preload progress
+		if (pContainer)
+			pContainer->EventLoadProgress(static_cast<float>(i + 1)/lstAssets.GetNumOfElements());
+	}
+
+	// Done
+	m_cWorkerPool.WaitForAll();
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the number of read asset files
+*/
+uint32 ScenePreloader::GetNumOfReadFiles() const
+{
+	m_cMutex.Lock();
+	const uint32 nNumOfReadFiles = m_nNumOfReadFiles;
+	m_cMutex.Unlock();
+	return nNumOfReadFiles;
+}
+
+/**
+*  @brief
+*    Returns the number of read bytes
+*/
+uint64 ScenePreloader::GetNumOfReadBytes() const
+{
+	m_cMutex.Lock();
+	const uint64 nNumOfReadBytes = m_nNumOfReadBytes;
+	m_cMutex.Unlock();
+	return nNumOfReadBytes;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+ScenePreloader::ScenePreloader(const ScenePreloader &cSource) :
+	m_pSceneContext(nullptr),
+	m_cWorkerPool(1),
+	m_cReadSemaphore(0, MaxSemaphoreValue),
+	m_nNumOfReadFiles(0),
+	m_nNumOfReadBytes(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+ScenePreloader &ScenePreloader::operator =(const ScenePreloader &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Collects the assets referenced by the attributes of a scene XML element and it's children
+*/
+void ScenePreloader::CollectSceneAssets(const XmlElement &cElement, Array<Asset*> &lstAssets)
+{
+	// Check all attributes, e.g. "Mesh" of "PLScene::SNMesh" or "Material" of "PLScene::SNBitmap3D"
+	for (const XmlAttribute *pAttribute=cElement.GetFirstAttribute(); pAttribute; pAttribute=pAttribute->GetNext()) {
+		Asset *pAsset = RequestAsset(pAttribute->GetValue());
+		if (pAsset && !lstAssets.IsElement(pAsset))
+			lstAssets.Add(pAsset);
+	}
+
+	// Check all child elements
+	for (const XmlElement *pChildElement=cElement.GetFirstChildElement(); pChildElement; pChildElement=pChildElement->GetNextSiblingElement())
+		CollectSceneAssets(*pChildElement, lstAssets);
+}
+
+/**
+*  @brief
+*    Collects the assets referenced by the texts of a XML element and it's children
+*/
+void ScenePreloader::CollectTextAssets(const XmlElement &cElement, Array<Asset*> &lstAssets)
+{
+	for (const XmlNode *pNode=cElement.GetFirstChild(); pNode; pNode=pNode->GetNextSibling()) {
+		if (pNode->GetType() == XmlNode::Text) {
+			// E.g. "<Texture Name="DiffuseMap">Data\Textures\Dungeon\Wall.dds</Texture>"
+			Asset *pAsset = RequestAsset(pNode->GetValue());
+			if (pAsset && !lstAssets.IsElement(pAsset))
+				lstAssets.Add(pAsset);
+		} else if (pNode->GetType() == XmlNode::Element) {
+			CollectTextAssets(static_cast<const XmlElement&>(*pNode), lstAssets);
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns an asset, the asset is created and it's file reading is started if it's new
+*/
+ScenePreloader::Asset *ScenePreloader::RequestAsset(const String &sFilename)
+{
+	// Get the asset type by using the filename extension
+	const String sExtension = Url(sFilename).GetExtension();
+	EAssetType nType = UnknownAsset;
+	if (sExtension.CompareNoCase("mesh"))
+		nType = MeshAsset;
+	else if (sExtension.CompareNoCase("mat"))
+		nType = MaterialAsset;
+	else if (sExtension.CompareNoCase("dds") || sExtension.CompareNoCase("tani"))
+		nType = TextureAsset;
+	if (nType == UnknownAsset)
+		return nullptr;
+
+	// Is the asset already known?
+	m_cMutex.Lock();
+	Asset *pAsset = m_mapAssets.Get(sFilename);
+	if (!pAsset) {
+		// Create the asset
+		pAsset = new Asset;
+		pAsset->sFilename = sFilename;
+		pAsset->nType     = nType;
+		pAsset->bRead     = false;
+		pAsset->pnData    = nullptr;
+		pAsset->nSize     = 0;
+		pAsset->bCreated  = false;
+		m_lstAssets.Add(pAsset);
+		m_mapAssets.Add(sFilename, pAsset);
+		m_cMutex.Unlock();
+
+		// Start reading the asset file
+		m_cWorkerPool.AddJob(new ReadJob(*this, *pAsset));
+	} else {
+		m_cMutex.Unlock();
+	}
+
+	// Done
+	return pAsset;
+}
+
+/**
+*  @brief
+*    Reads an asset file and requests it's dependencies
+*/
+void ScenePreloader::ReadAsset(Asset &cAsset)
+{
+	TraceScope cTraceScope("ScenePreloader::ReadAsset", "IO", cAsset.sFilename);
+	Array<Asset*> lstDependencies;
+	uint8 *pnData = nullptr;
+	uint32 nNumOfReadBytes = 0;
+
+	// Read the whole asset file into memory, this is the part which benefits from the worker threads - the data is
+	// kept and handed to the loader, so the file isn't read again
+	File cFile;
+	if (LoadableManager::GetInstance()->OpenFile(cFile, cAsset.sFilename)) {
+		const uint32 nSize = cFile.GetSize();
+		pnData = new uint8[nSize + 1];
+		nNumOfReadBytes = cFile.Read(pnData, 1, nSize);
+		pnData[nNumOfReadBytes] = '\0';
+		cFile.Close();
+		char *pszData = reinterpret_cast<char*>(pnData);
+
+		// Collect the dependencies
+		switch (cAsset.nType) {
+			case MeshAsset:
+			{
+				// The mesh materials are stored as zero terminated filenames, look for them within the raw mesh data
+				for (uint32 nEnd=4; nEnd<nNumOfReadBytes; nEnd++) {
+					if (pszData[nEnd] == '\0' && pszData[nEnd - 4] == '.' &&
+						(pszData[nEnd - 3] == 'm' || pszData[nEnd - 3] == 'M') &&
+						(pszData[nEnd - 2] == 'a' || pszData[nEnd - 2] == 'A') &&
+						(pszData[nEnd - 1] == 't' || pszData[nEnd - 1] == 'T')) {
+						// Find the start of the filename
+						uint32 nStart = nEnd - 4;
+						while (nStart > 0 && pszData[nStart - 1] >= ' ' && pszData[nStart - 1] <= '~')
+							nStart--;
+						Asset *pAsset = RequestAsset(String(&pszData[nStart], true, nEnd - nStart));
+						if (pAsset && !lstDependencies.IsElement(pAsset))
+							lstDependencies.Add(pAsset);
+					}
+				}
+				break;
+			}
+
+			case MaterialAsset:
+			case TextureAsset:
+			{
+				// Materials and texture animations are XML documents referencing textures, real textures are no XML documents
+				XmlDocument cDocument;
+				if (pszData[0] == '<' && cDocument.Parse(pszData)) {
+					const XmlElement *pRootElement = cDocument.GetRootElement();
+					if (pRootElement)
+						CollectTextAssets(*pRootElement, lstDependencies);
+				}
+				break;
+			}
+
+			case UnknownAsset:
+				// Nothing to do in here
+				break;
+		}
+	}
+
+	// The asset file was read (a missing file is no reason to stall the main thread)
+	m_cMutex.Lock();
+	cAsset.lstDependencies = lstDependencies;
+	cAsset.pnData = pnData;
+	cAsset.nSize  = nNumOfReadBytes;
+	cAsset.bRead  = true;
+	m_nNumOfReadFiles++;
+	m_nNumOfReadBytes += nNumOfReadBytes;
+	m_cMutex.Unlock();
+
+	// Wake up the main thread
+	m_cReadSemaphore.Unlock();
+}
+
+/**
+*  @brief
+*    Returns whether or not an asset and all its dependencies were read
+*/
+bool ScenePreloader::IsAssetReady(const Asset &cAsset) const
+{
+	if (!cAsset.bRead)
+		return false;
+	for (uint32 i=0; i<cAsset.lstDependencies.GetNumOfElements(); i++) {
+		if (!IsAssetReady(*cAsset.lstDependencies[i]))
+			return false;
+	}
+	return true;
+}
+
+/**
+*  @brief
+*    Creates the resource of an asset and the resources of its dependencies
+*/
+void ScenePreloader::CreateResource(Asset &cAsset)
+{
+	if (cAsset.bCreated)
+		return;
+	cAsset.bCreated = true;
+
+	// Create the dependencies first, so the loader finds them within the resource managers instead of reading their files
+	for (uint32 i=0; i<cAsset.lstDependencies.GetNumOfElements(); i++)
+		CreateResource(*cAsset.lstDependencies[i]);
+
+	TraceScope cTraceScope("ScenePreloader::CreateResource", "Resource", cAsset.sFilename);
+
+	// The resources are loaded by using the filename as resource name - just like the scene nodes are doing it, so
+	// they'll find them. The read file data is used, if there's none or it can't be loaded the file is loaded the usual
+	// way (which reports the error).
+	switch (cAsset.nType) {
+		case MeshAsset:
+		{
+			MeshManager &cMeshManager = m_pSceneContext->GetMeshManager();
+			Mesh *pMesh = LoadResourceFromMemory(cMeshManager, cAsset.sFilename, cAsset.pnData, cAsset.nSize);
+			if (!pMesh)
+				pMesh = cMeshManager.LoadMesh(cAsset.sFilename);
+			if (pMesh) {
+				ResourceHandler<Mesh> *pMeshHandler = new ResourceHandler<Mesh>();
+				pMeshHandler->SetResource(pMesh);
+				m_lstMeshHandlers.Add(pMeshHandler);
+			}
+			break;
+		}
+
+		case MaterialAsset:
+		{
+			MaterialManager &cMaterialManager = m_pSceneContext->GetRendererContext().GetMaterialManager();
+			Material *pMaterial = LoadResourceFromMemory(cMaterialManager, cAsset.sFilename, cAsset.pnData, cAsset.nSize);
+			if (!pMaterial)
+				pMaterial = cMaterialManager.LoadResource(cAsset.sFilename);
+			if (pMaterial) {
+				ResourceHandler<Material> *pMaterialHandler = new ResourceHandler<Material>();
+				pMaterialHandler->SetResource(pMaterial);
+				m_lstMaterialHandlers.Add(pMaterialHandler);
+			}
+			break;
+		}
+
+		case TextureAsset:
+		{
+			TextureManager &cTextureManager = m_pSceneContext->GetRendererContext().GetTextureManager();
+			Texture *pTexture = LoadResourceFromMemory(cTextureManager, cAsset.sFilename, cAsset.pnData, cAsset.nSize);
+			if (!pTexture)
+				pTexture = cTextureManager.LoadResource(cAsset.sFilename);
+			if (pTexture) {
+				ResourceHandler<Texture> *pTextureHandler = new ResourceHandler<Texture>();
+				pTextureHandler->SetResource(pTexture);
+				m_lstTextureHandlers.Add(pTextureHandler);
+			}
+			break;
+		}
+
+		case UnknownAsset:
+			// Nothing to do in here
+			break;
+	}
+
+	// The read file data is no longer required
+	if (cAsset.pnData) {
+		delete [] cAsset.pnData;
+		cAsset.pnData = nullptr;
+	}
+}
+
+
+
+
+//[-------------------------------------------------------]
+//[ Public ScenePreloader::ReadJob functions              ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+ScenePreloader::ReadJob::ReadJob(ScenePreloader &cScenePreloader, Asset &cAsset) :
+	m_pScenePreloader(&cScenePreloader),
+	m_pAsset(&cAsset)
+{
+}
+
+
+//[-------------------------------------------------------]
+//[ Public virtual WorkerPool::Job functions              ]
+//[-------------------------------------------------------]
+void ScenePreloader::ReadJob::Execute()
+{
+	m_pScenePreloader->ReadAsset(*m_pAsset);
+}
@@ -0,0 +1,335 @@
+/*********************************************************\
+ *  File: ScenePreloader.h                               *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_SCENEPRELOADER_H__
+#define __DUNGEON_SCENEPRELOADER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/System/Mutex.h>
+#include <PLCore/System/Semaphore.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/HashMap.h>
+#include "Tools/WorkerPool.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLCore {
+	class XmlElement;
+	template <class AType> class ResourceHandler;
+}
+namespace PLRenderer {
+	class Texture;
+	class Material;
+}
+namespace PLMesh {
+	class Mesh;
+}
+namespace PLScene {
+	class SceneContext;
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Parallel scene asset preloader
+*
+*  @remarks
+*    Loading a scene creates the meshes, materials and textures one after another on the main thread, so
+*    the file I/O is completly serial. The preloader parses the scene first and builds a list of the assets
+*    referenced by the scene nodes (in scene order). The files of those assets are read by a worker pool,
+*    reading a mesh or a material reveals further dependencies (materials, textures) which are read by the
+*    worker pool as well. Meanwhile, the main thread creates the resources in scene order as soon as an
+*    asset and all its dependencies have been read - the resource managers and the renderer are not
+*    thread-safe, so resource creation stays on the main thread. The read file data is kept until the resource
+*    is created and handed to its loader as memory file, the dependencies are created first, so each asset file
+*    is read only once. When the scene itself is loaded afterwards, the scene nodes find their resources already
+*    loaded within the resource managers.
+*
+*  @note
+*    - The preloader holds the created resources until it's destroyed, so destroy it after the scene has been loaded
+*/
+class ScenePreloader {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] cSceneContext
+		*    Scene context to create the resources within
+		*  @param[in] nNumOfThreads
+		*    Number of worker threads used to read the asset files
+		*/
+		ScenePreloader(PLScene::SceneContext &cSceneContext, PLCore::uint32 nNumOfThreads);
+
+		/**
+		*  @brief
+		*    Destructor
+		*
+		*  @note
+		*    - Releases the resources created by the preloader, resources which are used by the scene stay alive
+		*/
+		~ScenePreloader();
+
+		/**
+		*  @brief
+		*    Preloads the assets of a scene
+		*
+		*  @param[in] sFilename
+		*    Filename of the scene to preload the assets from, native filename in case of a compiled binary scene ("*.bscene")
+		*  @param[in] pContainer
+		*    Scene container the scene is going to be loaded into, the preload progress is reported through its load
+		*    progress event each time a resource was created (so a load screen is presented meanwhile), can be a null pointer
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (scene file not found or invalid, assets which can't be loaded are no error)
+		*/
+		bool Preload(const PLCore::String &sFilename, PLScene::SceneContainer *pContainer = nullptr);
+
+		/**
+		*  @brief
+		*    Returns the number of read asset files
+		*
+		*  @return
+		*    The number of read asset files
+		*/
+		PLCore::uint32 GetNumOfReadFiles() const;
+
+		/**
+		*  @brief
+		*    Returns the number of read bytes
+		*
+		*  @return
+		*    The number of read bytes
+		*/
+		PLCore::uint64 GetNumOfReadBytes() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Asset type
+		*/
+		enum EAssetType {
+			MeshAsset     = 0,	/**< Mesh ("*.mesh") */
+			MaterialAsset = 1,	/**< Material ("*.mat") */
+			TextureAsset  = 2,	/**< Texture (e.g. "*.dds" or "*.tani") */
+			UnknownAsset  = 3	/**< Unknown asset type */
+		};
+
+		/**
+		*  @brief
+		*    Asset referenced by the scene
+		*/
+		struct Asset {
+			PLCore::String		  sFilename;		/**< Filename of the asset, exactly as referenced (resource managers use it as resource name) */
+			EAssetType			  nType;			/**< Asset type */
+			bool				  bRead;			/**< Was the asset file read? (guarded by the preloader mutex) */
+			PLCore::uint8		 *pnData;			/**< Read asset file data, null pointer if not read or already handed to the loader (guarded by the preloader mutex) */
+			PLCore::uint32		  nSize;			/**< Size of the read asset file data (in bytes) */
+			bool				  bCreated;			/**< Was the resource created? (main thread only) */
+			PLCore::Array<Asset*> lstDependencies;	/**< Assets this asset depends on (guarded by the preloader mutex) */
+		};
+
+		/**
+		*  @brief
+		*    Worker pool job reading an asset file
+		*/
+		class ReadJob : public WorkerPool::Job {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Constructor
+				*
+				*  @param[in] cScenePreloader
+				*    Owner scene preloader
+				*  @param[in] cAsset
+				*    Asset to read
+				*/
+				ReadJob(ScenePreloader &cScenePreloader, Asset &cAsset);
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual WorkerPool::Job functions              ]
+			//[-------------------------------------------------------]
+			public:
+				virtual void Execute() override;
+
+
+			//[-------------------------------------------------------]
+			//[ Private data                                          ]
+			//[-------------------------------------------------------]
+			private:
+				ScenePreloader *m_pScenePreloader;	/**< Owner scene preloader, always valid */
+				Asset		   *m_pAsset;			/**< Asset to read, always valid */
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		ScenePreloader(const ScenePreloader &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		ScenePreloader &operator =(const ScenePreloader &cSource);
+
+		/**
+		*  @brief
+		*    Collects the assets referenced by the attributes of a scene XML element and it's children
+		*
+		*  @param[in]  cElement
+		*    Scene XML element to collect the assets from
+		*  @param[out] lstAssets
+		*    Receives the referenced assets in scene order, each asset is only added once
+		*/
+		void CollectSceneAssets(const PLCore::XmlElement &cElement, PLCore::Array<Asset*> &lstAssets);
+
+		/**
+		*  @brief
+		*    Collects the assets referenced by the texts of a XML element and it's children
+		*
+		*  @param[in]  cElement
+		*    XML element to collect the assets from (e.g. a material or a texture animation)
+		*  @param[out] lstAssets
+		*    Receives the referenced assets, each asset is only added once
+		*/
+		void CollectTextAssets(const PLCore::XmlElement &cElement, PLCore::Array<Asset*> &lstAssets);
+
+		/**
+		*  @brief
+		*    Returns an asset, the asset is created and it's file reading is started if it's new
+		*
+		*  @param[in] sFilename
+		*    Filename of the asset
+		*
+		*  @return
+		*    The asset, null pointer if the filename doesn't look like an asset
+		*
+		*  @note
+		*    - Can be called by any thread
+		*/
+		Asset *RequestAsset(const PLCore::String &sFilename);
+
+		/**
+		*  @brief
+		*    Reads an asset file and requests it's dependencies
+		*
+		*  @param[in] cAsset
+		*    Asset to read
+		*
+		*  @note
+		*    - Called by a worker thread
+		*/
+		void ReadAsset(Asset &cAsset);
+
+		/**
+		*  @brief
+		*    Returns whether or not an asset and all its dependencies were read
+		*
+		*  @param[in] cAsset
+		*    Asset to check
+		*
+		*  @return
+		*    'true' if the asset and all its dependencies were read, else 'false'
+		*
+		*  @note
+		*    - The preloader mutex must be locked
+		*/
+		bool IsAssetReady(const Asset &cAsset) const;
+
+		/**
+		*  @brief
+		*    Creates the resource of an asset and the resources of its dependencies
+		*
+		*  @param[in] cAsset
+		*    Asset to create the resource from, must be ready, the read file data is released
+		*
+		*  @note
+		*    - Must be called by the main thread
+		*    - Resources which were already created are not created again
+		*/
+		void CreateResource(Asset &cAsset);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLScene::SceneContext											*m_pSceneContext;		/**< Scene context to create the resources within, always valid */
+		WorkerPool														 m_cWorkerPool;			/**< Worker pool reading the asset files */
+		mutable PLCore::Mutex											 m_cMutex;				/**< Mutex guarding the assets and the statistics */
+		PLCore::Semaphore												 m_cReadSemaphore;		/**< Unlocked each time an asset file has been read */
+		PLCore::Array<Asset*>											 m_lstAssets;			/**< All assets */
+		PLCore::HashMap<PLCore::String, Asset*>							 m_mapAssets;			/**< Assets by filename */
+		PLCore::uint32													 m_nNumOfReadFiles;		/**< Number of read asset files */
+		PLCore::uint64													 m_nNumOfReadBytes;		/**< Number of read bytes */
+		PLCore::Array<PLCore::ResourceHandler<PLMesh::Mesh>*>			 m_lstMeshHandlers;		/**< Handlers of the created meshes */
+		PLCore::Array<PLCore::ResourceHandler<PLRenderer::Material>*>	 m_lstMaterialHandlers;	/**< Handlers of the created materials */
+		PLCore::Array<PLCore::ResourceHandler<PLRenderer::Texture>*>	 m_lstTextureHandlers;	/**< Handlers of the created textures */
+
+
+};
+
+
+#endif // __DUNGEON_SCENEPRELOADER_H__
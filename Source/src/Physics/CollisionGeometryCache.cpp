@@ -0,0 +1,218 @@
+/*********************************************************\
+ *  File: CollisionGeometryCache.cpp                     *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLMath/Matrix3x4.h>
+#include <PLRenderer/Renderer/IndexBuffer.h>
+#include <PLRenderer/Renderer/VertexBuffer.h>
+#include <PLMesh/Mesh.h>
+#include <PLMesh/Geometry.h>
+#include <PLMesh/MeshLODLevel.h>
+#include <PLMesh/MeshMorphTarget.h>
+#include "Physics/CollisionGeometryCache.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLRenderer;
+using namespace PLMesh;
+
+
+//[-------------------------------------------------------]
+//[ Public CollisionGeometry functions                    ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Appends an instance of this geometry
+*/
+void CollisionGeometry::AppendInstance(const Matrix3x4 &mTransform, Array<Vector3> &lstVertices, Array<uint32> &lstIndices) const
+{
+	const uint32 nFirstVertex = lstVertices.GetNumOfElements();
+	for (uint32 i=0; i<this->lstVertices.GetNumOfElements(); i++)
+		lstVertices.Add(mTransform*this->lstVertices[i]);
+	for (uint32 i=0; i<this->lstIndices.GetNumOfElements(); i++)
+		lstIndices.Add(nFirstVertex + this->lstIndices[i]);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+CollisionGeometryCache::CollisionGeometryCache()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+CollisionGeometryCache::~CollisionGeometryCache()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Returns the collision geometry of a mesh
+*/
+const CollisionGeometry *CollisionGeometryCache::Get(const Mesh &cMesh)
+{
+	// Create the collision geometry on first request
+	CollisionGeometry *pGeometry = m_mapGeometries.Get(cMesh.GetName());
+	if (!pGeometry) {
+		pGeometry = new CollisionGeometry;
+		CreateGeometry(cMesh, *pGeometry);
+		m_lstGeometries.Add(pGeometry);
+		m_mapGeometries.Add(cMesh.GetName(), pGeometry);
+	}
+
+	// Meshes without triangles have no collision geometry
+	return pGeometry->lstIndices.GetNumOfElements() ? pGeometry : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the number of cached collision geometries
+*/
+uint32 CollisionGeometryCache::GetNumOfGeometries() const
+{
+	return m_lstGeometries.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Destroys all cached collision geometries
+*/
+void CollisionGeometryCache::Clear()
+{
+	for (uint32 i=0; i<m_lstGeometries.GetNumOfElements(); i++)
+		delete m_lstGeometries[i];
+	m_lstGeometries.Clear();
+	m_mapGeometries.Clear();
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+CollisionGeometryCache::CollisionGeometryCache(const CollisionGeometryCache &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+CollisionGeometryCache &CollisionGeometryCache::operator =(const CollisionGeometryCache &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Creates the collision geometry of a mesh
+*/
+void CollisionGeometryCache::CreateGeometry(const Mesh &cMesh, CollisionGeometry &cGeometry) const
+{
+	// Get the vertex buffer of the base morph target and the first LOD level
+	const MeshMorphTarget *pMorphTarget = cMesh.GetMorphTarget(0);
+	VertexBuffer *pVertexBuffer = pMorphTarget ? pMorphTarget->GetVertexBuffer() : nullptr;
+	const MeshLODLevel *pLODLevel = cMesh.GetNumOfLODLevels() ? cMesh.GetLODLevel(0) : nullptr;
+	IndexBuffer *pIndexBuffer = pLODLevel ? pLODLevel->GetIndexBuffer() : nullptr;
+	if (!pVertexBuffer || !pIndexBuffer)
+		return; // Error!
+
+	// Vertices
+	if (pVertexBuffer->Lock(Lock::ReadOnly)) {
+		cGeometry.lstVertices.Resize(pVertexBuffer->GetNumOfElements(), false, false);
+		for (uint32 i=0; i<pVertexBuffer->GetNumOfElements(); i++) {
+			const float *pfPosition = static_cast<const float*>(pVertexBuffer->GetData(i, VertexBuffer::Position));
+			cGeometry.lstVertices[i].SetXYZ(pfPosition[0], pfPosition[1], pfPosition[2]);
+		}
+		pVertexBuffer->Unlock();
+	}
+
+	// Triangles, strips and fans are converted into lists
+	if (cGeometry.lstVertices.GetNumOfElements() && pIndexBuffer->Lock(Lock::ReadOnly)) {
+		const Array<Geometry> &lstGeometries = *pLODLevel->GetGeometries();
+		for (uint32 nGeometry=0; nGeometry<lstGeometries.GetNumOfElements(); nGeometry++) {
+			const Geometry &cMeshGeometry = lstGeometries[nGeometry];
+			const uint32 nStart = cMeshGeometry.GetStartIndex();
+			const uint32 nSize  = cMeshGeometry.GetIndexSize();
+			for (uint32 nIndex=2; nIndex<nSize; nIndex++) {
+				uint32 nTriangle[3];
+				switch (cMeshGeometry.GetPrimitiveType()) {
+					case Primitive::TriangleList:
+						if (nIndex%3 != 2)
+							continue;
+						nTriangle[0] = pIndexBuffer->GetData(nStart + nIndex - 2);
+						nTriangle[1] = pIndexBuffer->GetData(nStart + nIndex - 1);
+						nTriangle[2] = pIndexBuffer->GetData(nStart + nIndex);
+						break;
+
+					case Primitive::TriangleStrip:
+						// Every second triangle of a strip has the opposite winding
+						nTriangle[0] = pIndexBuffer->GetData(nStart + nIndex - ((nIndex & 1) ? 1 : 2));
+						nTriangle[1] = pIndexBuffer->GetData(nStart + nIndex - ((nIndex & 1) ? 2 : 1));
+						nTriangle[2] = pIndexBuffer->GetData(nStart + nIndex);
+						break;
+
+					case Primitive::TriangleFan:
+						nTriangle[0] = pIndexBuffer->GetData(nStart);
+						nTriangle[1] = pIndexBuffer->GetData(nStart + nIndex - 1);
+						nTriangle[2] = pIndexBuffer->GetData(nStart + nIndex);
+						break;
+
+					default:
+						// No triangles
+						nIndex = nSize;
+						continue;
+				}
+
+				// Skip degenerated triangles (strips are using them to connect strips) and invalid indices
+				const uint32 nNumOfVertices = cGeometry.lstVertices.GetNumOfElements();
+				if (nTriangle[0] != nTriangle[1] && nTriangle[1] != nTriangle[2] && nTriangle[0] != nTriangle[2] &&
+					nTriangle[0] < nNumOfVertices && nTriangle[1] < nNumOfVertices && nTriangle[2] < nNumOfVertices) {
+					cGeometry.lstIndices.Add(nTriangle[0]);
+					cGeometry.lstIndices.Add(nTriangle[1]);
+					cGeometry.lstIndices.Add(nTriangle[2]);
+				}
+			}
+		}
+		pIndexBuffer->Unlock();
+	}
+}
@@ -0,0 +1,194 @@
+/*********************************************************\
+ *  File: CollisionGeometryCache.h                       *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_COLLISIONGEOMETRYCACHE_H__
+#define __DUNGEON_COLLISIONGEOMETRYCACHE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/HashMap.h>
+#include <PLMath/Vector3.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Matrix3x4;
+}
+namespace PLMesh {
+	class Mesh;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Collision geometry, triangles of a mesh within the mesh space
+*/
+class CollisionGeometry {
+
+
+	//[-------------------------------------------------------]
+	//[ Public data                                           ]
+	//[-------------------------------------------------------]
+	public:
+		PLCore::Array<PLMath::Vector3> lstVertices;	/**< Vertex positions within the mesh space */
+		PLCore::Array<PLCore::uint32>  lstIndices;	/**< Triangle list, three vertex indices per triangle */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Appends an instance of this geometry
+		*
+		*  @param[in]  mTransform
+		*    Instance transform (including the scale of the instance)
+		*  @param[out] lstVertices
+		*    Vertex positions the transformed vertices are appended to
+		*  @param[out] lstIndices
+		*    Triangle list the triangles are appended to, the vertex indices refer to "lstVertices"
+		*/
+		void AppendInstance(const PLMath::Matrix3x4 &mTransform, PLCore::Array<PLMath::Vector3> &lstVertices, PLCore::Array<PLCore::uint32> &lstIndices) const;
+
+
+};
+
+/**
+*  @brief
+*    Collision geometry cache, reads the triangles of each mesh only once for the users of this instance
+*
+*  @remarks
+*    The cache reads the triangles of a mesh only once and stores them without any scale, the instances are created
+*    by transforming the cached geometry by using the transform (including the scale) of each instance. Strips and fans
+*    are converted into triangle lists, degenerated triangles are removed.
+*
+*  @note
+*    - Only the users of the cache (e.g. the static collision merger and the ray query service) share the geometry,
+*      the physics backend still builds and caches its own collision tree per mesh and scale
+*/
+class CollisionGeometryCache {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		CollisionGeometryCache();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~CollisionGeometryCache();
+
+		/**
+		*  @brief
+		*    Returns the collision geometry of a mesh
+		*
+		*  @param[in] cMesh
+		*    Mesh to return the collision geometry of, the geometry is created on first request
+		*
+		*  @return
+		*    The collision geometry of the mesh, null pointer on error (e.g. no triangles)
+		*/
+		const CollisionGeometry *Get(const PLMesh::Mesh &cMesh);
+
+		/**
+		*  @brief
+		*    Returns the number of cached collision geometries
+		*
+		*  @return
+		*    The number of cached collision geometries
+		*/
+		PLCore::uint32 GetNumOfGeometries() const;
+
+		/**
+		*  @brief
+		*    Destroys all cached collision geometries
+		*/
+		void Clear();
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		CollisionGeometryCache(const CollisionGeometryCache &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		CollisionGeometryCache &operator =(const CollisionGeometryCache &cSource);
+
+		/**
+		*  @brief
+		*    Creates the collision geometry of a mesh
+		*
+		*  @param[in]  cMesh
+		*    Mesh to create the collision geometry of
+		*  @param[out] cGeometry
+		*    Receives the collision geometry
+		*/
+		void CreateGeometry(const PLMesh::Mesh &cMesh, CollisionGeometry &cGeometry) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<CollisionGeometry*>					 m_lstGeometries;	/**< Cached collision geometries, destroyed by this instance */
+		PLCore::HashMap<PLCore::String, CollisionGeometry*>	 m_mapGeometries;	/**< Cached collision geometries by mesh name */
+
+
+};
+
+
+#endif // __DUNGEON_COLLISIONGEOMETRYCACHE_H__
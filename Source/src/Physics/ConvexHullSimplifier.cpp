@@ -0,0 +1,289 @@
+/*********************************************************\
+ *  File: ConvexHullSimplifier.cpp                       *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Log/Log.h>
+#include <PLCore/File/Url.h>
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLMath/Math.h>
+#include <PLRenderer/Renderer/IndexBuffer.h>
+#include <PLRenderer/Renderer/VertexBuffer.h>
+#include <PLMesh/Geometry.h>
+#include <PLMesh/MeshManager.h>
+#include <PLMesh/MeshLODLevel.h>
+#include <PLMesh/MeshMorphTarget.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Physics/ConvexHullSimplifier.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLRenderer;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 NumOfDirections = 256;	/**< Number of sampled directions the hull distance is measured along */
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+ConvexHullSimplifier::ConvexHullSimplifier(MeshManager &cMeshManager, const String &sMeshFilenamePrefix, const String &sNativeFilenamePrefix,
+										   uint32 nMaxVertices, uint32 nMaxFaces, float fTolerance) :
+	m_pMeshManager(&cMeshManager),
+	m_sMeshFilenamePrefix(sMeshFilenamePrefix),
+	m_sNativeFilenamePrefix(sNativeFilenamePrefix),
+	m_nMaxVertices(Math::Max(Math::Min(nMaxVertices, (nMaxFaces + 4)/2), 4u)),
+	m_fTolerance(fTolerance)
+{
+	// Sample the directions evenly on the unit sphere (Fibonacci sphere)
+	const float fGoldenAngle = Math::Pi*(3.0f - Math::Sqrt(5.0f));
+	m_lstDirections.Resize(NumOfDirections, false, false);
+	for (uint32 i=0; i<NumOfDirections; i++) {
+		const float fY      = 1.0f - 2.0f*(i + 0.5f)/NumOfDirections;
+		const float fRadius = Math::Sqrt(1.0f - fY*fY);
+		const float fAngle  = fGoldenAngle*i;
+		m_lstDirections[i].SetXYZ(Math::Cos(fAngle)*fRadius, fY, Math::Sin(fAngle)*fRadius);
+	}
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+ConvexHullSimplifier::~ConvexHullSimplifier()
+{
+	for (uint32 i=0; i<m_lstHullMeshes.GetNumOfElements(); i++)
+		delete m_lstHullMeshes[i];
+}
+
+/**
+*  @brief
+*    Simplifies the convex hull bodies of a scene container
+*/
+uint32 ConvexHullSimplifier::Simplify(SceneContainer &cContainer)
+{
+	uint32 nNumOfSimplifiedBodies = 0;
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			// Convex hull body using the render mesh of its scene node?
+			SceneNodeModifier *pBody = pSceneNode->GetModifier("PLPhysics::SNMPhysicsBodyConvexHull");
+			DynVar *pCollisionMesh = pBody ? pBody->GetAttribute("Mesh") : nullptr;
+			if (pCollisionMesh && !pCollisionMesh->GetString().GetLength() && pSceneNode->IsInstanceOf("PLScene::SNMesh")) {
+				MeshHandler *pMeshHandler = static_cast<SNMesh*>(pSceneNode)->GetMeshHandler();
+				const Mesh *pMesh = pMeshHandler ? pMeshHandler->GetResource() : nullptr;
+				if (pMesh) {
+					// The hull mesh of a render mesh is shared by all instances of the render mesh
+					HullMesh *pHullMesh = m_mapHullMeshes.Get(pMesh->GetName());
+					if (!pHullMesh) {
+						pHullMesh = new HullMesh;
+						pHullMesh->sFilename = CreateHullMesh(*pMesh, pHullMesh->nNumOfVertices, pHullMesh->nNumOfHullVertices);
+						m_lstHullMeshes.Add(pHullMesh);
+						m_mapHullMeshes.Add(pMesh->GetName(), pHullMesh);
+					}
+
+					// Let the body use the hull mesh
+					if (pHullMesh->sFilename.GetLength()) {
+						pCollisionMesh->SetString(pHullMesh->sFilename);
+						nNumOfSimplifiedBodies++;
+						PL_LOG(Info, "Convex hull of \"" + pSceneNode->GetAbsoluteName() + "\": " + pHullMesh->nNumOfVertices + " -> " + pHullMesh->nNumOfHullVertices + " vertices")
+					}
+				}
+			}
+
+			// Child containers
+			if (pSceneNode->IsContainer())
+				nNumOfSimplifiedBodies += Simplify(static_cast<SceneContainer&>(*pSceneNode));
+		}
+	}
+	return nNumOfSimplifiedBodies;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+ConvexHullSimplifier::ConvexHullSimplifier(const ConvexHullSimplifier &cSource) :
+	m_pMeshManager(nullptr),
+	m_nMaxVertices(0),
+	m_fTolerance(0.0f)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+ConvexHullSimplifier &ConvexHullSimplifier::operator =(const ConvexHullSimplifier &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Selects the vertices of the simplified hull
+*/
+void ConvexHullSimplifier::SelectVertices(const Array<Vector3> &lstVertices, Array<Vector3> &lstHullVertices) const
+{
+	// Support function of the original hull: Distance of the support plane and the supporting vertex per direction
+	Array<float>  lstSupport;
+	Array<uint32> lstSupportVertices;
+	lstSupport.Resize(NumOfDirections, false, false);
+	lstSupportVertices.Resize(NumOfDirections, false, false);
+	for (uint32 nDirection=0; nDirection<NumOfDirections; nDirection++) {
+		const Vector3 &vDirection = m_lstDirections[nDirection];
+		lstSupport[nDirection] = vDirection.DotProduct(lstVertices[0]);
+		lstSupportVertices[nDirection] = 0;
+		for (uint32 i=1; i<lstVertices.GetNumOfElements(); i++) {
+			const float fDistance = vDirection.DotProduct(lstVertices[i]);
+			if (lstSupport[nDirection] < fDistance) {
+				lstSupport[nDirection] = fDistance;
+				lstSupportVertices[nDirection] = i;
+			}
+		}
+	}
+
+	// Support function of the simplified hull, there are no vertices yet
+	Array<float> lstHullSupport;
+	lstHullSupport.Resize(NumOfDirections, false, false);
+	for (uint32 nDirection=0; nDirection<NumOfDirections; nDirection++)
+		lstHullSupport[nDirection] = -Math::MaxFloat;
+
+	// Add the vertex supporting the worst direction until the simplified hull is good enough
+	while (lstHullVertices.GetNumOfElements() < m_nMaxVertices) {
+		// Get the worst direction
+		uint32 nWorstDirection = 0;
+		float fWorstDistance = 0.0f;
+		for (uint32 nDirection=0; nDirection<NumOfDirections; nDirection++) {
+			const float fDistance = lstSupport[nDirection] - lstHullSupport[nDirection];
+			if (fWorstDistance < fDistance) {
+				fWorstDistance = fDistance;
+				nWorstDirection = nDirection;
+			}
+		}
+
+		// Good enough? (a hull requires at least four vertices, a flat render mesh has less supporting vertices)
+		if (!fWorstDistance || (fWorstDistance <= m_fTolerance && lstHullVertices.GetNumOfElements() >= 4))
+			break;
+
+		// Add the supporting vertex and update the support function of the simplified hull
+		const Vector3 &vVertex = lstVertices[lstSupportVertices[nWorstDirection]];
+		lstHullVertices.Add(vVertex);
+		for (uint32 nDirection=0; nDirection<NumOfDirections; nDirection++) {
+			const float fDistance = m_lstDirections[nDirection].DotProduct(vVertex);
+			if (lstHullSupport[nDirection] < fDistance)
+				lstHullSupport[nDirection] = fDistance;
+		}
+	}
+}
+
+/**
+*  @brief
+*    Creates and saves the hull mesh of a render mesh
+*/
+String ConvexHullSimplifier::CreateHullMesh(const Mesh &cMesh, uint32 &nNumOfVertices, uint32 &nNumOfHullVertices)
+{
+	nNumOfVertices     = 0;
+	nNumOfHullVertices = 0;
+
+	// Get the vertices of the render mesh
+	const CollisionGeometry *pGeometry = m_cGeometryCache.Get(cMesh);
+	if (!pGeometry)
+		return ""; // Error!
+	nNumOfVertices = pGeometry->lstVertices.GetNumOfElements();
+
+	// Select the vertices of the simplified hull, without gain the render mesh stays in use
+	Array<Vector3> lstHullVertices;
+	SelectVertices(pGeometry->lstVertices, lstHullVertices);
+	nNumOfHullVertices = lstHullVertices.GetNumOfElements();
+	if (nNumOfHullVertices < 4 || nNumOfHullVertices >= nNumOfVertices)
+		return ""; // Error!
+
+	// Create the hull mesh
+	const String sName = Url(cMesh.GetName()).GetTitle() + "_Hull.mesh";
+	Mesh *pMesh = m_pMeshManager->Create(m_sMeshFilenamePrefix + sName);
+	if (!pMesh)
+		return ""; // Error!
+	MeshMorphTarget *pMorphTarget = pMesh->AddMorphTarget();
+	MeshLODLevel *pLODLevel = pMesh->AddLODLevel();
+	pLODLevel->CreateIndexBuffer();
+	pLODLevel->CreateGeometries();
+
+	// Vertices, just positions
+	VertexBuffer *pVertexBuffer = pMorphTarget->GetVertexBuffer();
+	pVertexBuffer->AddVertexAttribute(VertexBuffer::Position, 0, VertexBuffer::Float3);
+	pVertexBuffer->Allocate(nNumOfHullVertices, Usage::Static);
+	if (pVertexBuffer->Lock(Lock::WriteOnly)) {
+		for (uint32 i=0; i<nNumOfHullVertices; i++) {
+			float *pfPosition = static_cast<float*>(pVertexBuffer->GetData(i, VertexBuffer::Position));
+			pfPosition[0] = lstHullVertices[i].x;
+			pfPosition[1] = lstHullVertices[i].y;
+			pfPosition[2] = lstHullVertices[i].z;
+		}
+		pVertexBuffer->Unlock();
+	}
+
+	// The hull is built from the vertices, a point list is all the mesh needs
+	IndexBuffer *pIndexBuffer = pLODLevel->GetIndexBuffer();
+	pIndexBuffer->SetElementTypeByMaximumIndex(nNumOfHullVertices - 1);
+	pIndexBuffer->Allocate(nNumOfHullVertices, Usage::Static);
+	if (pIndexBuffer->Lock(Lock::WriteOnly)) {
+		for (uint32 i=0; i<nNumOfHullVertices; i++)
+			pIndexBuffer->SetData(i, i);
+		pIndexBuffer->Unlock();
+	}
+	Geometry &cGeometry = pLODLevel->GetGeometries()->Add();
+	cGeometry.SetPrimitiveType(Primitive::PointList);
+	cGeometry.SetStartIndex(0);
+	cGeometry.SetIndexSize(nNumOfHullVertices);
+
+	// Save the hull mesh, the compiled scene references it by its filename
+	if (!pMesh->SaveByFilename(m_sNativeFilenamePrefix + sName)) {
+		delete pMesh;
+		return ""; // Error!
+	}
+
+	// Done
+	return m_sMeshFilenamePrefix + sName;
+}
@@ -0,0 +1,206 @@
+/*********************************************************\
+ *  File: ConvexHullSimplifier.h                         *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_CONVEXHULLSIMPLIFIER_H__
+#define __DUNGEON_CONVEXHULLSIMPLIFIER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/HashMap.h>
+#include <PLMath/Vector3.h>
+#include "Physics/CollisionGeometryCache.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMesh {
+	class MeshManager;
+}
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Convex hull simplifier, replaces the render meshes of convex hull bodies by simplified hull meshes
+*
+*  @remarks
+*    A "PLPhysics::SNMPhysicsBodyConvexHull" without collision mesh builds its convex hull from all vertices of the
+*    render mesh of its scene node, each time the scene is loaded. The simplifier selects a few vertices of the
+*    render mesh spanning nearly the same hull and saves them as collision mesh, which is then used by the body.
+*
+*    The vertices are selected greedily by using the support function of the hull: Along a fixed set of sampled
+*    directions, the distance between the support planes of the original and the simplified hull is measured,
+*    the original vertex supporting the worst direction is added next. The selection stops as soon as the
+*    simplified hull is within the tolerance along all sampled directions or the vertex cap has been reached.
+*    Because a hull with n vertices has at most 2n-4 faces, the face cap is a vertex cap as well.
+*
+*  @note
+*    - Meant to be used when compiling a scene, the compiled scene then references the simplified hull meshes
+*    - The tolerance is given within mesh space, the scale of a scene node scales the hull and its error
+*/
+class ConvexHullSimplifier {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] cMeshManager
+		*    Mesh manager used to create the hull meshes, must stay valid as long as this instance exists
+		*  @param[in] sMeshFilenamePrefix
+		*    Prefix of the hull mesh filenames used by the scene (e.g. "Data/Scenes/Dungeon_"), the render mesh name
+		*    and "_Hull.mesh" are appended
+		*  @param[in] sNativeFilenamePrefix
+		*    Prefix of the native filenames the hull meshes are saved to
+		*  @param[in] nMaxVertices
+		*    Maximum number of hull vertices (at least 4)
+		*  @param[in] nMaxFaces
+		*    Maximum number of hull faces (at least 4)
+		*  @param[in] fTolerance
+		*    Maximum distance between the original and the simplified hull (in mesh units)
+		*/
+		ConvexHullSimplifier(PLMesh::MeshManager &cMeshManager, const PLCore::String &sMeshFilenamePrefix, const PLCore::String &sNativeFilenamePrefix,
+							 PLCore::uint32 nMaxVertices, PLCore::uint32 nMaxFaces, float fTolerance);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~ConvexHullSimplifier();
+
+		/**
+		*  @brief
+		*    Simplifies the convex hull bodies of a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container to simplify the convex hull bodies of, child containers are taken into account
+		*
+		*  @return
+		*    Number of simplified convex hull bodies
+		*
+		*  @note
+		*    - The vertex counts before and after the simplification are written into the log for each body
+		*    - Bodies which already have a collision mesh are left alone
+		*/
+		PLCore::uint32 Simplify(PLScene::SceneContainer &cContainer);
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		ConvexHullSimplifier(const ConvexHullSimplifier &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		ConvexHullSimplifier &operator =(const ConvexHullSimplifier &cSource);
+
+		/**
+		*  @brief
+		*    Selects the vertices of the simplified hull
+		*
+		*  @param[in]  lstVertices
+		*    Vertices of the original hull
+		*  @param[out] lstHullVertices
+		*    Receives the vertices of the simplified hull
+		*/
+		void SelectVertices(const PLCore::Array<PLMath::Vector3> &lstVertices, PLCore::Array<PLMath::Vector3> &lstHullVertices) const;
+
+		/**
+		*  @brief
+		*    Creates and saves the hull mesh of a render mesh
+		*
+		*  @param[in] cMesh
+		*    Render mesh
+		*  @param[out] nNumOfVertices
+		*    Receives the number of vertices of the render mesh
+		*  @param[out] nNumOfHullVertices
+		*    Receives the number of vertices of the hull mesh
+		*
+		*  @return
+		*    Filename of the hull mesh as used by the scene, empty string if the render mesh can't be simplified
+		*/
+		PLCore::String CreateHullMesh(const PLMesh::Mesh &cMesh, PLCore::uint32 &nNumOfVertices, PLCore::uint32 &nNumOfHullVertices);
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Hull mesh of a render mesh
+		*/
+		struct HullMesh {
+			PLCore::String sFilename;			/**< Filename of the hull mesh as used by the scene, empty if the render mesh can't be simplified */
+			PLCore::uint32 nNumOfVertices;		/**< Number of vertices of the render mesh */
+			PLCore::uint32 nNumOfHullVertices;	/**< Number of vertices of the hull mesh */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLMesh::MeshManager									*m_pMeshManager;			/**< Mesh manager used to create the hull meshes, always valid */
+		PLCore::String										 m_sMeshFilenamePrefix;		/**< Prefix of the hull mesh filenames used by the scene */
+		PLCore::String										 m_sNativeFilenamePrefix;	/**< Prefix of the native filenames the hull meshes are saved to */
+		PLCore::uint32										 m_nMaxVertices;			/**< Maximum number of hull vertices, including the face cap */
+		float												 m_fTolerance;				/**< Maximum distance between the original and the simplified hull (in mesh units) */
+		PLCore::Array<PLMath::Vector3>						 m_lstDirections;			/**< Sampled directions the hull distance is measured along */
+		CollisionGeometryCache								 m_cGeometryCache;			/**< Vertices of the render meshes */
+		PLCore::Array<HullMesh*>							 m_lstHullMeshes;			/**< Hull meshes, the instances are owned by this simplifier */
+		PLCore::HashMap<PLCore::String, HullMesh*>			 m_mapHullMeshes;			/**< Hull mesh per render mesh name */
+
+
+};
+
+
+#endif // __DUNGEON_CONVEXHULLSIMPLIFIER_H__
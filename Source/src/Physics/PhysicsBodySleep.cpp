@@ -0,0 +1,79 @@
+/*********************************************************\
+ *  File: PhysicsBodySleep.cpp                           *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLPhysics/Body.h>
+#include <PLPhysics/SceneNodeModifiers/SNMPhysicsBody.h>
+#include "Physics/PhysicsBodySleep.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+using namespace PLPhysics;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Puts the dynamic bodies of a scene container to sleep
+*/
+uint32 PhysicsBodySleep::FreezeBodies(SceneContainer &cContainer)
+{
+	uint32 nNumOfFrozenBodies = 0;
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			// Get the body and check for a character controller
+			Body *pBody = nullptr;
+			bool bController = false;
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+				SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", j);
+				if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody"))
+					pBody = static_cast<SNMPhysicsBody*>(pSceneNodeModifier)->GetBody();
+				else if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsCharacter"))
+					bController = true;
+			}
+
+			// Static bodies are never simulated
+			if (pBody && !bController && pBody->GetMass() > 0.0f && !pBody->IsFrozen()) {
+				pBody->SetFrozen(true);
+				nNumOfFrozenBodies++;
+			}
+
+			// Child containers
+			if (pSceneNode->IsContainer())
+				nNumOfFrozenBodies += FreezeBodies(static_cast<SceneContainer&>(*pSceneNode));
+		}
+	}
+
+	// Done
+	return nNumOfFrozenBodies;
+}
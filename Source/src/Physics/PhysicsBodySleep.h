@@ -0,0 +1,84 @@
+/*********************************************************\
+ *  File: PhysicsBodySleep.h                             *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PHYSICSBODYSLEEP_H__
+#define __DUNGEON_PHYSICSBODYSLEEP_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/PLCore.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Puts the dynamic bodies of a loaded scene to sleep
+*
+*  @remarks
+*    The physics backend writes the transform of each awake body back into its scene node after each step,
+*    the transforms of sleeping (frozen) bodies are neither simulated nor written back. The props of the scene
+*    are placed at rest, but the bodies are created awake and the backend has to simulate them until they
+*    are frozen automatically - up to a few seconds with hundreds of props writing back their unchanged
+*    transforms. Putting them to sleep right after the scene has been loaded skips this, a sleeping body is
+*    woken up as soon as something touches it.
+*/
+class PhysicsBodySleep {
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Puts the dynamic bodies of a scene container to sleep
+		*
+		*  @param[in] cContainer
+		*    Scene container to put the dynamic bodies of to sleep, child containers are taken into account
+		*
+		*  @return
+		*    Number of bodies which were put to sleep
+		*
+		*  @note
+		*    - Bodies of scene nodes with a character controller are left awake, the controller moves them by using the velocity
+		*    - Must only be called right after the bodies were created, a moving body would stop at once
+		*/
+		static PLCore::uint32 FreezeBodies(PLScene::SceneContainer &cContainer);
+
+
+};
+
+
+#endif // __DUNGEON_PHYSICSBODYSLEEP_H__
@@ -0,0 +1,387 @@
+/*********************************************************\
+ *  File: PhysicsCacheArchive.cpp                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <string.h>
+#include <PLCore/File/File.h>
+#include <PLCore/File/Directory.h>
+#include <PLCore/File/FileSearch.h>
+#include <PLCore/Container/Array.h>
+#include "Tools/Trace.h"
+#include "Physics/PhysicsCacheSources.h"
+#include "Physics/PhysicsCacheArchive.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the 64 bit FNV-1a hash of the given data
+*/
+uint64 PhysicsCacheArchive::GetHash(const uint8 *pnData, uint32 nSize, uint64 nHash)
+{
+	for (uint32 i=0; i<nSize; i++) {
+		nHash ^= pnData[i];
+		nHash *= 1099511628211ULL;
+	}
+	return nHash;
+}
+
+/**
+*  @brief
+*    Packs all collision cache files of a directory into an archive
+*/
+bool PhysicsCacheArchive::Build(const String &sDirectory, const String &sFilename, uint32 nNumOfThreads, const Array<String> *plstUsedNames)
+{
+	TraceScope cTraceScope("PhysicsCacheArchive::Build", "Physics", sFilename);
+
+	// Collect the names of the used cache files and sort them (insertion sort, there are just a few hundred of them)
+	Array<String> lstNames;
+	Directory cDirectory(sDirectory);
+	FileSearch cSearch(cDirectory, "*.tc");
+	while (cSearch.HasNextFile()) {
+		const String sName = cSearch.GetNextFile();
+		if (plstUsedNames && !plstUsedNames->IsElement(sName))
+			continue;
+		uint32 nIndex = lstNames.GetNumOfElements();
+		lstNames.Add(sName);
+		for (; nIndex && strcmp(lstNames[nIndex - 1].GetASCII(), sName.GetASCII()) > 0; nIndex--)
+			lstNames[nIndex] = lstNames[nIndex - 1];
+		lstNames[nIndex] = sName;
+	}
+	if (!lstNames.GetNumOfElements())
+		return false; // Error!
+
+	// Hash the source meshes
+	PhysicsCacheSources cSources(nNumOfThreads);
+	cSources.Hash(lstNames);
+
+	// Layout: Header, entries, zero terminated names, entry contents (each starting at an "Alignment" boundary)
+	Header sHeader;
+	sHeader.nMagic         = Magic;
+	sHeader.nVersion       = Version;
+	sHeader.nNumOfEntries  = lstNames.GetNumOfElements();
+	sHeader.nEntriesOffset = sizeof(Header);
+	sHeader.nNamesOffset   = sHeader.nEntriesOffset + sHeader.nNumOfEntries*sizeof(Entry);
+	sHeader.nNamesSize     = 0;
+	Array<Entry> lstEntries;
+	lstEntries.Resize(sHeader.nNumOfEntries);
+	for (uint32 i=0; i<sHeader.nNumOfEntries; i++) {
+		Entry &sEntry = lstEntries[i];
+		sEntry.nName       = sHeader.nNamesSize;
+		sEntry.nOffset     = 0;
+		sEntry.nSize       = 0;
+		sEntry.nReserved   = 0;
+		sEntry.nHash       = GetHash(nullptr, 0);
+		sEntry.nSourceHash = cSources.GetSourceHash(lstNames[i]);
+		sHeader.nNamesSize += lstNames[i].GetLength() + 1;
+	}
+
+	// Open the archive file
+	File cArchive(sFilename);
+	if (!cArchive.Open(File::FileCreate | File::FileWrite))
+		return false; // Error!
+
+	// Write the header and the names, the entries are written as soon as the contents are known
+	bool bResult = (cArchive.Write(&sHeader, sizeof(Header), 1) == 1 &&
+					cArchive.Write(lstEntries.GetData(), sizeof(Entry), sHeader.nNumOfEntries) == sHeader.nNumOfEntries);
+	for (uint32 i=0; i<sHeader.nNumOfEntries && bResult; i++) {
+		const uint32 nLength = lstNames[i].GetLength() + 1;
+		bResult = (cArchive.Write(lstNames[i].GetASCII(), 1, nLength) == nLength);
+	}
+
+	// Write the entry contents
+	static const uint8 nZero[Alignment] = { 0 };
+	uint32 nOffset = sHeader.nNamesOffset + sHeader.nNamesSize;
+	Array<uint8> lstContent;
+	for (uint32 i=0; i<sHeader.nNumOfEntries && bResult; i++) {
+		// Align the content
+		const uint32 nPadding = (Alignment - (nOffset % Alignment)) % Alignment;
+		if (nPadding) {
+			bResult = (cArchive.Write(nZero, 1, nPadding) == nPadding);
+			nOffset += nPadding;
+		}
+
+		// Read the cache file
+		File cFile(sDirectory + '/' + lstNames[i]);
+		if (bResult && cFile.Open(File::FileRead)) {
+			const uint32 nSize = cFile.GetSize();
+			lstContent.Resize(nSize, false, false);
+			bResult = (!nSize || cFile.Read(lstContent.GetData(), 1, nSize) == nSize);
+			cFile.Close();
+
+			// Write the content
+			if (bResult && nSize)
+				bResult = (cArchive.Write(lstContent.GetData(), 1, nSize) == nSize);
+			Entry &sEntry = lstEntries[i];
+			sEntry.nOffset = nOffset;
+			sEntry.nSize   = nSize;
+			sEntry.nHash   = GetHash(lstContent.GetData(), nSize);
+			nOffset += nSize;
+		} else {
+			// Error!
+			bResult = false;
+		}
+	}
+
+	// Write the final entries
+	if (bResult)
+		bResult = (cArchive.Seek(sHeader.nEntriesOffset) && cArchive.Write(lstEntries.GetData(), sizeof(Entry), sHeader.nNumOfEntries) == sHeader.nNumOfEntries);
+
+	// Done
+	cArchive.Close();
+	return bResult;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PhysicsCacheArchive::PhysicsCacheArchive() :
+	m_pHeader(nullptr),
+	m_pEntries(nullptr),
+	m_pszNames(nullptr)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+PhysicsCacheArchive::~PhysicsCacheArchive()
+{
+}
+
+/**
+*  @brief
+*    Opens an archive
+*/
+bool PhysicsCacheArchive::Open(const String &sNativeFilename)
+{
+	// Close the previous archive
+	Close();
+
+	// Map the archive file
+	if (!m_cFile.Open(sNativeFilename))
+		return false; // Error!
+	const uint8 *pnData = m_cFile.GetData();
+	const uint32 nSize = m_cFile.GetSize();
+
+	// Check the header and the entries, so the getters don't need to
+	const Header *pHeader = reinterpret_cast<const Header*>(pnData);
+	bool bValid = (nSize >= sizeof(Header) && pHeader->nMagic == Magic && pHeader->nVersion == Version &&
+				   pHeader->nEntriesOffset <= nSize && pHeader->nNumOfEntries <= (nSize - pHeader->nEntriesOffset)/sizeof(Entry) &&
+				   pHeader->nNamesOffset <= nSize && pHeader->nNamesSize <= nSize - pHeader->nNamesOffset &&
+				   pHeader->nNamesSize && pnData[pHeader->nNamesOffset + pHeader->nNamesSize - 1] == '\0');
+	if (bValid) {
+		const Entry *pEntries = reinterpret_cast<const Entry*>(pnData + pHeader->nEntriesOffset);
+		for (uint32 i=0; i<pHeader->nNumOfEntries && bValid; i++)
+			bValid = (pEntries[i].nName < pHeader->nNamesSize && pEntries[i].nOffset <= nSize && pEntries[i].nSize <= nSize - pEntries[i].nOffset);
+	}
+	if (!bValid) {
+		m_cFile.Close();
+		return false; // Error!
+	}
+
+	// Done
+	m_pHeader  = pHeader;
+	m_pEntries = reinterpret_cast<const Entry*>(pnData + pHeader->nEntriesOffset);
+	m_pszNames = reinterpret_cast<const char*>(pnData + pHeader->nNamesOffset);
+	return true;
+}
+
+/**
+*  @brief
+*    Closes the archive
+*/
+void PhysicsCacheArchive::Close()
+{
+	m_pHeader  = nullptr;
+	m_pEntries = nullptr;
+	m_pszNames = nullptr;
+	m_cFile.Close();
+}
+
+/**
+*  @brief
+*    Returns whether or not an archive is opened
+*/
+bool PhysicsCacheArchive::IsOpen() const
+{
+	return (m_pHeader != nullptr);
+}
+
+/**
+*  @brief
+*    Returns the number of entries
+*/
+uint32 PhysicsCacheArchive::GetNumOfEntries() const
+{
+	return m_pHeader ? m_pHeader->nNumOfEntries : 0;
+}
+
+/**
+*  @brief
+*    Returns the name of an entry
+*/
+const char *PhysicsCacheArchive::GetEntryName(uint32 nIndex) const
+{
+	return (nIndex < GetNumOfEntries()) ? m_pszNames + m_pEntries[nIndex].nName : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the content of an entry
+*/
+const uint8 *PhysicsCacheArchive::GetEntryData(uint32 nIndex, uint32 &nSize) const
+{
+	if (nIndex < GetNumOfEntries()) {
+		nSize = m_pEntries[nIndex].nSize;
+		return m_cFile.GetData() + m_pEntries[nIndex].nOffset;
+	}
+
+	// Error!
+	nSize = 0;
+	return nullptr;
+}
+
+/**
+*  @brief
+*    Checks the content of an entry against its hash
+*/
+bool PhysicsCacheArchive::IsEntryValid(uint32 nIndex) const
+{
+	uint32 nSize = 0;
+	const uint8 *pnData = GetEntryData(nIndex, nSize);
+	return (pnData && GetHash(pnData, nSize) == m_pEntries[nIndex].nHash);
+}
+
+/**
+*  @brief
+*    Returns the index of an entry by using its name
+*/
+uint32 PhysicsCacheArchive::FindEntry(const String &sName) const
+{
+	// Binary search, the entries are sorted by name
+	uint32 nFirst = 0;
+	uint32 nLast  = GetNumOfEntries();
+	while (nFirst < nLast) {
+		const uint32 nMiddle = nFirst + (nLast - nFirst)/2;
+		const int nCompare = strcmp(m_pszNames + m_pEntries[nMiddle].nName, sName.GetASCII());
+		if (!nCompare)
+			return nMiddle;
+		if (nCompare < 0)
+			nFirst = nMiddle + 1;
+		else
+			nLast = nMiddle;
+	}
+
+	// Not found
+	return NoEntry;
+}
+
+/**
+*  @brief
+*    Restores the collision cache files of a directory
+*/
+uint32 PhysicsCacheArchive::Extract(const String &sDirectory, uint32 nNumOfThreads, uint32 &nNumOfStaleEntries) const
+{
+	TraceScope cTraceScope("PhysicsCacheArchive::Extract", "Physics", sDirectory);
+	uint32 nNumOfWrittenFiles = 0;
+	nNumOfStaleEntries = 0;
+
+	// Hash the source meshes
+	Array<String> lstNames;
+	for (uint32 i=0; i<GetNumOfEntries(); i++)
+		lstNames.Add(GetEntryName(i));
+	PhysicsCacheSources cSources(nNumOfThreads);
+	cSources.Hash(lstNames);
+
+	// Create the directory if required
+	Directory cDirectory(sDirectory);
+	if (GetNumOfEntries() && (cDirectory.Exists() || cDirectory.CreateRecursive())) {
+		for (uint32 i=0; i<GetNumOfEntries(); i++) {
+			File cFile(sDirectory + '/' + lstNames[i]);
+
+			// Has the mesh been changed since the archive was built? Then the cache file is stale as well, unless
+			// the physics backend has rebuilt it after the change - which can't be told, so it's rebuilt once more.
+			if (cSources.GetSourceHash(lstNames[i]) != m_pEntries[i].nSourceHash) {
+				nNumOfStaleEntries++;
+				if (cFile.Exists())
+					cFile.Delete();
+
+			// Is the cache file missing or outdated?
+			} else if (!cFile.Exists() || cFile.GetSize() != m_pEntries[i].nSize) {
+				// Never restore damaged content, the physics backend would use it without any further checks
+				if (IsEntryValid(i) && cFile.Open(File::FileCreate | File::FileWrite)) {
+					uint32 nSize = 0;
+					const uint8 *pnData = GetEntryData(i, nSize);
+					if (!nSize || cFile.Write(pnData, 1, nSize) == nSize)
+						nNumOfWrittenFiles++;
+					cFile.Close();
+				}
+			}
+		}
+	}
+
+	// Done
+	return nNumOfWrittenFiles;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+PhysicsCacheArchive::PhysicsCacheArchive(const PhysicsCacheArchive &cSource) :
+	m_pHeader(nullptr),
+	m_pEntries(nullptr),
+	m_pszNames(nullptr)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+PhysicsCacheArchive &PhysicsCacheArchive::operator =(const PhysicsCacheArchive &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
@@ -0,0 +1,308 @@
+/*********************************************************\
+ *  File: PhysicsCacheArchive.h                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PHYSICSCACHEARCHIVE_H__
+#define __DUNGEON_PHYSICSCACHEARCHIVE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/Array.h>
+#include "Tools/MemoryMappedFile.h"
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Physics collision cache archive
+*
+*  @remarks
+*    The physics backend serializes each collision tree it has built into an own small file within the cache
+*    directory of the physics world (e.g. "Data#Meshes#Dungeon#Cave_Cave10#mesh_1_1_1.tc"). The archive packs all
+*    of these files into a single file: a header, an index of entries sorted by name (so an entry is found by
+*    a binary search), a table of zero terminated names and the entry contents. Each entry content starts at a
+*    64 byte boundary and comes with a 64 bit FNV-1a hash of the content, so a damaged entry is detected before
+*    it's used. The archive is only written by "Build()" and used directly from a read-only memory mapped file.
+*
+*    Each entry also stores the source hash of the mesh and the scale it was built from (see "PhysicsCacheSources").
+*    Entries whose mesh has been changed since the archive was built are stale and never restored.
+*
+*    The archive is the deployment form of the cache - instead of copying hundreds of small files, a single file
+*    is copied (or read from a network share) and the cache directory is restored from it by "Extract()".
+*/
+class PhysicsCacheArchive {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 Magic     = 0x43504C50;	/**< Archive magic number ("PLPC") */
+		static const PLCore::uint32 Version   = 2;			/**< Archive format version */
+		static const PLCore::uint32 Alignment = 64;			/**< Alignment of the entry contents (in bytes) */
+		static const PLCore::uint32 NoEntry   = 0xFFFFFFFF;	/**< Entry index returned by "FindEntry()" if there's no such entry */
+
+		/**
+		*  @brief
+		*    File header
+		*/
+		struct Header {
+			PLCore::uint32 nMagic;			/**< Magic number, must be "Magic" */
+			PLCore::uint32 nVersion;		/**< Format version, must be "Version" */
+			PLCore::uint32 nNumOfEntries;	/**< Number of entries */
+			PLCore::uint32 nEntriesOffset;	/**< Offset of the entries (relative to the file start) */
+			PLCore::uint32 nNamesOffset;	/**< Offset of the name table (relative to the file start) */
+			PLCore::uint32 nNamesSize;		/**< Size of the name table (in bytes) */
+		};
+
+		/**
+		*  @brief
+		*    Entry, the entries are sorted by name
+		*/
+		struct Entry {
+			PLCore::uint32 nName;			/**< Offset of the zero terminated entry name (relative to the name table start) */
+			PLCore::uint32 nOffset;			/**< Offset of the content (relative to the file start, multiple of "Alignment") */
+			PLCore::uint32 nSize;			/**< Size of the content (in bytes) */
+			PLCore::uint32 nReserved;		/**< Reserved, always 0 */
+			PLCore::uint64 nHash;			/**< FNV-1a hash of the content */
+			PLCore::uint64 nSourceHash;		/**< Source hash of the mesh and scale the content was built from, "PhysicsCacheSources::UnknownSource" if unknown */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns the 64 bit FNV-1a hash of the given data
+		*
+		*  @param[in] pnData
+		*    Data to hash, can be a null pointer if "nSize" is 0
+		*  @param[in] nSize
+		*    Size of the data (in bytes)
+		*  @param[in] nHash
+		*    Hash to continue, e.g. the hash of previous data
+		*
+		*  @return
+		*    The 64 bit FNV-1a hash of the given data
+		*/
+		static PLCore::uint64 GetHash(const PLCore::uint8 *pnData, PLCore::uint32 nSize, PLCore::uint64 nHash = 14695981039346656037ULL);
+
+		/**
+		*  @brief
+		*    Packs all collision cache files of a directory into an archive
+		*
+		*  @param[in] sDirectory
+		*    Physics cache directory (e.g. "../_Cache/PLPhysicsNewton")
+		*  @param[in] sFilename
+		*    Name of the archive file to write, an existing archive is overwritten
+		*  @param[in] nNumOfThreads
+		*    Number of threads hashing the source meshes
+		*  @param[in] plstUsedNames
+		*    Names of the cache files to pack (see "PhysicsCacheSources::GetUsedCacheNames()"), null pointer to pack all cache files
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*
+		*  @note
+		*    - The archive must not be opened by a "PhysicsCacheArchive" instance at the same time
+		*    - The cache files must be up-to-date, stale cache files are removed by "Extract()"
+		*/
+		static bool Build(const PLCore::String &sDirectory, const PLCore::String &sFilename, PLCore::uint32 nNumOfThreads, const PLCore::Array<PLCore::String> *plstUsedNames = nullptr);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		PhysicsCacheArchive();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~PhysicsCacheArchive();
+
+		/**
+		*  @brief
+		*    Opens an archive
+		*
+		*  @param[in] sNativeFilename
+		*    Native filename of the archive
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (file not found or not a valid archive)
+		*
+		*  @note
+		*    - A previously opened archive is closed
+		*/
+		bool Open(const PLCore::String &sNativeFilename);
+
+		/**
+		*  @brief
+		*    Closes the archive
+		*/
+		void Close();
+
+		/**
+		*  @brief
+		*    Returns whether or not an archive is opened
+		*
+		*  @return
+		*    'true' if an archive is opened, else 'false'
+		*/
+		bool IsOpen() const;
+
+		/**
+		*  @brief
+		*    Returns the number of entries
+		*
+		*  @return
+		*    The number of entries, 0 if no archive is opened
+		*/
+		PLCore::uint32 GetNumOfEntries() const;
+
+		/**
+		*  @brief
+		*    Returns the name of an entry
+		*
+		*  @param[in] nIndex
+		*    Entry index
+		*
+		*  @return
+		*    The zero terminated name of the entry, null pointer on error
+		*/
+		const char *GetEntryName(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the content of an entry
+		*
+		*  @param[in] nIndex
+		*    Entry index
+		*  @param[out] nSize
+		*    Receives the size of the content (in bytes), 0 on error
+		*
+		*  @return
+		*    The content of the entry pointing directly into the mapped archive, null pointer on error
+		*
+		*  @note
+		*    - The content is not checked against its hash, use "IsEntryValid()" to do so
+		*/
+		const PLCore::uint8 *GetEntryData(PLCore::uint32 nIndex, PLCore::uint32 &nSize) const;
+
+		/**
+		*  @brief
+		*    Checks the content of an entry against its hash
+		*
+		*  @param[in] nIndex
+		*    Entry index
+		*
+		*  @return
+		*    'true' if the content matches its hash, else 'false'
+		*/
+		bool IsEntryValid(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the index of an entry by using its name
+		*
+		*  @param[in] sName
+		*    Entry name (e.g. "Data#Meshes#Dungeon#Cave_Cave10#mesh_1_1_1.tc")
+		*
+		*  @return
+		*    The index of the entry, "NoEntry" if there's no such entry
+		*/
+		PLCore::uint32 FindEntry(const PLCore::String &sName) const;
+
+		/**
+		*  @brief
+		*    Restores the collision cache files of a directory
+		*
+		*  @param[in] sDirectory
+		*    Physics cache directory (e.g. "../_Cache/PLPhysicsNewton"), is created if required
+		*  @param[in] nNumOfThreads
+		*    Number of threads hashing the source meshes
+		*  @param[out] nNumOfStaleEntries
+		*    Receives the number of stale entries
+		*
+		*  @return
+		*    The number of written cache files
+		*
+		*  @remarks
+		*    Only cache files which don't exist or have another size than the archived content are written, so
+		*    usually nothing is written at all. Entries which don't match their hash are skipped, the physics
+		*    backend then builds the collision tree from the mesh as usual. The cache files of stale entries are
+		*    removed, so the physics backend rebuilds them from the changed meshes instead of loading stale trees.
+		*/
+		PLCore::uint32 Extract(const PLCore::String &sDirectory, PLCore::uint32 nNumOfThreads, PLCore::uint32 &nNumOfStaleEntries) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		PhysicsCacheArchive(const PhysicsCacheArchive &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		PhysicsCacheArchive &operator =(const PhysicsCacheArchive &cSource);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		MemoryMappedFile  m_cFile;		/**< Memory mapped archive file */
+		const Header	 *m_pHeader;	/**< Archive header, null pointer if no archive is opened */
+		const Entry		 *m_pEntries;	/**< Archive entries, null pointer if no archive is opened */
+		const char		 *m_pszNames;	/**< Archive name table, null pointer if no archive is opened */
+
+
+};
+
+
+#endif // __DUNGEON_PHYSICSCACHEARCHIVE_H__
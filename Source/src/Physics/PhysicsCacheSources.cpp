@@ -0,0 +1,240 @@
+/*********************************************************\
+ *  File: PhysicsCacheSources.cpp                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/File.h>
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/Tools/LoadableManager.h>
+#include <PLMath/Vector3.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include "Tools/Trace.h"
+#include "Physics/PhysicsCacheArchive.h"
+#include "Physics/PhysicsCacheSources.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the mesh filename and the scale key of a cache file
+*/
+bool PhysicsCacheSources::GetSource(const String &sName, String &sMeshFilename, String &sScaleKey)
+{
+	// The physics backend replaces '/' and '.' of the mesh filename by '#' and appends '_' and the scale key
+	const int nMesh = sName.LastIndexOf("#mesh_");
+	if (nMesh > 0 && sName.EndsWith(".tc")) {
+		sMeshFilename = sName.GetSubstring(0, nMesh);
+		sMeshFilename.Replace('#', '/');
+		sMeshFilename += ".mesh";
+		sScaleKey = sName.GetSubstring(nMesh + 6, sName.GetLength() - nMesh - 6 - 3);
+		return true;
+	}
+
+	// Error!
+	return false;
+}
+
+/**
+*  @brief
+*    Returns the name of the cache file of a mesh and scale
+*/
+String PhysicsCacheSources::GetCacheName(const String &sMeshFilename, const Vector3 &vScale)
+{
+	// The physics backend appends the scale components to the mesh filename and replaces all directory separators and dots by '#'
+	String sName = sMeshFilename + '_' + vScale.x + '_' + vScale.y + '_' + vScale.z;
+	sName.Replace('/',  '#');
+	sName.Replace('\\', '#');
+	sName.Replace('.',  '#');
+	return sName + ".tc";
+}
+
+/**
+*  @brief
+*    Collects the names of the cache files used by the mesh bodies of a scene
+*/
+void PhysicsCacheSources::GetUsedCacheNames(const SceneContainer &cContainer, Array<String> &lstNames)
+{
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		const SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			// Does the scene node have a mesh body?
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+				if (pSceneNode->GetModifier("", j)->IsInstanceOf("PLPhysics::SNMPhysicsBodyMesh")) {
+					const DynVar *pMesh = pSceneNode->GetAttribute("Mesh");
+					if (pMesh) {
+						const String sName = GetCacheName(pMesh->GetString(), pSceneNode->GetTransform().GetScale());
+						if (!lstNames.IsElement(sName))
+							lstNames.Add(sName);
+					}
+					break;
+				}
+			}
+
+			// Child containers
+			if (pSceneNode->IsContainer())
+				GetUsedCacheNames(static_cast<const SceneContainer&>(*pSceneNode), lstNames);
+		}
+	}
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PhysicsCacheSources::PhysicsCacheSources(uint32 nNumOfThreads) :
+	m_cWorkerPool(nNumOfThreads)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+PhysicsCacheSources::~PhysicsCacheSources()
+{
+	// The worker threads must not touch the meshes anymore
+	m_cWorkerPool.WaitForAll();
+
+	// Destroy the meshes
+	for (uint32 i=0; i<m_lstMeshes.GetNumOfElements(); i++)
+		delete m_lstMeshes[i];
+}
+
+/**
+*  @brief
+*    Hashes the mesh files of cache files
+*/
+void PhysicsCacheSources::Hash(const Array<String> &lstNames)
+{
+	TraceScope cTraceScope("PhysicsCacheSources::Hash", "Physics");
+
+	// Add a job for each mesh file which wasn't hashed yet
+	for (uint32 i=0; i<lstNames.GetNumOfElements(); i++) {
+		String sMeshFilename, sScaleKey;
+		if (GetSource(lstNames[i], sMeshFilename, sScaleKey) && !m_mapMeshes.Get(sMeshFilename)) {
+			Mesh *pMesh = new Mesh;
+			pMesh->sFilename = sMeshFilename;
+			pMesh->nHash	 = UnknownSource;
+			m_lstMeshes.Add(pMesh);
+			m_mapMeshes.Add(sMeshFilename, pMesh);
+			m_cWorkerPool.AddJob(new HashJob(*pMesh));
+		}
+	}
+
+	// Wait until all mesh files have been hashed
+	m_cWorkerPool.WaitForAll();
+}
+
+/**
+*  @brief
+*    Returns the source hash of a cache file
+*/
+uint64 PhysicsCacheSources::GetSourceHash(const String &sName) const
+{
+	String sMeshFilename, sScaleKey;
+	if (GetSource(sName, sMeshFilename, sScaleKey)) {
+		const Mesh *pMesh = m_mapMeshes.Get(sMeshFilename);
+		if (pMesh && pMesh->nHash != UnknownSource)
+			return PhysicsCacheArchive::GetHash(reinterpret_cast<const uint8*>(sScaleKey.GetASCII()), sScaleKey.GetLength(), pMesh->nHash);
+	}
+
+	// Error!
+	return UnknownSource;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+PhysicsCacheSources::PhysicsCacheSources(const PhysicsCacheSources &cSource) :
+	m_cWorkerPool(1)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+PhysicsCacheSources &PhysicsCacheSources::operator =(const PhysicsCacheSources &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public PhysicsCacheSources::HashJob functions         ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PhysicsCacheSources::HashJob::HashJob(Mesh &cMesh) :
+	m_pMesh(&cMesh)
+{
+}
+
+
+//[-------------------------------------------------------]
+//[ Public virtual WorkerPool::Job functions              ]
+//[-------------------------------------------------------]
+void PhysicsCacheSources::HashJob::Execute()
+{
+	TraceScope cTraceScope("PhysicsCacheSources::HashJob", "Physics", m_pMesh->sFilename);
+
+	// Read the whole mesh file and hash it
+	File cFile;
+	if (LoadableManager::GetInstance()->OpenFile(cFile, m_pMesh->sFilename)) {
+		const uint32 nSize = cFile.GetSize();
+		uint8 *pnData = new uint8[nSize ? nSize : 1];
+		if (cFile.Read(pnData, 1, nSize) == nSize) {
+			m_pMesh->nHash = PhysicsCacheArchive::GetHash(pnData, nSize);
+
+			// "UnknownSource" is reserved for mesh files which weren't found
+			if (m_pMesh->nHash == UnknownSource)
+				m_pMesh->nHash = 1;
+		}
+		delete [] pnData;
+		cFile.Close();
+	}
+}
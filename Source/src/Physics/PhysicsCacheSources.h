@@ -0,0 +1,255 @@
+/*********************************************************\
+ *  File: PhysicsCacheSources.h                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PHYSICSCACHESOURCES_H__
+#define __DUNGEON_PHYSICSCACHESOURCES_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/HashMap.h>
+#include "Tools/WorkerPool.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Vector3;
+}
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Source hashes of physics collision cache files
+*
+*  @remarks
+*    The physics backend names a collision cache file after the mesh and the scale the collision tree was built
+*    for - "Data#Meshes#Dungeon#Cave_Cave10#mesh_1_1_1.tc" is the tree of "Data/Meshes/Dungeon/Cave_Cave10.mesh"
+*    with the scale key "1_1_1". The source hash of a cache file is the hash of the mesh file content continued by
+*    the scale key, so a cache file is stale as soon as the mesh it was built from has been changed. Each mesh file
+*    is hashed only once, no matter how many scales it's used with, and the mesh files are hashed by multiple threads.
+*/
+class PhysicsCacheSources {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint64 UnknownSource = 0;	/**< Source hash of a cache file whose mesh file wasn't found */
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns the mesh filename and the scale key of a cache file
+		*
+		*  @param[in] sName
+		*    Cache file name (e.g. "Data#Meshes#Dungeon#Cave_Cave10#mesh_1_1_1.tc")
+		*  @param[out] sMeshFilename
+		*    Receives the mesh filename (e.g. "Data/Meshes/Dungeon/Cave_Cave10.mesh")
+		*  @param[out] sScaleKey
+		*    Receives the scale key (e.g. "1_1_1")
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (not a mesh collision cache file)
+		*/
+		static bool GetSource(const PLCore::String &sName, PLCore::String &sMeshFilename, PLCore::String &sScaleKey);
+
+		/**
+		*  @brief
+		*    Returns the name of the cache file of a mesh and scale
+		*
+		*  @param[in] sMeshFilename
+		*    Mesh filename as used by the scene node (e.g. "Data\\Meshes\\Dungeon\\Cave_Cave10.mesh")
+		*  @param[in] vScale
+		*    Scale of the scene node
+		*
+		*  @return
+		*    The cache file name as the physics backend names it (e.g. "Data#Meshes#Dungeon#Cave_Cave10#mesh_1_1_1.tc")
+		*/
+		static PLCore::String GetCacheName(const PLCore::String &sMeshFilename, const PLMath::Vector3 &vScale);
+
+		/**
+		*  @brief
+		*    Collects the names of the cache files used by the mesh bodies of a scene
+		*
+		*  @param[in]  cContainer
+		*    Scene container to collect the cache files of, child containers are taken into account
+		*  @param[out] lstNames
+		*    Receives the cache file names, each name is added only once
+		*
+		*  @remarks
+		*    Each scale a mesh is used with has its own collision tree - cache files which are not used by the scene
+		*    (e.g. the per-scale trees of meshes merged by "StaticCollisionMerger") are not required anymore.
+		*/
+		static void GetUsedCacheNames(const PLScene::SceneContainer &cContainer, PLCore::Array<PLCore::String> &lstNames);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] nNumOfThreads
+		*    Number of threads hashing the mesh files, at least one thread is used
+		*/
+		explicit PhysicsCacheSources(PLCore::uint32 nNumOfThreads);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~PhysicsCacheSources();
+
+		/**
+		*  @brief
+		*    Hashes the mesh files of cache files
+		*
+		*  @param[in] lstNames
+		*    Cache file names, mesh files which were already hashed are not hashed again
+		*
+		*  @note
+		*    - Returns as soon as all mesh files have been hashed
+		*/
+		void Hash(const PLCore::Array<PLCore::String> &lstNames);
+
+		/**
+		*  @brief
+		*    Returns the source hash of a cache file
+		*
+		*  @param[in] sName
+		*    Cache file name, the mesh file must have been hashed by "Hash()"
+		*
+		*  @return
+		*    The source hash of the cache file, "UnknownSource" if the mesh file wasn't found or hashed
+		*/
+		PLCore::uint64 GetSourceHash(const PLCore::String &sName) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Hashed mesh file
+		*/
+		struct Mesh {
+			PLCore::String sFilename;	/**< Mesh filename */
+			PLCore::uint64 nHash;		/**< Hash of the mesh file content, "UnknownSource" if the mesh file wasn't found */
+		};
+
+		/**
+		*  @brief
+		*    Job hashing a mesh file
+		*/
+		class HashJob : public WorkerPool::Job {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Constructor
+				*
+				*  @param[in] cMesh
+				*    Mesh to hash
+				*/
+				explicit HashJob(Mesh &cMesh);
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual WorkerPool::Job functions              ]
+			//[-------------------------------------------------------]
+			public:
+				virtual void Execute() override;
+
+
+			//[-------------------------------------------------------]
+			//[ Private data                                          ]
+			//[-------------------------------------------------------]
+			private:
+				Mesh *m_pMesh;	/**< Mesh to hash, always valid */
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		PhysicsCacheSources(const PhysicsCacheSources &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		PhysicsCacheSources &operator =(const PhysicsCacheSources &cSource);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		WorkerPool								 m_cWorkerPool;	/**< Worker threads hashing the mesh files */
+		PLCore::Array<Mesh*>					 m_lstMeshes;	/**< Hashed mesh files, destroyed by this instance */
+		PLCore::HashMap<PLCore::String, Mesh*>	 m_mapMeshes;	/**< Hashed mesh files by filename */
+
+
+};
+
+
+#endif // __DUNGEON_PHYSICSCACHESOURCES_H__
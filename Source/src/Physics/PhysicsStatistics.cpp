@@ -0,0 +1,251 @@
+/*********************************************************\
+ *  File: PhysicsStatistics.cpp                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/Directory.h>
+#include <PLCore/File/FileSearch.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLPhysics/Body.h>
+#include <PLPhysics/SceneNodeModifiers/SNMPhysicsBody.h>
+#include "Physics/PhysicsCacheSources.h"
+#include "Physics/PhysicsStatistics.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+using namespace PLPhysics;
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PhysicsStatistics::PhysicsStatistics(const String &sCacheDirectory) :
+	m_sCacheDirectory(sCacheDirectory),
+	m_nNumOfCacheFiles(0),
+	m_nNumOfStaticBodies(0),
+	m_nNumOfAwakeBodies(0),
+	m_nNumOfSleepingBodies(0),
+	m_nNumOfJoints(0),
+	m_nNumOfCacheHits(0),
+	m_nNumOfCacheMisses(0)
+{
+	// Take note of the cache files which don't need to be built
+	m_nNumOfCacheFiles = GetNumOfCacheFiles();
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+PhysicsStatistics::~PhysicsStatistics()
+{
+}
+
+/**
+*  @brief
+*    Gathers the statistics
+*/
+void PhysicsStatistics::Update(const SceneContainer &cContainer)
+{
+	// Bodies and joints
+	m_nNumOfStaticBodies   = 0;
+	m_nNumOfAwakeBodies    = 0;
+	m_nNumOfSleepingBodies = 0;
+	m_nNumOfJoints         = 0;
+	UpdateBodies(cContainer);
+
+	// Each cache file which was added while the scene was loaded is a collision tree the physics backend had to build
+	Array<String> lstCacheNames;
+	PhysicsCacheSources::GetUsedCacheNames(cContainer, lstCacheNames);
+	const uint32 nNumOfCacheFiles = GetNumOfCacheFiles();
+	m_nNumOfCacheMisses = (nNumOfCacheFiles > m_nNumOfCacheFiles) ? nNumOfCacheFiles - m_nNumOfCacheFiles : 0;
+	if (m_nNumOfCacheMisses > lstCacheNames.GetNumOfElements())
+		m_nNumOfCacheMisses = lstCacheNames.GetNumOfElements();
+	m_nNumOfCacheHits = lstCacheNames.GetNumOfElements() - m_nNumOfCacheMisses;
+}
+
+/**
+*  @brief
+*    Returns the number of bodies
+*/
+uint32 PhysicsStatistics::GetNumOfBodies() const
+{
+	return m_nNumOfStaticBodies + m_nNumOfAwakeBodies + m_nNumOfSleepingBodies;
+}
+
+/**
+*  @brief
+*    Returns the number of static bodies
+*/
+uint32 PhysicsStatistics::GetNumOfStaticBodies() const
+{
+	return m_nNumOfStaticBodies;
+}
+
+/**
+*  @brief
+*    Returns the number of awake dynamic bodies
+*/
+uint32 PhysicsStatistics::GetNumOfAwakeBodies() const
+{
+	return m_nNumOfAwakeBodies;
+}
+
+/**
+*  @brief
+*    Returns the number of sleeping dynamic bodies
+*/
+uint32 PhysicsStatistics::GetNumOfSleepingBodies() const
+{
+	return m_nNumOfSleepingBodies;
+}
+
+/**
+*  @brief
+*    Returns the number of joints
+*/
+uint32 PhysicsStatistics::GetNumOfJoints() const
+{
+	return m_nNumOfJoints;
+}
+
+/**
+*  @brief
+*    Returns the number of collision trees which were read from the physics collision cache
+*/
+uint32 PhysicsStatistics::GetNumOfCacheHits() const
+{
+	return m_nNumOfCacheHits;
+}
+
+/**
+*  @brief
+*    Returns the number of collision trees which had to be built
+*/
+uint32 PhysicsStatistics::GetNumOfCacheMisses() const
+{
+	return m_nNumOfCacheMisses;
+}
+
+/**
+*  @brief
+*    Returns the statistics as string
+*/
+String PhysicsStatistics::ToString() const
+{
+	return String::Format("Bodies=\"%u\" Static=\"%u\" Awake=\"%u\" Sleeping=\"%u\" Joints=\"%u\" CacheHits=\"%u\" CacheMisses=\"%u\"",
+						  GetNumOfBodies(), m_nNumOfStaticBodies, m_nNumOfAwakeBodies, m_nNumOfSleepingBodies, m_nNumOfJoints, m_nNumOfCacheHits, m_nNumOfCacheMisses);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+PhysicsStatistics::PhysicsStatistics(const PhysicsStatistics &cSource) :
+	m_nNumOfCacheFiles(0),
+	m_nNumOfStaticBodies(0),
+	m_nNumOfAwakeBodies(0),
+	m_nNumOfSleepingBodies(0),
+	m_nNumOfJoints(0),
+	m_nNumOfCacheHits(0),
+	m_nNumOfCacheMisses(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+PhysicsStatistics &PhysicsStatistics::operator =(const PhysicsStatistics &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Gathers the body and joint statistics of a scene container
+*/
+void PhysicsStatistics::UpdateBodies(const SceneContainer &cContainer)
+{
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		const SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+				const SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", j);
+				if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody")) {
+					// Massless bodies are static, the physics backend freezes dynamic bodies which came to rest
+					const Body *pBody = static_cast<const SNMPhysicsBody*>(pSceneNodeModifier)->GetBody();
+					if (pBody) {
+						if (pBody->GetMass() <= 0.0f)
+							m_nNumOfStaticBodies++;
+						else if (pBody->IsFrozen())
+							m_nNumOfSleepingBodies++;
+						else
+							m_nNumOfAwakeBodies++;
+					}
+				} else if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsJoint")) {
+					m_nNumOfJoints++;
+				}
+			}
+
+			// Child containers
+			if (pSceneNode->IsContainer())
+				UpdateBodies(static_cast<const SceneContainer&>(*pSceneNode));
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the number of cache files within the physics collision cache directory
+*/
+uint32 PhysicsStatistics::GetNumOfCacheFiles() const
+{
+	uint32 nNumOfCacheFiles = 0;
+	if (m_sCacheDirectory.GetLength()) {
+		Directory cDirectory(m_sCacheDirectory);
+		if (cDirectory.Exists()) {
+			FileSearch cSearch(cDirectory, "*.tc");
+			while (cSearch.HasNextFile()) {
+				cSearch.GetNextFile();
+				nNumOfCacheFiles++;
+			}
+		}
+	}
+	return nNumOfCacheFiles;
+}
@@ -0,0 +1,229 @@
+/*********************************************************\
+ *  File: PhysicsStatistics.h                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PHYSICSSTATISTICS_H__
+#define __DUNGEON_PHYSICSSTATISTICS_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Physics statistics gathered from the physics world scene container
+*
+*  @remarks
+*    The statistics are gathered on request by walking the scene, there's no per-frame cost. The bodies are
+*    classified by using the physics bodies of the mesh, hull, box, sphere etc. body modifiers: Massless bodies
+*    are static, the dynamic bodies are either awake or sleeping (frozen by the physics backend because they
+*    came to rest). The physics collision cache is a hit if the collision tree of a mesh body was read from the
+*    cache directory, a miss if the physics backend had to build the collision tree while the scene was loaded.
+*
+*  @note
+*    - The physics world interface doesn't expose the counters of the Newton world, so the following ones are missing:
+*      Broadphase pairs, contact joints and contact points, solver iterations and the number of solver islands
+*/
+class PhysicsStatistics {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] sCacheDirectory
+		*    Physics collision cache directory, empty string if there's no cache directory
+		*
+		*  @note
+		*    - Must be created right before the scene is loaded, the cache files which are existing at this
+		*      time are the ones which don't need to be built
+		*/
+		explicit PhysicsStatistics(const PLCore::String &sCacheDirectory);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~PhysicsStatistics();
+
+		/**
+		*  @brief
+		*    Gathers the statistics
+		*
+		*  @param[in] cContainer
+		*    Scene container to gather the statistics of, child containers are taken into account
+		*/
+		void Update(const PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Returns the number of bodies
+		*
+		*  @return
+		*    The number of static, awake and sleeping bodies
+		*/
+		PLCore::uint32 GetNumOfBodies() const;
+
+		/**
+		*  @brief
+		*    Returns the number of static bodies
+		*
+		*  @return
+		*    The number of static bodies
+		*/
+		PLCore::uint32 GetNumOfStaticBodies() const;
+
+		/**
+		*  @brief
+		*    Returns the number of awake dynamic bodies
+		*
+		*  @return
+		*    The number of awake dynamic bodies
+		*/
+		PLCore::uint32 GetNumOfAwakeBodies() const;
+
+		/**
+		*  @brief
+		*    Returns the number of sleeping dynamic bodies
+		*
+		*  @return
+		*    The number of sleeping dynamic bodies
+		*/
+		PLCore::uint32 GetNumOfSleepingBodies() const;
+
+		/**
+		*  @brief
+		*    Returns the number of joints
+		*
+		*  @return
+		*    The number of joints
+		*/
+		PLCore::uint32 GetNumOfJoints() const;
+
+		/**
+		*  @brief
+		*    Returns the number of collision trees which were read from the physics collision cache
+		*
+		*  @return
+		*    The number of collision trees which were read from the physics collision cache
+		*/
+		PLCore::uint32 GetNumOfCacheHits() const;
+
+		/**
+		*  @brief
+		*    Returns the number of collision trees which had to be built
+		*
+		*  @return
+		*    The number of collision trees which had to be built
+		*/
+		PLCore::uint32 GetNumOfCacheMisses() const;
+
+		/**
+		*  @brief
+		*    Returns the statistics as string
+		*
+		*  @return
+		*    The statistics as string (e.g. "Bodies=\"245\" Static=\"2\" Awake=\"12\" Sleeping=\"231\" Joints=\"2\" CacheHits=\"176\" CacheMisses=\"1\"")
+		*/
+		PLCore::String ToString() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		PhysicsStatistics(const PhysicsStatistics &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		PhysicsStatistics &operator =(const PhysicsStatistics &cSource);
+
+		/**
+		*  @brief
+		*    Gathers the body and joint statistics of a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container to gather the statistics of, child containers are taken into account
+		*/
+		void UpdateBodies(const PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Returns the number of cache files within the physics collision cache directory
+		*
+		*  @return
+		*    The number of cache files within the physics collision cache directory
+		*/
+		PLCore::uint32 GetNumOfCacheFiles() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::String m_sCacheDirectory;		/**< Physics collision cache directory, can be empty */
+		PLCore::uint32 m_nNumOfCacheFiles;		/**< Number of cache files which were existing before the scene was loaded */
+		PLCore::uint32 m_nNumOfStaticBodies;	/**< Number of static bodies */
+		PLCore::uint32 m_nNumOfAwakeBodies;		/**< Number of awake dynamic bodies */
+		PLCore::uint32 m_nNumOfSleepingBodies;	/**< Number of sleeping dynamic bodies */
+		PLCore::uint32 m_nNumOfJoints;			/**< Number of joints */
+		PLCore::uint32 m_nNumOfCacheHits;		/**< Number of collision trees which were read from the physics collision cache */
+		PLCore::uint32 m_nNumOfCacheMisses;		/**< Number of collision trees which had to be built */
+
+
+};
+
+
+#endif // __DUNGEON_PHYSICSSTATISTICS_H__
@@ -0,0 +1,375 @@
+/*********************************************************\
+ *  File: StaticCollisionMerger.cpp                      *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/Container/Array.h>
+#include <PLMath/Matrix3x4.h>
+#include <PLRenderer/Renderer/IndexBuffer.h>
+#include <PLRenderer/Renderer/VertexBuffer.h>
+#include <PLMesh/Geometry.h>
+#include <PLMesh/MeshManager.h>
+#include <PLMesh/MeshLODLevel.h>
+#include <PLMesh/MeshMorphTarget.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Physics/StaticCollisionMerger.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLRenderer;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const char MergedSceneNodeName[] = "StaticCollision";	/**< Name of the scene node owning the merged static body of a cell */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the mesh of a scene node, null pointer if it's no mesh scene node or has no mesh
+*/
+static Mesh *GetSceneNodeMesh(const SceneNode &cSceneNode)
+{
+	if (cSceneNode.IsInstanceOf("PLScene::SNMesh")) {
+		MeshHandler *pMeshHandler = const_cast<SNMesh&>(static_cast<const SNMesh&>(cSceneNode)).GetMeshHandler();
+		if (pMeshHandler)
+			return pMeshHandler->GetResource();
+	}
+	return nullptr;
+}
+
+/**
+*  @brief
+*    Returns the key of the collision tree the physics backend uses for a mesh scene node, one per mesh and scale
+*/
+static String GetInstanceKey(const SceneNode &cSceneNode)
+{
+	const Mesh *pMesh = GetSceneNodeMesh(cSceneNode);
+	return pMesh ? pMesh->GetName() + '|' + cSceneNode.GetTransform().GetScale().ToString() : "";
+}
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns whether or not a scene node owns the merged static body of a cell
+*/
+bool StaticCollisionMerger::IsMergedSceneNode(const SceneNode &cSceneNode)
+{
+	return (cSceneNode.GetName() == MergedSceneNodeName && cSceneNode.IsInstanceOf("PLScene::SNMesh"));
+}
+
+/**
+*  @brief
+*    Returns the merged scene node a triangle of a merged static body belongs to
+*/
+SceneNode *StaticCollisionMerger::GetSceneNode(const SceneNode &cMergedSceneNode, uint32 nTriangle)
+{
+	// Get the collision mesh and the cell
+	const Mesh *pMesh = GetSceneNodeMesh(cMergedSceneNode);
+	SceneContainer *pCell = cMergedSceneNode.GetContainer();
+	if (pMesh && pCell && pMesh->GetNumOfLODLevels()) {
+		// Each merged scene node is a triangle list geometry named like the scene node
+		const Array<Geometry> &lstGeometries = *pMesh->GetLODLevel(0)->GetGeometries();
+		const uint32 nIndex = nTriangle*3;
+		for (uint32 i=0; i<lstGeometries.GetNumOfElements(); i++) {
+			const Geometry &cGeometry = lstGeometries[i];
+			if (nIndex >= cGeometry.GetStartIndex() && nIndex < cGeometry.GetStartIndex() + cGeometry.GetIndexSize())
+				return pCell->GetByName(cGeometry.GetName());
+		}
+	}
+
+	// Error!
+	return nullptr;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+StaticCollisionMerger::StaticCollisionMerger(MeshManager &cMeshManager, const String &sMeshFilenamePrefix, const String &sNativeFilenamePrefix) :
+	m_pMeshManager(&cMeshManager),
+	m_sMeshFilenamePrefix(sMeshFilenamePrefix),
+	m_sNativeFilenamePrefix(sNativeFilenamePrefix),
+	m_nNumOfInstancedBodies(0),
+	m_nNumOfSharedTrees(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+StaticCollisionMerger::~StaticCollisionMerger()
+{
+}
+
+/**
+*  @brief
+*    Merges the static mesh bodies of all cells directly within a scene container
+*/
+uint32 StaticCollisionMerger::Merge(SceneContainer &cContainer)
+{
+	// Count the static mesh bodies per mesh and scale of all cells to find the instanced meshes
+	m_mapInstances.Clear();
+	m_nNumOfInstancedBodies = 0;
+	m_nNumOfSharedTrees		= 0;
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode && pSceneNode->IsInstanceOf("PLScene::SCCell"))
+			CountInstances(static_cast<SceneContainer&>(*pSceneNode));
+	}
+	Iterator<uint32> cIterator = m_mapInstances.GetIterator();
+	while (cIterator.HasNext()) {
+		if (cIterator.Next() > 1)
+			m_nNumOfSharedTrees++;
+	}
+
+	// Merge the cells
+	uint32 nNumOfMergedBodies = 0;
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode && pSceneNode->IsInstanceOf("PLScene::SCCell"))
+			nNumOfMergedBodies += MergeCell(static_cast<SceneContainer&>(*pSceneNode));
+	}
+	return nNumOfMergedBodies;
+}
+
+/**
+*  @brief
+*    Merges the static mesh bodies of a cell
+*/
+uint32 StaticCollisionMerger::MergeCell(SceneContainer &cCell)
+{
+	// Was the cell merged before?
+	if (cCell.GetByName(MergedSceneNodeName))
+		return 0;
+
+	// Collect the scene nodes which can be merged
+	Array<SceneNode*> lstSceneNodes;
+	Array<SceneNodeModifier*> lstBodies;
+	Array<const CollisionGeometry*> lstGeometries;
+	for (uint32 i=0; i<cCell.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cCell.GetByIndex(i);
+		SceneNodeModifier *pBody = pSceneNode ? GetStaticMeshBody(*pSceneNode) : nullptr;
+		if (pBody && m_mapInstances.Get(GetInstanceKey(*pSceneNode)) > 1) {
+			// Instanced mesh, the body stays and references the collision tree shared by all instances
+			m_nNumOfInstancedBodies++;
+		} else if (pBody) {
+			// The collision geometry of a mesh is read only once
+			const CollisionGeometry *pGeometry = m_cGeometryCache.Get(*GetSceneNodeMesh(*pSceneNode));
+			if (pGeometry) {
+				lstSceneNodes.Add(pSceneNode);
+				lstBodies.Add(pBody);
+				lstGeometries.Add(pGeometry);
+			}
+		}
+	}
+	if (lstSceneNodes.GetNumOfElements() < 2)
+		return 0;
+
+	// Transform the instances into the cell space, one geometry per scene node
+	Array<Vector3> lstVertices;
+	Array<uint32> lstIndices;
+	Array<uint32> lstGeometryIndices;
+	for (uint32 i=0; i<lstSceneNodes.GetNumOfElements(); i++) {
+		lstGeometryIndices.Add(lstIndices.GetNumOfElements());
+		lstGeometries[i]->AppendInstance(lstSceneNodes[i]->GetTransform().GetMatrix(), lstVertices, lstIndices);
+	}
+	lstGeometryIndices.Add(lstIndices.GetNumOfElements());
+	const uint32 nNumOfVertices = lstVertices.GetNumOfElements();
+
+	// Create the collision mesh
+	const String sMeshFilename = m_sMeshFilenamePrefix + cCell.GetName() + "_StaticCollision.mesh";
+	Mesh *pMesh = m_pMeshManager->Create(sMeshFilename);
+	if (!pMesh)
+		return 0; // Error!
+	MeshMorphTarget *pMorphTarget = pMesh->AddMorphTarget();
+	MeshLODLevel *pLODLevel = pMesh->AddLODLevel();
+	pLODLevel->CreateIndexBuffer();
+	pLODLevel->CreateGeometries();
+
+	// Vertices, just positions
+	VertexBuffer *pVertexBuffer = pMorphTarget->GetVertexBuffer();
+	pVertexBuffer->AddVertexAttribute(VertexBuffer::Position, 0, VertexBuffer::Float3);
+	pVertexBuffer->Allocate(nNumOfVertices, Usage::Static);
+	if (pVertexBuffer->Lock(Lock::WriteOnly)) {
+		for (uint32 i=0; i<nNumOfVertices; i++) {
+			float *pfPosition = static_cast<float*>(pVertexBuffer->GetData(i, VertexBuffer::Position));
+			pfPosition[0] = lstVertices[i].x;
+			pfPosition[1] = lstVertices[i].y;
+			pfPosition[2] = lstVertices[i].z;
+		}
+		pVertexBuffer->Unlock();
+	}
+
+	// Indices
+	IndexBuffer *pIndexBuffer = pLODLevel->GetIndexBuffer();
+	pIndexBuffer->SetElementTypeByMaximumIndex(nNumOfVertices - 1);
+	pIndexBuffer->Allocate(lstIndices.GetNumOfElements(), Usage::Static);
+	if (pIndexBuffer->Lock(Lock::WriteOnly)) {
+		for (uint32 i=0; i<lstIndices.GetNumOfElements(); i++)
+			pIndexBuffer->SetData(i, lstIndices[i]);
+		pIndexBuffer->Unlock();
+	}
+
+	// Geometries, named like the merged scene nodes
+	Array<Geometry> &lstMeshGeometries = *pLODLevel->GetGeometries();
+	for (uint32 i=0; i<lstSceneNodes.GetNumOfElements(); i++) {
+		Geometry &cGeometry = lstMeshGeometries.Add();
+		cGeometry.SetName(lstSceneNodes[i]->GetName());
+		cGeometry.SetPrimitiveType(Primitive::TriangleList);
+		cGeometry.SetStartIndex(lstGeometryIndices[i]);
+		cGeometry.SetIndexSize(lstGeometryIndices[i + 1] - lstGeometryIndices[i]);
+	}
+
+	// Save the collision mesh, the compiled scene references it by its filename
+	if (!pMesh->SaveByFilename(m_sNativeFilenamePrefix + cCell.GetName() + "_StaticCollision.mesh")) {
+		delete pMesh;
+		return 0; // Error!
+	}
+
+	// Create the scene node owning the merged static body, it's at the origin of the cell
+	SceneNode *pMergedSceneNode = cCell.Create("PLScene::SNMesh", MergedSceneNodeName, "Flags=\"Invisible\" Mesh=\"" + sMeshFilename + '\"');
+	if (!pMergedSceneNode || !pMergedSceneNode->AddModifier("PLPhysics::SNMPhysicsBodyMesh")) {
+		if (pMergedSceneNode)
+			pMergedSceneNode->Delete();
+		return 0; // Error!
+	}
+
+	// The merged scene nodes no longer have bodies of their own
+	for (uint32 i=0; i<lstSceneNodes.GetNumOfElements(); i++)
+		lstSceneNodes[i]->RemoveModifier(*lstBodies[i]);
+
+	// Done
+	return lstSceneNodes.GetNumOfElements();
+}
+
+
+/**
+*  @brief
+*    Returns the number of static mesh bodies which were kept because their mesh is instanced
+*/
+uint32 StaticCollisionMerger::GetNumOfInstancedBodies() const
+{
+	return m_nNumOfInstancedBodies;
+}
+
+/**
+*  @brief
+*    Returns the number of collision trees shared by the kept static mesh bodies
+*/
+uint32 StaticCollisionMerger::GetNumOfSharedTrees() const
+{
+	return m_nNumOfSharedTrees;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+StaticCollisionMerger::StaticCollisionMerger(const StaticCollisionMerger &cSource) :
+	m_pMeshManager(nullptr),
+	m_nNumOfInstancedBodies(0),
+	m_nNumOfSharedTrees(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+StaticCollisionMerger &StaticCollisionMerger::operator =(const StaticCollisionMerger &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the static mesh body modifier of a scene node which can be merged
+*/
+SceneNodeModifier *StaticCollisionMerger::GetStaticMeshBody(SceneNode &cSceneNode) const
+{
+	// Only mesh scene nodes with a mesh can be merged
+	const Mesh *pMesh = GetSceneNodeMesh(cSceneNode);
+	if (!pMesh || !pMesh->GetNumOfLODLevels() || !pMesh->GetMorphTarget(0) || !pMesh->GetMorphTarget(0)->GetVertexBuffer())
+		return nullptr;
+
+	// Look for exactly one static mesh body and no transform modifiers
+	SceneNodeModifier *pBody = nullptr;
+	for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+		SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+		if (pSceneNodeModifier->IsInstanceOf("PLScene::SNMTransform"))
+			return nullptr; // The scene node moves
+		if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody")) {
+			// Only static mesh bodies (no mass) can be merged
+			const DynVar *pMass = pSceneNodeModifier->GetAttribute("Mass");
+			if (pBody || !pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBodyMesh") || (pMass && pMass->GetFloat() != 0.0f))
+				return nullptr;
+			pBody = pSceneNodeModifier;
+		}
+	}
+
+	// Done
+	return pBody;
+}
+
+/**
+*  @brief
+*    Counts the static mesh bodies of a cell per mesh and scale
+*/
+void StaticCollisionMerger::CountInstances(SceneContainer &cCell)
+{
+	for (uint32 i=0; i<cCell.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cCell.GetByIndex(i);
+		if (pSceneNode && GetStaticMeshBody(*pSceneNode)) {
+			const String sKey = GetInstanceKey(*pSceneNode);
+			m_mapInstances.Set(sKey, m_mapInstances.Get(sKey) + 1);
+		}
+	}
+}
@@ -0,0 +1,243 @@
+/*********************************************************\
+ *  File: StaticCollisionMerger.h                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_STATICCOLLISIONMERGER_H__
+#define __DUNGEON_STATICCOLLISIONMERGER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/HashMap.h>
+#include "Physics/CollisionGeometryCache.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMesh {
+	class MeshManager;
+}
+namespace PLScene {
+	class SceneNode;
+	class SceneContainer;
+	class SceneNodeModifier;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Static collision merger, merges the static mesh bodies of a cell into a single static body
+*
+*  @remarks
+*    Each static "PLScene::SNMesh" with a "PLPhysics::SNMPhysicsBodyMesh" modifier is a body of its own within the
+*    physics world, although it never moves. The merger transforms the meshes of all static mesh bodies directly
+*    within a "PLScene::SCCell" into the cell space and merges them into a single collision mesh, which is saved as
+*    mesh file - the collision geometry of each mesh is read only once (see "CollisionGeometryCache"). An invisible
+*    "PLScene::SNMesh" named "StaticCollision" using this mesh gets the only static mesh body of the cell, the static
+*    mesh body modifiers of the merged scene nodes are removed.
+*
+*    Each merged scene node becomes a geometry of the collision mesh named like the scene node, so a triangle of the
+*    merged body can be mapped back to its scene node (see "GetSceneNode()"). Scene nodes with transform modifiers
+*    (e.g. "PLScene::SNMRotationLinearAnimation") move and are never merged.
+*
+*    Instanced meshes - meshes with a static mesh body placed at least twice with the same scale within the scene
+*    container given to "Merge()" - are not merged either: The physics backend builds one collision tree per mesh and
+*    scale which is shared by all bodies using it, merging them would copy their triangles into each merged body.
+*    They stay bodies of their own referencing the shared tree. Instances with different scales get a tree each, the
+*    physics backend can't share a tree between scales.
+*
+*  @note
+*    - Meant to be used when compiling a scene, the compiled scene then contains the merged bodies
+*/
+class StaticCollisionMerger {
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns whether or not a scene node owns the merged static body of a cell
+		*
+		*  @param[in] cSceneNode
+		*    Scene node to check
+		*
+		*  @return
+		*    'true' if the scene node owns the merged static body of a cell, else 'false'
+		*/
+		static bool IsMergedSceneNode(const PLScene::SceneNode &cSceneNode);
+
+		/**
+		*  @brief
+		*    Returns the merged scene node a triangle of a merged static body belongs to
+		*
+		*  @param[in] cMergedSceneNode
+		*    Scene node named "StaticCollision" owning the merged static body
+		*  @param[in] nTriangle
+		*    Index of the triangle within the collision mesh
+		*
+		*  @return
+		*    The merged scene node the triangle belongs to, null pointer on error
+		*/
+		static PLScene::SceneNode *GetSceneNode(const PLScene::SceneNode &cMergedSceneNode, PLCore::uint32 nTriangle);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] cMeshManager
+		*    Mesh manager to create the collision meshes with, must stay valid as long as this instance exists
+		*  @param[in] sMeshFilenamePrefix
+		*    Prefix of the collision mesh filenames used by the scene (e.g. "Data/Scenes/Dungeon_"), the cell name and
+		*    "_StaticCollision.mesh" are appended
+		*  @param[in] sNativeFilenamePrefix
+		*    Prefix of the native collision mesh filenames the collision meshes are saved as, must point to the same files
+		*/
+		StaticCollisionMerger(PLMesh::MeshManager &cMeshManager, const PLCore::String &sMeshFilenamePrefix, const PLCore::String &sNativeFilenamePrefix);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~StaticCollisionMerger();
+
+		/**
+		*  @brief
+		*    Merges the static mesh bodies of all cells directly within a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container the cells are in, the instanced meshes are the ones of this scene container
+		*
+		*  @return
+		*    The number of merged static mesh bodies
+		*/
+		PLCore::uint32 Merge(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Merges the static mesh bodies of a cell
+		*
+		*  @param[in] cCell
+		*    Cell to merge the static mesh bodies of, nothing happens if it has less than two of them or was merged before
+		*
+		*  @return
+		*    The number of merged static mesh bodies
+		*
+		*  @note
+		*    - The instanced meshes of the last "Merge()" are skipped, without one all static mesh bodies are merged
+		*/
+		PLCore::uint32 MergeCell(PLScene::SceneContainer &cCell);
+
+		/**
+		*  @brief
+		*    Returns the number of static mesh bodies which were kept because their mesh is instanced
+		*
+		*  @return
+		*    The number of kept static mesh bodies of instanced meshes
+		*/
+		PLCore::uint32 GetNumOfInstancedBodies() const;
+
+		/**
+		*  @brief
+		*    Returns the number of collision trees shared by the kept static mesh bodies
+		*
+		*  @return
+		*    The number of different meshes and scales of the kept static mesh bodies
+		*/
+		PLCore::uint32 GetNumOfSharedTrees() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		StaticCollisionMerger(const StaticCollisionMerger &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		StaticCollisionMerger &operator =(const StaticCollisionMerger &cSource);
+
+		/**
+		*  @brief
+		*    Returns the static mesh body modifier of a scene node which can be merged
+		*
+		*  @param[in] cSceneNode
+		*    Scene node to check
+		*
+		*  @return
+		*    The static mesh body modifier, null pointer if the scene node can't be merged
+		*/
+		PLScene::SceneNodeModifier *GetStaticMeshBody(PLScene::SceneNode &cSceneNode) const;
+
+		/**
+		*  @brief
+		*    Counts the static mesh bodies of a cell per mesh and scale
+		*
+		*  @param[in] cCell
+		*    Cell to count the static mesh bodies of
+		*/
+		void CountInstances(PLScene::SceneContainer &cCell);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLMesh::MeshManager								*m_pMeshManager;			/**< Mesh manager to create the collision meshes with, always valid */
+		PLCore::String									 m_sMeshFilenamePrefix;		/**< Prefix of the collision mesh filenames used by the scene */
+		PLCore::String									 m_sNativeFilenamePrefix;	/**< Prefix of the native collision mesh filenames */
+		CollisionGeometryCache							 m_cGeometryCache;			/**< Collision geometries of the merged meshes, each mesh is read only once */
+		PLCore::HashMap<PLCore::String, PLCore::uint32>	 m_mapInstances;			/**< Number of static mesh bodies per mesh and scale within the scene container given to "Merge()" */
+		PLCore::uint32									 m_nNumOfInstancedBodies;	/**< Number of kept static mesh bodies of instanced meshes */
+		PLCore::uint32									 m_nNumOfSharedTrees;		/**< Number of collision trees shared by the kept static mesh bodies */
+
+
+};
+
+
+#endif // __DUNGEON_STATICCOLLISIONMERGER_H__
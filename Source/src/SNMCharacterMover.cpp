@@ -0,0 +1,503 @@
+/*********************************************************\
+ *  File: SNMCharacterMover.cpp                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Tools/Timing.h>
+#include <PLMath/Matrix3x4.h>
+#include <PLScene/Scene/SceneContext.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLPhysics/SceneNodeModifiers/SNMPhysicsBody.h>
+#include "Scene/RayQueryService.h"
+#include "SNMCharacterMover.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+using namespace PLPhysics;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float	Skin				= 0.005f;	/**< Distance the capsule keeps to the surfaces it hits */
+static const uint32	MaxStepsPerUpdate	= 16;		/**< Maximum number of fixed steps per update, the remaining time is dropped */
+static const uint32	MaxSlideIterations	= 4;		/**< Maximum number of surfaces the capsule slides along within one movement */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the lowest root of a quadratic equation within ]0, fMaxRoot[
+*/
+static bool GetLowestRoot(float fA, float fB, float fC, float fMaxRoot, float &fRoot)
+{
+	if (Math::Abs(fA) < Math::Epsilon)
+		return false; // No quadratic equation
+	const float fDeterminant = fB*fB - 4.0f*fA*fC;
+	if (fDeterminant < 0.0f)
+		return false; // No real roots
+	const float fSquareRoot = Math::Sqrt(fDeterminant);
+	float fRoot1 = (-fB - fSquareRoot)/(2.0f*fA);
+	float fRoot2 = (-fB + fSquareRoot)/(2.0f*fA);
+	if (fRoot1 > fRoot2) {
+		const float fTemp = fRoot1;
+		fRoot1 = fRoot2;
+		fRoot2 = fTemp;
+	}
+	if (fRoot1 > 0.0f && fRoot1 < fMaxRoot) {
+		fRoot = fRoot1;
+		return true;
+	}
+	if (fRoot2 > 0.0f && fRoot2 < fMaxRoot) {
+		fRoot = fRoot2;
+		return true;
+	}
+	return false;
+}
+
+/**
+*  @brief
+*    Returns whether or not a point on the plane of a triangle is inside the triangle
+*/
+static bool IsPointInTriangle(const Vector3 &vPoint, const Vector3 &vV0, const Vector3 &vV1, const Vector3 &vV2, const Vector3 &vNormal)
+{
+	return ((vV1 - vV0).CrossProduct(vPoint - vV0).DotProduct(vNormal) >= 0.0f &&
+			(vV2 - vV1).CrossProduct(vPoint - vV1).DotProduct(vNormal) >= 0.0f &&
+			(vV0 - vV2).CrossProduct(vPoint - vV2).DotProduct(vNormal) >= 0.0f);
+}
+
+/**
+*  @brief
+*    Sweeps a sphere against a triangle, updates the time and contact point if the sphere hits the triangle before the given time
+*
+*  @remarks
+*    Based on "Improved Collision detection and Response" by Kasper Fauerby: The sphere hits either the inside of the
+*    triangle, one of its corners or one of its edges. Both sides of the triangle are solid, a sphere which already
+*    penetrates the triangle can only move away from it.
+*/
+static bool SweepSphere(const Vector3 &vCenter, const Vector3 &vMove, float fRadius, const Vector3 &vV0, const Vector3 &vV1, const Vector3 &vV2, float &fTime, Vector3 &vContact)
+{
+	// Get the triangle plane facing the sphere
+	Vector3 vNormal = (vV1 - vV0).CrossProduct(vV2 - vV0);
+	const float fLength = vNormal.GetLength();
+	if (fLength < Math::Epsilon)
+		return false; // Degenerated triangle
+	vNormal /= fLength;
+	float fDistance = vNormal.DotProduct(vCenter - vV0);
+	if (fDistance < 0.0f) {
+		vNormal	  = -vNormal;
+		fDistance = -fDistance;
+	}
+	const float fNormalDotMove = vNormal.DotProduct(vMove);
+	if (fNormalDotMove >= 0.0f)
+		return false; // Moving away from the plane or parallel to it
+
+	// Get the time interval the sphere touches the plane
+	const float fPlaneTime0 = Math::Max((fDistance - fRadius)/-fNormalDotMove, 0.0f);
+	const float fPlaneTime1 = (fDistance + fRadius)/-fNormalDotMove;
+	if (fPlaneTime0 >= fTime || fPlaneTime1 <= 0.0f)
+		return false; // The sphere doesn't touch the plane in time
+
+	// Does the sphere touch the plane inside the triangle?
+	const Vector3 vPlaneContact = vCenter + vMove*fPlaneTime0 - vNormal*(fDistance + fNormalDotMove*fPlaneTime0);
+	if (IsPointInTriangle(vPlaneContact, vV0, vV1, vV2, vNormal)) {
+		fTime	 = fPlaneTime0;
+		vContact = vPlaneContact;
+		return true;
+	}
+
+	// Sweep against the corners
+	const Vector3 *pvCorners[3] = { &vV0, &vV1, &vV2 };
+	const float fMoveSquaredLength = vMove.DotProduct(vMove);
+	bool bHit = false;
+	for (uint32 i=0; i<3; i++) {
+		const Vector3 &vCorner = *pvCorners[i];
+		const float fC = (vCorner - vCenter).DotProduct(vCorner - vCenter) - fRadius*fRadius;
+		float fRoot;
+		if (fC > 0.0f && GetLowestRoot(fMoveSquaredLength, 2.0f*vMove.DotProduct(vCenter - vCorner), fC, fTime, fRoot)) {
+			fTime	 = fRoot;
+			vContact = vCorner;
+			bHit	 = true;
+		}
+	}
+
+	// Sweep against the edges
+	for (uint32 i=0; i<3; i++) {
+		const Vector3 &vStart = *pvCorners[i];
+		const Vector3  vEdge  = *pvCorners[(i + 1)%3] - vStart;
+		const Vector3  vBase  = vStart - vCenter;
+		const float fEdgeSquaredLength = vEdge.DotProduct(vEdge);
+		const float fEdgeDotMove	   = vEdge.DotProduct(vMove);
+		const float fEdgeDotBase	   = vEdge.DotProduct(vBase);
+		const float fA = -fEdgeSquaredLength*fMoveSquaredLength + fEdgeDotMove*fEdgeDotMove;
+		const float fB = fEdgeSquaredLength*2.0f*vMove.DotProduct(vBase) - 2.0f*fEdgeDotMove*fEdgeDotBase;
+		const float fC = fEdgeSquaredLength*(fRadius*fRadius - vBase.DotProduct(vBase)) + fEdgeDotBase*fEdgeDotBase;
+		float fRoot;
+		if (fC < 0.0f && fEdgeSquaredLength > Math::Epsilon && GetLowestRoot(fA, fB, fC, fTime, fRoot)) {
+			// Is the contact within the edge?
+			const float fEdgePosition = (fEdgeDotMove*fRoot - fEdgeDotBase)/fEdgeSquaredLength;
+			if (fEdgePosition >= 0.0f && fEdgePosition <= 1.0f) {
+				fTime	 = fRoot;
+				vContact = vStart + vEdge*fEdgePosition;
+				bHit	 = true;
+			}
+		}
+	}
+
+	// Done
+	return bHit;
+}
+
+
+//[-------------------------------------------------------]
+//[ RTTI interface                                        ]
+//[-------------------------------------------------------]
+pl_implement_class(SNMCharacterMover)
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+SNMCharacterMover::SNMCharacterMover(SceneNode &cSceneNode) : SceneNodeModifier(cSceneNode),
+	Radius(this),
+	Height(this),
+	EyeHeight(this),
+	Speed(this),
+	RunSpeed(this),
+	JumpSpeed(this),
+	Gravity(this),
+	StepHeight(this),
+	MaxSlope(this),
+	StepRate(this),
+	Flags(this),
+	SlotOnUpdate(this),
+	m_fForward(0.0f),
+	m_fLeft(0.0f),
+	m_bRun(false),
+	m_bJump(false),
+	m_bOnGround(false),
+	m_fVerticalVelocity(0.0f),
+	m_fTimeAccumulator(0.0f),
+	m_bPhysics(true),
+	m_fMass(0.0f)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+SNMCharacterMover::~SNMCharacterMover()
+{
+}
+
+/**
+*  @brief
+*    Sets the movement of the next update
+*/
+void SNMCharacterMover::SetMovement(float fForward, float fLeft, bool bRun, bool bJump)
+{
+	m_fForward = fForward;
+	m_fLeft	   = fLeft;
+	m_bRun	   = bRun;
+	m_bJump	   = bJump;
+}
+
+/**
+*  @brief
+*    Returns whether or not the character stands on the ground
+*/
+bool SNMCharacterMover::IsOnGround() const
+{
+	return m_bOnGround;
+}
+
+
+//[-------------------------------------------------------]
+//[ Protected virtual SceneNodeModifier functions         ]
+//[-------------------------------------------------------]
+void SNMCharacterMover::OnActivate(bool bActivate)
+{
+	// Connect/disconnect event handler
+	SceneContext *pSceneContext = GetSceneContext();
+	if (pSceneContext) {
+		if (bActivate)
+			pSceneContext->EventUpdate.Connect(SlotOnUpdate);
+		else
+			pSceneContext->EventUpdate.Disconnect(SlotOnUpdate);
+	}
+
+	// Start without a backlog of time to simulate
+	m_fTimeAccumulator = 0.0f;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Called when the scene node needs to be updated
+*/
+void SNMCharacterMover::OnUpdate()
+{
+	// Get the transform from the scene container of the scene node into the space of the static collision
+	SceneNode &cSceneNode = GetSceneNode();
+	RayQueryService *pRayQueryService = RayQueryService::GetCurrent();
+	SceneContainer *pContainer = cSceneNode.GetContainer();
+	Matrix3x4 mTransform;
+	if (!pRayQueryService || !pContainer || !pRayQueryService->GetTransform(*pContainer, mTransform)) {
+		// There's no collision to sweep against, let the physics move the character
+		SetPhysics(true);
+		m_fTimeAccumulator = 0.0f;
+		return;
+	}
+	SetPhysics(false);
+
+	// Get the number of fixed steps to simulate, within very slow frames the remaining time is dropped
+	const float fTimeStep = 1.0f/Math::Max(StepRate.Get(), 1.0f);
+	m_fTimeAccumulator += Timing::GetInstance()->GetTimeDifference();
+	uint32 nNumOfSteps = static_cast<uint32>(m_fTimeAccumulator/fTimeStep);
+	if (nNumOfSteps > MaxStepsPerUpdate) {
+		nNumOfSteps = MaxStepsPerUpdate;
+		m_fTimeAccumulator = 0.0f;
+	} else {
+		m_fTimeAccumulator -= nNumOfSteps*fTimeStep;
+	}
+	if (!nNumOfSteps)
+		return; // Keep the movement for the next update
+
+	// Get the horizontal movement per step within the space of the static collision
+	const Vector3 &vPosition = cSceneNode.GetTransform().GetPosition();
+	const Vector3 vLocalDirection = cSceneNode.GetTransform().GetRotation().GetZAxis()*m_fForward + cSceneNode.GetTransform().GetRotation().GetXAxis()*m_fLeft;
+	const Vector3 vOrigin = mTransform*vPosition;
+	Vector3 vDirection = mTransform*(vPosition + vLocalDirection) - vOrigin;
+	vDirection.y = 0.0f;
+	Vector3 vMove;
+	if (!vDirection.IsNull())
+		vMove = vDirection.GetNormalized()*((m_bRun ? RunSpeed.Get() : Speed.Get())*fTimeStep);
+
+	// Jump
+	if (m_bJump && m_bOnGround && !(GetFlags() & NoJump)) {
+		m_fVerticalVelocity = JumpSpeed;
+		m_bOnGround = false;
+	}
+
+	// Get the static and dynamic triangles within reach of all steps
+	const float fRadius		= Radius;
+	const float fDuration	= nNumOfSteps*fTimeStep;
+	const float fReach		= vMove.GetLength()*nNumOfSteps + (Math::Abs(m_fVerticalVelocity) + Gravity*fDuration)*fDuration + StepHeight + Skin;
+	Vector3 vFeet = vOrigin - Vector3(0.0f, EyeHeight, 0.0f);
+	m_lstTriangles.Reset();
+	pRayQueryService->GetTriangles(vFeet - Vector3(fRadius + fReach, fReach, fRadius + fReach), vFeet + Vector3(fRadius + fReach, Height + fReach, fRadius + fReach), m_lstTriangles);
+
+	// Simulate the steps
+	for (uint32 i=0; i<nNumOfSteps; i++)
+		Step(vFeet, vMove, fTimeStep);
+
+	// Set the new scene node position
+	cSceneNode.GetTransform().SetPosition(mTransform.GetInverted()*(vFeet + Vector3(0.0f, EyeHeight, 0.0f)));
+
+	// The movement was used
+	m_fForward = m_fLeft = 0.0f;
+	m_bRun	   = m_bJump = false;
+}
+
+/**
+*  @brief
+*    Hands the character over to the physics or takes it over
+*/
+void SNMCharacterMover::SetPhysics(bool bPhysics)
+{
+	if (m_bPhysics != bPhysics) {
+		m_bPhysics = bPhysics;
+
+		// Switch the physics body and character controller of the scene node
+		SceneNode &cSceneNode = GetSceneNode();
+		for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+			SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+			if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody")) {
+				// A massless body isn't simulated, it follows the scene node and pushes the dynamic bodies it touches
+				SNMPhysicsBody *pBody = static_cast<SNMPhysicsBody*>(pSceneNodeModifier);
+				if (bPhysics) {
+					pBody->SetMass(m_fMass);
+				} else {
+					m_fMass = pBody->GetMass();
+					pBody->SetMass(0.0f);
+				}
+			} else if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsCharacter")) {
+				pSceneNodeModifier->SetActive(bPhysics);
+			}
+		}
+
+		// Start the own simulation at rest
+		m_bOnGround			= false;
+		m_fVerticalVelocity	= 0.0f;
+	}
+}
+
+/**
+*  @brief
+*    Simulates one fixed step
+*/
+void SNMCharacterMover::Step(Vector3 &vFeet, const Vector3 &vMove, float fTimeStep)
+{
+	const float fMinGroundNormal = Math::Cos(static_cast<float>(MaxSlope*Math::DegToRad));
+
+	// Horizontal movement
+	if (!vMove.IsNull()) {
+		Vector3 vWalkFeet = vFeet;
+		Slide(vWalkFeet, vMove, true);
+
+		// Blocked while on the ground? Try to walk up a step: Up, forward and down again
+		const float fMoveLength = vMove.GetLength();
+		if (m_bOnGround && StepHeight > 0.0f && Vector3(vWalkFeet.x - vFeet.x, 0.0f, vWalkFeet.z - vFeet.z).GetLength() < fMoveLength*0.9f) {
+			Vector3 vStepFeet = vFeet;
+			Slide(vStepFeet, Vector3(0.0f, StepHeight, 0.0f), false);
+			const float fRaise = vStepFeet.y - vFeet.y;
+			Slide(vStepFeet, vMove, true);
+			float fFraction;
+			Vector3 vNormal;
+			const bool bGround = Move(vStepFeet, Vector3(0.0f, -fRaise, 0.0f), fFraction, vNormal);
+
+			// Use the step if it lands on walkable ground and gets further
+			if (bGround && vNormal.y >= fMinGroundNormal &&
+				Vector3(vStepFeet.x - vFeet.x, 0.0f, vStepFeet.z - vFeet.z).GetLength() > Vector3(vWalkFeet.x - vFeet.x, 0.0f, vWalkFeet.z - vFeet.z).GetLength())
+				vWalkFeet = vStepFeet;
+		}
+		vFeet = vWalkFeet;
+	}
+
+	// Vertical movement, while standing on the ground the character sticks to it when walking down steps and slopes
+	m_fVerticalVelocity -= Gravity*fTimeStep;
+	const bool bStick = (m_bOnGround && m_fVerticalVelocity <= 0.0f);
+	const float fFall = m_fVerticalVelocity*fTimeStep;
+	Vector3 vFallFeet = vFeet;
+	float fFraction;
+	Vector3 vNormal;
+	if (Move(vFallFeet, Vector3(0.0f, bStick ? Math::Min(fFall, -StepHeight.Get()) : fFall, 0.0f), fFraction, vNormal) && vNormal.y*fFall < 0.0f) {
+		if (vNormal.y >= fMinGroundNormal) {
+			// Landed on walkable ground
+			vFeet = vFallFeet;
+			m_bOnGround = true;
+			m_fVerticalVelocity = 0.0f;
+			return;
+		} else if (vNormal.y <= -fMinGroundNormal) {
+			// Hit the ceiling
+			vFeet = vFallFeet;
+			m_bOnGround = false;
+			m_fVerticalVelocity = 0.0f;
+			return;
+		}
+	}
+
+	// Falling, slide down steep slopes
+	m_bOnGround = false;
+	Slide(vFeet, Vector3(0.0f, fFall, 0.0f), false);
+}
+
+/**
+*  @brief
+*    Moves the capsule along a movement and slides along what it hits
+*/
+void SNMCharacterMover::Slide(Vector3 &vFeet, Vector3 vMove, bool bWalk) const
+{
+	const float fMinGroundNormal = Math::Cos(static_cast<float>(MaxSlope*Math::DegToRad));
+	for (uint32 i=0; i<MaxSlideIterations && !vMove.IsNull(); i++) {
+		float fFraction;
+		Vector3 vNormal;
+		if (!Move(vFeet, vMove, fFraction, vNormal))
+			return; // The whole movement was done
+
+		// Walking, surfaces which are too steep are walls
+		if (bWalk && vNormal.y < fMinGroundNormal) {
+			vNormal.y = 0.0f;
+			if (vNormal.IsNull())
+				return; // Blocked
+			vNormal.Normalize();
+		}
+
+		// Project the remaining movement onto the hit surface
+		vMove *= 1.0f - fFraction;
+		vMove -= vNormal*vNormal.DotProduct(vMove);
+	}
+}
+
+/**
+*  @brief
+*    Moves the capsule along a movement until it hits something
+*/
+bool SNMCharacterMover::Move(Vector3 &vFeet, const Vector3 &vMove, float &fFraction, Vector3 &vNormal) const
+{
+	const float fMoveLength = vMove.GetLength();
+	if (fMoveLength < Math::Epsilon) {
+		fFraction = 1.0f;
+		return false;
+	}
+
+	// The capsule is swept as a column of spheres which are at most half a radius apart
+	const float fRadius	 = Radius;
+	const float fSegment = Math::Max(Height - fRadius*2.0f, 0.0f);
+	const uint32 nNumOfSpheres = (fSegment > 0.0f) ? static_cast<uint32>(fSegment*2.0f/fRadius) + 2 : 1;
+	const float fSpacing = (nNumOfSpheres > 1) ? fSegment/(nNumOfSpheres - 1) : 0.0f;
+
+	// Find the earliest hit
+	float fTime = 1.0f;
+	Vector3 vContact;
+	uint32 nSphere = 0;
+	bool bHit = false;
+	for (uint32 i=0; i+2<m_lstTriangles.GetNumOfElements(); i+=3) {
+		for (uint32 j=0; j<nNumOfSpheres; j++) {
+			if (SweepSphere(vFeet + Vector3(0.0f, fRadius + j*fSpacing, 0.0f), vMove, fRadius, m_lstTriangles[i], m_lstTriangles[i + 1], m_lstTriangles[i + 2], fTime, vContact)) {
+				nSphere = j;
+				bHit	= true;
+			}
+		}
+	}
+
+	// Move until the capsule keeps the skin distance to the hit
+	if (bHit) {
+		fFraction = Math::Max(fTime*fMoveLength - Skin, 0.0f)/fMoveLength;
+		vNormal = vFeet + Vector3(0.0f, fRadius + nSphere*fSpacing, 0.0f) + vMove*fTime - vContact;
+		if (vNormal.IsNull())
+			vNormal = -vMove;
+		vNormal.Normalize();
+	} else {
+		fFraction = 1.0f;
+	}
+	vFeet += vMove*fFraction;
+
+	// Done
+	return bHit;
+}
@@ -0,0 +1,242 @@
+/*********************************************************\
+ *  File: SNMCharacterMover.h                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_CHARACTERMOVER_H__
+#define __DUNGEON_CHARACTERMOVER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/Array.h>
+#include <PLMath/Vector3.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Scene node modifier class moving the scene node as character through the collision of the ray query service
+*
+*  @remarks
+*    The character is a vertical capsule, the scene node is at the eye height above the capsule bottom. The movement
+*    is simulated with a fixed rate which doesn't depend on the frame rate. Each movement is swept against the static
+*    and dynamic triangles of the current ray query service (see "RayQueryService"), so the character can't tunnel
+*    through the walls even at large time steps: The character slides along what it hits, walks up steps and walkable
+*    slopes and falls if there's no ground below it. The capsule is swept as a column of overlapping spheres which are
+*    at most half a radius apart: Between two spheres the swept shape is up to 0.032 radius (1 - sqrt(15/16)) thinner
+*    than the capsule, an edge poking in horizontally between two spheres may get this much closer to the capsule axis.
+*
+*    The movement direction is set by the owner each frame (see "SetMovement()"). The physics body of the scene node
+*    (if there's one) is used as proxy pushing the dynamic bodies: While this modifier moves the character, the body
+*    is massless and follows the scene node, make it a little larger than the capsule so it touches what the capsule
+*    is blocked by. The walk camera of the dungeon scene has a capsule radius of 0.2 and an ellipsoid body radius of
+*    0.25 with the same height, so the body pushes a dynamic body before the capsule gets stuck at its triangles.
+*    Without a ray query service (e.g. while the scene is loaded progressively), the body gets back its mass and the
+*    physics character controller of the scene node (if there's one) moves the character instead.
+*/
+class SNMCharacterMover : public PLScene::SceneNodeModifier {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Flags (PLScene::SceneNodeModifier flags extension)
+		*/
+		enum EFlags {
+			NoJump = 1<<2	/**< The character can't jump */
+		};
+		pl_enum(EFlags)
+			pl_enum_base(SceneNodeModifier::EFlags)
+			pl_enum_value(NoJump,	"The character can't jump")
+		pl_enum_end
+
+
+	//[-------------------------------------------------------]
+	//[ RTTI interface                                        ]
+	//[-------------------------------------------------------]
+	pl_class(pl_rtti_export, SNMCharacterMover, "", PLScene::SceneNodeModifier, "Scene node modifier class moving the scene node as character through the collision of the ray query service")
+		// Attributes
+		pl_attribute(Radius,		float,					0.25f,		ReadWrite,	DirectValue,	"Capsule radius",																"Min='0.01'")
+		pl_attribute(Height,		float,					1.6f,		ReadWrite,	DirectValue,	"Capsule height, including the caps",											"Min='0.02'")
+		pl_attribute(EyeHeight,		float,					1.4f,		ReadWrite,	DirectValue,	"Height of the scene node above the capsule bottom",							"")
+		pl_attribute(Speed,			float,					2.0f,		ReadWrite,	DirectValue,	"Walk speed (in units per second)",												"Min='0.0'")
+		pl_attribute(RunSpeed,		float,					4.0f,		ReadWrite,	DirectValue,	"Run speed (in units per second)",												"Min='0.0'")
+		pl_attribute(JumpSpeed,		float,					4.0f,		ReadWrite,	DirectValue,	"Upwards speed at the start of a jump (in units per second)",					"Min='0.0'")
+		pl_attribute(Gravity,		float,					9.81f,		ReadWrite,	DirectValue,	"Gravity (in units per square second)",											"Min='0.0'")
+		pl_attribute(StepHeight,	float,					0.35f,		ReadWrite,	DirectValue,	"Maximum height of a step the character walks up",								"Min='0.0'")
+		pl_attribute(MaxSlope,		float,					45.0f,		ReadWrite,	DirectValue,	"Steepest slope the character can walk on (in degree)",							"Min='0.0' Max='89.0'")
+		pl_attribute(StepRate,		float,					60.0f,		ReadWrite,	DirectValue,	"Fixed rate the movement is simulated with (in steps per second)",				"Min='1.0'")
+			// Overwritten PLScene::SceneNodeModifier attributes
+		pl_attribute(Flags,			pl_flag_type(EFlags),	0,			ReadWrite,	GetSet,			"Flags",																		"")
+		// Constructors
+		pl_constructor_1(ParameterConstructor,	PLScene::SceneNode&,	"Parameter constructor",	"")
+		// Slots
+		pl_slot_0(OnUpdate,	"Called when the scene node needs to be updated",	"")
+	pl_class_end
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] cSceneNode
+		*    Owner scene node
+		*/
+		SNMCharacterMover(PLScene::SceneNode &cSceneNode);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		virtual ~SNMCharacterMover();
+
+		/**
+		*  @brief
+		*    Sets the movement of the next update
+		*
+		*  @param[in] fForward
+		*    Forward movement (-1 = backward ... 1 = forward), along the scene node z axis
+		*  @param[in] fLeft
+		*    Sideward movement (-1 = right ... 1 = left), along the scene node x axis
+		*  @param[in] bRun
+		*    Run instead of walk?
+		*  @param[in] bJump
+		*    Jump? (ignored while the character is not on the ground)
+		*
+		*  @note
+		*    - The movement is reset after each update, set it each frame
+		*/
+		void SetMovement(float fForward, float fLeft, bool bRun, bool bJump);
+
+		/**
+		*  @brief
+		*    Returns whether or not the character stands on the ground
+		*
+		*  @return
+		*    'true' if the character stands on the ground, else 'false'
+		*/
+		bool IsOnGround() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Protected virtual PLScene::SceneNodeModifier functions]
+	//[-------------------------------------------------------]
+	protected:
+		virtual void OnActivate(bool bActivate) override;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Called when the scene node needs to be updated
+		*/
+		void OnUpdate();
+
+		/**
+		*  @brief
+		*    Hands the character over to the physics or takes it over
+		*
+		*  @param[in] bPhysics
+		*    'true' to let the physics body and character controller of the scene node move the character, 'false' to
+		*    move it by this modifier with the physics body as massless proxy
+		*/
+		void SetPhysics(bool bPhysics);
+
+		/**
+		*  @brief
+		*    Simulates one fixed step
+		*
+		*  @param[in, out] vFeet
+		*    Capsule bottom, receives the new capsule bottom
+		*  @param[in]      vMove
+		*    Horizontal movement of the step
+		*  @param[in]      fTimeStep
+		*    Duration of the step (in seconds)
+		*/
+		void Step(PLMath::Vector3 &vFeet, const PLMath::Vector3 &vMove, float fTimeStep);
+
+		/**
+		*  @brief
+		*    Moves the capsule along a movement and slides along what it hits
+		*
+		*  @param[in, out] vFeet
+		*    Capsule bottom, receives the new capsule bottom
+		*  @param[in]      vMove
+		*    Movement
+		*  @param[in]      bWalk
+		*    Walking? If so, surfaces steeper than the maximum slope are handled like vertical walls.
+		*/
+		void Slide(PLMath::Vector3 &vFeet, PLMath::Vector3 vMove, bool bWalk) const;
+
+		/**
+		*  @brief
+		*    Moves the capsule along a movement until it hits something
+		*
+		*  @param[in, out] vFeet
+		*    Capsule bottom, receives the new capsule bottom
+		*  @param[in]      vMove
+		*    Movement
+		*  @param[out]     fFraction
+		*    Receives the fraction of the movement which was done (0 ... 1)
+		*  @param[out]     vNormal
+		*    Receives the normal of the hit surface, not touched if nothing was hit
+		*
+		*  @return
+		*    'true' if something was hit, else 'false'
+		*/
+		bool Move(PLMath::Vector3 &vFeet, const PLMath::Vector3 &vMove, float &fFraction, PLMath::Vector3 &vNormal) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		float							m_fForward;				/**< Forward movement of the next update */
+		float							m_fLeft;				/**< Sideward movement of the next update */
+		bool							m_bRun;					/**< Run within the next update? */
+		bool							m_bJump;				/**< Jump within the next update? */
+		bool							m_bOnGround;			/**< Does the character stand on the ground? */
+		float							m_fVerticalVelocity;	/**< Vertical velocity (in units per second) */
+		float							m_fTimeAccumulator;		/**< Time which was not simulated yet (in seconds) */
+		bool							m_bPhysics;				/**< Does the physics move the character? */
+		float							m_fMass;				/**< Mass of the physics body while the physics moves the character */
+		PLCore::Array<PLMath::Vector3>	m_lstTriangles;			/**< Static and dynamic triangles near the character, three corners per triangle */
+
+
+};
+
+
+#endif // __DUNGEON_CHARACTERMOVER_H__
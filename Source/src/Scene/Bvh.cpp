@@ -0,0 +1,624 @@
+/*********************************************************\
+ *  File: Bvh.cpp                                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLMath/Math.h>
+#include <PLMath/Matrix3x4.h>
+#include "Scene/Bvh.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 NumOfBins		   = 12;	/**< Number of bins the surface area heuristic is evaluated at */
+static const uint32 MaxLeafTriangles   = 4;		/**< A node with up to this number of triangles is always a leaf */
+static const uint32 MaxCheapLeaf	   = 16;	/**< A node with up to this number of triangles becomes a leaf if no split is cheaper */
+static const uint32 MaxDepth		   = 60;	/**< Maximum depth of the hierarchy, limits the traversal stack */
+static const uint32 TraversalStackSize = MaxDepth + 2;	/**< Size of the traversal stack */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the surface area of a box
+*/
+static float GetSurfaceArea(const Vector3 &vMin, const Vector3 &vMax)
+{
+	const Vector3 vSize = vMax - vMin;
+	return 2.0f*(vSize.x*vSize.y + vSize.y*vSize.z + vSize.z*vSize.x);
+}
+
+/**
+*  @brief
+*    Grows a box so that it includes a point
+*/
+static void GrowBox(Vector3 &vMin, Vector3 &vMax, const Vector3 &vPoint)
+{
+	if (vMin.x > vPoint.x) vMin.x = vPoint.x;
+	if (vMin.y > vPoint.y) vMin.y = vPoint.y;
+	if (vMin.z > vPoint.z) vMin.z = vPoint.z;
+	if (vMax.x < vPoint.x) vMax.x = vPoint.x;
+	if (vMax.y < vPoint.y) vMax.y = vPoint.y;
+	if (vMax.z < vPoint.z) vMax.z = vPoint.z;
+}
+
+/**
+*  @brief
+*    Returns the reciprocal ray direction used by the box tests, axis parallel directions get a huge reciprocal
+*/
+static Vector3 GetInverseDirection(const Vector3 &vDirection)
+{
+	return Vector3(vDirection.x ? 1.0f/vDirection.x : Math::MaxFloat,
+				   vDirection.y ? 1.0f/vDirection.y : Math::MaxFloat,
+				   vDirection.z ? 1.0f/vDirection.z : Math::MaxFloat);
+}
+
+/**
+*  @brief
+*    Returns whether or not two boxes overlap
+*/
+static bool OverlapBox(const Vector3 &vMin1, const Vector3 &vMax1, const Vector3 &vMin2, const Vector3 &vMax2)
+{
+	return (vMin1.x <= vMax2.x && vMax1.x >= vMin2.x &&
+			vMin1.y <= vMax2.y && vMax1.y >= vMin2.y &&
+			vMin1.z <= vMax2.z && vMax1.z >= vMin2.z);
+}
+
+/**
+*  @brief
+*    Intersects a ray with a box by using the slab test, returns the entry distance of the ray
+*/
+static bool IntersectBox(const Vector3 &vMin, const Vector3 &vMax, const Vector3 &vOrigin, const Vector3 &vInverseDirection, float fMaxDistance, float &fEntry)
+{
+	const float fX1 = (vMin.x - vOrigin.x)*vInverseDirection.x;
+	const float fX2 = (vMax.x - vOrigin.x)*vInverseDirection.x;
+	const float fY1 = (vMin.y - vOrigin.y)*vInverseDirection.y;
+	const float fY2 = (vMax.y - vOrigin.y)*vInverseDirection.y;
+	const float fZ1 = (vMin.z - vOrigin.z)*vInverseDirection.z;
+	const float fZ2 = (vMax.z - vOrigin.z)*vInverseDirection.z;
+	const float fNear = Math::Max(Math::Max(Math::Min(fX1, fX2), Math::Min(fY1, fY2)), Math::Min(fZ1, fZ2));
+	const float fFar  = Math::Min(Math::Min(Math::Max(fX1, fX2), Math::Max(fY1, fY2)), Math::Max(fZ1, fZ2));
+	fEntry = Math::Max(fNear, 0.0f);
+	return (fEntry <= fFar && fEntry <= fMaxDistance);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+Bvh::Bvh() :
+	m_bMoved(false)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+Bvh::~Bvh()
+{
+}
+
+/**
+*  @brief
+*    Builds the hierarchy
+*/
+void Bvh::Build(const Array<Vector3> &lstVertices, const Array<uint32> &lstIndices)
+{
+	// Copy the triangles
+	Clear();
+	m_lstVertices = lstVertices;
+	m_lstIndices  = lstIndices;
+	const uint32 nNumOfTriangles = m_lstIndices.GetNumOfElements()/3;
+	if (nNumOfTriangles) {
+		// Centroid per triangle
+		Array<Vector3> lstCentroids;
+		lstCentroids.Resize(nNumOfTriangles, false, false);
+		m_lstTriangles.Resize(nNumOfTriangles, false, false);
+		for (uint32 i=0; i<nNumOfTriangles; i++) {
+			lstCentroids[i] = (m_lstVertices[m_lstIndices[i*3]] + m_lstVertices[m_lstIndices[i*3 + 1]] + m_lstVertices[m_lstIndices[i*3 + 2]])/3.0f;
+			m_lstTriangles[i] = i;
+		}
+
+		// Build the nodes, starting with the root
+		m_lstNodes.Add();
+		BuildNode(0, 0, nNumOfTriangles, lstCentroids, 0);
+	}
+
+	// No vertex was moved yet
+	m_lstMoved.Resize(m_lstVertices.GetNumOfElements(), true, false);
+	for (uint32 i=0; i<m_lstMoved.GetNumOfElements(); i++)
+		m_lstMoved[i] = 0;
+	m_lstRefitted.Resize(m_lstNodes.GetNumOfElements(), true, false);
+}
+
+/**
+*  @brief
+*    Moves a range of vertices
+*/
+void Bvh::MoveVertices(uint32 nFirstVertex, const Array<Vector3> &lstVertices, const Matrix3x4 &mTransform)
+{
+	if (nFirstVertex + lstVertices.GetNumOfElements() <= m_lstVertices.GetNumOfElements()) {
+		for (uint32 i=0; i<lstVertices.GetNumOfElements(); i++) {
+			m_lstVertices[nFirstVertex + i] = mTransform*lstVertices[i];
+			m_lstMoved[nFirstVertex + i]	= 1;
+		}
+		if (lstVertices.GetNumOfElements())
+			m_bMoved = true;
+	}
+}
+
+/**
+*  @brief
+*    Refits the hierarchy to the moved vertices
+*/
+uint32 Bvh::Refit()
+{
+	if (!m_bMoved)
+		return 0;
+
+	// The children of a node are always behind it, so the bounds are calculated bottom-up by going backwards, only
+	// leaves with moved vertices and their parents are recalculated
+	uint32 nNumOfRefittedNodes = 0;
+	for (int i=m_lstNodes.GetNumOfElements()-1; i>=0; i--) {
+		Node &sNode = m_lstNodes[i];
+		bool bRefit = false;
+		if (sNode.nNumOfTriangles) {
+			for (uint32 j=0; j<sNode.nNumOfTriangles && !bRefit; j++) {
+				const uint32 nTriangle = m_lstTriangles[sNode.nFirst + j];
+				bRefit = (m_lstMoved[m_lstIndices[nTriangle*3]] || m_lstMoved[m_lstIndices[nTriangle*3 + 1]] || m_lstMoved[m_lstIndices[nTriangle*3 + 2]]);
+			}
+			if (bRefit)
+				CalculateLeafBounds(sNode);
+		} else {
+			bRefit = (m_lstRefitted[i + 1] || m_lstRefitted[sNode.nFirst]);
+			if (bRefit) {
+				const Node &sLeft  = m_lstNodes[i + 1];
+				const Node &sRight = m_lstNodes[sNode.nFirst];
+				sNode.vMin = sLeft.vMin;
+				sNode.vMax = sLeft.vMax;
+				GrowBox(sNode.vMin, sNode.vMax, sRight.vMin);
+				GrowBox(sNode.vMin, sNode.vMax, sRight.vMax);
+			}
+		}
+		m_lstRefitted[i] = bRefit;
+		if (bRefit)
+			nNumOfRefittedNodes++;
+	}
+
+	// The vertices are no longer moved
+	for (uint32 i=0; i<m_lstMoved.GetNumOfElements(); i++)
+		m_lstMoved[i] = 0;
+	m_bMoved = false;
+
+	// Done
+	return nNumOfRefittedNodes;
+}
+
+/**
+*  @brief
+*    Clears the hierarchy
+*/
+void Bvh::Clear()
+{
+	m_lstVertices.Clear();
+	m_lstIndices.Clear();
+	m_lstTriangles.Clear();
+	m_lstNodes.Clear();
+	m_lstMoved.Clear();
+	m_lstRefitted.Clear();
+	m_bMoved = false;
+}
+
+/**
+*  @brief
+*    Returns the number of triangles
+*/
+uint32 Bvh::GetNumOfTriangles() const
+{
+	return m_lstTriangles.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the number of nodes
+*/
+uint32 Bvh::GetNumOfNodes() const
+{
+	return m_lstNodes.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Intersects a ray with the triangles
+*/
+bool Bvh::Intersect(const Ray &sRay, Hit &sHit) const
+{
+	if (!m_lstNodes.GetNumOfElements())
+		return false; // Nothing to hit
+
+	// Traverse the hierarchy, the nearer child first
+	const Vector3 vInverseDirection = GetInverseDirection(sRay.vDirection);
+	uint32 nStack[TraversalStackSize];
+	uint32 nStackSize = 0;
+	nStack[nStackSize++] = 0;
+	bool bHit = false;
+	while (nStackSize) {
+		const Node &sNode = m_lstNodes[nStack[--nStackSize]];
+		float fEntry;
+		if (IntersectBox(sNode.vMin, sNode.vMax, sRay.vOrigin, vInverseDirection, sHit.fDistance, fEntry)) {
+			if (sNode.nNumOfTriangles) {
+				// Leaf
+				for (uint32 i=0; i<sNode.nNumOfTriangles; i++) {
+					const uint32 nTriangle = m_lstTriangles[sNode.nFirst + i];
+					float fDistance;
+					if (IntersectTriangle(sRay, nTriangle, sHit.fDistance, fDistance)) {
+						sHit.fDistance = fDistance;
+						sHit.nTriangle = nTriangle;
+						bHit = true;
+					}
+				}
+			} else {
+				// Inner node, push the farther child first
+				const uint32 nLeft  = static_cast<uint32>(&sNode - &m_lstNodes[0]) + 1;
+				const uint32 nRight = sNode.nFirst;
+				float fLeftEntry, fRightEntry;
+				const bool bLeft  = IntersectBox(m_lstNodes[nLeft].vMin,  m_lstNodes[nLeft].vMax,  sRay.vOrigin, vInverseDirection, sHit.fDistance, fLeftEntry);
+				const bool bRight = IntersectBox(m_lstNodes[nRight].vMin, m_lstNodes[nRight].vMax, sRay.vOrigin, vInverseDirection, sHit.fDistance, fRightEntry);
+				if (bLeft && bRight) {
+					nStack[nStackSize++] = (fLeftEntry < fRightEntry) ? nRight : nLeft;
+					nStack[nStackSize++] = (fLeftEntry < fRightEntry) ? nLeft  : nRight;
+				} else if (bLeft) {
+					nStack[nStackSize++] = nLeft;
+				} else if (bRight) {
+					nStack[nStackSize++] = nRight;
+				}
+			}
+		}
+	}
+
+	// Done
+	return bHit;
+}
+
+/**
+*  @brief
+*    Intersects a packet of rays with the triangles
+*/
+uint32 Bvh::Intersect(const Ray *pRays, Hit *pHits, uint32 nNumOfRays) const
+{
+	if (!m_lstNodes.GetNumOfElements())
+		return 0; // Nothing to hit
+	if (nNumOfRays > MaxPacketSize)
+		nNumOfRays = MaxPacketSize;
+
+	// Reciprocal ray directions
+	Vector3 vInverseDirections[MaxPacketSize];
+	bool bUpdated[MaxPacketSize];
+	for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+		vInverseDirections[nRay] = GetInverseDirection(pRays[nRay].vDirection);
+		bUpdated[nRay] = false;
+	}
+
+	// Traverse the hierarchy once for all rays, a node is visited if at least one ray hits its bounds
+	uint32 nStack[TraversalStackSize];
+	uint32 nStackSize = 0;
+	nStack[nStackSize++] = 0;
+	uint32 nActiveRays[MaxPacketSize];
+	while (nStackSize) {
+		const uint32 nNode = nStack[--nStackSize];
+		const Node &sNode = m_lstNodes[nNode];
+
+		// Collect the rays hitting the node bounds
+		uint32 nNumOfActiveRays = 0;
+		float fFirstEntry = 0.0f;
+		for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+			float fEntry;
+			if (IntersectBox(sNode.vMin, sNode.vMax, pRays[nRay].vOrigin, vInverseDirections[nRay], pHits[nRay].fDistance, fEntry)) {
+				if (!nNumOfActiveRays)
+					fFirstEntry = fEntry;
+				nActiveRays[nNumOfActiveRays++] = nRay;
+			}
+		}
+		if (nNumOfActiveRays) {
+			if (sNode.nNumOfTriangles) {
+				// Leaf
+				for (uint32 i=0; i<sNode.nNumOfTriangles; i++) {
+					const uint32 nTriangle = m_lstTriangles[sNode.nFirst + i];
+					for (uint32 j=0; j<nNumOfActiveRays; j++) {
+						const uint32 nRay = nActiveRays[j];
+						float fDistance;
+						if (IntersectTriangle(pRays[nRay], nTriangle, pHits[nRay].fDistance, fDistance)) {
+							pHits[nRay].fDistance = fDistance;
+							pHits[nRay].nTriangle = nTriangle;
+							bUpdated[nRay] = true;
+						}
+					}
+				}
+			} else {
+				// Inner node, the first active ray decides which child is visited first
+				const uint32 nLeft  = nNode + 1;
+				const uint32 nRight = sNode.nFirst;
+				const uint32 nRay   = nActiveRays[0];
+				float fLeftEntry, fRightEntry;
+				IntersectBox(m_lstNodes[nLeft].vMin,  m_lstNodes[nLeft].vMax,  pRays[nRay].vOrigin, vInverseDirections[nRay], Math::MaxFloat, fLeftEntry);
+				IntersectBox(m_lstNodes[nRight].vMin, m_lstNodes[nRight].vMax, pRays[nRay].vOrigin, vInverseDirections[nRay], Math::MaxFloat, fRightEntry);
+				nStack[nStackSize++] = (fLeftEntry < fRightEntry) ? nRight : nLeft;
+				nStack[nStackSize++] = (fLeftEntry < fRightEntry) ? nLeft  : nRight;
+			}
+		}
+	}
+
+	// Count the updated hits
+	uint32 nNumOfUpdatedHits = 0;
+	for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+		if (bUpdated[nRay])
+			nNumOfUpdatedHits++;
+	}
+	return nNumOfUpdatedHits;
+}
+
+/**
+*  @brief
+*    Returns the triangles which bounds overlap a box
+*/
+void Bvh::GetTriangles(const Vector3 &vMin, const Vector3 &vMax, Array<uint32> &lstTriangles) const
+{
+	if (!m_lstNodes.GetNumOfElements())
+		return; // Nothing to return
+
+	// Traverse the hierarchy
+	uint32 nStack[TraversalStackSize];
+	uint32 nStackSize = 0;
+	nStack[nStackSize++] = 0;
+	while (nStackSize) {
+		const uint32 nNode = nStack[--nStackSize];
+		const Node &sNode = m_lstNodes[nNode];
+		if (OverlapBox(sNode.vMin, sNode.vMax, vMin, vMax)) {
+			if (sNode.nNumOfTriangles) {
+				// Leaf, test the triangle bounds
+				for (uint32 i=0; i<sNode.nNumOfTriangles; i++) {
+					const uint32 nTriangle = m_lstTriangles[sNode.nFirst + i];
+					Vector3 vTriangleMin = m_lstVertices[m_lstIndices[nTriangle*3]];
+					Vector3 vTriangleMax = vTriangleMin;
+					GrowBox(vTriangleMin, vTriangleMax, m_lstVertices[m_lstIndices[nTriangle*3 + 1]]);
+					GrowBox(vTriangleMin, vTriangleMax, m_lstVertices[m_lstIndices[nTriangle*3 + 2]]);
+					if (OverlapBox(vTriangleMin, vTriangleMax, vMin, vMax))
+						lstTriangles.Add(nTriangle);
+				}
+			} else {
+				// Inner node
+				nStack[nStackSize++] = sNode.nFirst;
+				nStack[nStackSize++] = nNode + 1;
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the corners of a triangle
+*/
+void Bvh::GetTriangle(uint32 nTriangle, Vector3 &vV0, Vector3 &vV1, Vector3 &vV2) const
+{
+	vV0 = m_lstVertices[m_lstIndices[nTriangle*3]];
+	vV1 = m_lstVertices[m_lstIndices[nTriangle*3 + 1]];
+	vV2 = m_lstVertices[m_lstIndices[nTriangle*3 + 2]];
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+Bvh::Bvh(const Bvh &cSource) :
+	m_bMoved(false)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+Bvh &Bvh::operator =(const Bvh &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Builds a node and its children
+*/
+void Bvh::BuildNode(uint32 nNode, uint32 nFirst, uint32 nNumOfTriangles, const Array<Vector3> &lstCentroids, uint32 nDepth)
+{
+	// Start as leaf
+	{
+		Node &sNode = m_lstNodes[nNode];
+		sNode.nFirst		  = nFirst;
+		sNode.nNumOfTriangles = nNumOfTriangles;
+		CalculateLeafBounds(sNode);
+	}
+	if (nNumOfTriangles <= MaxLeafTriangles || nDepth >= MaxDepth)
+		return;
+
+	// Get the largest axis of the centroid bounds
+	Vector3 vCentroidMin = lstCentroids[m_lstTriangles[nFirst]];
+	Vector3 vCentroidMax = vCentroidMin;
+	for (uint32 i=1; i<nNumOfTriangles; i++)
+		GrowBox(vCentroidMin, vCentroidMax, lstCentroids[m_lstTriangles[nFirst + i]]);
+	const Vector3 vExtent = vCentroidMax - vCentroidMin;
+	const uint32 nAxis = (vExtent.x > vExtent.y) ? ((vExtent.x > vExtent.z) ? 0 : 2) : ((vExtent.y > vExtent.z) ? 1 : 2);
+	const float fExtent = vExtent[nAxis];
+	if (fExtent <= 0.0f)
+		return; // All centroids are at the same position
+
+	// Sort the triangles into the bins
+	Vector3 vBinMin[NumOfBins], vBinMax[NumOfBins];
+	uint32 nBinCount[NumOfBins];
+	for (uint32 nBin=0; nBin<NumOfBins; nBin++) {
+		vBinMin[nBin].SetXYZ( Math::MaxFloat,  Math::MaxFloat,  Math::MaxFloat);
+		vBinMax[nBin].SetXYZ(-Math::MaxFloat, -Math::MaxFloat, -Math::MaxFloat);
+		nBinCount[nBin] = 0;
+	}
+	const float fBinScale = NumOfBins/fExtent;
+	for (uint32 i=0; i<nNumOfTriangles; i++) {
+		const uint32 nTriangle = m_lstTriangles[nFirst + i];
+		const uint32 nBin = Math::Min(static_cast<uint32>((lstCentroids[nTriangle][nAxis] - vCentroidMin[nAxis])*fBinScale), NumOfBins - 1);
+		for (uint32 nCorner=0; nCorner<3; nCorner++)
+			GrowBox(vBinMin[nBin], vBinMax[nBin], m_lstVertices[m_lstIndices[nTriangle*3 + nCorner]]);
+		nBinCount[nBin]++;
+	}
+
+	// Surface area and triangle count on the right side of each bin boundary
+	float fRightArea[NumOfBins];
+	uint32 nRightCount[NumOfBins];
+	Vector3 vMin( Math::MaxFloat,  Math::MaxFloat,  Math::MaxFloat);
+	Vector3 vMax(-Math::MaxFloat, -Math::MaxFloat, -Math::MaxFloat);
+	uint32 nCount = 0;
+	for (uint32 nBin=NumOfBins-1; nBin>0; nBin--) {
+		if (nBinCount[nBin]) {
+			GrowBox(vMin, vMax, vBinMin[nBin]);
+			GrowBox(vMin, vMax, vBinMax[nBin]);
+			nCount += nBinCount[nBin];
+		}
+		fRightArea[nBin]  = nCount ? GetSurfaceArea(vMin, vMax) : 0.0f;
+		nRightCount[nBin] = nCount;
+	}
+
+	// Find the cheapest split, the split is left of the bin
+	uint32 nBestSplit = 0;
+	float fBestCost = Math::MaxFloat;
+	vMin.SetXYZ( Math::MaxFloat,  Math::MaxFloat,  Math::MaxFloat);
+	vMax.SetXYZ(-Math::MaxFloat, -Math::MaxFloat, -Math::MaxFloat);
+	nCount = 0;
+	for (uint32 nSplit=1; nSplit<NumOfBins; nSplit++) {
+		if (nBinCount[nSplit - 1]) {
+			GrowBox(vMin, vMax, vBinMin[nSplit - 1]);
+			GrowBox(vMin, vMax, vBinMax[nSplit - 1]);
+			nCount += nBinCount[nSplit - 1];
+		}
+		if (nCount && nRightCount[nSplit]) {
+			const float fCost = GetSurfaceArea(vMin, vMax)*nCount + fRightArea[nSplit]*nRightCount[nSplit];
+			if (fBestCost > fCost) {
+				fBestCost  = fCost;
+				nBestSplit = nSplit;
+			}
+		}
+	}
+	if (!nBestSplit)
+		return; // No split possible
+
+	// Keep the leaf if splitting isn't cheaper (traversal and intersection are assumed to cost the same)
+	const Node &sLeaf = m_lstNodes[nNode];
+	if (nNumOfTriangles <= MaxCheapLeaf && fBestCost/GetSurfaceArea(sLeaf.vMin, sLeaf.vMax) + 1.0f >= nNumOfTriangles)
+		return;
+
+	// Partition the triangles
+	uint32 i = nFirst;
+	uint32 j = nFirst + nNumOfTriangles;
+	while (i < j) {
+		const uint32 nTriangle = m_lstTriangles[i];
+		const uint32 nBin = Math::Min(static_cast<uint32>((lstCentroids[nTriangle][nAxis] - vCentroidMin[nAxis])*fBinScale), NumOfBins - 1);
+		if (nBin < nBestSplit) {
+			i++;
+		} else {
+			j--;
+			m_lstTriangles[i] = m_lstTriangles[j];
+			m_lstTriangles[j] = nTriangle;
+		}
+	}
+	const uint32 nNumOfLeftTriangles = i - nFirst;
+
+	// Build the children, the left child directly follows this node
+	const uint32 nLeft = m_lstNodes.GetNumOfElements();
+	m_lstNodes.Add();
+	BuildNode(nLeft, nFirst, nNumOfLeftTriangles, lstCentroids, nDepth + 1);
+	const uint32 nRight = m_lstNodes.GetNumOfElements();
+	m_lstNodes.Add();
+	BuildNode(nRight, nFirst + nNumOfLeftTriangles, nNumOfTriangles - nNumOfLeftTriangles, lstCentroids, nDepth + 1);
+
+	// This node is an inner node
+	Node &sNode = m_lstNodes[nNode];
+	sNode.nFirst		  = nRight;
+	sNode.nNumOfTriangles = 0;
+}
+
+/**
+*  @brief
+*    Calculates the bounds of the triangles of a leaf
+*/
+void Bvh::CalculateLeafBounds(Node &sNode) const
+{
+	sNode.vMin = sNode.vMax = m_lstVertices[m_lstIndices[m_lstTriangles[sNode.nFirst]*3]];
+	for (uint32 i=0; i<sNode.nNumOfTriangles; i++) {
+		const uint32 nTriangle = m_lstTriangles[sNode.nFirst + i];
+		for (uint32 nCorner=0; nCorner<3; nCorner++)
+			GrowBox(sNode.vMin, sNode.vMax, m_lstVertices[m_lstIndices[nTriangle*3 + nCorner]]);
+	}
+}
+
+/**
+*  @brief
+*    Intersects a ray with a triangle
+*/
+bool Bvh::IntersectTriangle(const Ray &sRay, uint32 nTriangle, float fMaxDistance, float &fDistance) const
+{
+	// Moeller-Trumbore, both sides of the triangle are hit
+	const Vector3 &v0 = m_lstVertices[m_lstIndices[nTriangle*3]];
+	const Vector3 vEdge1 = m_lstVertices[m_lstIndices[nTriangle*3 + 1]] - v0;
+	const Vector3 vEdge2 = m_lstVertices[m_lstIndices[nTriangle*3 + 2]] - v0;
+	const Vector3 vP = sRay.vDirection.CrossProduct(vEdge2);
+	const float fDeterminant = vEdge1.DotProduct(vP);
+	if (Math::Abs(fDeterminant) < Math::Epsilon)
+		return false; // The ray is parallel to the triangle
+	const float fInverseDeterminant = 1.0f/fDeterminant;
+	const Vector3 vT = sRay.vOrigin - v0;
+	const float fU = vT.DotProduct(vP)*fInverseDeterminant;
+	if (fU < 0.0f || fU > 1.0f)
+		return false;
+	const Vector3 vQ = vT.CrossProduct(vEdge1);
+	const float fV = sRay.vDirection.DotProduct(vQ)*fInverseDeterminant;
+	if (fV < 0.0f || fU + fV > 1.0f)
+		return false;
+	fDistance = vEdge2.DotProduct(vQ)*fInverseDeterminant;
+	return (fDistance >= 0.0f && fDistance < fMaxDistance);
+}
@@ -0,0 +1,331 @@
+/*********************************************************\
+ *  File: Bvh.h                                          *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_BVH_H__
+#define __DUNGEON_BVH_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/Array.h>
+#include <PLMath/Vector3.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Matrix3x4;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Bounding volume hierarchy over triangles for nearest hit ray queries
+*
+*  @remarks
+*    The hierarchy is built top-down by using the surface area heuristic (SAH), evaluated at a fixed number of bins
+*    along the largest axis of the triangle centroids. The nodes are stored depth-first within a single array, the
+*    left child of an inner node directly follows its parent. After vertices have been moved, the hierarchy can
+*    be refitted: The topology is kept, only the bounds of the nodes with moved vertices are recalculated bottom-up
+*    - cheap, but the quality of the hierarchy degrades the further the vertices move away from where the hierarchy
+*    was built.
+*
+*    Rays can be intersected one by one or as packet: A packet shares the traversal, each node is fetched once for
+*    all rays of the packet, which pays off for coherent rays such as the rays of a screen region.
+*/
+class Bvh {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 NoTriangle    = 0xFFFFFFFF;	/**< Triangle index of a hit which didn't hit anything */
+		static const PLCore::uint32 MaxPacketSize = 64;			/**< Maximum number of rays within a packet */
+
+		/**
+		*  @brief
+		*    Ray
+		*/
+		struct Ray {
+			PLMath::Vector3 vOrigin;		/**< Ray origin */
+			PLMath::Vector3 vDirection;		/**< Ray direction, the hit distances are in units of its length */
+		};
+
+		/**
+		*  @brief
+		*    Nearest hit of a ray
+		*
+		*  @remarks
+		*    The hit must be initialized by the caller with the maximum distance and "NoTriangle", it's only updated
+		*    by a closer hit - this way a ray can be intersected with multiple hierarchies.
+		*/
+		struct Hit {
+			float		   fDistance;	/**< Distance of the hit (in units of the ray direction length) */
+			PLCore::uint32 nTriangle;	/**< Index of the hit triangle, "NoTriangle" if nothing was hit */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		Bvh();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~Bvh();
+
+		/**
+		*  @brief
+		*    Builds the hierarchy
+		*
+		*  @param[in] lstVertices
+		*    Vertices, copied by the hierarchy
+		*  @param[in] lstIndices
+		*    Three vertex indices per triangle, copied by the hierarchy
+		*/
+		void Build(const PLCore::Array<PLMath::Vector3> &lstVertices, const PLCore::Array<PLCore::uint32> &lstIndices);
+
+		/**
+		*  @brief
+		*    Moves a range of vertices
+		*
+		*  @param[in] nFirstVertex
+		*    Index of the first vertex to move
+		*  @param[in] lstVertices
+		*    Untransformed vertices, the range must be within the vertices the hierarchy was built with
+		*  @param[in] mTransform
+		*    Transform of the vertices
+		*
+		*  @note
+		*    - The bounds are not updated until "Refit()" is called
+		*/
+		void MoveVertices(PLCore::uint32 nFirstVertex, const PLCore::Array<PLMath::Vector3> &lstVertices, const PLMath::Matrix3x4 &mTransform);
+
+		/**
+		*  @brief
+		*    Refits the hierarchy to the moved vertices
+		*
+		*  @return
+		*    The number of nodes which bounds were recalculated
+		*/
+		PLCore::uint32 Refit();
+
+		/**
+		*  @brief
+		*    Clears the hierarchy
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Returns the number of triangles
+		*
+		*  @return
+		*    The number of triangles
+		*/
+		PLCore::uint32 GetNumOfTriangles() const;
+
+		/**
+		*  @brief
+		*    Returns the number of nodes
+		*
+		*  @return
+		*    The number of nodes
+		*/
+		PLCore::uint32 GetNumOfNodes() const;
+
+		/**
+		*  @brief
+		*    Intersects a ray with the triangles
+		*
+		*  @param[in]     sRay
+		*    Ray to intersect
+		*  @param[in, out] sHit
+		*    Nearest hit, updated if a triangle is hit closer than the given hit distance
+		*
+		*  @return
+		*    'true' if the hit was updated, else 'false'
+		*/
+		bool Intersect(const Ray &sRay, Hit &sHit) const;
+
+		/**
+		*  @brief
+		*    Intersects a packet of rays with the triangles
+		*
+		*  @param[in]      pRays
+		*    Rays to intersect, must be valid
+		*  @param[in, out] pHits
+		*    Nearest hit per ray, must be valid, updated if a triangle is hit closer than the given hit distance
+		*  @param[in]      nNumOfRays
+		*    Number of rays within the packet (at most "MaxPacketSize")
+		*
+		*  @return
+		*    Number of updated hits
+		*/
+		PLCore::uint32 Intersect(const Ray *pRays, Hit *pHits, PLCore::uint32 nNumOfRays) const;
+
+		/**
+		*  @brief
+		*    Returns the triangles which bounds overlap a box
+		*
+		*  @param[in]  vMin
+		*    Minimum corner of the box
+		*  @param[in]  vMax
+		*    Maximum corner of the box
+		*  @param[out] lstTriangles
+		*    Receives the indices of the triangles, the list is not cleared
+		*/
+		void GetTriangles(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax, PLCore::Array<PLCore::uint32> &lstTriangles) const;
+
+		/**
+		*  @brief
+		*    Returns the corners of a triangle
+		*
+		*  @param[in]  nTriangle
+		*    Index of the triangle, must be valid
+		*  @param[out] vV0
+		*    Receives the first corner
+		*  @param[out] vV1
+		*    Receives the second corner
+		*  @param[out] vV2
+		*    Receives the third corner
+		*/
+		void GetTriangle(PLCore::uint32 nTriangle, PLMath::Vector3 &vV0, PLMath::Vector3 &vV1, PLMath::Vector3 &vV2) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Hierarchy node
+		*/
+		struct Node {
+			PLMath::Vector3 vMin;			/**< Minimum of the node bounds */
+			PLMath::Vector3 vMax;			/**< Maximum of the node bounds */
+			PLCore::uint32  nFirst;			/**< Leaf: First triangle within "m_lstTriangles", inner node: Index of the right child */
+			PLCore::uint32  nNumOfTriangles;	/**< Leaf: Number of triangles, inner node: 0 */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		Bvh(const Bvh &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		Bvh &operator =(const Bvh &cSource);
+
+		/**
+		*  @brief
+		*    Builds a node and its children
+		*
+		*  @param[in] nNode
+		*    Index of the node to build
+		*  @param[in] nFirst
+		*    First triangle of the node within "m_lstTriangles"
+		*  @param[in] nNumOfTriangles
+		*    Number of triangles of the node
+		*  @param[in] lstCentroids
+		*    Centroid per triangle
+		*  @param[in] nDepth
+		*    Depth of the node, 0 for the root
+		*/
+		void BuildNode(PLCore::uint32 nNode, PLCore::uint32 nFirst, PLCore::uint32 nNumOfTriangles, const PLCore::Array<PLMath::Vector3> &lstCentroids, PLCore::uint32 nDepth);
+
+		/**
+		*  @brief
+		*    Calculates the bounds of the triangles of a leaf
+		*
+		*  @param[in, out] sNode
+		*    Leaf to calculate the bounds of
+		*/
+		void CalculateLeafBounds(Node &sNode) const;
+
+		/**
+		*  @brief
+		*    Intersects a ray with a triangle
+		*
+		*  @param[in] sRay
+		*    Ray to intersect
+		*  @param[in] nTriangle
+		*    Triangle index
+		*  @param[in] fMaxDistance
+		*    Maximum distance of the hit
+		*  @param[out] fDistance
+		*    Receives the distance of the hit
+		*
+		*  @return
+		*    'true' if the triangle is hit closer than the maximum distance, else 'false'
+		*/
+		bool IntersectTriangle(const Ray &sRay, PLCore::uint32 nTriangle, float fMaxDistance, float &fDistance) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<PLMath::Vector3> m_lstVertices;	/**< Vertices */
+		PLCore::Array<PLCore::uint32>  m_lstIndices;	/**< Three vertex indices per triangle */
+		PLCore::Array<PLCore::uint32>  m_lstTriangles;	/**< Triangle indices, sorted by the leaves */
+		PLCore::Array<Node>			   m_lstNodes;		/**< Nodes, depth-first, the first node is the root */
+		PLCore::Array<PLCore::uint8>   m_lstMoved;		/**< Was the vertex moved since the last refit? Per vertex */
+		PLCore::Array<PLCore::uint8>   m_lstRefitted;	/**< Were the bounds of the node recalculated by the current refit? Per node */
+		bool						   m_bMoved;		/**< Were any vertices moved since the last refit? */
+
+
+};
+
+
+#endif // __DUNGEON_BVH_H__
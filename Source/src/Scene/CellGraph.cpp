@@ -0,0 +1,232 @@
+/*********************************************************\
+ *  File: CellGraph.cpp                                  *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/Container/Queue.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Scene/CellGraph.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+CellGraph::CellGraph()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+CellGraph::~CellGraph()
+{
+}
+
+/**
+*  @brief
+*    Builds the graph
+*/
+bool CellGraph::Build(SceneContainer &cContainer)
+{
+	// Remove the previous graph
+	Clear();
+
+	// Collect the cells
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode && pSceneNode->IsInstanceOf("PLScene::SCCell"))
+			m_lstCells.Add(static_cast<SceneContainer*>(pSceneNode));
+	}
+	m_lstNeighbours.Resize(m_lstCells.GetNumOfElements());
+
+	// Connect the cells by using their cell portals
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		AddPortals(i, *m_lstCells[i]);
+
+	// Done
+	return (m_lstCells.GetNumOfElements() != 0);
+}
+
+/**
+*  @brief
+*    Clears the graph
+*/
+void CellGraph::Clear()
+{
+	m_lstCells.Clear();
+	m_lstNeighbours.Clear();
+}
+
+/**
+*  @brief
+*    Returns the number of cells
+*/
+uint32 CellGraph::GetNumOfCells() const
+{
+	return m_lstCells.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns a cell
+*/
+SceneContainer *CellGraph::GetCell(uint32 nCell) const
+{
+	return (nCell < m_lstCells.GetNumOfElements()) ? m_lstCells[nCell] : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the index of the cell a scene node is in
+*/
+uint32 CellGraph::GetCellIndex(const SceneNode &cSceneNode) const
+{
+	// Walk up the scene graph until a cell of the graph is found
+	const SceneNode *pSceneNode = &cSceneNode;
+	while (pSceneNode) {
+		for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+			if (m_lstCells[i] == pSceneNode)
+				return i;
+		}
+		pSceneNode = pSceneNode->GetContainer();
+	}
+
+	// Not within a cell of the graph
+	return InvalidCell;
+}
+
+/**
+*  @brief
+*    Returns the indices of the neighbour cells of a cell
+*/
+const Array<uint32> &CellGraph::GetNeighbours(uint32 nCell) const
+{
+	static const Array<uint32> lstNoNeighbours;
+	return (nCell < m_lstNeighbours.GetNumOfElements()) ? m_lstNeighbours[nCell] : lstNoNeighbours;
+}
+
+/**
+*  @brief
+*    Calculates the portal distances of all cells to a start cell
+*/
+void CellGraph::GetDistances(uint32 nStartCell, Array<uint32> &lstDistances) const
+{
+	// Initialize the distances
+	lstDistances.Resize(m_lstCells.GetNumOfElements());
+	for (uint32 i=0; i<lstDistances.GetNumOfElements(); i++)
+		lstDistances[i] = Unreachable;
+	if (nStartCell >= m_lstCells.GetNumOfElements())
+		return; // Error!
+
+	// Breadth-first search starting at the start cell
+	Queue<uint32> lstOpen;
+	lstDistances[nStartCell] = 0;
+	lstOpen.Push(nStartCell);
+	uint32 nCell = 0;
+	while (lstOpen.Pop(&nCell)) {
+		const Array<uint32> &lstNeighbours = m_lstNeighbours[nCell];
+		for (uint32 i=0; i<lstNeighbours.GetNumOfElements(); i++) {
+			const uint32 nNeighbour = lstNeighbours[i];
+			if (lstDistances[nNeighbour] == Unreachable) {
+				lstDistances[nNeighbour] = lstDistances[nCell] + 1;
+				lstOpen.Push(nNeighbour);
+			}
+		}
+	}
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+CellGraph::CellGraph(const CellGraph &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+CellGraph &CellGraph::operator =(const CellGraph &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Adds the connections of the cell portals within a container
+*/
+void CellGraph::AddPortals(uint32 nCell, SceneContainer &cContainer)
+{
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			if (pSceneNode->IsInstanceOf("PLScene::SNCellPortal")) {
+				// Get the target cell, the target is relative to the container the portal is in (e.g. "Parent.kanal5")
+				const DynVar *pTargetCell = pSceneNode->GetAttribute("TargetCell");
+				if (pTargetCell) {
+					const SceneNode *pTargetSceneNode = cContainer.GetByName(pTargetCell->GetString());
+					if (pTargetSceneNode) {
+						const uint32 nTargetCell = GetCellIndex(*pTargetSceneNode);
+						if (nTargetCell != InvalidCell && nTargetCell != nCell)
+							AddConnection(nCell, nTargetCell);
+					}
+				}
+			} else if (pSceneNode->IsContainer() && !pSceneNode->IsInstanceOf("PLScene::SCCell")) {
+				// Portals may be within containers inside the cell
+				AddPortals(nCell, static_cast<SceneContainer&>(*pSceneNode));
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Adds an undirected connection between two cells
+*/
+void CellGraph::AddConnection(uint32 nFirstCell, uint32 nSecondCell)
+{
+	if (!m_lstNeighbours[nFirstCell].IsElement(nSecondCell))
+		m_lstNeighbours[nFirstCell].Add(nSecondCell);
+	if (!m_lstNeighbours[nSecondCell].IsElement(nFirstCell))
+		m_lstNeighbours[nSecondCell].Add(nFirstCell);
+}
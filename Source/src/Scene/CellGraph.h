@@ -0,0 +1,216 @@
+/*********************************************************\
+ *  File: CellGraph.h                                    *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_CELLGRAPH_H__
+#define __DUNGEON_CELLGRAPH_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/Array.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneNode;
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Graph of the cells of a scene, connected by their cell portals
+*
+*  @remarks
+*    The graph consists of the "PLScene::SCCell" containers directly within a scene container, two cells are
+*    connected if one of them has a "PLScene::SNCellPortal" targeting the other one. The connections are
+*    treated as undirected, the distance between two cells is the number of portals between them.
+*/
+class CellGraph {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 InvalidCell = 0xFFFFFFFF;	/**< Invalid cell index */
+		static const PLCore::uint32 Unreachable = 0xFFFFFFFF;	/**< Distance of a cell which can't be reached */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		CellGraph();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~CellGraph();
+
+		/**
+		*  @brief
+		*    Builds the graph
+		*
+		*  @param[in] cContainer
+		*    Scene container the cells are in (e.g. the physics world container of the dungeon)
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (no cells found)
+		*/
+		bool Build(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Clears the graph
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Returns the number of cells
+		*
+		*  @return
+		*    The number of cells
+		*/
+		PLCore::uint32 GetNumOfCells() const;
+
+		/**
+		*  @brief
+		*    Returns a cell
+		*
+		*  @param[in] nCell
+		*    Cell index
+		*
+		*  @return
+		*    The cell container, null pointer on error
+		*/
+		PLScene::SceneContainer *GetCell(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns the index of the cell a scene node is in
+		*
+		*  @param[in] cSceneNode
+		*    Scene node to return the cell index from, can be a cell itself
+		*
+		*  @return
+		*    The cell index, "InvalidCell" if the scene node isn't within a cell of the graph
+		*/
+		PLCore::uint32 GetCellIndex(const PLScene::SceneNode &cSceneNode) const;
+
+		/**
+		*  @brief
+		*    Returns the indices of the neighbour cells of a cell
+		*
+		*  @param[in] nCell
+		*    Cell index
+		*
+		*  @return
+		*    The indices of the cells connected to the given cell by a portal
+		*/
+		const PLCore::Array<PLCore::uint32> &GetNeighbours(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Calculates the portal distances of all cells to a start cell
+		*
+		*  @param[in]  nStartCell
+		*    Index of the start cell
+		*  @param[out] lstDistances
+		*    Receives the distance (number of portals) of each cell to the start cell, "Unreachable" if a cell can't be reached
+		*/
+		void GetDistances(PLCore::uint32 nStartCell, PLCore::Array<PLCore::uint32> &lstDistances) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		CellGraph(const CellGraph &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		CellGraph &operator =(const CellGraph &cSource);
+
+		/**
+		*  @brief
+		*    Adds the connections of the cell portals within a container
+		*
+		*  @param[in] nCell
+		*    Index of the cell the container is in
+		*  @param[in] cContainer
+		*    Container to search for cell portals (the cell itself or a container within it)
+		*/
+		void AddPortals(PLCore::uint32 nCell, PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Adds an undirected connection between two cells
+		*
+		*  @param[in] nFirstCell
+		*    Index of the first cell
+		*  @param[in] nSecondCell
+		*    Index of the second cell
+		*/
+		void AddConnection(PLCore::uint32 nFirstCell, PLCore::uint32 nSecondCell);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<PLScene::SceneContainer*>			m_lstCells;			/**< Cells */
+		PLCore::Array<PLCore::Array<PLCore::uint32> >	m_lstNeighbours;	/**< Neighbour cell indices per cell */
+
+
+};
+
+
+#endif // __DUNGEON_CELLGRAPH_H__
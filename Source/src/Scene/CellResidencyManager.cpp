@@ -0,0 +1,369 @@
+/*********************************************************\
+ *  File: CellResidencyManager.cpp                       *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLRenderer/Renderer/Renderer.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include "Scene/CellResidencyManager.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLRenderer;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+CellResidencyManager::CellResidencyManager(Renderer *pRenderer, uint32 nMaxHops, uint64 nBudget) :
+	m_pRenderer(pRenderer),
+	m_nMaxHops(nMaxHops),
+	m_nBudget(nBudget),
+	m_nCameraCell(CellGraph::InvalidCell),
+	m_nUpdate(0),
+	m_nMeasuredCell(CellGraph::InvalidCell),
+	m_nMeasureMemory(0),
+	m_nMeasureUpdate(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+CellResidencyManager::~CellResidencyManager()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Initializes the residency manager
+*/
+bool CellResidencyManager::Init(SceneContainer &cContainer)
+{
+	// Destroy the previous residency information
+	Clear();
+
+	// Build the cell graph
+	if (!m_cCellGraph.Build(cContainer))
+		return false; // Error!
+
+	// Initially, all cells are resident
+	for (uint32 i=0; i<m_cCellGraph.GetNumOfCells(); i++) {
+		Cell *pCell = new Cell;
+		pCell->cCell.SetElement(m_cCellGraph.GetCell(i));
+		pCell->bResident  = true;
+		pCell->nFootprint  = 0;
+		pCell->nHoldUpdate = 0;
+		CollectSceneNodes(*m_cCellGraph.GetCell(i), *pCell);
+		m_lstCells.Add(pCell);
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Updates the residency of the cells
+*/
+void CellResidencyManager::Update(SceneNode *pCamera)
+{
+	// Get the cell the camera is in
+	if (!pCamera)
+		return;
+	const uint32 nCameraCell = m_cCellGraph.GetCellIndex(*pCamera);
+	if (nCameraCell == CellGraph::InvalidCell)
+		return;
+
+	// Update the portal distances if the camera has moved into another cell
+	if (m_nCameraCell != nCameraCell) {
+		m_nCameraCell = nCameraCell;
+		m_cCellGraph.GetDistances(nCameraCell, m_lstDistances);
+	}
+
+	// The cell the camera is in and its direct neighbours are always resident
+	const uint32 nMaxHops = (m_nMaxHops > 1) ? m_nMaxHops : 1;
+	m_nUpdate++;
+
+	// Measure the footprint of the cell made resident last as soon as the renderer statistics had time to catch up
+	uint64 nUsedMemory = GetUsedMemory();
+	if (m_nMeasuredCell != CellGraph::InvalidCell && m_nUpdate - m_nMeasureUpdate >= SettleUpdates) {
+		m_lstCells[m_nMeasuredCell]->nFootprint = (nUsedMemory > m_nMeasureMemory) ? nUsedMemory - m_nMeasureMemory : 0;
+		m_nMeasuredCell = CellGraph::InvalidCell;
+	}
+
+	// Over budget? Evict the most distant resident cell, only one cell per update so the renderer statistics can catch up
+	if (m_nBudget && nUsedMemory > m_nBudget) {
+		uint32 nMostDistantCell = CellGraph::InvalidCell;
+		for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+			if (m_lstCells[i]->bResident && m_lstDistances[i] > 1 && (nMostDistantCell == CellGraph::InvalidCell || m_lstDistances[i] > m_lstDistances[nMostDistantCell]))
+				nMostDistantCell = i;
+		}
+		if (nMostDistantCell != CellGraph::InvalidCell) {
+			Evict(nMostDistantCell);
+
+			// Hold the cell back, else it would be made resident again as soon as the memory is freed
+			m_lstCells[nMostDistantCell]->nHoldUpdate = m_nUpdate + ReadmitUpdates;
+		}
+		return;
+	}
+
+	// Evict the resident cells which are too far away
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		if (m_lstCells[i]->bResident && m_lstDistances[i] > nMaxHops)
+			Evict(i);
+	}
+
+	// Make the cells within reach resident, nearest first. The cell the camera is in and its direct neighbours are made
+	// resident right away. The other cells are made resident one hop closer than they're evicted, one cell per update
+	// and only if no footprint is measured, no longer held back and their known footprint fits into the budget.
+	bool bMadeResident = false;
+	for (uint32 nDistance=0; nDistance<=nMaxHops; nDistance++) {
+		for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+			Cell &cCell = *m_lstCells[i];
+			if (!cCell.bResident && m_lstDistances[i] == nDistance) {
+				if (nDistance <= 1 || (!bMadeResident && nDistance < nMaxHops && m_nUpdate >= cCell.nHoldUpdate &&
+					(!m_nBudget || (m_nMeasuredCell == CellGraph::InvalidCell && nUsedMemory + cCell.nFootprint <= m_nBudget)))) {
+					// Measure the footprint of the cell, unless the memory added by another cell would falsify it
+					if (!bMadeResident && m_nMeasuredCell == CellGraph::InvalidCell) {
+						m_nMeasuredCell  = i;
+						m_nMeasureMemory = nUsedMemory;
+						m_nMeasureUpdate = m_nUpdate;
+					} else {
+						m_nMeasuredCell = CellGraph::InvalidCell;
+					}
+					MakeResident(i);
+					nUsedMemory += cCell.nFootprint;
+					bMadeResident = true;
+				}
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the cell graph
+*/
+const CellGraph &CellResidencyManager::GetCellGraph() const
+{
+	return m_cCellGraph;
+}
+
+/**
+*  @brief
+*    Returns whether or not a cell is resident
+*/
+bool CellResidencyManager::IsResident(uint32 nCell) const
+{
+	return (nCell < m_lstCells.GetNumOfElements() && m_lstCells[nCell]->bResident);
+}
+
+/**
+*  @brief
+*    Returns the number of resident cells
+*/
+uint32 CellResidencyManager::GetNumOfResidentCells() const
+{
+	uint32 nNumOfResidentCells = 0;
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		if (m_lstCells[i]->bResident)
+			nNumOfResidentCells++;
+	}
+	return nNumOfResidentCells;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+CellResidencyManager::CellResidencyManager(const CellResidencyManager &cSource) :
+	m_pRenderer(nullptr),
+	m_nMaxHops(0),
+	m_nBudget(0),
+	m_nCameraCell(CellGraph::InvalidCell),
+	m_nUpdate(0),
+	m_nMeasuredCell(CellGraph::InvalidCell),
+	m_nMeasureMemory(0),
+	m_nMeasureUpdate(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+CellResidencyManager &CellResidencyManager::operator =(const CellResidencyManager &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Destroys the residency information of all cells, evicted cells are made resident again
+*/
+void CellResidencyManager::Clear()
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		Cell *pCell = m_lstCells[i];
+		if (!pCell->bResident)
+			MakeResident(i);
+		for (uint32 j=0; j<pCell->lstSceneNodes.GetNumOfElements(); j++)
+			delete pCell->lstSceneNodes[j];
+		delete pCell;
+	}
+	m_lstCells.Clear();
+	m_cCellGraph.Clear();
+	m_nCameraCell = CellGraph::InvalidCell;
+	m_lstDistances.Clear();
+	m_nUpdate		= 0;
+	m_nMeasuredCell = CellGraph::InvalidCell;
+}
+
+/**
+*  @brief
+*    Collects the scene nodes having a mesh or a physics body
+*/
+void CellResidencyManager::CollectSceneNodes(SceneContainer &cContainer, Cell &cCell)
+{
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			// Has the scene node a mesh or a physics body?
+			bool bCollect = (pSceneNode->GetAttribute("Mesh") != nullptr);
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers() && !bCollect; j++)
+				bCollect = pSceneNode->GetModifier("", j)->IsInstanceOf("PLPhysics::SNMPhysicsBody");
+			if (bCollect) {
+				SceneNodeHandler *pSceneNodeHandler = new SceneNodeHandler();
+				pSceneNodeHandler->SetElement(pSceneNode);
+				cCell.lstSceneNodes.Add(pSceneNodeHandler);
+			}
+
+			// Collect the scene nodes within containers inside the cell as well (but not within other cells)
+			if (pSceneNode->IsContainer() && !pSceneNode->IsInstanceOf("PLScene::SCCell"))
+				CollectSceneNodes(static_cast<SceneContainer&>(*pSceneNode), cCell);
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the currently used GPU memory
+*/
+uint64 CellResidencyManager::GetUsedMemory() const
+{
+	if (m_pRenderer) {
+		const Statistics &sStatistics = m_pRenderer->GetStatistics();
+		return static_cast<uint64>(sStatistics.nTextureBuffersMem) + sStatistics.nVertexBufferMem + sStatistics.nIndexBufferMem;
+	}
+	return 0;
+}
+
+/**
+*  @brief
+*    Makes a cell resident
+*/
+void CellResidencyManager::MakeResident(uint32 nCell)
+{
+	Cell &cCell = *m_lstCells[nCell];
+
+	// Restore the meshes and activate the physics bodies
+	for (uint32 i=0; i<cCell.lstSceneNodes.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cCell.lstSceneNodes[i]->GetElement();
+		if (pSceneNode) {
+			DynVar *pMesh = pSceneNode->GetAttribute("Mesh");
+			if (pMesh && i < cCell.lstMeshes.GetNumOfElements() && cCell.lstMeshes[i].GetLength())
+				pMesh->SetString(cCell.lstMeshes[i]);
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+				SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", j);
+				if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody"))
+					pSceneNodeModifier->SetActive(true);
+			}
+		}
+	}
+	cCell.lstMeshes.Clear();
+
+	// Activate the cell container
+	SceneNode *pCellSceneNode = cCell.cCell.GetElement();
+	if (pCellSceneNode)
+		pCellSceneNode->SetActive(true);
+
+	// Done
+	cCell.bResident = true;
+}
+
+/**
+*  @brief
+*    Evicts a cell
+*/
+void CellResidencyManager::Evict(uint32 nCell)
+{
+	Cell &cCell = *m_lstCells[nCell];
+
+	// The freed memory would falsify a pending footprint measurement
+	m_nMeasuredCell = CellGraph::InvalidCell;
+
+	// Deactivate the cell container
+	SceneNode *pCellSceneNode = cCell.cCell.GetElement();
+	if (pCellSceneNode)
+		pCellSceneNode->SetActive(false);
+
+	// Release the meshes and deactivate the physics bodies
+	cCell.lstMeshes.Resize(cCell.lstSceneNodes.GetNumOfElements());
+	for (uint32 i=0; i<cCell.lstSceneNodes.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cCell.lstSceneNodes[i]->GetElement();
+		if (pSceneNode) {
+			DynVar *pMesh = pSceneNode->GetAttribute("Mesh");
+			if (pMesh) {
+				cCell.lstMeshes[i] = pMesh->GetString();
+				pMesh->SetString("");
+			}
+			for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+				SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", j);
+				if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody"))
+					pSceneNodeModifier->SetActive(false);
+			}
+		}
+	}
+
+	// Done
+	cCell.bResident = false;
+}
@@ -0,0 +1,266 @@
+/*********************************************************\
+ *  File: CellResidencyManager.h                         *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_CELLRESIDENCYMANAGER_H__
+#define __DUNGEON_CELLRESIDENCYMANAGER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Scene/CellGraph.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLRenderer {
+	class Renderer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Cell residency manager streaming the content of cells in and out
+*
+*  @remarks
+*    The residency manager tracks the portal distance of each cell to the cell the camera is in. Cells which are
+*    further away than the configured number of hops are evicted: Their container is deactivated, the meshes of
+*    their mesh scene nodes are released (so the resource managers can destroy the meshes and - through the
+*    materials - the textures) and their physics bodies are deactivated. As soon as the camera comes closer, the
+*    cell is made resident again - one hop closer than the eviction distance, so a camera moving back and forth
+*    across a portal doesn't stream a cell in and out each time.
+*
+*    Additionally, the GPU memory used by textures, vertex and index buffers is kept under a memory budget: If the
+*    renderer statistics report more memory than the budget, the most distant resident cell is evicted and held
+*    back for a while. The footprint of a cell is measured when it's made resident: The renderer statistics need
+*    a few updates to catch up, so just one optional cell is made resident at a time and the memory it added after
+*    those updates is remembered as its footprint. A cell is only made resident again if its known footprint fits
+*    into the budget. The cell the camera is in and its direct neighbours are always resident.
+*/
+class CellResidencyManager {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 SettleUpdates  = 10;	/**< Number of updates the renderer statistics are given to catch up before the footprint of a cell is measured */
+		static const PLCore::uint32 ReadmitUpdates = 120;	/**< Number of updates a cell evicted to meet the budget is held back before it can be made resident again */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] pRenderer
+		*    Renderer to query the memory statistics from, can be a null pointer (no memory budget in this case)
+		*  @param[in] nMaxHops
+		*    Maximum portal distance of a resident cell to the cell the camera is in
+		*  @param[in] nBudget
+		*    GPU memory budget (in bytes), 0 for no budget
+		*/
+		CellResidencyManager(PLRenderer::Renderer *pRenderer, PLCore::uint32 nMaxHops, PLCore::uint64 nBudget);
+
+		/**
+		*  @brief
+		*    Destructor
+		*
+		*  @note
+		*    - All evicted cells are made resident again
+		*/
+		~CellResidencyManager();
+
+		/**
+		*  @brief
+		*    Initializes the residency manager
+		*
+		*  @param[in] cContainer
+		*    Scene container the cells are in (e.g. the physics world container of the dungeon)
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (no cells found)
+		*/
+		bool Init(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Updates the residency of the cells
+		*
+		*  @param[in] pCamera
+		*    Current camera scene node, can be a null pointer (nothing is changed in this case)
+		*/
+		void Update(PLScene::SceneNode *pCamera);
+
+		/**
+		*  @brief
+		*    Returns the cell graph
+		*
+		*  @return
+		*    The cell graph
+		*/
+		const CellGraph &GetCellGraph() const;
+
+		/**
+		*  @brief
+		*    Returns whether or not a cell is resident
+		*
+		*  @param[in] nCell
+		*    Cell index
+		*
+		*  @return
+		*    'true' if the cell is resident, else 'false'
+		*/
+		bool IsResident(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns the number of resident cells
+		*
+		*  @return
+		*    The number of resident cells
+		*/
+		PLCore::uint32 GetNumOfResidentCells() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Residency information of a cell
+		*/
+		struct Cell {
+			PLScene::SceneNodeHandler					cCell;			/**< Cell container */
+			bool										bResident;		/**< Is the cell currently resident? */
+			PLCore::uint64								nFootprint;		/**< GPU memory the cell added the last time it was made resident (in bytes), 0 if unknown */
+			PLCore::uint32								nHoldUpdate;	/**< Update before which the cell isn't made resident again (after it was evicted to meet the budget) */
+			PLCore::Array<PLScene::SceneNodeHandler*>	lstSceneNodes;	/**< Scene nodes within the cell having a mesh or a physics body */
+			PLCore::Array<PLCore::String>				lstMeshes;		/**< Mesh filenames of the scene nodes, set while the cell is evicted */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		CellResidencyManager(const CellResidencyManager &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		CellResidencyManager &operator =(const CellResidencyManager &cSource);
+
+		/**
+		*  @brief
+		*    Destroys the residency information of all cells, evicted cells are made resident again
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Collects the scene nodes having a mesh or a physics body
+		*
+		*  @param[in]  cContainer
+		*    Container to collect the scene nodes from
+		*  @param[out] cCell
+		*    Receives the scene nodes
+		*/
+		void CollectSceneNodes(PLScene::SceneContainer &cContainer, Cell &cCell);
+
+		/**
+		*  @brief
+		*    Returns the currently used GPU memory
+		*
+		*  @return
+		*    The currently used GPU memory used by textures, vertex and index buffers (in bytes), 0 if there's no renderer
+		*/
+		PLCore::uint64 GetUsedMemory() const;
+
+		/**
+		*  @brief
+		*    Makes a cell resident
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*/
+		void MakeResident(PLCore::uint32 nCell);
+
+		/**
+		*  @brief
+		*    Evicts a cell
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @note
+		*    - A pending footprint measurement is dropped, the freed memory would falsify it
+		*/
+		void Evict(PLCore::uint32 nCell);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLRenderer::Renderer		  *m_pRenderer;		/**< Renderer to query the memory statistics from, can be a null pointer */
+		PLCore::uint32				   m_nMaxHops;		/**< Maximum portal distance of a resident cell */
+		PLCore::uint64				   m_nBudget;		/**< GPU memory budget (in bytes), 0 for no budget */
+		CellGraph					   m_cCellGraph;	/**< Cell graph */
+		PLCore::Array<Cell*>		   m_lstCells;		/**< Residency information per cell */
+		PLCore::uint32				   m_nCameraCell;	/**< Index of the cell the camera was in during the last update */
+		PLCore::Array<PLCore::uint32>  m_lstDistances;	/**< Portal distances to the cell the camera is in */
+		PLCore::uint32				   m_nUpdate;		/**< Current update */
+		PLCore::uint32				   m_nMeasuredCell;	/**< Index of the cell which footprint is measured, "CellGraph::InvalidCell" if none */
+		PLCore::uint64				   m_nMeasureMemory;	/**< Used GPU memory before the measured cell was made resident (in bytes) */
+		PLCore::uint32				   m_nMeasureUpdate;	/**< Update the measured cell was made resident within */
+
+
+};
+
+
+#endif // __DUNGEON_CELLRESIDENCYMANAGER_H__
@@ -0,0 +1,409 @@
+/*********************************************************\
+ *  File: InstanceBatcher.cpp                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/Container/HashMap.h>
+#include <PLRenderer/Material/Material.h>
+#include <PLMesh/Mesh.h>
+#include <PLMesh/MeshHandler.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Tools/Trace.h"
+#include "Scene/LooseOctree.h"
+#include "Scene/PortalCuller.h"
+#include "Scene/RenderQueue.h"
+#include "Scene/InstanceBatcher.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLRenderer;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the transform of a scene node relative to one of its parent scene containers
+*/
+static Matrix3x4 GetRelativeTransform(SceneNode &cSceneNode, const SceneNode *pContainer)
+{
+	Matrix3x4 mTransform = cSceneNode.GetTransform().GetMatrix();
+	for (SceneContainer *pParent=cSceneNode.GetContainer(); pParent && pParent!=pContainer; pParent=pParent->GetContainer())
+		mTransform = pParent->GetTransform().GetMatrix()*mTransform;
+	return mTransform;
+}
+
+/**
+*  @brief
+*    Returns the mesh handler of a scene node, null pointer if it's no mesh scene node or has no mesh
+*/
+static MeshHandler *GetSceneNodeMeshHandler(SceneNode &cSceneNode)
+{
+	if (cSceneNode.IsInstanceOf("PLScene::SNMesh")) {
+		MeshHandler *pMeshHandler = static_cast<SNMesh&>(cSceneNode).GetMeshHandler();
+		if (pMeshHandler && pMeshHandler->GetResource())
+			return pMeshHandler;
+	}
+	return nullptr;
+}
+
+/**
+*  @brief
+*    Returns whether or not a scene node is animated, which means it has any other modifier than a physics body
+*/
+static bool IsAnimated(SceneNode &cSceneNode)
+{
+	for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+		if (!cSceneNode.GetModifier("", i)->IsInstanceOf("PLPhysics::SNMPhysicsBody"))
+			return true;
+	}
+	return false;
+}
+
+/**
+*  @brief
+*    Returns whether or not a scene node has a physics body with mass, which means it can be moved by the physics
+*/
+static bool HasBodyWithMass(SceneNode &cSceneNode)
+{
+	for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+		const SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+		if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody")) {
+			const DynVar *pMass = pSceneNodeModifier->GetAttribute("Mass");
+			if (pMass && pMass->GetFloat() > 0.0f)
+				return true;
+		}
+	}
+	return false;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+InstanceBatcher::InstanceBatcher() :
+	m_pPortalCuller(nullptr),
+	m_nStamp(0),
+	m_nNumOfVisibleBatches(0),
+	m_nNumOfVisibleInstances(0),
+	m_nNumOfBatchedSubmissions(0),
+	m_nNumOfSaveableSubmissions(0),
+	m_nNumOfMovedInstances(0),
+	m_nNumOfRebuiltBatches(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+InstanceBatcher::~InstanceBatcher()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Builds the batches of the mesh scene nodes within the cells of a portal culler
+*/
+uint32 InstanceBatcher::Build(const PortalCuller &cPortalCuller, uint32 nMinInstances)
+{
+	TraceScope cTraceScope("InstanceBatcher::Build", "Scene");
+
+	// Remove the previous batches
+	Clear();
+	m_pPortalCuller = &cPortalCuller;
+
+	// Group the mesh scene nodes which are not animated by the names of their mesh and materials
+	HashMap<String, uint32> mapGroups;	// Group index plus one by mesh and material names
+	Array<Array<uint32>*>	lstGroups;	// Cell and octree entry index pairs per group
+	for (uint32 nCell=0; nCell<cPortalCuller.GetNumOfCells(); nCell++) {
+		Array<uint32> *plstInstances = new Array<uint32>;
+		m_lstCells.Add(plstInstances);
+		SceneContainer	  *pCell   = cPortalCuller.GetCell(nCell);
+		const LooseOctree *pOctree = cPortalCuller.GetOctree(nCell);
+		const uint32 nNumOfEntries = (pCell && pOctree) ? pOctree->GetNumOfEntries() : 0;
+		plstInstances->Resize(nNumOfEntries, true, false);
+
+		// Scene nodes attached to another scene node by an anchor modifier move along with it
+		Array<SceneNode*> lstAttached;
+		for (uint32 nEntry=0; nEntry<nNumOfEntries; nEntry++) {
+			SceneNode *pSceneNode = pOctree->GetSceneNode(nEntry);
+			for (uint32 i=0; pSceneNode && i<pSceneNode->GetNumOfModifiers(); i++) {
+				const SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", i);
+				if (pSceneNodeModifier->IsInstanceOf("PLScene::SNMAnchor")) {
+					const DynVar *pAttachedNode = pSceneNodeModifier->GetAttribute("AttachedNode");
+					SceneNode *pAttachedSceneNode = pAttachedNode ? pCell->GetByName(pAttachedNode->GetString()) : nullptr;
+					if (pAttachedSceneNode)
+						lstAttached.Add(pAttachedSceneNode);
+				}
+			}
+		}
+
+		// Add the scene nodes to the groups
+		for (uint32 nEntry=0; nEntry<nNumOfEntries; nEntry++) {
+			(*plstInstances)[nEntry] = NoInstance;
+			SceneNode *pSceneNode = pOctree->GetSceneNode(nEntry);
+			MeshHandler *pMeshHandler = pSceneNode ? GetSceneNodeMeshHandler(*pSceneNode) : nullptr;
+			if (pMeshHandler && !IsAnimated(*pSceneNode) && !lstAttached.IsElement(pSceneNode)) {
+				String sKey = pMeshHandler->GetResource()->GetName();
+				for (uint32 i=0; i<pMeshHandler->GetNumOfMaterials(); i++) {
+					const Material *pMaterial = pMeshHandler->GetMaterial(i);
+					sKey += "|";
+					if (pMaterial)
+						sKey += pMaterial->GetName();
+				}
+				uint32 nGroup = mapGroups.Get(sKey);
+				if (!nGroup) {
+					lstGroups.Add(new Array<uint32>);
+					nGroup = lstGroups.GetNumOfElements();
+					mapGroups.Add(sKey, nGroup);
+				}
+				lstGroups[nGroup - 1]->Add(nCell);
+				lstGroups[nGroup - 1]->Add(nEntry);
+			}
+		}
+	}
+
+	// The groups with enough instances become batches
+	if (nMinInstances < 2)
+		nMinInstances = 2;
+	for (uint32 nGroup=0; nGroup<lstGroups.GetNumOfElements(); nGroup++) {
+		const Array<uint32> &lstGroup = *lstGroups[nGroup];
+		if (lstGroup.GetNumOfElements()/2 >= nMinInstances) {
+			Batch *pBatch = new Batch;
+			pBatch->nNumOfMaterials = 0;
+			pBatch->nStamp			= 0;
+			pBatch->nRebuildStamp	= 0;
+			for (uint32 i=0; i<lstGroup.GetNumOfElements(); i+=2) {
+				SceneNode &cSceneNode = *cPortalCuller.GetOctree(lstGroup[i])->GetSceneNode(lstGroup[i + 1]);
+				if (!i) {
+					const MeshHandler *pMeshHandler = GetSceneNodeMeshHandler(cSceneNode);
+					pBatch->sMeshName		= pMeshHandler->GetResource()->GetName();
+					pBatch->nNumOfMaterials = pMeshHandler->GetNumOfMaterials();
+				}
+
+				// Add the instance and write its transform
+				Instance &sInstance = m_lstInstances.Add();
+				sInstance.nBatch = m_lstBatches.GetNumOfElements();
+				sInstance.nIndex = pBatch->lstTransforms.GetNumOfElements();
+				sInstance.nCell	 = lstGroup[i];
+				sInstance.nEntry = lstGroup[i + 1];
+				sInstance.nStamp = 0;
+				(*m_lstCells[sInstance.nCell])[sInstance.nEntry] = m_lstInstances.GetNumOfElements() - 1;
+				pBatch->lstTransforms.Add(GetRelativeTransform(cSceneNode, nullptr));
+				if (HasBodyWithMass(cSceneNode))
+					m_lstMovableInstances.Add(m_lstInstances.GetNumOfElements() - 1);
+			}
+			m_lstBatches.Add(pBatch);
+		}
+		delete lstGroups[nGroup];
+	}
+
+	// Done
+	return m_lstBatches.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Removes the batches
+*/
+void InstanceBatcher::Clear()
+{
+	for (uint32 i=0; i<m_lstBatches.GetNumOfElements(); i++)
+		delete m_lstBatches[i];
+	m_lstBatches.Clear();
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+	m_lstInstances.Clear();
+	m_lstMovableInstances.Clear();
+	m_pPortalCuller			 = nullptr;
+	m_nNumOfVisibleBatches		= 0;
+	m_nNumOfVisibleInstances	= 0;
+	m_nNumOfBatchedSubmissions	= 0;
+	m_nNumOfSaveableSubmissions = 0;
+	m_nNumOfMovedInstances		= 0;
+	m_nNumOfRebuiltBatches		= 0;
+}
+
+/**
+*  @brief
+*    Updates the moved instances and gathers the visible instances of the batches
+*/
+void InstanceBatcher::Update(const RenderQueue &cRenderQueue)
+{
+	// Reset the results of the previous update
+	m_nStamp++;
+	m_nNumOfVisibleBatches		= 0;
+	m_nNumOfVisibleInstances	= 0;
+	m_nNumOfBatchedSubmissions	= 0;
+	m_nNumOfSaveableSubmissions = 0;
+	m_nNumOfMovedInstances		= 0;
+	m_nNumOfRebuiltBatches		= 0;
+	if (!m_pPortalCuller)
+		return;
+
+	// Rewrite the transforms of the moved instances, the other instances can't move
+	for (uint32 i=0; i<m_lstMovableInstances.GetNumOfElements(); i++) {
+		const Instance &sInstance = m_lstInstances[m_lstMovableInstances[i]];
+		SceneNode *pSceneNode = m_pPortalCuller->GetOctree(sInstance.nCell)->GetSceneNode(sInstance.nEntry);
+		if (pSceneNode) {
+			Batch &cBatch = *m_lstBatches[sInstance.nBatch];
+			const Matrix3x4 mTransform = GetRelativeTransform(*pSceneNode, nullptr);
+			if (mTransform != cBatch.lstTransforms[sInstance.nIndex]) {
+				cBatch.lstTransforms[sInstance.nIndex] = mTransform;
+				m_nNumOfMovedInstances++;
+				if (cBatch.nRebuildStamp != m_nStamp) {
+					cBatch.nRebuildStamp = m_nStamp;
+					m_nNumOfRebuiltBatches++;
+				}
+			}
+		}
+	}
+
+	// Gather the visible instances in draw order, each batch with visible instances is one submission per material
+	for (uint32 i=0; i<m_lstBatches.GetNumOfElements(); i++)
+		m_lstBatches[i]->lstVisible.Reset();
+	for (uint32 i=0; i<cRenderQueue.GetNumOfItems(); i++) {
+		const uint32 nInstance = (*m_lstCells[cRenderQueue.GetCell(i)])[cRenderQueue.GetEntry(i)];
+		if (nInstance == NoInstance) {
+			m_nNumOfBatchedSubmissions++;
+		} else {
+			Instance &sInstance = m_lstInstances[nInstance];
+			Batch &cBatch = *m_lstBatches[sInstance.nBatch];
+			if (cBatch.nStamp != m_nStamp) {
+				cBatch.nStamp = m_nStamp;
+				m_nNumOfVisibleBatches++;
+				m_nNumOfBatchedSubmissions += cBatch.nNumOfMaterials;
+			}
+			if (sInstance.nStamp != m_nStamp) {
+				sInstance.nStamp = m_nStamp;
+				cBatch.lstVisible.Add(sInstance.nIndex);
+				m_nNumOfVisibleInstances++;
+			}
+		}
+	}
+	m_nNumOfSaveableSubmissions = cRenderQueue.GetNumOfItems() - m_nNumOfBatchedSubmissions;
+}
+
+/**
+*  @brief
+*    Returns the number of batches
+*/
+uint32 InstanceBatcher::GetNumOfBatches() const
+{
+	return m_lstBatches.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the number of instances
+*/
+uint32 InstanceBatcher::GetNumOfInstances() const
+{
+	return m_lstInstances.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the mesh name of a batch
+*/
+const String &InstanceBatcher::GetMeshName(uint32 nBatch) const
+{
+	return m_lstBatches[nBatch]->sMeshName;
+}
+
+/**
+*  @brief
+*    Returns the instance transforms of a batch
+*/
+const Array<Matrix3x4> &InstanceBatcher::GetTransforms(uint32 nBatch) const
+{
+	return m_lstBatches[nBatch]->lstTransforms;
+}
+
+/**
+*  @brief
+*    Returns the visible instances of a batch
+*/
+const Array<uint32> &InstanceBatcher::GetVisibleInstances(uint32 nBatch) const
+{
+	return m_lstBatches[nBatch]->lstVisible;
+}
+
+/**
+*  @brief
+*    Returns the counters of the last update as string
+*/
+String InstanceBatcher::ToString() const
+{
+	return String::Format("Batches=\"%u\" Instances=\"%u\" VisibleBatches=\"%u\" VisibleInstances=\"%u\" BatchedSubmissions=\"%u\" SaveableSubmissions=\"%u\" MovedInstances=\"%u\" RebuiltBatches=\"%u\"",
+						  m_lstBatches.GetNumOfElements(), m_lstInstances.GetNumOfElements(), m_nNumOfVisibleBatches, m_nNumOfVisibleInstances,
+						  m_nNumOfBatchedSubmissions, m_nNumOfSaveableSubmissions, m_nNumOfMovedInstances, m_nNumOfRebuiltBatches);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+InstanceBatcher::InstanceBatcher(const InstanceBatcher &cSource) :
+	m_pPortalCuller(nullptr),
+	m_nStamp(0),
+	m_nNumOfVisibleBatches(0),
+	m_nNumOfVisibleInstances(0),
+	m_nNumOfBatchedSubmissions(0),
+	m_nNumOfSaveableSubmissions(0),
+	m_nNumOfMovedInstances(0),
+	m_nNumOfRebuiltBatches(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+InstanceBatcher &InstanceBatcher::operator =(const InstanceBatcher &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
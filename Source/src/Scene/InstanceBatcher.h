@@ -0,0 +1,259 @@
+/*********************************************************\
+ *  File: InstanceBatcher.h                              *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_INSTANCEBATCHER_H__
+#define __DUNGEON_INSTANCEBATCHER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLMath/Matrix3x4.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+class PortalCuller;
+class RenderQueue;
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Instance batches of the mesh scene nodes sharing a mesh and its materials
+*
+*  @remarks
+*    When built, the mesh scene nodes which are not animated (no other modifiers than a physics body) are grouped by
+*    their mesh and materials, each group with at least a minimum number of instances becomes a batch. A batch keeps a
+*    packed buffer of the world space transforms of its instances, written when the batch is built. The instances
+*    with a physics body with mass are the only ones which can move, just they are compared with their transforms
+*    each update, a moved instance rewrites its transform within the buffer of its batch.
+*
+*    Once per frame, the sorted render queue is walked: The visible instances of each batch are gathered in draw
+*    order, each batch with visible instances counts as one draw submission per material instead of one per material
+*    of each instance. It's a measurement tool just like the render queue: There's no instanced draw path, the scene
+*    renderer of the engine still submits each mesh scene node by itself, so the batching is disabled by default (see
+*    "DungeonConfig::InstanceBatching") and the submission counters only tell how much an instanced draw path would save.
+*/
+class InstanceBatcher {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 NoInstance = 0xFFFFFFFF;	/**< Instance index of octree entries which are not batched */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		InstanceBatcher();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~InstanceBatcher();
+
+		/**
+		*  @brief
+		*    Builds the batches of the mesh scene nodes within the cells of a portal culler
+		*
+		*  @param[in] cPortalCuller
+		*    Portal culler providing the cells, must stay valid as long as this batcher is used
+		*  @param[in] nMinInstances
+		*    Minimum number of instances of a batch (at least 2), smaller groups are not batched
+		*
+		*  @return
+		*    The number of batches
+		*/
+		PLCore::uint32 Build(const PortalCuller &cPortalCuller, PLCore::uint32 nMinInstances);
+
+		/**
+		*  @brief
+		*    Removes the batches
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Updates the moved instances and gathers the visible instances of the batches
+		*
+		*  @param[in] cRenderQueue
+		*    Render queue built from the same portal culler, must have been updated right before
+		*/
+		void Update(const RenderQueue &cRenderQueue);
+
+		/**
+		*  @brief
+		*    Returns the number of batches
+		*
+		*  @return
+		*    The number of batches
+		*/
+		PLCore::uint32 GetNumOfBatches() const;
+
+		/**
+		*  @brief
+		*    Returns the number of instances
+		*
+		*  @return
+		*    The number of instances of all batches
+		*/
+		PLCore::uint32 GetNumOfInstances() const;
+
+		/**
+		*  @brief
+		*    Returns the mesh name of a batch
+		*
+		*  @param[in] nBatch
+		*    Index of the batch, must be valid
+		*
+		*  @return
+		*    The name of the mesh all instances of the batch share
+		*/
+		const PLCore::String &GetMeshName(PLCore::uint32 nBatch) const;
+
+		/**
+		*  @brief
+		*    Returns the instance transforms of a batch
+		*
+		*  @param[in] nBatch
+		*    Index of the batch, must be valid
+		*
+		*  @return
+		*    The packed world space transforms of all instances of the batch
+		*/
+		const PLCore::Array<PLMath::Matrix3x4> &GetTransforms(PLCore::uint32 nBatch) const;
+
+		/**
+		*  @brief
+		*    Returns the visible instances of a batch
+		*
+		*  @param[in] nBatch
+		*    Index of the batch, must be valid
+		*
+		*  @return
+		*    Indices of the visible instances within the transforms of the batch, in draw order of the last update
+		*/
+		const PLCore::Array<PLCore::uint32> &GetVisibleInstances(PLCore::uint32 nBatch) const;
+
+		/**
+		*  @brief
+		*    Returns the counters of the last update as string
+		*
+		*  @return
+		*    The counters as string (e.g. "Batches=\"24\" Instances=\"412\" VisibleBatches=\"9\" VisibleInstances=\"130\" BatchedSubmissions=\"190\" SaveableSubmissions=\"121\" MovedInstances=\"0\" RebuiltBatches=\"0\"")
+		*/
+		PLCore::String ToString() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Batch
+		*/
+		struct Batch {
+			PLCore::String					 sMeshName;			/**< Name of the shared mesh */
+			PLCore::uint32					 nNumOfMaterials;	/**< Number of materials of the shared mesh, one draw submission each */
+			PLCore::Array<PLMath::Matrix3x4> lstTransforms;		/**< Packed world space transforms of the instances */
+			PLCore::Array<PLCore::uint32>	 lstVisible;		/**< Indices of the visible instances of the last update */
+			PLCore::uint32					 nStamp;			/**< Update the batch was found visible the last time */
+			PLCore::uint32					 nRebuildStamp;		/**< Update the transforms of the batch were rewritten the last time */
+		};
+
+		/**
+		*  @brief
+		*    Instance
+		*/
+		struct Instance {
+			PLCore::uint32 nBatch;		/**< Index of the batch */
+			PLCore::uint32 nIndex;		/**< Index of the instance within its batch */
+			PLCore::uint32 nCell;		/**< Index of the cell */
+			PLCore::uint32 nEntry;		/**< Index of the octree entry within the cell */
+			PLCore::uint32 nStamp;		/**< Update the instance was found visible the last time */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		InstanceBatcher(const InstanceBatcher &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		InstanceBatcher &operator =(const InstanceBatcher &cSource);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		const PortalCuller							 *m_pPortalCuller;			/**< Portal culler providing the cells, null pointer if not built */
+		PLCore::Array<Batch*>						  m_lstBatches;				/**< Batches */
+		PLCore::Array<Instance>						  m_lstInstances;			/**< Instances of all batches */
+		PLCore::Array<PLCore::Array<PLCore::uint32>*> m_lstCells;				/**< Instance index per octree entry of each cell, same order as within the portal culler */
+		PLCore::Array<PLCore::uint32>				  m_lstMovableInstances;	/**< Instances which can move */
+		PLCore::uint32								  m_nStamp;					/**< Current update */
+		PLCore::uint32								  m_nNumOfVisibleBatches;	/**< Number of batches with visible instances within the last update */
+		PLCore::uint32								  m_nNumOfVisibleInstances;	/**< Number of visible instances within the last update */
+		PLCore::uint32								  m_nNumOfBatchedSubmissions;	/**< Number of draw submissions of the last update if the batches were drawn instanced */
+		PLCore::uint32								  m_nNumOfSaveableSubmissions;	/**< Number of draw submissions an instanced draw path would have saved within the last update */
+		PLCore::uint32								  m_nNumOfMovedInstances;	/**< Number of instances which moved within the last update */
+		PLCore::uint32								  m_nNumOfRebuiltBatches;	/**< Number of batches which transforms were rewritten within the last update */
+
+
+};
+
+
+#endif // __DUNGEON_INSTANCEBATCHER_H__
@@ -0,0 +1,479 @@
+/*********************************************************\
+ *  File: LooseOctree.cpp                                *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLMath/Math.h>
+#include <PLMath/Plane.h>
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Scene/LooseOctree.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 TraversalStackSize = LooseOctree::MaxDepth*7 + 1;	/**< Size of the traversal stack, each level pushes up to 8 children while popping one */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns half of the largest edge length of a box
+*/
+static float GetHalfExtent(const Vector3 &vMin, const Vector3 &vMax)
+{
+	return Math::Max(Math::Max(vMax.x - vMin.x, vMax.y - vMin.y), vMax.z - vMin.z)*0.5f;
+}
+
+/**
+*  @brief
+*    Returns whether or not two boxes overlap
+*/
+static bool OverlapBox(const Vector3 &vMin1, const Vector3 &vMax1, const Vector3 &vMin2, const Vector3 &vMax2)
+{
+	return (vMin1.x <= vMax2.x && vMax1.x >= vMin2.x &&
+			vMin1.y <= vMax2.y && vMax1.y >= vMin2.y &&
+			vMin1.z <= vMax2.z && vMax1.z >= vMin2.z);
+}
+
+/**
+*  @brief
+*    Returns whether or not a box is completely inside of a cube
+*/
+static bool IsInsideCube(const Vector3 &vMin, const Vector3 &vMax, const Vector3 &vCenter, float fHalfSize)
+{
+	return (vMin.x >= vCenter.x - fHalfSize && vMax.x <= vCenter.x + fHalfSize &&
+			vMin.y >= vCenter.y - fHalfSize && vMax.y <= vCenter.y + fHalfSize &&
+			vMin.z >= vCenter.z - fHalfSize && vMax.z <= vCenter.z + fHalfSize);
+}
+
+/**
+*  @brief
+*    Intersects a ray with a box by using the slab test
+*/
+static bool IntersectBox(const Vector3 &vMin, const Vector3 &vMax, const Vector3 &vOrigin, const Vector3 &vInverseDirection, float fMaxDistance)
+{
+	const float fX1 = (vMin.x - vOrigin.x)*vInverseDirection.x;
+	const float fX2 = (vMax.x - vOrigin.x)*vInverseDirection.x;
+	const float fY1 = (vMin.y - vOrigin.y)*vInverseDirection.y;
+	const float fY2 = (vMax.y - vOrigin.y)*vInverseDirection.y;
+	const float fZ1 = (vMin.z - vOrigin.z)*vInverseDirection.z;
+	const float fZ2 = (vMax.z - vOrigin.z)*vInverseDirection.z;
+	const float fNear = Math::Max(Math::Max(Math::Min(fX1, fX2), Math::Min(fY1, fY2)), Math::Min(fZ1, fZ2));
+	const float fFar  = Math::Min(Math::Min(Math::Max(fX1, fX2), Math::Max(fY1, fY2)), Math::Max(fZ1, fZ2));
+	const float fEntry = Math::Max(fNear, 0.0f);
+	return (fEntry <= fFar && fEntry <= fMaxDistance);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+LooseOctree::LooseOctree()
+{
+	Reset(Vector3::Zero, Vector3::Zero);
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+LooseOctree::~LooseOctree()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Removes all entries and sets the bounds of the root octant
+*/
+void LooseOctree::Reset(const Vector3 &vMin, const Vector3 &vMax)
+{
+	Clear();
+
+	// The root octant is the cube around the region, made a bit larger so that entries touching the border still fit
+	Octant &sRoot = m_lstOctants.Add();
+	sRoot.vCenter	  = (vMin + vMax)*0.5f;
+	sRoot.fHalfSize	  = Math::Max(GetHalfExtent(vMin, vMax)*1.01f, 0.01f);
+	sRoot.nDepth	  = 0;
+	for (uint32 i=0; i<8; i++)
+		sRoot.nChildren[i] = NoIndex;
+	sRoot.nFirstEntry = NoIndex;
+}
+
+/**
+*  @brief
+*    Removes all entries and octants
+*/
+void LooseOctree::Clear()
+{
+	for (uint32 i=0; i<m_lstEntries.GetNumOfElements(); i++)
+		delete m_lstEntries[i].pSceneNode;
+	m_lstEntries.Clear();
+	m_lstOctants.Clear();
+}
+
+/**
+*  @brief
+*    Adds an entry
+*/
+uint32 LooseOctree::Add(SceneNode &cSceneNode, const Vector3 &vMin, const Vector3 &vMax)
+{
+	const uint32 nEntry = m_lstEntries.GetNumOfElements();
+	Entry &sEntry = m_lstEntries.Add();
+	sEntry.pSceneNode = new SceneNodeHandler();
+	sEntry.pSceneNode->SetElement(&cSceneNode);
+	sEntry.vMin		  = vMin;
+	sEntry.vMax		  = vMax;
+	Link(nEntry, GetOctant(vMin, vMax));
+
+	// Done
+	return nEntry;
+}
+
+/**
+*  @brief
+*    Updates the bounding box of an entry
+*/
+bool LooseOctree::Update(uint32 nEntry, const Vector3 &vMin, const Vector3 &vMax)
+{
+	Entry &sEntry = m_lstEntries[nEntry];
+	sEntry.vMin = vMin;
+	sEntry.vMax = vMax;
+
+	// The entry stays where it is as long as it's within the loose bounds of its octant and doesn't fit into a child
+	const Octant &sOctant = m_lstOctants[sEntry.nOctant];
+	if (IsInsideCube(vMin, vMax, sOctant.vCenter, sOctant.fHalfSize*2.0f) &&
+		(sOctant.nDepth >= MaxDepth || GetHalfExtent(vMin, vMax) > sOctant.fHalfSize*0.5f))
+		return false;
+
+	// Move the entry into another octant
+	const uint32 nOctant = GetOctant(vMin, vMax);
+	if (nOctant == sEntry.nOctant)
+		return false;
+	Unlink(nEntry);
+	Link(nEntry, nOctant);
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the number of entries
+*/
+uint32 LooseOctree::GetNumOfEntries() const
+{
+	return m_lstEntries.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the number of octants
+*/
+uint32 LooseOctree::GetNumOfOctants() const
+{
+	return m_lstOctants.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the scene node of an entry
+*/
+SceneNode *LooseOctree::GetSceneNode(uint32 nEntry) const
+{
+	return m_lstEntries[nEntry].pSceneNode->GetElement();
+}
+
+/**
+*  @brief
+*    Returns the bounding box of an entry
+*/
+void LooseOctree::GetBoundingBox(uint32 nEntry, Vector3 &vMin, Vector3 &vMax) const
+{
+	vMin = m_lstEntries[nEntry].vMin;
+	vMax = m_lstEntries[nEntry].vMax;
+}
+
+/**
+*  @brief
+*    Returns the entries which bounding boxes overlap a box
+*/
+uint32 LooseOctree::QueryBox(const Vector3 &vMin, const Vector3 &vMax, Array<uint32> &lstEntries) const
+{
+	Query sQuery;
+	sQuery.vMin		   = vMin;
+	sQuery.vMax		   = vMax;
+	sQuery.pvCenter	   = nullptr;
+	sQuery.fRadius	   = 0.0f;
+	sQuery.pPlanes	   = nullptr;
+	sQuery.nNumOfPlanes = 0;
+	sQuery.pvOrigin	   = nullptr;
+	sQuery.fMaxDistance = 0.0f;
+	return Collect(sQuery, lstEntries);
+}
+
+/**
+*  @brief
+*    Returns the entries which bounding boxes overlap a sphere
+*/
+uint32 LooseOctree::QuerySphere(const Vector3 &vCenter, float fRadius, Array<uint32> &lstEntries) const
+{
+	Query sQuery;
+	sQuery.vMin		   = Vector3(vCenter.x - fRadius, vCenter.y - fRadius, vCenter.z - fRadius);
+	sQuery.vMax		   = Vector3(vCenter.x + fRadius, vCenter.y + fRadius, vCenter.z + fRadius);
+	sQuery.pvCenter	   = &vCenter;
+	sQuery.fRadius	   = fRadius;
+	sQuery.pPlanes	   = nullptr;
+	sQuery.nNumOfPlanes = 0;
+	sQuery.pvOrigin	   = nullptr;
+	sQuery.fMaxDistance = 0.0f;
+	return Collect(sQuery, lstEntries);
+}
+
+/**
+*  @brief
+*    Returns the entries which bounding boxes are not completely outside of a convex volume
+*/
+uint32 LooseOctree::QueryFrustum(const Plane *pPlanes, uint32 nNumOfPlanes, Array<uint32> &lstEntries) const
+{
+	Query sQuery;
+	sQuery.vMin		   = Vector3(-Math::MaxFloat, -Math::MaxFloat, -Math::MaxFloat);
+	sQuery.vMax		   = Vector3( Math::MaxFloat,  Math::MaxFloat,  Math::MaxFloat);
+	sQuery.pvCenter	   = nullptr;
+	sQuery.fRadius	   = 0.0f;
+	sQuery.pPlanes	   = pPlanes;
+	sQuery.nNumOfPlanes = nNumOfPlanes;
+	sQuery.pvOrigin	   = nullptr;
+	sQuery.fMaxDistance = 0.0f;
+	return Collect(sQuery, lstEntries);
+}
+
+/**
+*  @brief
+*    Returns the entries which bounding boxes are hit by a ray
+*/
+uint32 LooseOctree::QueryRay(const Vector3 &vOrigin, const Vector3 &vDirection, float fMaxDistance, Array<uint32> &lstEntries) const
+{
+	// The bounds of the ray segment reject most of the octants before the slab test is done
+	const Vector3 vEnd = vOrigin + vDirection*fMaxDistance;
+	Query sQuery;
+	sQuery.vMin				 = Vector3(Math::Min(vOrigin.x, vEnd.x), Math::Min(vOrigin.y, vEnd.y), Math::Min(vOrigin.z, vEnd.z));
+	sQuery.vMax				 = Vector3(Math::Max(vOrigin.x, vEnd.x), Math::Max(vOrigin.y, vEnd.y), Math::Max(vOrigin.z, vEnd.z));
+	sQuery.pvCenter			 = nullptr;
+	sQuery.fRadius			 = 0.0f;
+	sQuery.pPlanes			 = nullptr;
+	sQuery.nNumOfPlanes		 = 0;
+	sQuery.pvOrigin			 = &vOrigin;
+	sQuery.vInverseDirection = Vector3(vDirection.x ? 1.0f/vDirection.x : Math::MaxFloat,
+									   vDirection.y ? 1.0f/vDirection.y : Math::MaxFloat,
+									   vDirection.z ? 1.0f/vDirection.z : Math::MaxFloat);
+	sQuery.fMaxDistance		 = fMaxDistance;
+	return Collect(sQuery, lstEntries);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+LooseOctree::LooseOctree(const LooseOctree &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+LooseOctree &LooseOctree::operator =(const LooseOctree &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the octant an entry belongs into, creates the octant if required
+*/
+uint32 LooseOctree::GetOctant(const Vector3 &vMin, const Vector3 &vMax)
+{
+	const Vector3 vCenter	  = (vMin + vMax)*0.5f;
+	const float	  fHalfExtent = GetHalfExtent(vMin, vMax);
+
+	// Entries which center is outside of the root cell don't fit anywhere and stay at the root
+	if (!IsInsideCube(vCenter, vCenter, m_lstOctants[0].vCenter, m_lstOctants[0].fHalfSize))
+		return 0;
+
+	// Descend as long as the entry fits into the loose bounds of the child containing its center
+	uint32 nOctant = 0;
+	while (m_lstOctants[nOctant].nDepth < MaxDepth && fHalfExtent <= m_lstOctants[nOctant].fHalfSize*0.5f) {
+		const Octant sOctant = m_lstOctants[nOctant];
+		const uint32 nChild = ((vCenter.x >= sOctant.vCenter.x) ? 1 : 0) |
+							  ((vCenter.y >= sOctant.vCenter.y) ? 2 : 0) |
+							  ((vCenter.z >= sOctant.vCenter.z) ? 4 : 0);
+		if (sOctant.nChildren[nChild] == NoIndex) {
+			// Create the child, this may reallocate the octants so the parent was copied
+			const float fHalfSize = sOctant.fHalfSize*0.5f;
+			const uint32 nNewOctant = m_lstOctants.GetNumOfElements();
+			Octant &sChild = m_lstOctants.Add();
+			sChild.vCenter	   = Vector3(sOctant.vCenter.x + ((nChild & 1) ? fHalfSize : -fHalfSize),
+										 sOctant.vCenter.y + ((nChild & 2) ? fHalfSize : -fHalfSize),
+										 sOctant.vCenter.z + ((nChild & 4) ? fHalfSize : -fHalfSize));
+			sChild.fHalfSize   = fHalfSize;
+			sChild.nDepth	   = sOctant.nDepth + 1;
+			for (uint32 i=0; i<8; i++)
+				sChild.nChildren[i] = NoIndex;
+			sChild.nFirstEntry = NoIndex;
+			m_lstOctants[nOctant].nChildren[nChild] = nNewOctant;
+		}
+		nOctant = m_lstOctants[nOctant].nChildren[nChild];
+	}
+
+	// Done
+	return nOctant;
+}
+
+/**
+*  @brief
+*    Links an entry into an octant
+*/
+void LooseOctree::Link(uint32 nEntry, uint32 nOctant)
+{
+	Entry  &sEntry	= m_lstEntries[nEntry];
+	Octant &sOctant = m_lstOctants[nOctant];
+	sEntry.nOctant	  = nOctant;
+	sEntry.nPrevious  = NoIndex;
+	sEntry.nNext	  = sOctant.nFirstEntry;
+	if (sOctant.nFirstEntry != NoIndex)
+		m_lstEntries[sOctant.nFirstEntry].nPrevious = nEntry;
+	sOctant.nFirstEntry = nEntry;
+}
+
+/**
+*  @brief
+*    Unlinks an entry from its octant
+*/
+void LooseOctree::Unlink(uint32 nEntry)
+{
+	const Entry &sEntry = m_lstEntries[nEntry];
+	if (sEntry.nPrevious != NoIndex)
+		m_lstEntries[sEntry.nPrevious].nNext = sEntry.nNext;
+	else
+		m_lstOctants[sEntry.nOctant].nFirstEntry = sEntry.nNext;
+	if (sEntry.nNext != NoIndex)
+		m_lstEntries[sEntry.nNext].nPrevious = sEntry.nPrevious;
+}
+
+/**
+*  @brief
+*    Returns whether or not a box is touched by a query
+*/
+bool LooseOctree::IsTouched(const Query &sQuery, const Vector3 &vMin, const Vector3 &vMax) const
+{
+	// Bounds of the query
+	if (!OverlapBox(sQuery.vMin, sQuery.vMax, vMin, vMax))
+		return false;
+
+	// Sphere, the squared distance from the center to the closest point of the box
+	if (sQuery.pvCenter) {
+		const Vector3 &vCenter = *sQuery.pvCenter;
+		const float fX = vCenter.x - Math::Max(vMin.x, Math::Min(vCenter.x, vMax.x));
+		const float fY = vCenter.y - Math::Max(vMin.y, Math::Min(vCenter.y, vMax.y));
+		const float fZ = vCenter.z - Math::Max(vMin.z, Math::Min(vCenter.z, vMax.z));
+		if (fX*fX + fY*fY + fZ*fZ > sQuery.fRadius*sQuery.fRadius)
+			return false;
+	}
+
+	// Volume, the box is outside if the corner farthest along the plane normal is behind the plane
+	for (uint32 i=0; i<sQuery.nNumOfPlanes; i++) {
+		const Plane &cPlane = sQuery.pPlanes[i];
+		if (cPlane.a*((cPlane.a >= 0.0f) ? vMax.x : vMin.x) +
+			cPlane.b*((cPlane.b >= 0.0f) ? vMax.y : vMin.y) +
+			cPlane.c*((cPlane.c >= 0.0f) ? vMax.z : vMin.z) + cPlane.d < 0.0f)
+			return false;
+	}
+
+	// Ray
+	if (sQuery.pvOrigin && !IntersectBox(vMin, vMax, *sQuery.pvOrigin, sQuery.vInverseDirection, sQuery.fMaxDistance))
+		return false;
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Collects the entries touched by a query
+*/
+uint32 LooseOctree::Collect(const Query &sQuery, Array<uint32> &lstEntries) const
+{
+	// The root is always visited because it also holds the entries which don't fit into it
+	uint32 nNumOfTested = 0;
+	uint32 nStack[TraversalStackSize];
+	uint32 nStackSize = 0;
+	nStack[nStackSize++] = 0;
+	while (nStackSize) {
+		const Octant &sOctant = m_lstOctants[nStack[--nStackSize]];
+
+		// Test the entries of the octant
+		for (uint32 nEntry=sOctant.nFirstEntry; nEntry!=NoIndex; nEntry=m_lstEntries[nEntry].nNext) {
+			const Entry &sEntry = m_lstEntries[nEntry];
+			nNumOfTested++;
+			if (IsTouched(sQuery, sEntry.vMin, sEntry.vMax))
+				lstEntries.Add(nEntry);
+		}
+
+		// Visit the children which loose bounds are touched
+		for (uint32 i=0; i<8; i++) {
+			if (sOctant.nChildren[i] != NoIndex) {
+				const Octant &sChild = m_lstOctants[sOctant.nChildren[i]];
+				const float fLooseHalfSize = sChild.fHalfSize*2.0f;
+				const Vector3 vLooseMin(sChild.vCenter.x - fLooseHalfSize, sChild.vCenter.y - fLooseHalfSize, sChild.vCenter.z - fLooseHalfSize);
+				const Vector3 vLooseMax(sChild.vCenter.x + fLooseHalfSize, sChild.vCenter.y + fLooseHalfSize, sChild.vCenter.z + fLooseHalfSize);
+				if (IsTouched(sQuery, vLooseMin, vLooseMax))
+					nStack[nStackSize++] = sOctant.nChildren[i];
+			}
+		}
+	}
+
+	// Done
+	return nNumOfTested;
+}
@@ -0,0 +1,399 @@
+/*********************************************************\
+ *  File: LooseOctree.h                                  *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_LOOSEOCTREE_H__
+#define __DUNGEON_LOOSEOCTREE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Container/Array.h>
+#include <PLMath/Vector3.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Plane;
+}
+namespace PLScene {
+	class SceneNode;
+	class SceneNodeHandler;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Loose octree of scene node bounding boxes
+*
+*  @remarks
+*    Each octant has loose bounds twice the size of its cell, so an entry is stored within the deepest octant which
+*    cell contains the center of the entry and which loose bounds contain the whole entry - an entry is stored exactly
+*    once and only its own size decides the depth, no matter where it is. Moving an entry within the loose bounds of
+*    its octant is just a bounding box update, else it's moved into another octant. Entries which don't fit into the
+*    root octant stay at the root. The octants are created on demand.
+*/
+class LooseOctree {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 MaxDepth = 8;	/**< Maximum depth of the octants, the root is at depth 0 */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		LooseOctree();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~LooseOctree();
+
+		/**
+		*  @brief
+		*    Removes all entries and sets the bounds of the root octant
+		*
+		*  @param[in] vMin
+		*    Minimum corner of the region the entries are expected in
+		*  @param[in] vMax
+		*    Maximum corner of the region the entries are expected in
+		*/
+		void Reset(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax);
+
+		/**
+		*  @brief
+		*    Removes all entries and octants
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Adds an entry
+		*
+		*  @param[in] cSceneNode
+		*    Scene node of the entry
+		*  @param[in] vMin
+		*    Minimum corner of the bounding box of the entry
+		*  @param[in] vMax
+		*    Maximum corner of the bounding box of the entry
+		*
+		*  @return
+		*    Index of the entry
+		*/
+		PLCore::uint32 Add(PLScene::SceneNode &cSceneNode, const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax);
+
+		/**
+		*  @brief
+		*    Updates the bounding box of an entry
+		*
+		*  @param[in] nEntry
+		*    Index of the entry, must be valid
+		*  @param[in] vMin
+		*    New minimum corner of the bounding box of the entry
+		*  @param[in] vMax
+		*    New maximum corner of the bounding box of the entry
+		*
+		*  @return
+		*    'true' if the entry was moved into another octant, else 'false'
+		*/
+		bool Update(PLCore::uint32 nEntry, const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax);
+
+		/**
+		*  @brief
+		*    Returns the number of entries
+		*
+		*  @return
+		*    The number of entries
+		*/
+		PLCore::uint32 GetNumOfEntries() const;
+
+		/**
+		*  @brief
+		*    Returns the number of octants
+		*
+		*  @return
+		*    The number of octants
+		*/
+		PLCore::uint32 GetNumOfOctants() const;
+
+		/**
+		*  @brief
+		*    Returns the scene node of an entry
+		*
+		*  @param[in] nEntry
+		*    Index of the entry, must be valid
+		*
+		*  @return
+		*    The scene node of the entry, null pointer if it was destroyed
+		*/
+		PLScene::SceneNode *GetSceneNode(PLCore::uint32 nEntry) const;
+
+		/**
+		*  @brief
+		*    Returns the bounding box of an entry
+		*
+		*  @param[in]  nEntry
+		*    Index of the entry, must be valid
+		*  @param[out] vMin
+		*    Receives the minimum corner of the bounding box
+		*  @param[out] vMax
+		*    Receives the maximum corner of the bounding box
+		*/
+		void GetBoundingBox(PLCore::uint32 nEntry, PLMath::Vector3 &vMin, PLMath::Vector3 &vMax) const;
+
+		/**
+		*  @brief
+		*    Returns the entries which bounding boxes overlap a box
+		*
+		*  @param[in]  vMin
+		*    Minimum corner of the box
+		*  @param[in]  vMax
+		*    Maximum corner of the box
+		*  @param[out] lstEntries
+		*    Receives the indices of the entries, the list is not cleared
+		*
+		*  @return
+		*    The number of tested entries
+		*/
+		PLCore::uint32 QueryBox(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax, PLCore::Array<PLCore::uint32> &lstEntries) const;
+
+		/**
+		*  @brief
+		*    Returns the entries which bounding boxes overlap a sphere
+		*
+		*  @param[in]  vCenter
+		*    Sphere center
+		*  @param[in]  fRadius
+		*    Sphere radius
+		*  @param[out] lstEntries
+		*    Receives the indices of the entries, the list is not cleared
+		*
+		*  @return
+		*    The number of tested entries
+		*/
+		PLCore::uint32 QuerySphere(const PLMath::Vector3 &vCenter, float fRadius, PLCore::Array<PLCore::uint32> &lstEntries) const;
+
+		/**
+		*  @brief
+		*    Returns the entries which bounding boxes are not completely outside of a convex volume
+		*
+		*  @param[in]  pPlanes
+		*    Planes bounding the volume (e.g. a view frustum), the plane normals point into the volume
+		*  @param[in]  nNumOfPlanes
+		*    Number of planes
+		*  @param[out] lstEntries
+		*    Receives the indices of the entries, the list is not cleared
+		*
+		*  @return
+		*    The number of tested entries
+		*
+		*  @note
+		*    - A bounding box is outside if it's completely behind one of the planes, so a few bounding boxes
+		*      near the corners of the volume are returned although they're outside
+		*/
+		PLCore::uint32 QueryFrustum(const PLMath::Plane *pPlanes, PLCore::uint32 nNumOfPlanes, PLCore::Array<PLCore::uint32> &lstEntries) const;
+
+		/**
+		*  @brief
+		*    Returns the entries which bounding boxes are hit by a ray
+		*
+		*  @param[in]  vOrigin
+		*    Ray origin
+		*  @param[in]  vDirection
+		*    Ray direction, the maximum distance is in units of its length
+		*  @param[in]  fMaxDistance
+		*    Maximum distance along the ray
+		*  @param[out] lstEntries
+		*    Receives the indices of the entries, the list is not cleared
+		*
+		*  @return
+		*    The number of tested entries
+		*/
+		PLCore::uint32 QueryRay(const PLMath::Vector3 &vOrigin, const PLMath::Vector3 &vDirection, float fMaxDistance, PLCore::Array<PLCore::uint32> &lstEntries) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		static const PLCore::uint32 NoIndex = 0xFFFFFFFF;	/**< Invalid octant or entry index */
+
+		/**
+		*  @brief
+		*    Octant
+		*/
+		struct Octant {
+			PLMath::Vector3 vCenter;		/**< Center of the cell */
+			float			fHalfSize;		/**< Half edge length of the cell, the loose bounds are twice as large */
+			PLCore::uint32	nDepth;			/**< Depth, 0 for the root */
+			PLCore::uint32	nChildren[8];	/**< Child octants, "NoIndex" if there's none */
+			PLCore::uint32	nFirstEntry;	/**< First entry within the octant, "NoIndex" if there's none */
+		};
+
+		/**
+		*  @brief
+		*    Entry
+		*/
+		struct Entry {
+			PLScene::SceneNodeHandler *pSceneNode;		/**< Scene node, always valid, destroyed by the octree */
+			PLMath::Vector3			   vMin;			/**< Minimum corner of the bounding box */
+			PLMath::Vector3			   vMax;			/**< Maximum corner of the bounding box */
+			PLCore::uint32			   nOctant;			/**< Octant the entry is in */
+			PLCore::uint32			   nPrevious;		/**< Previous entry within the octant, "NoIndex" if there's none */
+			PLCore::uint32			   nNext;			/**< Next entry within the octant, "NoIndex" if there's none */
+		};
+
+		/**
+		*  @brief
+		*    Query volume
+		*/
+		struct Query {
+			PLMath::Vector3		  vMin;				/**< Minimum corner of the query bounds */
+			PLMath::Vector3		  vMax;				/**< Maximum corner of the query bounds */
+			const PLMath::Vector3 *pvCenter;		/**< Sphere center, null pointer if no sphere query */
+			float				  fRadius;			/**< Sphere radius */
+			const PLMath::Plane	  *pPlanes;			/**< Volume planes, null pointer if no volume query */
+			PLCore::uint32		  nNumOfPlanes;		/**< Number of volume planes */
+			const PLMath::Vector3 *pvOrigin;		/**< Ray origin, null pointer if no ray query */
+			PLMath::Vector3		  vInverseDirection;	/**< Reciprocal ray direction */
+			float				  fMaxDistance;		/**< Maximum distance along the ray */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		LooseOctree(const LooseOctree &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		LooseOctree &operator =(const LooseOctree &cSource);
+
+		/**
+		*  @brief
+		*    Returns the octant an entry belongs into, creates the octant if required
+		*
+		*  @param[in] vMin
+		*    Minimum corner of the bounding box of the entry
+		*  @param[in] vMax
+		*    Maximum corner of the bounding box of the entry
+		*
+		*  @return
+		*    Index of the octant
+		*/
+		PLCore::uint32 GetOctant(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax);
+
+		/**
+		*  @brief
+		*    Links an entry into an octant
+		*
+		*  @param[in] nEntry
+		*    Index of the entry
+		*  @param[in] nOctant
+		*    Index of the octant
+		*/
+		void Link(PLCore::uint32 nEntry, PLCore::uint32 nOctant);
+
+		/**
+		*  @brief
+		*    Unlinks an entry from its octant
+		*
+		*  @param[in] nEntry
+		*    Index of the entry
+		*/
+		void Unlink(PLCore::uint32 nEntry);
+
+		/**
+		*  @brief
+		*    Returns whether or not a box is touched by a query
+		*
+		*  @param[in] sQuery
+		*    Query
+		*  @param[in] vMin
+		*    Minimum corner of the box
+		*  @param[in] vMax
+		*    Maximum corner of the box
+		*
+		*  @return
+		*    'true' if the box is touched by the query, else 'false'
+		*/
+		bool IsTouched(const Query &sQuery, const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax) const;
+
+		/**
+		*  @brief
+		*    Collects the entries touched by a query
+		*
+		*  @param[in]  sQuery
+		*    Query
+		*  @param[out] lstEntries
+		*    Receives the indices of the entries
+		*
+		*  @return
+		*    The number of tested entries
+		*/
+		PLCore::uint32 Collect(const Query &sQuery, PLCore::Array<PLCore::uint32> &lstEntries) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<Octant> m_lstOctants;	/**< Octants, the root is the first one */
+		PLCore::Array<Entry>  m_lstEntries;	/**< Entries */
+
+
+};
+
+
+#endif // __DUNGEON_LOOSEOCTREE_H__
@@ -0,0 +1,617 @@
+/*********************************************************\
+ *  File: OcclusionCuller.cpp                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/String/Tokenizer.h>
+#include <PLMath/Math.h>
+#include <PLMesh/Mesh.h>
+#include <PLMesh/MeshHandler.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Tools/Trace.h"
+#include "Scene/LooseOctree.h"
+#include "Scene/PortalCuller.h"
+#include "Scene/OcclusionCuller.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float NearDistance = 0.05f;	/**< Distance of the near plane the occluder triangles are clipped against */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the transform of a scene node relative to one of its parent scene containers
+*/
+static Matrix3x4 GetRelativeTransform(SceneNode &cSceneNode, const SceneNode *pContainer)
+{
+	Matrix3x4 mTransform = cSceneNode.GetTransform().GetMatrix();
+	for (SceneContainer *pParent=cSceneNode.GetContainer(); pParent && pParent!=pContainer; pParent=pParent->GetContainer())
+		mTransform = pParent->GetTransform().GetMatrix()*mTransform;
+	return mTransform;
+}
+
+/**
+*  @brief
+*    Returns the mesh of a scene node, null pointer if it's no mesh scene node or has no mesh
+*/
+static Mesh *GetSceneNodeMesh(SceneNode &cSceneNode)
+{
+	if (cSceneNode.IsInstanceOf("PLScene::SNMesh")) {
+		MeshHandler *pMeshHandler = static_cast<SNMesh&>(cSceneNode).GetMeshHandler();
+		if (pMeshHandler)
+			return pMeshHandler->GetResource();
+	}
+	return nullptr;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+OcclusionCuller::OcclusionCuller(uint32 nNumOfThreads) :
+	m_cWorkerPool(nNumOfThreads),
+	m_pPortalCuller(nullptr),
+	m_nNumOfOccluders(0),
+	m_fScaleX(0.0f),
+	m_fScaleY(0.0f),
+	m_nNumOfVisibleOccluders(0),
+	m_nNumOfTestedMeshes(0),
+	m_nNumOfTileHits(0),
+	m_nNumOfPixelHits(0),
+	m_nNumOfCulledMeshes(0),
+	m_nNumOfKeptCasters(0)
+{
+	m_lstDepths.Resize(Width*Height, true, false);
+	m_lstTileDepths.Resize((Width/TileSize)*(Height/TileSize), true, false);
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+OcclusionCuller::~OcclusionCuller()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Gathers the occluders within the cells of a portal culler
+*/
+uint32 OcclusionCuller::Build(const PortalCuller &cPortalCuller, const String &sOccluders)
+{
+	TraceScope cTraceScope("OcclusionCuller::Build", "Scene");
+
+	// Remove the previous occluders
+	Clear();
+	m_pPortalCuller = &cPortalCuller;
+
+	// Get the parts of the occluder mesh names
+	Array<String> lstOccluders;
+	Tokenizer cTokenizer;
+	cTokenizer.Start(sOccluders);
+	for (String sToken=cTokenizer.GetNextToken(); sToken.GetLength(); sToken=cTokenizer.GetNextToken())
+		lstOccluders.Add(sToken);
+	cTokenizer.Stop();
+
+	// Find the occluders within the octrees of the cells, the triangles of meshes used several times are shared
+	for (uint32 nCell=0; nCell<cPortalCuller.GetNumOfCells(); nCell++) {
+		Cell *pCell = new Cell;
+		m_lstCells.Add(pCell);
+		const LooseOctree *pOctree = cPortalCuller.GetOctree(nCell);
+		const uint32 nNumOfEntries = pOctree ? pOctree->GetNumOfEntries() : 0;
+		pCell->lstOccluders.Resize(nNumOfEntries, true, false);
+		pCell->lstHidden.Resize(nNumOfEntries, true, false);
+		for (uint32 nEntry=0; nEntry<nNumOfEntries; nEntry++) {
+			pCell->lstOccluders[nEntry] = nullptr;
+			pCell->lstHidden[nEntry]	= 0;
+			SceneNode *pSceneNode = pOctree->GetSceneNode(nEntry);
+			const Mesh *pMesh = pSceneNode ? GetSceneNodeMesh(*pSceneNode) : nullptr;
+			if (pSceneNode && pSceneNode->IsInstanceOf("PLScene::SNLight") && (pSceneNode->GetFlags() & SceneNode::CastShadow)) {
+				pCell->lstLights.Add(nEntry);
+			} else if (pMesh) {
+				for (uint32 i=0; i<lstOccluders.GetNumOfElements(); i++) {
+					if (pMesh->GetName().IndexOf(lstOccluders[i]) >= 0) {
+						pCell->lstOccluders[nEntry] = m_cGeometryCache.Get(*pMesh);
+						if (pCell->lstOccluders[nEntry])
+							m_nNumOfOccluders++;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// Done
+	return m_nNumOfOccluders;
+}
+
+/**
+*  @brief
+*    Makes all hidden meshes visible again and removes the occluders
+*/
+void OcclusionCuller::Clear()
+{
+	ShowHidden();
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+	m_cGeometryCache.Clear();
+	m_lstVertices.Clear();
+	m_lstTriangles.Clear();
+	m_lstShadowLights.Clear();
+	m_pPortalCuller			 = nullptr;
+	m_nNumOfOccluders		 = 0;
+	m_nNumOfVisibleOccluders = 0;
+	m_nNumOfTestedMeshes	 = 0;
+	m_nNumOfTileHits		 = 0;
+	m_nNumOfPixelHits		 = 0;
+	m_nNumOfCulledMeshes	 = 0;
+	m_nNumOfKeptCasters		 = 0;
+}
+
+/**
+*  @brief
+*    Hides the visible meshes which are hidden behind the occluders
+*/
+void OcclusionCuller::Update(SceneNode *pCamera, float fAspect)
+{
+	// Reset the results of the previous update
+	ShowHidden();
+	m_lstTriangles.Reset();
+	m_lstShadowLights.Reset();
+	m_nNumOfVisibleOccluders = 0;
+	m_nNumOfTestedMeshes	 = 0;
+	m_nNumOfTileHits		 = 0;
+	m_nNumOfPixelHits		 = 0;
+	m_nNumOfCulledMeshes	 = 0;
+	m_nNumOfKeptCasters		 = 0;
+	if (!pCamera || !m_pPortalCuller || !m_nNumOfOccluders)
+		return;
+
+	// Get the camera settings, a vertical field of view is assumed (just like within the portal culler)
+	const DynVar *pFOV	  = pCamera->GetAttribute("FOV");
+	const DynVar *pAspect = pCamera->GetAttribute("Aspect");
+	const float fTan	  = Math::Tan(static_cast<float>((pFOV ? pFOV->GetFloat() : 45.0f)*0.5f*Math::DegToRad));
+	fAspect *= pAspect ? pAspect->GetFloat() : 1.0f;
+	m_fScaleX = Width*0.5f/(fTan*fAspect);
+	m_fScaleY = Height*0.5f/fTan;
+
+	// Get the transforms from the space of the visible cells into the world space and the view space, the camera looks along its z axis
+	const Matrix3x4 mCameraInverse = GetRelativeTransform(*pCamera, nullptr).GetInverted();
+	Array<Matrix3x4> lstCellWorldTransforms;
+	Array<Matrix3x4> lstCellTransforms;
+	lstCellWorldTransforms.Resize(m_lstCells.GetNumOfElements(), true, false);
+	lstCellTransforms.Resize(m_lstCells.GetNumOfElements(), true, false);
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		SceneContainer *pCell = m_pPortalCuller->GetCell(nCell);
+		if (pCell && m_pPortalCuller->IsCellVisible(nCell)) {
+			lstCellWorldTransforms[nCell] = GetRelativeTransform(*pCell, nullptr);
+			lstCellTransforms[nCell]	  = mCameraInverse*lstCellWorldTransforms[nCell];
+		}
+	}
+
+	// Get the ranges of the visible shadow casting lights, their shadow passes render the meshes within their ranges
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		if (m_pPortalCuller->GetCell(nCell) && m_pPortalCuller->IsCellVisible(nCell)) {
+			const Cell &cCell = *m_lstCells[nCell];
+			const LooseOctree &cOctree = *m_pPortalCuller->GetOctree(nCell);
+			for (uint32 i=0; i<cCell.lstLights.GetNumOfElements(); i++) {
+				const uint32 nEntry = cCell.lstLights[i];
+				SceneNode *pSceneNode = cOctree.GetSceneNode(nEntry);
+				if (pSceneNode && pSceneNode->IsVisible() && m_pPortalCuller->IsSceneNodeVisible(nCell, nEntry)) {
+					Vector3 vMin, vMax;
+					cOctree.GetBoundingBox(nEntry, vMin, vMax);
+					const Vector3 vWorldMin = lstCellWorldTransforms[nCell]*vMin;
+					const Vector3 vWorldMax = lstCellWorldTransforms[nCell]*vMax;
+					ShadowLight &sShadowLight = m_lstShadowLights.Add();
+					sShadowLight.vCenter = (vWorldMin + vWorldMax)*0.5f;
+					sShadowLight.fRadius = (vWorldMax - vWorldMin).GetLength()*0.5f;
+				}
+			}
+		}
+	}
+
+	// Project the triangles of the visible occluders
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		SceneContainer *pCell = m_pPortalCuller->GetCell(nCell);
+		if (pCell && m_pPortalCuller->IsCellVisible(nCell)) {
+			const Cell &cCell = *m_lstCells[nCell];
+			const LooseOctree &cOctree = *m_pPortalCuller->GetOctree(nCell);
+			for (uint32 nEntry=0; nEntry<cCell.lstOccluders.GetNumOfElements(); nEntry++) {
+				SceneNode *pSceneNode = cCell.lstOccluders[nEntry] ? cOctree.GetSceneNode(nEntry) : nullptr;
+				if (pSceneNode && pSceneNode->IsVisible() && m_pPortalCuller->IsSceneNodeVisible(nCell, nEntry)) {
+					AddOccluder(*cCell.lstOccluders[nEntry], lstCellTransforms[nCell]*GetRelativeTransform(*pSceneNode, pCell));
+					m_nNumOfVisibleOccluders++;
+				}
+			}
+		}
+	}
+	if (!m_lstTriangles.GetNumOfElements())
+		return;
+
+	// Rasterize the tile rows in parallel
+	{
+		TraceScope cTraceScope("OcclusionCuller::Rasterize", "Scene");
+		for (uint32 nTileRow=0; nTileRow<Height/TileSize; nTileRow++)
+			m_cWorkerPool.AddJob(new RasterizeJob(*this, nTileRow));
+		m_cWorkerPool.WaitForAll();
+	}
+
+	// Test the other visible meshes, only meshes are hidden (e.g. lights behind an occluder still light the visible meshes),
+	// shadow casters within the range of a visible shadow casting light are kept
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		if (m_pPortalCuller->GetCell(nCell) && m_pPortalCuller->IsCellVisible(nCell)) {
+			Cell &cCell = *m_lstCells[nCell];
+			const LooseOctree &cOctree = *m_pPortalCuller->GetOctree(nCell);
+			for (uint32 nEntry=0; nEntry<cCell.lstOccluders.GetNumOfElements(); nEntry++) {
+				if (!cCell.lstOccluders[nEntry] && m_pPortalCuller->IsSceneNodeVisible(nCell, nEntry)) {
+					SceneNode *pSceneNode = cOctree.GetSceneNode(nEntry);
+					if (pSceneNode && pSceneNode->IsVisible() && pSceneNode->IsInstanceOf("PLScene::SNMesh")) {
+						Vector3 vMin, vMax;
+						cOctree.GetBoundingBox(nEntry, vMin, vMax);
+						m_nNumOfTestedMeshes++;
+						if (IsOccluded(vMin, vMax, lstCellTransforms[nCell])) {
+							if ((pSceneNode->GetFlags() & SceneNode::CastShadow) && IsLit(vMin, vMax, lstCellWorldTransforms[nCell])) {
+								m_nNumOfKeptCasters++;
+							} else {
+								pSceneNode->SetVisible(false);
+								cCell.lstHidden[nEntry] = 1;
+								m_nNumOfCulledMeshes++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the number of occluders
+*/
+uint32 OcclusionCuller::GetNumOfOccluders() const
+{
+	return m_nNumOfOccluders;
+}
+
+/**
+*  @brief
+*    Returns the counters of the last update as string
+*/
+String OcclusionCuller::ToString() const
+{
+	return String::Format("Occluders=\"%u\" OccluderTriangles=\"%u\" OcclusionTested=\"%u\" TileHits=\"%u\" PixelHits=\"%u\" Occluded=\"%u\" KeptShadowCasters=\"%u\"",
+						  m_nNumOfVisibleOccluders, m_lstTriangles.GetNumOfElements(), m_nNumOfTestedMeshes, m_nNumOfTileHits, m_nNumOfPixelHits, m_nNumOfCulledMeshes, m_nNumOfKeptCasters);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public OcclusionCuller::RasterizeJob functions        ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+OcclusionCuller::RasterizeJob::RasterizeJob(OcclusionCuller &cOcclusionCuller, uint32 nTileRow) :
+	m_pOcclusionCuller(&cOcclusionCuller),
+	m_nTileRow(nTileRow)
+{
+}
+
+
+//[-------------------------------------------------------]
+//[ Public virtual WorkerPool::Job functions              ]
+//[-------------------------------------------------------]
+void OcclusionCuller::RasterizeJob::Execute()
+{
+	m_pOcclusionCuller->RasterizeTileRow(m_nTileRow);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+OcclusionCuller::OcclusionCuller(const OcclusionCuller &cSource) :
+	m_cWorkerPool(1),
+	m_pPortalCuller(nullptr),
+	m_nNumOfOccluders(0),
+	m_fScaleX(0.0f),
+	m_fScaleY(0.0f),
+	m_nNumOfVisibleOccluders(0),
+	m_nNumOfTestedMeshes(0),
+	m_nNumOfTileHits(0),
+	m_nNumOfPixelHits(0),
+	m_nNumOfCulledMeshes(0),
+	m_nNumOfKeptCasters(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+OcclusionCuller &OcclusionCuller::operator =(const OcclusionCuller &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Makes the meshes hidden by the previous update visible again
+*/
+void OcclusionCuller::ShowHidden()
+{
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		Cell &cCell = *m_lstCells[nCell];
+		const LooseOctree *pOctree = m_pPortalCuller ? m_pPortalCuller->GetOctree(nCell) : nullptr;
+		for (uint32 nEntry=0; nEntry<cCell.lstHidden.GetNumOfElements(); nEntry++) {
+			if (cCell.lstHidden[nEntry]) {
+				cCell.lstHidden[nEntry] = 0;
+				SceneNode *pSceneNode = pOctree ? pOctree->GetSceneNode(nEntry) : nullptr;
+				if (pSceneNode)
+					pSceneNode->SetVisible(true);
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Projects the triangles of an occluder
+*/
+void OcclusionCuller::AddOccluder(const CollisionGeometry &cGeometry, const Matrix3x4 &mTransform)
+{
+	// Transform the vertices into the view space
+	m_lstVertices.Resize(cGeometry.lstVertices.GetNumOfElements(), true, false);
+	for (uint32 i=0; i<cGeometry.lstVertices.GetNumOfElements(); i++)
+		m_lstVertices[i] = mTransform*cGeometry.lstVertices[i];
+
+	// Clip the triangles against the near plane, a clipped triangle becomes a quadrangle at most
+	for (uint32 nTriangle=0; nTriangle+2<cGeometry.lstIndices.GetNumOfElements(); nTriangle+=3) {
+		Vector3 vPolygon[4];
+		uint32 nNumOfVertices = 0;
+		for (uint32 i=0; i<3; i++) {
+			const Vector3 &vA = m_lstVertices[cGeometry.lstIndices[nTriangle + i]];
+			const Vector3 &vB = m_lstVertices[cGeometry.lstIndices[nTriangle + (i + 1)%3]];
+			if (vA.z >= NearDistance)
+				vPolygon[nNumOfVertices++] = vA;
+			if ((vA.z >= NearDistance) != (vB.z >= NearDistance))
+				vPolygon[nNumOfVertices++] = vA + (vB - vA)*((NearDistance - vA.z)/(vB.z - vA.z));
+		}
+		if (nNumOfVertices < 3)
+			continue;
+
+		// Project the polygon
+		float fX[4], fY[4], fInvZ[4];
+		for (uint32 i=0; i<nNumOfVertices; i++) {
+			fInvZ[i] = 1.0f/vPolygon[i].z;
+			fX[i]	 = Width*0.5f  + vPolygon[i].x*m_fScaleX*fInvZ[i];
+			fY[i]	 = Height*0.5f - vPolygon[i].y*m_fScaleY*fInvZ[i];
+		}
+
+		// Add the triangles of the polygon which are within the screen
+		for (uint32 i=2; i<nNumOfVertices; i++) {
+			const uint32 nVertices[3] = { 0, i - 1, i };
+			Triangle sTriangle;
+			float fMinX = Math::MaxFloat, fMaxX = -Math::MaxFloat, fMinY = Math::MaxFloat, fMaxY = -Math::MaxFloat;
+			for (uint32 j=0; j<3; j++) {
+				sTriangle.fX[j]	   = fX[nVertices[j]];
+				sTriangle.fY[j]	   = fY[nVertices[j]];
+				sTriangle.fInvZ[j] = fInvZ[nVertices[j]];
+				fMinX = Math::Min(fMinX, sTriangle.fX[j]);
+				fMaxX = Math::Max(fMaxX, sTriangle.fX[j]);
+				fMinY = Math::Min(fMinY, sTriangle.fY[j]);
+				fMaxY = Math::Max(fMaxY, sTriangle.fY[j]);
+			}
+			if (fMaxX >= 0.0f && fMinX <= Width && fMaxY >= 0.0f && fMinY <= Height) {
+				sTriangle.nMinY = static_cast<uint32>(Math::Max(fMinY - 0.5f, 0.0f));
+				sTriangle.nMaxY = Math::Min(static_cast<uint32>(Math::Max(fMaxY - 0.5f, 0.0f)), Height - 1);
+				m_lstTriangles.Add(sTriangle);
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Rasterizes the projected triangles into a tile row and builds the maximum depths of its tiles
+*/
+void OcclusionCuller::RasterizeTileRow(uint32 nTileRow)
+{
+	// Clear the rows, uncovered pixels are infinitely far away
+	const uint32 nFirstRow = nTileRow*TileSize;
+	const uint32 nLastRow  = nFirstRow + TileSize - 1;
+	float *pfDepths = m_lstDepths.GetData();
+	for (uint32 i=nFirstRow*Width; i<(nLastRow + 1)*Width; i++)
+		pfDepths[i] = Math::MaxFloat;
+
+	// Rasterize the triangles covering the rows, the pixels are sampled at their centers
+	for (uint32 nTriangle=0; nTriangle<m_lstTriangles.GetNumOfElements(); nTriangle++) {
+		const Triangle &sTriangle = m_lstTriangles[nTriangle];
+		if (sTriangle.nMaxY < nFirstRow || sTriangle.nMinY > nLastRow)
+			continue;
+
+		// The edge functions divided by the doubled triangle area are the barycentric coordinates, so both windings are covered
+		const float fArea = (sTriangle.fX[1] - sTriangle.fX[0])*(sTriangle.fY[2] - sTriangle.fY[0]) - (sTriangle.fY[1] - sTriangle.fY[0])*(sTriangle.fX[2] - sTriangle.fX[0]);
+		if (Math::Abs(fArea) < 0.0001f)
+			continue;
+		const float fInvArea = 1.0f/fArea;
+		float fStepX[3], fStepY[3], fEdge[3];
+		float fMinX = Math::MaxFloat, fMaxX = -Math::MaxFloat;
+		const uint32 nStartY = Math::Max(sTriangle.nMinY, nFirstRow);
+		const uint32 nEndY	 = Math::Min(sTriangle.nMaxY, nLastRow);
+		for (uint32 i=0; i<3; i++) {
+			const uint32 nA = (i + 1)%3;
+			const uint32 nB = (i + 2)%3;
+			fStepX[i] = -(sTriangle.fY[nB] - sTriangle.fY[nA])*fInvArea;
+			fStepY[i] =  (sTriangle.fX[nB] - sTriangle.fX[nA])*fInvArea;
+			fMinX = Math::Min(fMinX, sTriangle.fX[i]);
+			fMaxX = Math::Max(fMaxX, sTriangle.fX[i]);
+		}
+		const uint32 nStartX = static_cast<uint32>(Math::Max(fMinX - 0.5f, 0.0f));
+		const uint32 nEndX	 = Math::Min(static_cast<uint32>(Math::Max(fMaxX - 0.5f, 0.0f)), Width - 1);
+		for (uint32 i=0; i<3; i++) {
+			const uint32 nA = (i + 1)%3;
+			fEdge[i] = (nStartX + 0.5f - sTriangle.fX[nA])*fStepX[i] + (nStartY + 0.5f - sTriangle.fY[nA])*fStepY[i];
+		}
+
+		// Walk the rows
+		for (uint32 nY=nStartY; nY<=nEndY; nY++) {
+			float fE0 = fEdge[0], fE1 = fEdge[1], fE2 = fEdge[2];
+			float *pfDepth = pfDepths + nY*Width + nStartX;
+			for (uint32 nX=nStartX; nX<=nEndX; nX++, pfDepth++) {
+				if (fE0 >= 0.0f && fE1 >= 0.0f && fE2 >= 0.0f) {
+					const float fInvZ = fE0*sTriangle.fInvZ[0] + fE1*sTriangle.fInvZ[1] + fE2*sTriangle.fInvZ[2];
+					if (fInvZ > 0.0f && 1.0f/fInvZ < *pfDepth)
+						*pfDepth = 1.0f/fInvZ;
+				}
+				fE0 += fStepX[0];
+				fE1 += fStepX[1];
+				fE2 += fStepX[2];
+			}
+			fEdge[0] += fStepY[0];
+			fEdge[1] += fStepY[1];
+			fEdge[2] += fStepY[2];
+		}
+	}
+
+	// Build the maximum depths of the tiles
+	for (uint32 nTileX=0; nTileX<Width/TileSize; nTileX++) {
+		float fMaxDepth = 0.0f;
+		for (uint32 nY=nFirstRow; nY<=nLastRow; nY++) {
+			const float *pfDepth = pfDepths + nY*Width + nTileX*TileSize;
+			for (uint32 nX=0; nX<TileSize; nX++)
+				fMaxDepth = Math::Max(fMaxDepth, pfDepth[nX]);
+		}
+		m_lstTileDepths[nTileRow*(Width/TileSize) + nTileX] = fMaxDepth;
+	}
+}
+
+/**
+*  @brief
+*    Tests a bounding box against the depth buffer
+*/
+bool OcclusionCuller::IsOccluded(const Vector3 &vMin, const Vector3 &vMax, const Matrix3x4 &mTransform)
+{
+	// Get the screen rectangle and the nearest depth of the bounding box, a box reaching the near plane is visible
+	float fMinX = Math::MaxFloat, fMaxX = -Math::MaxFloat, fMinY = Math::MaxFloat, fMaxY = -Math::MaxFloat, fMinZ = Math::MaxFloat;
+	for (uint32 i=0; i<8; i++) {
+		const Vector3 vCorner = mTransform*Vector3((i & 1) ? vMax.x : vMin.x, (i & 2) ? vMax.y : vMin.y, (i & 4) ? vMax.z : vMin.z);
+		if (vCorner.z < NearDistance)
+			return false;
+		const float fX = Width*0.5f  + vCorner.x*m_fScaleX/vCorner.z;
+		const float fY = Height*0.5f - vCorner.y*m_fScaleY/vCorner.z;
+		fMinX = Math::Min(fMinX, fX);
+		fMaxX = Math::Max(fMaxX, fX);
+		fMinY = Math::Min(fMinY, fY);
+		fMaxY = Math::Max(fMaxY, fY);
+		fMinZ = Math::Min(fMinZ, vCorner.z);
+	}
+
+	// Boxes outside of the screen are left to the frustum culling of the renderer
+	if (fMaxX < 0.0f || fMinX >= Width || fMaxY < 0.0f || fMinY >= Height)
+		return false;
+	const uint32 nMinX = static_cast<uint32>(Math::Max(fMinX, 0.0f));
+	const uint32 nMaxX = Math::Min(static_cast<uint32>(fMaxX), Width - 1);
+	const uint32 nMinY = static_cast<uint32>(Math::Max(fMinY, 0.0f));
+	const uint32 nMaxY = Math::Min(static_cast<uint32>(fMaxY), Height - 1);
+
+	// Test the tiles first, only tiles with a farther maximum depth need their pixels to be tested
+	bool bPixelTest = false;
+	for (uint32 nTileY=nMinY/TileSize; nTileY<=nMaxY/TileSize; nTileY++) {
+		for (uint32 nTileX=nMinX/TileSize; nTileX<=nMaxX/TileSize; nTileX++) {
+			if (m_lstTileDepths[nTileY*(Width/TileSize) + nTileX] >= fMinZ) {
+				bPixelTest = true;
+				const uint32 nStartY = Math::Max(nTileY*TileSize, nMinY);
+				const uint32 nEndY	 = Math::Min(nTileY*TileSize + TileSize - 1, nMaxY);
+				const uint32 nStartX = Math::Max(nTileX*TileSize, nMinX);
+				const uint32 nEndX	 = Math::Min(nTileX*TileSize + TileSize - 1, nMaxX);
+				for (uint32 nY=nStartY; nY<=nEndY; nY++) {
+					for (uint32 nX=nStartX; nX<=nEndX; nX++) {
+						if (m_lstDepths[nY*Width + nX] >= fMinZ) {
+							// Visible
+							m_nNumOfPixelHits++;
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Occluded
+	if (bPixelTest)
+		m_nNumOfPixelHits++;
+	else
+		m_nNumOfTileHits++;
+	return true;
+}
+
+/**
+*  @brief
+*    Tests whether or not a bounding box is within the range of a visible shadow casting light
+*/
+bool OcclusionCuller::IsLit(const Vector3 &vMin, const Vector3 &vMax, const Matrix3x4 &mTransform) const
+{
+	// Compare the bounding spheres, the corners of the bounding box don't need to be transformed one by one
+	const Vector3 vWorldMin = mTransform*vMin;
+	const Vector3 vWorldMax = mTransform*vMax;
+	const Vector3 vCenter	= (vWorldMin + vWorldMax)*0.5f;
+	const float   fRadius	= (vWorldMax - vWorldMin).GetLength()*0.5f;
+	for (uint32 i=0; i<m_lstShadowLights.GetNumOfElements(); i++) {
+		const ShadowLight &sShadowLight = m_lstShadowLights[i];
+		if ((sShadowLight.vCenter - vCenter).GetLength() <= sShadowLight.fRadius + fRadius)
+			return true;
+	}
+
+	// Not within the range of any visible shadow casting light
+	return false;
+}
@@ -0,0 +1,350 @@
+/*********************************************************\
+ *  File: OcclusionCuller.h                              *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_OCCLUSIONCULLER_H__
+#define __DUNGEON_OCCLUSIONCULLER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLMath/Matrix3x4.h>
+#include "Tools/WorkerPool.h"
+#include "Physics/CollisionGeometryCache.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneNode;
+}
+class PortalCuller;
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Software rasterized occlusion culling of the meshes within the visible cells
+*
+*  @remarks
+*    Once per frame, after the portal culler has determined the visible scene nodes, the visible occluder meshes (large
+*    closed meshes such as the caves and tunnels, designated by parts of their mesh names) are rasterized into a low
+*    resolution depth buffer on the CPU. The depth buffer is split into bands of tile rows which are rasterized by
+*    worker threads in parallel, each band also builds the maximum depth of each of its tiles. The screen rectangle
+*    and nearest depth of the bounding box of each other visible mesh is then tested against the tiles first and the
+*    pixels of the tiles which can't decide second - a mesh which is behind the depth buffer everywhere within its
+*    rectangle is set invisible until the next update.
+*
+*    An invisible scene node is skipped by all render passes, the shadow passes included. A shadow casting mesh is
+*    therefore only hidden if it's outside the range of every visible shadow casting light, else it could still throw
+*    a shadow into the visible part of the scene. The ranges are bounding spheres around the bounding boxes of the
+*    lights and meshes, so a few more shadow casters than necessary are kept.
+*
+*    Depths are distances along the view direction. The occluder triangles are clipped against the near plane and
+*    drawn without back face culling, so the caves occlude from within as well. Coverage is sampled at the pixel
+*    centers, so a mesh may be culled a little early along the silhouettes of the occluders.
+*/
+class OcclusionCuller {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 Width	 = 256;	/**< Depth buffer width (in pixels) */
+		static const PLCore::uint32 Height	 = 128;	/**< Depth buffer height (in pixels) */
+		static const PLCore::uint32 TileSize = 8;	/**< Tile width and height (in pixels), also the height of the rasterized bands */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] nNumOfThreads
+		*    Number of worker threads rasterizing the occluders
+		*/
+		explicit OcclusionCuller(PLCore::uint32 nNumOfThreads);
+
+		/**
+		*  @brief
+		*    Destructor
+		*
+		*  @note
+		*    - The hidden meshes are made visible again
+		*/
+		~OcclusionCuller();
+
+		/**
+		*  @brief
+		*    Gathers the occluders within the cells of a portal culler
+		*
+		*  @param[in] cPortalCuller
+		*    Portal culler providing the cells and the visible scene nodes, must stay valid as long as this culler is used
+		*  @param[in] sOccluders
+		*    Space separated parts of the mesh names of the occluder meshes (e.g. "Cave_Cave Tunnel")
+		*
+		*  @return
+		*    The number of occluders
+		*/
+		PLCore::uint32 Build(const PortalCuller &cPortalCuller, const PLCore::String &sOccluders);
+
+		/**
+		*  @brief
+		*    Makes all hidden meshes visible again and removes the occluders
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Hides the visible meshes which are hidden behind the occluders
+		*
+		*  @param[in] pCamera
+		*    Camera scene node ("PLScene::SNCamera"), can be a null pointer
+		*  @param[in] fAspect
+		*    Width to height ratio of the viewport
+		*
+		*  @note
+		*    - The portal culler must have been updated for the same camera right before
+		*    - If there's no camera or no occluder is visible, all meshes are visible
+		*/
+		void Update(PLScene::SceneNode *pCamera, float fAspect);
+
+		/**
+		*  @brief
+		*    Returns the number of occluders
+		*
+		*  @return
+		*    The number of occluders within all cells
+		*/
+		PLCore::uint32 GetNumOfOccluders() const;
+
+		/**
+		*  @brief
+		*    Returns the counters of the last update as string
+		*
+		*  @return
+		*    The counters as string (e.g. "Occluders=\"6\" OccluderTriangles=\"5120\" OcclusionTested=\"120\" TileHits=\"64\" PixelHits=\"56\" Occluded=\"90\" KeptShadowCasters=\"41\"")
+		*/
+		PLCore::String ToString() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Cell
+		*/
+		struct Cell {
+			PLCore::Array<const CollisionGeometry*> lstOccluders;	/**< Occluder geometry per octree entry, null pointer for entries which are no occluders */
+			PLCore::Array<PLCore::uint8>			lstHidden;		/**< Was the scene node hidden by the culler? Per octree entry */
+			PLCore::Array<PLCore::uint32>			lstLights;		/**< Octree entries of the shadow casting lights */
+		};
+
+		/**
+		*  @brief
+		*    Bounding sphere of a visible shadow casting light within the world space
+		*/
+		struct ShadowLight {
+			PLMath::Vector3 vCenter;	/**< Center */
+			float			fRadius;	/**< Radius */
+		};
+
+		/**
+		*  @brief
+		*    Projected triangle
+		*/
+		struct Triangle {
+			float		   fX[3];		/**< Horizontal screen positions (in pixels) */
+			float		   fY[3];		/**< Vertical screen positions (in pixels) */
+			float		   fInvZ[3];	/**< Reciprocal depths, linear within the screen space */
+			PLCore::uint32 nMinY;		/**< First pixel row the triangle may cover */
+			PLCore::uint32 nMaxY;		/**< Last pixel row the triangle may cover */
+		};
+
+		/**
+		*  @brief
+		*    Job rasterizing the projected triangles into a band of tile rows
+		*/
+		class RasterizeJob : public WorkerPool::Job {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Constructor
+				*
+				*  @param[in] cOcclusionCuller
+				*    Owner occlusion culler
+				*  @param[in] nTileRow
+				*    Index of the tile row to rasterize
+				*/
+				RasterizeJob(OcclusionCuller &cOcclusionCuller, PLCore::uint32 nTileRow);
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual WorkerPool::Job functions              ]
+			//[-------------------------------------------------------]
+			public:
+				virtual void Execute() override;
+
+
+			//[-------------------------------------------------------]
+			//[ Private data                                          ]
+			//[-------------------------------------------------------]
+			private:
+				OcclusionCuller *m_pOcclusionCuller;	/**< Owner occlusion culler, always valid */
+				PLCore::uint32	 m_nTileRow;			/**< Index of the tile row to rasterize */
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		OcclusionCuller(const OcclusionCuller &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		OcclusionCuller &operator =(const OcclusionCuller &cSource);
+
+		/**
+		*  @brief
+		*    Makes the meshes hidden by the previous update visible again
+		*/
+		void ShowHidden();
+
+		/**
+		*  @brief
+		*    Projects the triangles of an occluder
+		*
+		*  @param[in] cGeometry
+		*    Occluder geometry
+		*  @param[in] mTransform
+		*    Transforms from the occluder space into the view space
+		*/
+		void AddOccluder(const CollisionGeometry &cGeometry, const PLMath::Matrix3x4 &mTransform);
+
+		/**
+		*  @brief
+		*    Rasterizes the projected triangles into a tile row and builds the maximum depths of its tiles
+		*
+		*  @param[in] nTileRow
+		*    Index of the tile row
+		*
+		*  @note
+		*    - Called by the worker threads, the tile rows don't share any data which is written
+		*/
+		void RasterizeTileRow(PLCore::uint32 nTileRow);
+
+		/**
+		*  @brief
+		*    Tests a bounding box against the depth buffer
+		*
+		*  @param[in] vMin
+		*    Minimum of the bounding box within the space of its cell
+		*  @param[in] vMax
+		*    Maximum of the bounding box within the space of its cell
+		*  @param[in] mTransform
+		*    Transforms from the space of the cell into the view space
+		*
+		*  @return
+		*    'true' if the bounding box is hidden behind the occluders, else 'false'
+		*/
+		bool IsOccluded(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax, const PLMath::Matrix3x4 &mTransform);
+
+		/**
+		*  @brief
+		*    Tests whether or not a bounding box is within the range of a visible shadow casting light
+		*
+		*  @param[in] vMin
+		*    Minimum of the bounding box within the space of its cell
+		*  @param[in] vMax
+		*    Maximum of the bounding box within the space of its cell
+		*  @param[in] mTransform
+		*    Transforms from the space of the cell into the world space
+		*
+		*  @return
+		*    'true' if a mesh within the bounding box can throw a shadow into the visible part of the scene, else 'false'
+		*/
+		bool IsLit(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax, const PLMath::Matrix3x4 &mTransform) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		WorkerPool						 m_cWorkerPool;				/**< Worker threads rasterizing the tile rows */
+		CollisionGeometryCache			 m_cGeometryCache;			/**< Triangles of the occluder meshes */
+		const PortalCuller				*m_pPortalCuller;			/**< Portal culler providing the cells and the visible scene nodes, null pointer if not built */
+		PLCore::Array<Cell*>			 m_lstCells;				/**< Cells, same order as within the portal culler */
+		PLCore::uint32					 m_nNumOfOccluders;			/**< Number of occluders within all cells */
+		PLCore::Array<PLMath::Vector3>	 m_lstVertices;				/**< Vertices of the current occluder within the view space */
+		PLCore::Array<Triangle>			 m_lstTriangles;			/**< Projected triangles of the visible occluders */
+		PLCore::Array<ShadowLight>		 m_lstShadowLights;			/**< Visible shadow casting lights of the last update */
+		PLCore::Array<float>			 m_lstDepths;				/**< Depth buffer, "Width" times "Height" depths */
+		PLCore::Array<float>			 m_lstTileDepths;			/**< Maximum depth of each tile */
+		float							 m_fScaleX;					/**< Horizontal projection scale (in pixels) */
+		float							 m_fScaleY;					/**< Vertical projection scale (in pixels) */
+		PLCore::uint32					 m_nNumOfVisibleOccluders;	/**< Number of occluders rasterized by the last update */
+		PLCore::uint32					 m_nNumOfTestedMeshes;		/**< Number of meshes tested by the last update */
+		PLCore::uint32					 m_nNumOfTileHits;			/**< Number of meshes culled by their tiles alone within the last update */
+		PLCore::uint32					 m_nNumOfPixelHits;			/**< Number of meshes which required a test of their pixels within the last update */
+		PLCore::uint32					 m_nNumOfCulledMeshes;		/**< Number of meshes hidden by the last update */
+		PLCore::uint32					 m_nNumOfKeptCasters;		/**< Number of occluded meshes kept visible by the last update because they cast shadows into the visible part of the scene */
+
+
+};
+
+
+#endif // __DUNGEON_OCCLUSIONCULLER_H__
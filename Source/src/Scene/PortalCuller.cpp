@@ -0,0 +1,577 @@
+/*********************************************************\
+ *  File: PortalCuller.cpp                               *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLCore/String/Tokenizer.h>
+#include <PLMath/Math.h>
+#include <PLMath/Plane.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Scene/LooseOctree.h"
+#include "Scene/SpatialIndex.h"
+#include "Scene/PotentiallyVisibleSet.h"
+#include "Scene/PortalCuller.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float PortalDistance = 0.1f;	/**< A camera closer to a portal plane than this is within the portal, the portal is not clipped then */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the transform of a scene node relative to one of its parent scene containers
+*/
+static Matrix3x4 GetRelativeTransform(SceneNode &cSceneNode, const SceneNode *pContainer)
+{
+	Matrix3x4 mTransform = cSceneNode.GetTransform().GetMatrix();
+	for (SceneContainer *pParent=cSceneNode.GetContainer(); pParent && pParent!=pContainer; pParent=pParent->GetContainer())
+		mTransform = pParent->GetTransform().GetMatrix()*mTransform;
+	return mTransform;
+}
+
+/**
+*  @brief
+*    Returns the signed distance of a point to a plane
+*/
+static float GetDistance(const Plane &cPlane, const Vector3 &vPoint)
+{
+	return cPlane.a*vPoint.x + cPlane.b*vPoint.y + cPlane.c*vPoint.z + cPlane.d;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PortalCuller::PortalCuller() :
+	m_pPotentiallyVisibleSet(nullptr),
+	m_bPotentiallyVisibleSetUsed(false),
+	m_nStamp(0),
+	m_nNumOfVisitedCells(0),
+	m_nNumOfTraversedPortals(0),
+	m_nNumOfTestedSceneNodes(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+PortalCuller::~PortalCuller()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Gathers the cells and cell portals of a scene container
+*/
+bool PortalCuller::Build(SceneContainer &cContainer, const SpatialIndex &cSpatialIndex)
+{
+	Clear();
+	if (!m_cCellGraph.Build(cContainer))
+		return false; // Error!
+
+	// Add the cells
+	for (uint32 i=0; i<m_cCellGraph.GetNumOfCells(); i++) {
+		SceneContainer *pCell = m_cCellGraph.GetCell(i);
+		Cell *pCullerCell = new Cell;
+		pCullerCell->cCell.SetElement(pCell);
+		pCullerCell->pOctree = cSpatialIndex.GetOctree(*pCell);
+		pCullerCell->lstStamps.Resize(pCullerCell->pOctree ? pCullerCell->pOctree->GetNumOfEntries() : 0);
+		for (uint32 j=0; j<pCullerCell->lstStamps.GetNumOfElements(); j++)
+			pCullerCell->lstStamps[j] = 0;
+		pCullerCell->nStamp	 = 0;
+		pCullerCell->bHidden = false;
+		m_lstCells.Add(pCullerCell);
+	}
+
+	// Add the cell portals
+	for (uint32 i=0; i<m_cCellGraph.GetNumOfCells(); i++)
+		AddPortals(i, *m_cCellGraph.GetCell(i));
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Makes all cells visible again and removes them
+*/
+void PortalCuller::Clear()
+{
+	ApplyVisibility(true);
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+	for (uint32 i=0; i<m_lstPortals.GetNumOfElements(); i++)
+		delete m_lstPortals[i];
+	m_lstPortals.Clear();
+	m_lstVisibleSceneNodes.Clear();
+	m_cCellGraph.Clear();
+	m_pPotentiallyVisibleSet	 = nullptr;
+	m_bPotentiallyVisibleSetUsed = false;
+	m_nNumOfVisitedCells	 = 0;
+	m_nNumOfTraversedPortals = 0;
+	m_nNumOfTestedSceneNodes = 0;
+}
+
+/**
+*  @brief
+*    Determines the visible cells and scene nodes
+*/
+void PortalCuller::Update(SceneNode *pCamera, float fAspect)
+{
+	// Reset the results of the previous update
+	BeginUpdate();
+
+	// Get the cell the camera is in, without one there's nothing to cull
+	const uint32 nCameraCell = pCamera ? m_cCellGraph.GetCellIndex(*pCamera) : CellGraph::InvalidCell;
+	if (nCameraCell == CellGraph::InvalidCell) {
+		ApplyVisibility(true);
+		return;
+	}
+	const SceneNode *pCameraCell = m_lstCells[nCameraCell]->cCell.GetElement();
+
+	// Get the camera settings, a vertical field of view is assumed (a horizontal one just gives a larger frustum)
+	const DynVar *pFOV	  = pCamera->GetAttribute("FOV");
+	const DynVar *pAspect = pCamera->GetAttribute("Aspect");
+	const DynVar *pZFar	  = pCamera->GetAttribute("ZFar");
+	const float fTan	  = Math::Tan(static_cast<float>((pFOV ? pFOV->GetFloat() : 45.0f)*0.5f*Math::DegToRad));
+	const float fZFar	  = pZFar ? pZFar->GetFloat() : 1000.0f;
+	fAspect *= pAspect ? pAspect->GetFloat() : 1.0f;
+
+	// Get the camera position within the space of the cell
+	const Matrix3x4 mCamera = GetRelativeTransform(*pCamera, pCameraCell);
+	const Vector3 vEye = mCamera*Vector3::Zero;
+
+	// Within a region of the potentially visible set, the visible cells and scene nodes are just looked up
+	const uint32 nRegion = m_pPotentiallyVisibleSet ? m_pPotentiallyVisibleSet->GetRegion(nCameraCell, vEye) : PotentiallyVisibleSet::NoRegion;
+	if (nRegion != PotentiallyVisibleSet::NoRegion) {
+		m_bPotentiallyVisibleSetUsed = true;
+		for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+			// Evicted cells stay invisible, just like within the traversal
+			Cell &cCell = *m_lstCells[i];
+			const SceneNode *pCell = cCell.cCell.GetElement();
+			const uint32 *pnSceneNodes = m_pPotentiallyVisibleSet->GetSceneNodes(nRegion, i);
+			if (pnSceneNodes && pCell && pCell->IsActive()) {
+				cCell.nStamp = m_nStamp;
+				m_nNumOfVisitedCells++;
+				for (uint32 nEntry=0; nEntry<cCell.lstStamps.GetNumOfElements(); nEntry++) {
+					if (pnSceneNodes[nEntry/32] & (1u << (nEntry%32))) {
+						cCell.lstStamps[nEntry] = m_nStamp;
+						SceneNode *pSceneNode = cCell.pOctree->GetSceneNode(nEntry);
+						if (pSceneNode)
+							m_lstVisibleSceneNodes.Add(pSceneNode);
+					}
+				}
+			}
+		}
+	} else {
+		// Traverse the cells with the view frustum, the camera looks along its z axis
+		Vector3 vForward = mCamera*Vector3::UnitZ - vEye;
+		Vector3 vUp		 = mCamera*Vector3::UnitY - vEye;
+		Vector3 vSide	 = mCamera*Vector3::UnitX - vEye;
+		vForward.Normalize();
+		vUp.Normalize();
+		vSide.Normalize();
+		Traverse(nCameraCell, vEye, vForward, vUp, vSide, fTan*fAspect, fTan, fZFar);
+	}
+
+	// Hide the cells which were not reached
+	ApplyVisibility(false);
+}
+
+/**
+*  @brief
+*    Starts sampling the visible cells and scene nodes of several views
+*/
+void PortalCuller::BeginSampling()
+{
+	BeginUpdate();
+}
+
+/**
+*  @brief
+*    Adds the visible cells and scene nodes of a view to the current samples
+*/
+void PortalCuller::Sample(uint32 nCell, const Vector3 &vEye, const Vector3 &vForward, const Vector3 &vUp, const Vector3 &vSide, float fTanX, float fTanY, float fZFar)
+{
+	if (nCell < m_lstCells.GetNumOfElements())
+		Traverse(nCell, vEye, vForward, vUp, vSide, fTanX, fTanY, fZFar);
+}
+
+/**
+*  @brief
+*    Sets the potentially visible set
+*/
+void PortalCuller::SetPotentiallyVisibleSet(const PotentiallyVisibleSet *pPotentiallyVisibleSet)
+{
+	m_pPotentiallyVisibleSet = pPotentiallyVisibleSet;
+}
+
+/**
+*  @brief
+*    Returns the number of cells
+*/
+uint32 PortalCuller::GetNumOfCells() const
+{
+	return m_lstCells.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns a cell
+*/
+SceneContainer *PortalCuller::GetCell(uint32 nCell) const
+{
+	return (nCell < m_lstCells.GetNumOfElements()) ? static_cast<SceneContainer*>(m_lstCells[nCell]->cCell.GetElement()) : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the octree of a cell
+*/
+const LooseOctree *PortalCuller::GetOctree(uint32 nCell) const
+{
+	return (nCell < m_lstCells.GetNumOfElements()) ? m_lstCells[nCell]->pOctree : nullptr;
+}
+
+/**
+*  @brief
+*    Returns whether or not a cell was found visible by the last update or the current samples
+*/
+bool PortalCuller::IsCellVisible(uint32 nCell) const
+{
+	return (nCell < m_lstCells.GetNumOfElements() && m_lstCells[nCell]->nStamp == m_nStamp);
+}
+
+/**
+*  @brief
+*    Returns whether or not a scene node was found visible by the last update or the current samples
+*/
+bool PortalCuller::IsSceneNodeVisible(uint32 nCell, uint32 nEntry) const
+{
+	return (nCell < m_lstCells.GetNumOfElements() && nEntry < m_lstCells[nCell]->lstStamps.GetNumOfElements() && m_lstCells[nCell]->lstStamps[nEntry] == m_nStamp);
+}
+
+/**
+*  @brief
+*    Returns the number of visible scene nodes
+*/
+uint32 PortalCuller::GetNumOfVisibleSceneNodes() const
+{
+	return m_lstVisibleSceneNodes.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns a visible scene node
+*/
+SceneNode *PortalCuller::GetVisibleSceneNode(uint32 nIndex) const
+{
+	return (nIndex < m_lstVisibleSceneNodes.GetNumOfElements()) ? m_lstVisibleSceneNodes[nIndex] : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the counters of the last update as string
+*/
+String PortalCuller::ToString() const
+{
+	return String::Format("Cells=\"%u\" Portals=\"%u\" Tested=\"%u\" Visible=\"%u\" PVS=\"%u\"",
+						  m_nNumOfVisitedCells, m_nNumOfTraversedPortals, m_nNumOfTestedSceneNodes, m_lstVisibleSceneNodes.GetNumOfElements(), m_bPotentiallyVisibleSetUsed ? 1 : 0);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+PortalCuller::PortalCuller(const PortalCuller &cSource) :
+	m_pPotentiallyVisibleSet(nullptr),
+	m_bPotentiallyVisibleSetUsed(false),
+	m_nStamp(0),
+	m_nNumOfVisitedCells(0),
+	m_nNumOfTraversedPortals(0),
+	m_nNumOfTestedSceneNodes(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+PortalCuller &PortalCuller::operator =(const PortalCuller &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Adds the cell portals within a container
+*/
+void PortalCuller::AddPortals(uint32 nCell, SceneContainer &cContainer)
+{
+	SceneContainer &cCell = *m_cCellGraph.GetCell(nCell);
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			if (pSceneNode->IsInstanceOf("PLScene::SNCellPortal")) {
+				// Get the target cell, the target is relative to the container the portal is in (e.g. "Parent.kanal5")
+				const DynVar *pTargetCell = pSceneNode->GetAttribute("TargetCell");
+				const DynVar *pVertices	  = pSceneNode->GetAttribute("Vertices");
+				SceneNode *pTargetSceneNode = pTargetCell ? cContainer.GetByName(pTargetCell->GetString()) : nullptr;
+				const uint32 nTargetCell = pTargetSceneNode ? m_cCellGraph.GetCellIndex(*pTargetSceneNode) : CellGraph::InvalidCell;
+				if (pVertices && nTargetCell != CellGraph::InvalidCell && nTargetCell != nCell) {
+					// Get the portal polygon within the space of the cell, the vertices are within the space of the portal
+					Array<float> lstCoordinates;
+					Tokenizer cTokenizer;
+					cTokenizer.Start(pVertices->GetString());
+					for (String sToken=cTokenizer.GetNextToken(); sToken.GetLength(); sToken=cTokenizer.GetNextToken())
+						lstCoordinates.Add(sToken.GetFloat());
+					cTokenizer.Stop();
+					if (lstCoordinates.GetNumOfElements() >= 9) {
+						const Matrix3x4 mPortal = GetRelativeTransform(*pSceneNode, &cCell);
+						Portal *pPortal = new Portal;
+						pPortal->nTargetCell = nTargetCell;
+						for (uint32 j=0; j+2<lstCoordinates.GetNumOfElements(); j+=3)
+							pPortal->lstVertices.Add(mPortal*Vector3(lstCoordinates[j], lstCoordinates[j+1], lstCoordinates[j+2]));
+
+						// The cells are directly within the same scene container
+						pPortal->mTransform = m_cCellGraph.GetCell(nTargetCell)->GetTransform().GetMatrix().GetInverted()*cCell.GetTransform().GetMatrix();
+						m_lstCells[nCell]->lstPortals.Add(m_lstPortals.GetNumOfElements());
+						m_lstPortals.Add(pPortal);
+					}
+				}
+			} else if (pSceneNode->IsContainer() && !pSceneNode->IsInstanceOf("PLScene::SCCell")) {
+				// Portals may be within containers inside the cell
+				AddPortals(nCell, static_cast<SceneContainer&>(*pSceneNode));
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Resets the results of the previous update
+*/
+void PortalCuller::BeginUpdate()
+{
+	m_nStamp++;
+	m_lstVisibleSceneNodes.Reset();
+	m_bPotentiallyVisibleSetUsed = false;
+	m_nNumOfVisitedCells		 = 0;
+	m_nNumOfTraversedPortals	 = 0;
+	m_nNumOfTestedSceneNodes	 = 0;
+}
+
+/**
+*  @brief
+*    Traverses the cells with a view frustum
+*/
+void PortalCuller::Traverse(uint32 nCell, const Vector3 &vEye, const Vector3 &vForward, const Vector3 &vUp, const Vector3 &vSide, float fTanX, float fTanY, float fZFar)
+{
+	// The frustum passes through its far rectangle
+	Frustum sFrustum;
+	sFrustum.vEye = vEye;
+	const Vector3 vFarCenter = vEye + vForward*fZFar;
+	const Vector3 vFarUp	 = vUp*(fZFar*fTanY);
+	const Vector3 vFarSide	 = vSide*(fZFar*fTanX);
+	sFrustum.lstPolygon.Add(vFarCenter - vFarSide - vFarUp);
+	sFrustum.lstPolygon.Add(vFarCenter + vFarSide - vFarUp);
+	sFrustum.lstPolygon.Add(vFarCenter + vFarSide + vFarUp);
+	sFrustum.lstPolygon.Add(vFarCenter - vFarSide + vFarUp);
+	sFrustum.vFarPoint	= vFarCenter;
+	sFrustum.vFarNormal = -vForward;
+
+	// Traverse the cells
+	m_lstPath.Reset();
+	VisitCell(nCell, sFrustum, 0);
+}
+
+/**
+*  @brief
+*    Visits a cell and traverses its portals
+*/
+void PortalCuller::VisitCell(uint32 nCell, const Frustum &sFrustum, uint32 nDepth)
+{
+	Cell &cCell = *m_lstCells[nCell];
+	if (cCell.nStamp != m_nStamp) {
+		cCell.nStamp = m_nStamp;
+		m_nNumOfVisitedCells++;
+	}
+
+	// Test the scene nodes of the cell, a cell reached through several portals reports each scene node once
+	Array<Plane> lstPlanes;
+	GetPlanes(sFrustum, lstPlanes);
+	if (cCell.pOctree) {
+		Array<uint32> lstEntries;
+		m_nNumOfTestedSceneNodes += cCell.pOctree->QueryFrustum(lstPlanes.GetData(), lstPlanes.GetNumOfElements(), lstEntries);
+		for (uint32 i=0; i<lstEntries.GetNumOfElements(); i++) {
+			const uint32 nEntry = lstEntries[i];
+			if (cCell.lstStamps[nEntry] != m_nStamp) {
+				cCell.lstStamps[nEntry] = m_nStamp;
+				SceneNode *pSceneNode = cCell.pOctree->GetSceneNode(nEntry);
+				if (pSceneNode)
+					m_lstVisibleSceneNodes.Add(pSceneNode);
+			}
+		}
+	}
+	if (nDepth >= MaxPortalDepth)
+		return;
+
+	// Traverse the portals
+	m_lstPath.Add(nCell);
+	for (uint32 i=0; i<cCell.lstPortals.GetNumOfElements(); i++) {
+		const Portal &sPortal = *m_lstPortals[cCell.lstPortals[i]];
+
+		// Don't go back along the current path and don't enter evicted cells
+		const SceneNode *pTargetCell = m_lstCells[sPortal.nTargetCell]->cCell.GetElement();
+		if (m_lstPath.IsElement(sPortal.nTargetCell) || !pTargetCell || !pTargetCell->IsActive())
+			continue;
+
+		// Clip the portal polygon against the frustum, a camera within the portal sees through it unclipped
+		const Vector3 vNormal = (sPortal.lstVertices[1] - sPortal.lstVertices[0]).CrossProduct(sPortal.lstVertices[2] - sPortal.lstVertices[0]).Normalize();
+		Array<Vector3> lstPolygon;
+		if (Math::Abs(vNormal.DotProduct(sFrustum.vEye - sPortal.lstVertices[0])) < PortalDistance) {
+			lstPolygon = sFrustum.lstPolygon;
+		} else {
+			lstPolygon = sPortal.lstVertices;
+			for (uint32 j=0; j<lstPlanes.GetNumOfElements() && lstPolygon.GetNumOfElements()>=3; j++)
+				ClipPolygon(lstPolygon, lstPlanes[j]);
+			if (lstPolygon.GetNumOfElements() < 3)
+				continue; // The portal is not visible
+		}
+
+		// Build the frustum through the portal within the space of the target cell
+		Frustum sPortalFrustum;
+		sPortalFrustum.vEye = sPortal.mTransform*sFrustum.vEye;
+		for (uint32 j=0; j<lstPolygon.GetNumOfElements(); j++)
+			sPortalFrustum.lstPolygon.Add(sPortal.mTransform*lstPolygon[j]);
+		sPortalFrustum.vFarPoint  = sPortal.mTransform*sFrustum.vFarPoint;
+		sPortalFrustum.vFarNormal = sPortal.mTransform*(sFrustum.vFarPoint + sFrustum.vFarNormal) - sPortalFrustum.vFarPoint;
+		m_nNumOfTraversedPortals++;
+		VisitCell(sPortal.nTargetCell, sPortalFrustum, nDepth + 1);
+	}
+	m_lstPath.RemoveAtIndex(m_lstPath.GetNumOfElements() - 1);
+}
+
+/**
+*  @brief
+*    Sets the visibility of the cells to the result of the traversal
+*/
+void PortalCuller::ApplyVisibility(bool bAll)
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		Cell &cCell = *m_lstCells[i];
+		SceneNode *pCell = cCell.cCell.GetElement();
+		if (pCell) {
+			// Only cells hidden by the culler are made visible again, cells hidden by someone else stay hidden
+			const bool bVisible = bAll || cCell.nStamp == m_nStamp;
+			if (bVisible && cCell.bHidden) {
+				pCell->SetVisible(true);
+				cCell.bHidden = false;
+			} else if (!bVisible && !cCell.bHidden && pCell->IsVisible()) {
+				pCell->SetVisible(false);
+				cCell.bHidden = true;
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the planes of a frustum
+*/
+void PortalCuller::GetPlanes(const Frustum &sFrustum, Array<Plane> &lstPlanes)
+{
+	// The center of the polygon is inside of the frustum, it gives the planes built from the eye their orientation
+	const uint32 nNumOfVertices = sFrustum.lstPolygon.GetNumOfElements();
+	Vector3 vCenter = Vector3::Zero;
+	for (uint32 i=0; i<nNumOfVertices; i++)
+		vCenter += sFrustum.lstPolygon[i];
+	if (nNumOfVertices)
+		vCenter /= static_cast<float>(nNumOfVertices);
+
+	// One plane through the eye per polygon edge
+	for (uint32 i=0; i<nNumOfVertices; i++) {
+		const Vector3 &vV0 = sFrustum.lstPolygon[i];
+		const Vector3 &vV1 = sFrustum.lstPolygon[(i+1)%nNumOfVertices];
+		Vector3 vNormal = (vV0 - sFrustum.vEye).CrossProduct(vV1 - sFrustum.vEye);
+		const float fLength = vNormal.GetLength();
+		if (fLength > Math::Epsilon) {
+			vNormal /= fLength;
+			if (vNormal.DotProduct(vCenter - sFrustum.vEye) < 0.0f)
+				vNormal = -vNormal;
+			lstPlanes.Add(Plane(vNormal.x, vNormal.y, vNormal.z, -vNormal.DotProduct(sFrustum.vEye)));
+		}
+	}
+
+	// Far plane
+	const Vector3 &vFarNormal = sFrustum.vFarNormal;
+	lstPlanes.Add(Plane(vFarNormal.x, vFarNormal.y, vFarNormal.z, -vFarNormal.DotProduct(sFrustum.vFarPoint)));
+}
+
+/**
+*  @brief
+*    Clips a convex polygon against a plane
+*/
+void PortalCuller::ClipPolygon(Array<Vector3> &lstPolygon, const Plane &cPlane)
+{
+	Array<Vector3> lstClipped;
+	const uint32 nNumOfVertices = lstPolygon.GetNumOfElements();
+	for (uint32 i=0; i<nNumOfVertices; i++) {
+		const Vector3 &vV0 = lstPolygon[i];
+		const Vector3 &vV1 = lstPolygon[(i+1)%nNumOfVertices];
+		const float fDistance0 = GetDistance(cPlane, vV0);
+		const float fDistance1 = GetDistance(cPlane, vV1);
+		if (fDistance0 >= 0.0f)
+			lstClipped.Add(vV0);
+		if ((fDistance0 >= 0.0f) != (fDistance1 >= 0.0f))
+			lstClipped.Add(vV0 + (vV1 - vV0)*(fDistance0/(fDistance0 - fDistance1)));
+	}
+	lstPolygon = lstClipped;
+}
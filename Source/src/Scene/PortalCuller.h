@@ -0,0 +1,441 @@
+/*********************************************************\
+ *  File: PortalCuller.h                                 *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_PORTALCULLER_H__
+#define __DUNGEON_PORTALCULLER_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLMath/Matrix3x4.h>
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Scene/CellGraph.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Plane;
+}
+namespace PLScene {
+	class SceneContainer;
+}
+class LooseOctree;
+class SpatialIndex;
+class PotentiallyVisibleSet;
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Portal based visibility culling of the cells
+*
+*  @remarks
+*    Once per frame the cells are traversed through their cell portals, starting with the cell the camera is in. The
+*    view frustum is clipped by each traversed portal polygon, a cell is visible if the frustum clipped down to it is
+*    not empty. The cells which are not reached are set invisible, so the renderer doesn't traverse them at all. The
+*    scene nodes of the visible cells are tested against the clipped frustum of their cell by using the octree of the
+*    cell (see "SpatialIndex"), the frustum culling of the single scene nodes is still done by the renderer.
+*
+*    If a potentially visible set is set and the camera is within one of its regions, the visible cells and scene
+*    nodes are looked up instead of traversing the portals. The potentially visible set is computed offline by
+*    sampling views through this culler (see "BeginSampling()" and "Sample()").
+*
+*    A frustum is kept as the camera position (eye), a convex polygon the frustum passes through and a far plane.
+*    Portal traversal clips the portal polygon against the frustum and builds the next frustum from the eye and the
+*    clipped polygon, so the frustums get narrower with each portal.
+*/
+class PortalCuller {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 MaxPortalDepth = 16;	/**< Maximum number of portals traversed in a row */
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		PortalCuller();
+
+		/**
+		*  @brief
+		*    Destructor
+		*
+		*  @note
+		*    - The hidden cells are made visible again
+		*/
+		~PortalCuller();
+
+		/**
+		*  @brief
+		*    Gathers the cells and cell portals of a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container the cells are in (e.g. the physics world container of the dungeon)
+		*  @param[in] cSpatialIndex
+		*    Spatial index of the scene container, must stay valid as long as this culler is used
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (no cells found)
+		*/
+		bool Build(PLScene::SceneContainer &cContainer, const SpatialIndex &cSpatialIndex);
+
+		/**
+		*  @brief
+		*    Makes all cells visible again and removes them
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Determines the visible cells and scene nodes
+		*
+		*  @param[in] pCamera
+		*    Camera scene node ("PLScene::SNCamera"), can be a null pointer
+		*  @param[in] fAspect
+		*    Width to height ratio of the viewport
+		*
+		*  @note
+		*    - If there's no camera or it's not within a cell, all cells are visible
+		*/
+		void Update(PLScene::SceneNode *pCamera, float fAspect);
+
+		/**
+		*  @brief
+		*    Starts sampling the visible cells and scene nodes of several views
+		*
+		*  @note
+		*    - Resets the results of the last update or samples, the visibility of the cells is not changed
+		*/
+		void BeginSampling();
+
+		/**
+		*  @brief
+		*    Adds the visible cells and scene nodes of a view to the current samples
+		*
+		*  @param[in] nCell
+		*    Index of the cell the view is in
+		*  @param[in] vEye
+		*    View position within the space of the cell
+		*  @param[in] vForward
+		*    Normalized view direction within the space of the cell
+		*  @param[in] vUp
+		*    Normalized up direction within the space of the cell
+		*  @param[in] vSide
+		*    Normalized side direction within the space of the cell
+		*  @param[in] fTanX
+		*    Tangent of the half horizontal field of view
+		*  @param[in] fTanY
+		*    Tangent of the half vertical field of view
+		*  @param[in] fZFar
+		*    View distance
+		*
+		*  @note
+		*    - The potentially visible set is not used, the portals are always traversed
+		*/
+		void Sample(PLCore::uint32 nCell, const PLMath::Vector3 &vEye, const PLMath::Vector3 &vForward, const PLMath::Vector3 &vUp,
+					const PLMath::Vector3 &vSide, float fTanX, float fTanY, float fZFar);
+
+		/**
+		*  @brief
+		*    Sets the potentially visible set
+		*
+		*  @param[in] pPotentiallyVisibleSet
+		*    Potentially visible set matching the cells of this culler, must stay valid as long as it's set, can be a null pointer
+		*/
+		void SetPotentiallyVisibleSet(const PotentiallyVisibleSet *pPotentiallyVisibleSet);
+
+		/**
+		*  @brief
+		*    Returns the number of cells
+		*
+		*  @return
+		*    The number of cells
+		*/
+		PLCore::uint32 GetNumOfCells() const;
+
+		/**
+		*  @brief
+		*    Returns a cell
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @return
+		*    The cell scene container, null pointer on error
+		*/
+		PLScene::SceneContainer *GetCell(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns the octree of a cell
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @return
+		*    The octree of the cell, null pointer on error
+		*/
+		const LooseOctree *GetOctree(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns whether or not a cell was found visible by the last update or the current samples
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @return
+		*    'true' if the cell was found visible, else 'false'
+		*/
+		bool IsCellVisible(PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns whether or not a scene node was found visible by the last update or the current samples
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*  @param[in] nEntry
+		*    Index of the octree entry of the scene node
+		*
+		*  @return
+		*    'true' if the scene node was found visible, else 'false'
+		*/
+		bool IsSceneNodeVisible(PLCore::uint32 nCell, PLCore::uint32 nEntry) const;
+
+		/**
+		*  @brief
+		*    Returns the number of visible scene nodes
+		*
+		*  @return
+		*    The number of scene nodes within the visible cells which touch the clipped frustums
+		*/
+		PLCore::uint32 GetNumOfVisibleSceneNodes() const;
+
+		/**
+		*  @brief
+		*    Returns a visible scene node
+		*
+		*  @param[in] nIndex
+		*    Index of the visible scene node
+		*
+		*  @return
+		*    The visible scene node, null pointer on error
+		*/
+		PLScene::SceneNode *GetVisibleSceneNode(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the counters of the last update as string
+		*
+		*  @return
+		*    The counters as string (e.g. "Cells=\"3\" Portals=\"4\" Tested=\"412\" Visible=\"128\" PVS=\"0\"")
+		*/
+		PLCore::String ToString() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Cell portal
+		*/
+		struct Portal {
+			PLCore::uint32					nTargetCell;	/**< Index of the cell the portal leads into */
+			PLCore::Array<PLMath::Vector3>	lstVertices;	/**< Portal polygon within the space of the cell the portal is in */
+			PLMath::Matrix3x4				mTransform;		/**< Transforms from the space of the cell the portal is in into the space of the target cell */
+		};
+
+		/**
+		*  @brief
+		*    Cell
+		*/
+		struct Cell {
+			PLScene::SceneNodeHandler		cCell;			/**< Cell scene container */
+			const LooseOctree			   *pOctree;		/**< Octree of the cell, can be a null pointer */
+			PLCore::Array<PLCore::uint32>	lstPortals;		/**< Indices of the portals within the cell */
+			PLCore::Array<PLCore::uint32>	lstStamps;		/**< Update the octree entries were found visible the last time, per octree entry */
+			PLCore::uint32					nStamp;			/**< Update the cell was visited the last time */
+			bool							bHidden;		/**< Was the cell set invisible by the culler? */
+		};
+
+		/**
+		*  @brief
+		*    Frustum within the space of a cell
+		*/
+		struct Frustum {
+			PLMath::Vector3					vEye;			/**< Camera position */
+			PLCore::Array<PLMath::Vector3>	lstPolygon;		/**< Convex polygon the frustum passes through */
+			PLMath::Vector3					vFarPoint;		/**< Point on the far plane */
+			PLMath::Vector3					vFarNormal;		/**< Normal of the far plane, pointing into the frustum */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		PortalCuller(const PortalCuller &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		PortalCuller &operator =(const PortalCuller &cSource);
+
+		/**
+		*  @brief
+		*    Adds the cell portals within a container
+		*
+		*  @param[in] nCell
+		*    Index of the cell the container is in
+		*  @param[in] cContainer
+		*    Container to search for cell portals (the cell itself or a container within it)
+		*/
+		void AddPortals(PLCore::uint32 nCell, PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Resets the results of the previous update
+		*/
+		void BeginUpdate();
+
+		/**
+		*  @brief
+		*    Traverses the cells with a view frustum
+		*
+		*  @param[in] nCell
+		*    Index of the cell the view is in
+		*  @param[in] vEye
+		*    View position within the space of the cell
+		*  @param[in] vForward
+		*    Normalized view direction within the space of the cell
+		*  @param[in] vUp
+		*    Normalized up direction within the space of the cell
+		*  @param[in] vSide
+		*    Normalized side direction within the space of the cell
+		*  @param[in] fTanX
+		*    Tangent of the half horizontal field of view
+		*  @param[in] fTanY
+		*    Tangent of the half vertical field of view
+		*  @param[in] fZFar
+		*    View distance
+		*/
+		void Traverse(PLCore::uint32 nCell, const PLMath::Vector3 &vEye, const PLMath::Vector3 &vForward, const PLMath::Vector3 &vUp,
+					  const PLMath::Vector3 &vSide, float fTanX, float fTanY, float fZFar);
+
+		/**
+		*  @brief
+		*    Visits a cell and traverses its portals
+		*
+		*  @param[in] nCell
+		*    Index of the cell
+		*  @param[in] sFrustum
+		*    Frustum within the space of the cell
+		*  @param[in] nDepth
+		*    Number of portals traversed to reach the cell
+		*/
+		void VisitCell(PLCore::uint32 nCell, const Frustum &sFrustum, PLCore::uint32 nDepth);
+
+		/**
+		*  @brief
+		*    Sets the visibility of the cells to the result of the traversal
+		*
+		*  @param[in] bAll
+		*    Make all cells visible?
+		*/
+		void ApplyVisibility(bool bAll);
+
+		/**
+		*  @brief
+		*    Returns the planes of a frustum
+		*
+		*  @param[in]  sFrustum
+		*    Frustum
+		*  @param[out] lstPlanes
+		*    Receives the planes, the plane normals point into the frustum
+		*/
+		static void GetPlanes(const Frustum &sFrustum, PLCore::Array<PLMath::Plane> &lstPlanes);
+
+		/**
+		*  @brief
+		*    Clips a convex polygon against a plane
+		*
+		*  @param[in, out] lstPolygon
+		*    Polygon, receives the part in front of the plane
+		*  @param[in]      cPlane
+		*    Plane
+		*/
+		static void ClipPolygon(PLCore::Array<PLMath::Vector3> &lstPolygon, const PLMath::Plane &cPlane);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		CellGraph						  m_cCellGraph;					/**< Cell graph, used to find the cell the camera is in */
+		PLCore::Array<Cell*>			  m_lstCells;					/**< Cells, same order as within the cell graph */
+		PLCore::Array<Portal*>			  m_lstPortals;					/**< Cell portals */
+		PLCore::Array<PLCore::uint32>	  m_lstPath;					/**< Cells of the current traversal path, no cell is entered twice along a path */
+		PLCore::Array<PLScene::SceneNode*> m_lstVisibleSceneNodes;		/**< Visible scene nodes of the last update */
+		const PotentiallyVisibleSet		 *m_pPotentiallyVisibleSet;		/**< Potentially visible set, can be a null pointer */
+		bool							  m_bPotentiallyVisibleSetUsed;	/**< Was the potentially visible set used by the last update? */
+		PLCore::uint32					  m_nStamp;						/**< Update counter */
+		PLCore::uint32					  m_nNumOfVisitedCells;			/**< Number of cells visited by the last update */
+		PLCore::uint32					  m_nNumOfTraversedPortals;		/**< Number of portals traversed by the last update */
+		PLCore::uint32					  m_nNumOfTestedSceneNodes;		/**< Number of scene node bounding boxes tested by the last update */
+
+
+};
+
+
+#endif // __DUNGEON_PORTALCULLER_H__
@@ -0,0 +1,409 @@
+/*********************************************************\
+ *  File: PotentiallyVisibleSet.cpp                      *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/File.h>
+#include <PLMath/Math.h>
+#include <PLMath/Vector3.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include "Tools/Trace.h"
+#include "Scene/LooseOctree.h"
+#include "Scene/PortalCuller.h"
+#include "Physics/PhysicsCacheArchive.h"
+#include "Scene/PotentiallyVisibleSet.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float ViewTangent	= 1.05f;	/**< Tangent of the half field of view of the sample views, a bit more than 45 degrees so the six views overlap */
+static const float ViewDistance = 1000.0f;	/**< View distance of the sample views */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the number of 32 bit words required for the given number of bits
+*/
+static uint32 GetNumOfWords(uint32 nNumOfBits)
+{
+	return (nNumOfBits + 31)/32;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+PotentiallyVisibleSet::PotentiallyVisibleSet()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+PotentiallyVisibleSet::~PotentiallyVisibleSet()
+{
+}
+
+/**
+*  @brief
+*    Computes the potentially visible set
+*/
+uint32 PotentiallyVisibleSet::Compute(PortalCuller &cPortalCuller, float fRegionSize)
+{
+	TraceScope cTraceScope("PotentiallyVisibleSet::Compute", "Scene");
+
+	// Remove the previous potentially visible set
+	Clear();
+
+	// Six views along the axes cover all directions (forward, up, side)
+	static const Vector3 vViews[6][3] = {
+		{ Vector3( 1.0f,  0.0f,  0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3( 0.0f, 0.0f, -1.0f) },
+		{ Vector3(-1.0f,  0.0f,  0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3( 0.0f, 0.0f,  1.0f) },
+		{ Vector3( 0.0f,  1.0f,  0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3( 1.0f, 0.0f,  0.0f) },
+		{ Vector3( 0.0f, -1.0f,  0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(-1.0f, 0.0f,  0.0f) },
+		{ Vector3( 0.0f,  0.0f,  1.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3( 1.0f, 0.0f,  0.0f) },
+		{ Vector3( 0.0f,  0.0f, -1.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(-1.0f, 0.0f,  0.0f) }
+	};
+
+	// Setup the region grid of each cell around the bounding box of its scene nodes
+	const uint32 nNumOfCells = cPortalCuller.GetNumOfCells();
+	m_lstCells.Resize(nNumOfCells);
+	uint32 nNumOfRegions = 0;
+	for (uint32 nCell=0; nCell<nNumOfCells; nCell++) {
+		Cell &sCell = m_lstCells[nCell];
+		GetCell(cPortalCuller, nCell, sCell);
+		sCell.nFirstRegion = nNumOfRegions;
+		sCell.nReserved	   = 0;
+
+		// Get the bounding box of the scene nodes, a cell without scene nodes has no regions
+		const LooseOctree *pOctree = cPortalCuller.GetOctree(nCell);
+		Vector3 vMin, vMax;
+		for (uint32 nEntry=0; nEntry<sCell.nNumOfSceneNodes; nEntry++) {
+			Vector3 vEntryMin, vEntryMax;
+			pOctree->GetBoundingBox(nEntry, vEntryMin, vEntryMax);
+			if (nEntry) {
+				vMin = Vector3(Math::Min(vMin.x, vEntryMin.x), Math::Min(vMin.y, vEntryMin.y), Math::Min(vMin.z, vEntryMin.z));
+				vMax = Vector3(Math::Max(vMax.x, vEntryMax.x), Math::Max(vMax.y, vEntryMax.y), Math::Max(vMax.z, vEntryMax.z));
+			} else {
+				vMin = vEntryMin;
+				vMax = vEntryMax;
+			}
+		}
+		const float fMin[3] = { vMin.x, vMin.y, vMin.z };
+		const float fMax[3] = { vMax.x, vMax.y, vMax.z };
+		for (uint32 i=0; i<3; i++) {
+			const float fExtent = fMax[i] - fMin[i];
+			sCell.nNumOfRegions[i] = sCell.nNumOfSceneNodes ? Math::Min(Math::Max(static_cast<uint32>(fExtent/fRegionSize + 0.5f), 1u), MaxRegionsPerAxis) : 0;
+			sCell.fMin[i]		   = fMin[i];
+			sCell.fRegionSize[i]   = sCell.nNumOfRegions[i] ? fExtent/sCell.nNumOfRegions[i] : 0.0f;
+		}
+		nNumOfRegions += sCell.nNumOfRegions[0]*sCell.nNumOfRegions[1]*sCell.nNumOfRegions[2];
+	}
+
+	// Sample the regions
+	m_lstRegions.Resize(nNumOfRegions);
+	for (uint32 nCell=0; nCell<nNumOfCells; nCell++) {
+		const Cell &sCell = m_lstCells[nCell];
+		uint32 nRegion = sCell.nFirstRegion;
+		for (uint32 nZ=0; nZ<sCell.nNumOfRegions[2]; nZ++) {
+			for (uint32 nY=0; nY<sCell.nNumOfRegions[1]; nY++) {
+				for (uint32 nX=0; nX<sCell.nNumOfRegions[0]; nX++, nRegion++) {
+					// Sample the lattice of points within the region, including the region corners
+					cPortalCuller.BeginSampling();
+					for (uint32 nPoint=0; nPoint<SamplesPerAxis*SamplesPerAxis*SamplesPerAxis; nPoint++) {
+						const float fX = static_cast<float>(nPoint%SamplesPerAxis)/(SamplesPerAxis - 1);
+						const float fY = static_cast<float>(nPoint/SamplesPerAxis%SamplesPerAxis)/(SamplesPerAxis - 1);
+						const float fZ = static_cast<float>(nPoint/(SamplesPerAxis*SamplesPerAxis))/(SamplesPerAxis - 1);
+						const Vector3 vEye(sCell.fMin[0] + (nX + fX)*sCell.fRegionSize[0],
+										   sCell.fMin[1] + (nY + fY)*sCell.fRegionSize[1],
+										   sCell.fMin[2] + (nZ + fZ)*sCell.fRegionSize[2]);
+						for (uint32 nView=0; nView<6; nView++)
+							cPortalCuller.Sample(nCell, vEye, vViews[nView][0], vViews[nView][1], vViews[nView][2], ViewTangent, ViewTangent, ViewDistance);
+					}
+
+					// Store the visible cells, followed by the visible scene nodes of each visible cell
+					const uint32 nOffset = m_lstWords.GetNumOfElements();
+					m_lstRegions[nRegion] = nOffset;
+					for (uint32 i=0; i<::GetNumOfWords(nNumOfCells); i++)
+						m_lstWords.Add(0);
+					for (uint32 nVisibleCell=0; nVisibleCell<nNumOfCells; nVisibleCell++) {
+						if (cPortalCuller.IsCellVisible(nVisibleCell)) {
+							m_lstWords[nOffset + nVisibleCell/32] |= 1u << (nVisibleCell%32);
+							const uint32 nSceneNodes = m_lstWords.GetNumOfElements();
+							for (uint32 i=0; i<::GetNumOfWords(m_lstCells[nVisibleCell].nNumOfSceneNodes); i++)
+								m_lstWords.Add(0);
+							for (uint32 nEntry=0; nEntry<m_lstCells[nVisibleCell].nNumOfSceneNodes; nEntry++) {
+								if (cPortalCuller.IsSceneNodeVisible(nVisibleCell, nEntry))
+									m_lstWords[nSceneNodes + nEntry/32] |= 1u << (nEntry%32);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Done
+	return nNumOfRegions;
+}
+
+/**
+*  @brief
+*    Removes the potentially visible set
+*/
+void PotentiallyVisibleSet::Clear()
+{
+	m_lstCells.Clear();
+	m_lstRegions.Clear();
+	m_lstWords.Clear();
+}
+
+/**
+*  @brief
+*    Writes the potentially visible set into a file
+*/
+bool PotentiallyVisibleSet::Save(const String &sFilename) const
+{
+	// Open the file
+	File cFile(sFilename);
+	if (!cFile.Open(File::FileCreate | File::FileWrite))
+		return false; // Error!
+
+	// Write the header, the cells, the region offsets and the visibility words
+	Header sHeader;
+	sHeader.nMagic		  = Magic;
+	sHeader.nVersion	  = Version;
+	sHeader.nNumOfCells	  = m_lstCells.GetNumOfElements();
+	sHeader.nNumOfRegions = m_lstRegions.GetNumOfElements();
+	sHeader.nNumOfWords	  = m_lstWords.GetNumOfElements();
+	sHeader.nReserved	  = 0;
+	const bool bResult = (cFile.Write(&sHeader, sizeof(Header), 1) == 1 &&
+						  (!sHeader.nNumOfCells   || cFile.Write(m_lstCells.GetData(),   sizeof(Cell),   sHeader.nNumOfCells)   == sHeader.nNumOfCells) &&
+						  (!sHeader.nNumOfRegions || cFile.Write(m_lstRegions.GetData(), sizeof(uint32), sHeader.nNumOfRegions) == sHeader.nNumOfRegions) &&
+						  (!sHeader.nNumOfWords   || cFile.Write(m_lstWords.GetData(),   sizeof(uint32), sHeader.nNumOfWords)   == sHeader.nNumOfWords));
+	cFile.Close();
+
+	// Done
+	return bResult;
+}
+
+/**
+*  @brief
+*    Reads the potentially visible set from a file
+*/
+bool PotentiallyVisibleSet::Load(const String &sFilename, const PortalCuller &cPortalCuller)
+{
+	TraceScope cTraceScope("PotentiallyVisibleSet::Load", "Scene", sFilename);
+
+	// Remove the previous potentially visible set
+	Clear();
+
+	// Open the file
+	File cFile(sFilename);
+	if (!cFile.Open(File::FileRead))
+		return false; // Error!
+
+	// Read the header, it must match the cells of the portal culler
+	Header sHeader;
+	bool bValid = (cFile.Read(&sHeader, sizeof(Header), 1) == 1 && sHeader.nMagic == Magic && sHeader.nVersion == Version &&
+				   sHeader.nNumOfCells == cPortalCuller.GetNumOfCells() &&
+				   static_cast<uint64>(sizeof(Header)) + static_cast<uint64>(sHeader.nNumOfCells)*sizeof(Cell) +
+				   (static_cast<uint64>(sHeader.nNumOfRegions) + sHeader.nNumOfWords)*sizeof(uint32) == cFile.GetSize());
+
+	// Read the cells, the region offsets and the visibility words
+	if (bValid) {
+		m_lstCells.Resize(sHeader.nNumOfCells, true, false);
+		m_lstRegions.Resize(sHeader.nNumOfRegions, true, false);
+		m_lstWords.Resize(sHeader.nNumOfWords, true, false);
+		bValid = ((!sHeader.nNumOfCells   || cFile.Read(m_lstCells.GetData(),   sizeof(Cell),   sHeader.nNumOfCells)   == sHeader.nNumOfCells) &&
+				  (!sHeader.nNumOfRegions || cFile.Read(m_lstRegions.GetData(), sizeof(uint32), sHeader.nNumOfRegions) == sHeader.nNumOfRegions) &&
+				  (!sHeader.nNumOfWords   || cFile.Read(m_lstWords.GetData(),   sizeof(uint32), sHeader.nNumOfWords)   == sHeader.nNumOfWords));
+	}
+	cFile.Close();
+
+	// Check the cells against the portal culler and the region grids, so the getters don't need to
+	uint32 nNumOfRegions = 0;
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements() && bValid; nCell++) {
+		const Cell &sCell = m_lstCells[nCell];
+		Cell sCullerCell;
+		GetCell(cPortalCuller, nCell, sCullerCell);
+		bValid = (sCell.nNameHash == sCullerCell.nNameHash && sCell.nSceneNodesHash == sCullerCell.nSceneNodesHash &&
+				  sCell.nNumOfSceneNodes == sCullerCell.nNumOfSceneNodes && sCell.nFirstRegion == nNumOfRegions &&
+				  sCell.nNumOfRegions[0] <= MaxRegionsPerAxis && sCell.nNumOfRegions[1] <= MaxRegionsPerAxis && sCell.nNumOfRegions[2] <= MaxRegionsPerAxis);
+		nNumOfRegions += sCell.nNumOfRegions[0]*sCell.nNumOfRegions[1]*sCell.nNumOfRegions[2];
+	}
+	bValid = bValid && (nNumOfRegions == m_lstRegions.GetNumOfElements());
+
+	// Check the visibility words of the regions
+	for (uint32 nRegion=0; nRegion<m_lstRegions.GetNumOfElements() && bValid; nRegion++) {
+		const uint32 nCellWords = ::GetNumOfWords(m_lstCells.GetNumOfElements());
+		bValid = (m_lstRegions[nRegion] <= m_lstWords.GetNumOfElements() && nCellWords <= m_lstWords.GetNumOfElements() - m_lstRegions[nRegion] &&
+				  GetNumOfWords(nRegion) <= m_lstWords.GetNumOfElements() - m_lstRegions[nRegion]);
+	}
+	if (!bValid) {
+		Clear();
+		return false; // Error!
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the number of regions
+*/
+uint32 PotentiallyVisibleSet::GetNumOfRegions() const
+{
+	return m_lstRegions.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the region a position is in
+*/
+uint32 PotentiallyVisibleSet::GetRegion(uint32 nCell, const Vector3 &vPosition) const
+{
+	if (nCell < m_lstCells.GetNumOfElements()) {
+		const Cell &sCell = m_lstCells[nCell];
+		const float fPosition[3] = { vPosition.x, vPosition.y, vPosition.z };
+		uint32 nIndex[3];
+		for (uint32 i=0; i<3; i++) {
+			// A position on the maximum border still belongs to the last region
+			const float fRegion = sCell.fRegionSize[i] ? (fPosition[i] - sCell.fMin[i])/sCell.fRegionSize[i] : ((fPosition[i] == sCell.fMin[i]) ? 0.0f : -1.0f);
+			if (!sCell.nNumOfRegions[i] || fRegion < 0.0f || fRegion > sCell.nNumOfRegions[i])
+				return NoRegion; // Outside of the region grid
+			nIndex[i] = Math::Min(static_cast<uint32>(fRegion), sCell.nNumOfRegions[i] - 1);
+		}
+		return sCell.nFirstRegion + (nIndex[2]*sCell.nNumOfRegions[1] + nIndex[1])*sCell.nNumOfRegions[0] + nIndex[0];
+	}
+
+	// Error!
+	return NoRegion;
+}
+
+/**
+*  @brief
+*    Returns whether or not a cell is potentially visible from a region
+*/
+bool PotentiallyVisibleSet::IsCellVisible(uint32 nRegion, uint32 nCell) const
+{
+	return (nRegion < m_lstRegions.GetNumOfElements() && nCell < m_lstCells.GetNumOfElements() &&
+			(m_lstWords[m_lstRegions[nRegion] + nCell/32] & (1u << (nCell%32))) != 0);
+}
+
+/**
+*  @brief
+*    Returns the potentially visible scene nodes of a cell
+*/
+const uint32 *PotentiallyVisibleSet::GetSceneNodes(uint32 nRegion, uint32 nCell) const
+{
+	if (IsCellVisible(nRegion, nCell)) {
+		// The scene node bits of the visible cells follow the cell bits in cell order
+		uint32 nOffset = m_lstRegions[nRegion] + ::GetNumOfWords(m_lstCells.GetNumOfElements());
+		for (uint32 i=0; i<nCell; i++) {
+			if (IsCellVisible(nRegion, i))
+				nOffset += ::GetNumOfWords(m_lstCells[i].nNumOfSceneNodes);
+		}
+		return m_lstWords.GetData() + nOffset;
+	}
+
+	// Error!
+	return nullptr;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+PotentiallyVisibleSet::PotentiallyVisibleSet(const PotentiallyVisibleSet &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+PotentiallyVisibleSet &PotentiallyVisibleSet::operator =(const PotentiallyVisibleSet &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the cell record of a portal culler cell
+*/
+void PotentiallyVisibleSet::GetCell(const PortalCuller &cPortalCuller, uint32 nCell, Cell &sCell)
+{
+	// Hash the absolute cell name
+	const SceneContainer *pCell = cPortalCuller.GetCell(nCell);
+	const String sCellName = pCell ? pCell->GetAbsoluteName() : "";
+	sCell.nNameHash = PhysicsCacheArchive::GetHash(reinterpret_cast<const uint8*>(sCellName.GetASCII()), sCellName.GetLength());
+
+	// Hash the scene node names in octree entry order, including the terminating zeros so the names can't run into each other
+	const LooseOctree *pOctree = cPortalCuller.GetOctree(nCell);
+	sCell.nNumOfSceneNodes = pOctree ? pOctree->GetNumOfEntries() : 0;
+	sCell.nSceneNodesHash  = PhysicsCacheArchive::GetHash(nullptr, 0);
+	for (uint32 nEntry=0; nEntry<sCell.nNumOfSceneNodes; nEntry++) {
+		const SceneNode *pSceneNode = pOctree->GetSceneNode(nEntry);
+		const String sName = pSceneNode ? pSceneNode->GetName() : "";
+		sCell.nSceneNodesHash = PhysicsCacheArchive::GetHash(reinterpret_cast<const uint8*>(sName.GetASCII()), sName.GetLength() + 1, sCell.nSceneNodesHash);
+	}
+}
+
+/**
+*  @brief
+*    Returns the number of visibility words of a region
+*/
+uint32 PotentiallyVisibleSet::GetNumOfWords(uint32 nRegion) const
+{
+	uint32 nNumOfWords = ::GetNumOfWords(m_lstCells.GetNumOfElements());
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		if (IsCellVisible(nRegion, nCell))
+			nNumOfWords += ::GetNumOfWords(m_lstCells[nCell].nNumOfSceneNodes);
+	}
+	return nNumOfWords;
+}
@@ -0,0 +1,288 @@
+/*********************************************************\
+ *  File: PotentiallyVisibleSet.h                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_POTENTIALLYVISIBLESET_H__
+#define __DUNGEON_POTENTIALLYVISIBLESET_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLMath {
+	class Vector3;
+}
+class PortalCuller;
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Potentially visible set of the cells, precomputed offline
+*
+*  @remarks
+*    The bounding box of the scene nodes of each cell is split into a grid of regions. For each region, the cells
+*    and scene nodes visible from anywhere within the region are sampled by using the portal culler: A lattice of
+*    points within the region is sampled, from each point six views along the axes cover all directions. The
+*    results are stored as one bit per cell and one bit per octree entry of each visible cell (see "SpatialIndex").
+*    At runtime, the portal culler just looks the region of the camera up instead of traversing the portals.
+*
+*    The visibility between the sample points is approximated, the portal culler itself stays the reference. A
+*    stored potentially visible set only matches the scene it was computed for - each cell comes with a hash of its
+*    name and of the names of its scene nodes in octree entry order, "Load()" rejects files not matching the cells.
+*/
+class PotentiallyVisibleSet {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 Magic			  = 0x53565050;	/**< File magic number ("PPVS") */
+		static const PLCore::uint32 Version			  = 1;			/**< File format version */
+		static const PLCore::uint32 NoRegion		  = 0xFFFFFFFF;	/**< Region index returned by "GetRegion()" if there's no such region */
+		static const PLCore::uint32 MaxRegionsPerAxis = 16;			/**< Maximum number of regions per cell along each axis */
+		static const PLCore::uint32 SamplesPerAxis	  = 3;			/**< Number of sample points per region along each axis */
+
+		/**
+		*  @brief
+		*    File header
+		*/
+		struct Header {
+			PLCore::uint32 nMagic;			/**< Magic number, must be "Magic" */
+			PLCore::uint32 nVersion;		/**< Format version, must be "Version" */
+			PLCore::uint32 nNumOfCells;		/**< Number of cells */
+			PLCore::uint32 nNumOfRegions;	/**< Number of regions */
+			PLCore::uint32 nNumOfWords;		/**< Number of 32 bit visibility words */
+			PLCore::uint32 nReserved;		/**< Reserved, always 0 */
+		};
+
+		/**
+		*  @brief
+		*    Cell, the cells follow the header in the order of the portal culler cells
+		*/
+		struct Cell {
+			PLCore::uint64 nNameHash;			/**< FNV-1a hash of the absolute cell name */
+			PLCore::uint64 nSceneNodesHash;		/**< FNV-1a hash of the scene node names in octree entry order */
+			PLCore::uint32 nNumOfSceneNodes;	/**< Number of octree entries */
+			PLCore::uint32 nFirstRegion;		/**< Index of the first region of the cell */
+			PLCore::uint32 nNumOfRegions[3];	/**< Number of regions along each axis */
+			float		   fMin[3];				/**< Minimum of the region grid within the space of the cell */
+			float		   fRegionSize[3];		/**< Region size along each axis */
+			PLCore::uint32 nReserved;			/**< Reserved, always 0 */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		PotentiallyVisibleSet();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~PotentiallyVisibleSet();
+
+		/**
+		*  @brief
+		*    Computes the potentially visible set
+		*
+		*  @param[in] cPortalCuller
+		*    Portal culler to sample the views with, the potentially visible set must not be set within it
+		*  @param[in] fRegionSize
+		*    Preferred region size, larger cells get larger regions (see "MaxRegionsPerAxis")
+		*
+		*  @return
+		*    The number of regions
+		*
+		*  @note
+		*    - The previous potentially visible set is removed
+		*    - The results of the last update of the portal culler are lost
+		*/
+		PLCore::uint32 Compute(PortalCuller &cPortalCuller, float fRegionSize = 4.0f);
+
+		/**
+		*  @brief
+		*    Removes the potentially visible set
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Writes the potentially visible set into a file
+		*
+		*  @param[in] sFilename
+		*    Name of the file to write, an existing file is overwritten
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool Save(const PLCore::String &sFilename) const;
+
+		/**
+		*  @brief
+		*    Reads the potentially visible set from a file
+		*
+		*  @param[in] sFilename
+		*    Name of the file to read
+		*  @param[in] cPortalCuller
+		*    Portal culler the potentially visible set is used by
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (file not found, not valid or not matching the cells of the portal culler)
+		*
+		*  @note
+		*    - The previous potentially visible set is removed
+		*/
+		bool Load(const PLCore::String &sFilename, const PortalCuller &cPortalCuller);
+
+		/**
+		*  @brief
+		*    Returns the number of regions
+		*
+		*  @return
+		*    The number of regions of all cells
+		*/
+		PLCore::uint32 GetNumOfRegions() const;
+
+		/**
+		*  @brief
+		*    Returns the region a position is in
+		*
+		*  @param[in] nCell
+		*    Index of the cell the position is in
+		*  @param[in] vPosition
+		*    Position within the space of the cell
+		*
+		*  @return
+		*    The index of the region, "NoRegion" if the position is outside of the region grid of the cell
+		*/
+		PLCore::uint32 GetRegion(PLCore::uint32 nCell, const PLMath::Vector3 &vPosition) const;
+
+		/**
+		*  @brief
+		*    Returns whether or not a cell is potentially visible from a region
+		*
+		*  @param[in] nRegion
+		*    Index of the region
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @return
+		*    'true' if the cell is potentially visible, else 'false'
+		*/
+		bool IsCellVisible(PLCore::uint32 nRegion, PLCore::uint32 nCell) const;
+
+		/**
+		*  @brief
+		*    Returns the potentially visible scene nodes of a cell
+		*
+		*  @param[in] nRegion
+		*    Index of the region
+		*  @param[in] nCell
+		*    Index of the cell
+		*
+		*  @return
+		*    One bit per octree entry of the cell (bit "n%32" of word "n/32" is octree entry "n"), null pointer if the cell is not potentially visible
+		*/
+		const PLCore::uint32 *GetSceneNodes(PLCore::uint32 nRegion, PLCore::uint32 nCell) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		PotentiallyVisibleSet(const PotentiallyVisibleSet &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		PotentiallyVisibleSet &operator =(const PotentiallyVisibleSet &cSource);
+
+		/**
+		*  @brief
+		*    Returns the cell record of a portal culler cell
+		*
+		*  @param[in]  cPortalCuller
+		*    Portal culler
+		*  @param[in]  nCell
+		*    Index of the cell
+		*  @param[out] sCell
+		*    Receives the name hash, scene nodes hash and number of scene nodes of the cell, the other members are not touched
+		*/
+		static void GetCell(const PortalCuller &cPortalCuller, PLCore::uint32 nCell, Cell &sCell);
+
+		/**
+		*  @brief
+		*    Returns the number of visibility words of a region
+		*
+		*  @param[in] nRegion
+		*    Index of the region
+		*
+		*  @return
+		*    The number of visibility words of the region
+		*/
+		PLCore::uint32 GetNumOfWords(PLCore::uint32 nRegion) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<Cell>			  m_lstCells;	/**< Cells */
+		PLCore::Array<PLCore::uint32> m_lstRegions;	/**< Offset of the visibility words of each region */
+		PLCore::Array<PLCore::uint32> m_lstWords;	/**< Visibility words, per region the cell bits followed by the scene node bits of each visible cell */
+
+
+};
+
+
+#endif // __DUNGEON_POTENTIALLYVISIBLESET_H__
@@ -0,0 +1,522 @@
+/*********************************************************\
+ *  File: RayQueryService.cpp                            *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLMath/Matrix3x4.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Physics/StaticCollisionMerger.h"
+#include "Scene/RayQueryService.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the physics body modifier of a mesh scene node, null pointer if it's no mesh scene node or has no physics body
+*/
+static SceneNodeModifier *GetPhysicsBody(SceneNode &cSceneNode)
+{
+	if (cSceneNode.IsInstanceOf("PLScene::SNMesh")) {
+		for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+			SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+			if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody"))
+				return pSceneNodeModifier;
+		}
+	}
+	return nullptr;
+}
+
+/**
+*  @brief
+*    Returns the transform of a scene node relative to one of its parent scene containers
+*/
+static Matrix3x4 GetRelativeTransform(SceneNode &cSceneNode, const SceneNode *pContainer)
+{
+	Matrix3x4 mTransform = cSceneNode.GetTransform().GetMatrix();
+	for (SceneContainer *pParent=cSceneNode.GetContainer(); pParent && pParent!=pContainer; pParent=pParent->GetContainer())
+		mTransform = pParent->GetTransform().GetMatrix()*mTransform;
+	return mTransform;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private static data                                   ]
+//[-------------------------------------------------------]
+RayQueryService *RayQueryService::m_pCurrent = nullptr;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the current ray query service
+*/
+RayQueryService *RayQueryService::GetCurrent()
+{
+	return m_pCurrent;
+}
+
+/**
+*  @brief
+*    Sets the current ray query service
+*/
+void RayQueryService::SetCurrent(RayQueryService *pRayQueryService)
+{
+	m_pCurrent = pRayQueryService;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+RayQueryService::RayQueryService()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+RayQueryService::~RayQueryService()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Prepares the groups of a scene container
+*/
+void RayQueryService::Build(SceneContainer &cContainer)
+{
+	Clear();
+	m_cContainer.SetElement(&cContainer);
+	AddGroups(cContainer, true);
+}
+
+/**
+*  @brief
+*    Destroys all groups
+*/
+void RayQueryService::Clear()
+{
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++) {
+		Group *pGroup = m_lstGroups[i];
+		for (uint32 j=0; j<pGroup->cStatic.lstSources.GetNumOfElements(); j++)
+			delete pGroup->cStatic.lstSources[j];
+		for (uint32 j=0; j<pGroup->cDynamic.lstSources.GetNumOfElements(); j++)
+			delete pGroup->cDynamic.lstSources[j];
+		delete pGroup;
+	}
+	m_lstGroups.Clear();
+	m_cContainer.SetElement(nullptr);
+	m_cGeometryCache.Clear();
+}
+
+/**
+*  @brief
+*    Marks the dynamic hierarchies as outdated
+*/
+void RayQueryService::Invalidate()
+{
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++)
+		m_lstGroups[i]->bOutdated = true;
+}
+
+/**
+*  @brief
+*    Returns the number of triangles within the built hierarchies
+*/
+uint32 RayQueryService::GetNumOfTriangles() const
+{
+	uint32 nNumOfTriangles = 0;
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++) {
+		const Group &cGroup = *m_lstGroups[i];
+		nNumOfTriangles += cGroup.cStatic.cBvh.GetNumOfTriangles() + cGroup.cDynamic.cBvh.GetNumOfTriangles();
+	}
+	return nNumOfTriangles;
+}
+
+/**
+*  @brief
+*    Intersects a ray with the physics bodies
+*/
+SceneNode *RayQueryService::Intersect(const Vector3 &vOrigin, const Vector3 &vDirection, float fMaxDistance, float &fDistance)
+{
+	Bvh::Ray sRay;
+	sRay.vOrigin	= vOrigin;
+	sRay.vDirection = vDirection;
+	Bvh::Hit sHit;
+	sHit.fDistance = fMaxDistance;
+	sHit.nTriangle = Bvh::NoTriangle;
+
+	// The hit is only updated by closer hits, so the last tree updating it has the nearest hit
+	SceneNode *pSceneNode = nullptr;
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++) {
+		Group &cGroup = *m_lstGroups[i];
+		if (PrepareGroup(cGroup, true)) {
+			if (cGroup.cStatic.cBvh.Intersect(sRay, sHit))
+				pSceneNode = GetSceneNode(cGroup.cStatic, sHit.nTriangle);
+			if (cGroup.cDynamic.cBvh.Intersect(sRay, sHit))
+				pSceneNode = GetSceneNode(cGroup.cDynamic, sHit.nTriangle);
+		}
+	}
+
+	// Done
+	if (pSceneNode)
+		fDistance = sHit.fDistance;
+	return pSceneNode;
+}
+
+/**
+*  @brief
+*    Intersects a packet of rays with the physics bodies
+*/
+uint32 RayQueryService::Intersect(const Bvh::Ray *pRays, uint32 nNumOfRays, float fMaxDistance, SceneNode **ppSceneNodes, float *pfDistances)
+{
+	if (nNumOfRays > Bvh::MaxPacketSize)
+		nNumOfRays = Bvh::MaxPacketSize;
+
+	// Initialize the hits
+	Bvh::Hit sHits[Bvh::MaxPacketSize];
+	for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+		sHits[nRay].fDistance = fMaxDistance;
+		sHits[nRay].nTriangle = Bvh::NoTriangle;
+		ppSceneNodes[nRay] = nullptr;
+	}
+
+	// Intersect the packet with each tree, a ray got a closer hit if its distance decreased
+	float fPreviousDistances[Bvh::MaxPacketSize];
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++) {
+		Group &cGroup = *m_lstGroups[i];
+		if (PrepareGroup(cGroup, true)) {
+			const Tree *pTrees[2] = { &cGroup.cStatic, &cGroup.cDynamic };
+			for (uint32 nTree=0; nTree<2; nTree++) {
+				for (uint32 nRay=0; nRay<nNumOfRays; nRay++)
+					fPreviousDistances[nRay] = sHits[nRay].fDistance;
+				if (pTrees[nTree]->cBvh.Intersect(pRays, sHits, nNumOfRays)) {
+					for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+						if (sHits[nRay].fDistance < fPreviousDistances[nRay])
+							ppSceneNodes[nRay] = GetSceneNode(*pTrees[nTree], sHits[nRay].nTriangle);
+					}
+				}
+			}
+		}
+	}
+
+	// Done
+	uint32 nNumOfHits = 0;
+	for (uint32 nRay=0; nRay<nNumOfRays; nRay++) {
+		pfDistances[nRay] = ppSceneNodes[nRay] ? sHits[nRay].fDistance : fMaxDistance;
+		if (ppSceneNodes[nRay])
+			nNumOfHits++;
+	}
+	return nNumOfHits;
+}
+
+/**
+*  @brief
+*    Returns the triangles which bounds overlap a box
+*/
+void RayQueryService::GetTriangles(const Vector3 &vMin, const Vector3 &vMax, Array<Vector3> &lstVertices)
+{
+	Array<uint32> lstTriangles;
+	for (uint32 i=0; i<m_lstGroups.GetNumOfElements(); i++) {
+		Group &cGroup = *m_lstGroups[i];
+		if (PrepareGroup(cGroup, true)) {
+			const Bvh *pTrees[2] = { &cGroup.cStatic.cBvh, &cGroup.cDynamic.cBvh };
+			for (uint32 nTree=0; nTree<2; nTree++) {
+				lstTriangles.Reset();
+				pTrees[nTree]->GetTriangles(vMin, vMax, lstTriangles);
+				for (uint32 j=0; j<lstTriangles.GetNumOfElements(); j++) {
+					Vector3 vV0, vV1, vV2;
+					pTrees[nTree]->GetTriangle(lstTriangles[j], vV0, vV1, vV2);
+					lstVertices.Add(vV0);
+					lstVertices.Add(vV1);
+					lstVertices.Add(vV2);
+				}
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Returns the transform from the space of a scene node into the space of the ray queries
+*/
+bool RayQueryService::GetTransform(SceneNode &cSceneNode, Matrix3x4 &mTransform) const
+{
+	const SceneNode *pContainer = m_cContainer.GetElement();
+	if (pContainer) {
+		if (&cSceneNode == pContainer) {
+			mTransform.SetIdentity();
+			return true;
+		}
+		for (const SceneContainer *pParent=cSceneNode.GetContainer(); pParent; pParent=pParent->GetContainer()) {
+			if (pParent == pContainer) {
+				mTransform = GetRelativeTransform(cSceneNode, pContainer);
+				return true;
+			}
+		}
+	}
+
+	// Error!
+	return false;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+RayQueryService::RayQueryService(const RayQueryService &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+RayQueryService &RayQueryService::operator =(const RayQueryService &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Adds a group for a scene container and for the cells within it
+*/
+void RayQueryService::AddGroups(SceneContainer &cContainer, bool bGroup)
+{
+	// Add the group of the scene container
+	if (bGroup) {
+		Group *pGroup = new Group;
+		pGroup->cContainer.SetElement(&cContainer);
+		pGroup->bBuilt	  = false;
+		pGroup->bOutdated = false;
+		m_lstGroups.Add(pGroup);
+	}
+
+	// Look for cells, the other scene containers belong to the group of their parent
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode && pSceneNode->IsContainer())
+			AddGroups(static_cast<SceneContainer&>(*pSceneNode), pSceneNode->IsInstanceOf("PLScene::SCCell"));
+	}
+}
+
+/**
+*  @brief
+*    Returns a group ready for intersection
+*/
+bool RayQueryService::PrepareGroup(Group &cGroup, bool bDynamic)
+{
+	// Evicted cells are skipped, their meshes are released
+	const SceneNode *pContainer = cGroup.cContainer.GetElement();
+	if (!pContainer || !pContainer->IsActive())
+		return false;
+
+	// Build the hierarchies or refit the dynamic hierarchy to the moved scene nodes (only if it's going to be used)
+	if (!cGroup.bBuilt) {
+		BuildGroup(cGroup);
+		cGroup.bOutdated = false;
+	} else if (bDynamic && cGroup.bOutdated) {
+		if (!RefitTree(cGroup.cDynamic))
+			BuildGroup(cGroup); // A scene node was destroyed
+		cGroup.bOutdated = false;
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Builds the hierarchies of a group
+*/
+void RayQueryService::BuildGroup(Group &cGroup)
+{
+	// Destroy the previous sources
+	Tree *pTrees[2] = { &cGroup.cStatic, &cGroup.cDynamic };
+	for (uint32 nTree=0; nTree<2; nTree++) {
+		for (uint32 i=0; i<pTrees[nTree]->lstSources.GetNumOfElements(); i++)
+			delete pTrees[nTree]->lstSources[i];
+		pTrees[nTree]->lstSources.Clear();
+		pTrees[nTree]->cBvh.Clear();
+	}
+
+	// Collect the scene nodes and build the hierarchies
+	SceneNode *pContainer = cGroup.cContainer.GetElement();
+	if (pContainer) {
+		CollectSceneNodes(static_cast<SceneContainer&>(*pContainer), cGroup);
+		for (uint32 nTree=0; nTree<2; nTree++) {
+			Array<Vector3> lstVertices;
+			Array<uint32> lstIndices;
+			GetTriangles(*pTrees[nTree], lstVertices, lstIndices);
+			pTrees[nTree]->cBvh.Build(lstVertices, lstIndices);
+		}
+	}
+	cGroup.bBuilt = true;
+}
+
+/**
+*  @brief
+*    Collects the physics body scene nodes of a scene container, cells are skipped
+*/
+void RayQueryService::CollectSceneNodes(SceneContainer &cContainer, Group &cGroup)
+{
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			if (pSceneNode->IsContainer()) {
+				// Cells have groups of their own
+				if (!pSceneNode->IsInstanceOf("PLScene::SCCell"))
+					CollectSceneNodes(static_cast<SceneContainer&>(*pSceneNode), cGroup);
+			} else {
+				// Only mesh scene nodes with a physics body and a loaded mesh can be hit
+				const SceneNodeModifier *pBody = GetPhysicsBody(*pSceneNode);
+				MeshHandler *pMeshHandler = pBody ? static_cast<SNMesh*>(pSceneNode)->GetMeshHandler() : nullptr;
+				const Mesh *pMesh = pMeshHandler ? pMeshHandler->GetResource() : nullptr;
+				const CollisionGeometry *pGeometry = pMesh ? m_cGeometryCache.Get(*pMesh) : nullptr;
+				if (pGeometry) {
+					Source *pSource = new Source;
+					pSource->cSceneNode.SetElement(pSceneNode);
+					pSource->pGeometry		= pGeometry;
+					pSource->nFirstVertex	= 0;
+					pSource->nFirstTriangle = 0;
+					pSource->bMerged		= StaticCollisionMerger::IsMergedSceneNode(*pSceneNode);
+
+					// Massless bodies are static
+					const DynVar *pMass = pBody->GetAttribute("Mass");
+					if (pMass && pMass->GetFloat() > 0.0f)
+						cGroup.cDynamic.lstSources.Add(pSource);
+					else
+						cGroup.cStatic.lstSources.Add(pSource);
+				}
+			}
+		}
+	}
+}
+
+/**
+*  @brief
+*    Adds the triangles of the scene nodes of a tree to a triangle list
+*/
+bool RayQueryService::GetTriangles(Tree &cTree, Array<Vector3> &lstVertices, Array<uint32> &lstIndices) const
+{
+	const SceneNode *pContainer = m_cContainer.GetElement();
+	for (uint32 i=0; i<cTree.lstSources.GetNumOfElements(); i++) {
+		Source &sSource = *cTree.lstSources[i];
+		SceneNode *pSceneNode = sSource.cSceneNode.GetElement();
+		if (!pSceneNode)
+			return false; // Error!
+		sSource.nFirstVertex   = lstVertices.GetNumOfElements();
+		sSource.nFirstTriangle = lstIndices.GetNumOfElements()/3;
+		sSource.mTransform	   = GetRelativeTransform(*pSceneNode, pContainer);
+		sSource.pGeometry->AppendInstance(sSource.mTransform, lstVertices, lstIndices);
+	}
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Refits the hierarchy of a tree to the scene nodes which moved
+*/
+bool RayQueryService::RefitTree(Tree &cTree) const
+{
+	// Transform the triangles of the moved scene nodes only
+	const SceneNode *pContainer = m_cContainer.GetElement();
+	for (uint32 i=0; i<cTree.lstSources.GetNumOfElements(); i++) {
+		Source &sSource = *cTree.lstSources[i];
+		SceneNode *pSceneNode = sSource.cSceneNode.GetElement();
+		if (!pSceneNode)
+			return false; // Error!
+		const Matrix3x4 mTransform = GetRelativeTransform(*pSceneNode, pContainer);
+		if (mTransform != sSource.mTransform) {
+			sSource.mTransform = mTransform;
+			cTree.cBvh.MoveVertices(sSource.nFirstVertex, sSource.pGeometry->lstVertices, mTransform);
+		}
+	}
+
+	// Recalculate the bounds of the nodes holding them
+	cTree.cBvh.Refit();
+
+	// Done
+	return true;
+}
+
+/**
+*  @brief
+*    Returns the scene node a triangle of a tree belongs to
+*/
+SceneNode *RayQueryService::GetSceneNode(const Tree &cTree, uint32 nTriangle) const
+{
+	if (!cTree.lstSources.GetNumOfElements())
+		return nullptr; // Error!
+
+	// Binary search for the last source starting at or before the triangle
+	uint32 nLow  = 0;
+	uint32 nHigh = cTree.lstSources.GetNumOfElements();
+	while (nHigh - nLow > 1) {
+		const uint32 nMiddle = (nLow + nHigh)/2;
+		if (cTree.lstSources[nMiddle]->nFirstTriangle <= nTriangle)
+			nLow = nMiddle;
+		else
+			nHigh = nMiddle;
+	}
+	const Source &sSource = *cTree.lstSources[nLow];
+	SceneNode *pSceneNode = sSource.cSceneNode.GetElement();
+
+	// A merged static body is mapped back to the scene node the triangle was merged from
+	if (pSceneNode && sSource.bMerged) {
+		SceneNode *pMergedSceneNode = StaticCollisionMerger::GetSceneNode(*pSceneNode, nTriangle - sSource.nFirstTriangle);
+		if (pMergedSceneNode)
+			return pMergedSceneNode;
+	}
+	return pSceneNode;
+}
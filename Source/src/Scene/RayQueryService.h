@@ -0,0 +1,393 @@
+/*********************************************************\
+ *  File: RayQueryService.h                              *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_RAYQUERYSERVICE_H__
+#define __DUNGEON_RAYQUERYSERVICE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLMath/Matrix3x4.h>
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Physics/CollisionGeometryCache.h"
+#include "Scene/Bvh.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Ray query service, returns the nearest physics body scene node hit by a ray
+*
+*  @remarks
+*    Used for mouse picking and line-of-sight tests without a physics backend ray cast. The triangles of the mesh
+*    scene nodes having a physics body are held within bounding volume hierarchies (see "Bvh"), one group per cell
+*    and one group for the scene nodes directly within the scene container. Each group has a static hierarchy for
+*    the massless bodies, including the merged static bodies (see "StaticCollisionMerger"), and a dynamic hierarchy
+*    for the bodies with mass. A group is built the first time a ray is intersected with it, groups of inactive
+*    (evicted) cells are skipped. After "Invalidate()" the dynamic hierarchies are refitted to the current scene
+*    node transforms the next time a ray is intersected with them: The transform of each scene node is compared
+*    with the transform its triangles were placed with, only the triangles of moved scene nodes are transformed
+*    again and only the nodes holding them are refitted (resting and sleeping bodies cost a transform comparison).
+*    The topology is kept, a dynamic hierarchy is only rebuilt if one of its scene nodes was destroyed.
+*
+*    All positions and directions are within the space of the scene container given to "Build()".
+*/
+class RayQueryService {
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns the current ray query service
+		*
+		*  @return
+		*    The ray query service of the loaded scene, a null pointer if there's none
+		*/
+		static RayQueryService *GetCurrent();
+
+		/**
+		*  @brief
+		*    Sets the current ray query service
+		*
+		*  @param[in] pRayQueryService
+		*    Ray query service of the loaded scene, can be a null pointer
+		*
+		*  @note
+		*    - Used by scene node modifiers which collide with the physics bodies (see "SNMCharacterMover"),
+		*      it's not reset automatically
+		*/
+		static void SetCurrent(RayQueryService *pRayQueryService);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		RayQueryService();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~RayQueryService();
+
+		/**
+		*  @brief
+		*    Prepares the groups of a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container with the physics bodies (usually the physics world), the cells directly within it
+		*    get groups of their own, must stay valid as long as this service is used
+		*
+		*  @note
+		*    - The hierarchies of the groups are built on demand
+		*/
+		void Build(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Destroys all groups
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Marks the dynamic hierarchies as outdated
+		*
+		*  @note
+		*    - Call this once per frame, the refit is done on demand and only looks at the scene nodes which moved
+		*/
+		void Invalidate();
+
+		/**
+		*  @brief
+		*    Returns the number of triangles within the built hierarchies
+		*
+		*  @return
+		*    The number of triangles within the built hierarchies
+		*/
+		PLCore::uint32 GetNumOfTriangles() const;
+
+		/**
+		*  @brief
+		*    Intersects a ray with the physics bodies
+		*
+		*  @param[in] vOrigin
+		*    Ray origin
+		*  @param[in] vDirection
+		*    Normalized ray direction
+		*  @param[in] fMaxDistance
+		*    Maximum distance along the ray
+		*  @param[out] fDistance
+		*    Receives the distance of the nearest hit, not touched if nothing was hit
+		*
+		*  @return
+		*    The scene node of the nearest hit, null pointer if nothing was hit
+		*/
+		PLScene::SceneNode *Intersect(const PLMath::Vector3 &vOrigin, const PLMath::Vector3 &vDirection, float fMaxDistance, float &fDistance);
+
+		/**
+		*  @brief
+		*    Intersects a packet of rays with the physics bodies
+		*
+		*  @param[in]  pRays
+		*    Rays with normalized directions, "Bvh::MaxPacketSize" at most
+		*  @param[in]  nNumOfRays
+		*    Number of rays
+		*  @param[in]  fMaxDistance
+		*    Maximum distance along the rays
+		*  @param[out] ppSceneNodes
+		*    Receives the scene node of the nearest hit per ray, null pointer if the ray hit nothing
+		*  @param[out] pfDistances
+		*    Receives the distance of the nearest hit per ray, "fMaxDistance" if the ray hit nothing
+		*
+		*  @return
+		*    The number of rays which hit something
+		*
+		*  @remarks
+		*    The rays share the hierarchy traversal, use packets for coherent rays (e.g. the rays of a screen region).
+		*/
+		PLCore::uint32 Intersect(const Bvh::Ray *pRays, PLCore::uint32 nNumOfRays, float fMaxDistance, PLScene::SceneNode **ppSceneNodes, float *pfDistances);
+
+		/**
+		*  @brief
+		*    Returns the triangles which bounds overlap a box
+		*
+		*  @param[in]  vMin
+		*    Minimum corner of the box
+		*  @param[in]  vMax
+		*    Maximum corner of the box
+		*  @param[out] lstVertices
+		*    Receives the three corners of each triangle, the list is not cleared
+		*
+		*  @remarks
+		*    The massless bodies and the bodies with mass of the groups which can be intersected are taken into account,
+		*    the dynamic hierarchies are refitted to the moved scene nodes first.
+		*/
+		void GetTriangles(const PLMath::Vector3 &vMin, const PLMath::Vector3 &vMax, PLCore::Array<PLMath::Vector3> &lstVertices);
+
+		/**
+		*  @brief
+		*    Returns the transform from the space of a scene node into the space of the ray queries
+		*
+		*  @param[in]  cSceneNode
+		*    Scene node within the scene container given to "Build()"
+		*  @param[out] mTransform
+		*    Receives the transform
+		*
+		*  @return
+		*    'true' if all went fine, else 'false' (the scene node is not within the scene container)
+		*/
+		bool GetTransform(PLScene::SceneNode &cSceneNode, PLMath::Matrix3x4 &mTransform) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Scene node which triangles are within a hierarchy
+		*/
+		struct Source {
+			PLScene::SceneNodeHandler  cSceneNode;		/**< Scene node */
+			const CollisionGeometry	  *pGeometry;		/**< Collision geometry of the scene node mesh, always valid */
+			PLCore::uint32			   nFirstVertex;	/**< Index of the first vertex of the scene node within the hierarchy */
+			PLCore::uint32			   nFirstTriangle;	/**< Index of the first triangle of the scene node within the hierarchy */
+			PLMath::Matrix3x4		   mTransform;		/**< Transform the triangles of the scene node were placed with */
+			bool					   bMerged;			/**< Is this the merged static body of a cell? */
+		};
+
+		/**
+		*  @brief
+		*    Hierarchy together with the scene nodes of its triangles
+		*/
+		struct Tree {
+			Bvh					  cBvh;			/**< Bounding volume hierarchy */
+			PLCore::Array<Source*> lstSources;	/**< Scene nodes ordered by their first triangle, destroyed by the owner of the tree */
+		};
+
+		/**
+		*  @brief
+		*    Group of the physics bodies of a cell or the scene container
+		*/
+		struct Group {
+			PLScene::SceneNodeHandler cContainer;	/**< Cell or the scene container itself */
+			bool					  bBuilt;		/**< Are the hierarchies built? */
+			bool					  bOutdated;	/**< Must the dynamic hierarchy be refitted? */
+			Tree					  cStatic;		/**< Massless bodies */
+			Tree					  cDynamic;		/**< Bodies with mass */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		RayQueryService(const RayQueryService &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		RayQueryService &operator =(const RayQueryService &cSource);
+
+		/**
+		*  @brief
+		*    Adds a group for a scene container and for the cells within it
+		*
+		*  @param[in] cContainer
+		*    Scene container to add the cells of
+		*  @param[in] bGroup
+		*    Add a group for the scene container itself?
+		*/
+		void AddGroups(PLScene::SceneContainer &cContainer, bool bGroup);
+
+		/**
+		*  @brief
+		*    Returns a group ready for intersection
+		*
+		*  @param[in] cGroup
+		*    Group to prepare
+		*  @param[in] bDynamic
+		*    Is the dynamic hierarchy going to be used? If not, it's not refitted
+		*
+		*  @return
+		*    'true' if the group can be intersected, 'false' if its container is gone or inactive
+		*/
+		bool PrepareGroup(Group &cGroup, bool bDynamic);
+
+		/**
+		*  @brief
+		*    Builds the hierarchies of a group
+		*
+		*  @param[in] cGroup
+		*    Group to build
+		*/
+		void BuildGroup(Group &cGroup);
+
+		/**
+		*  @brief
+		*    Collects the physics body scene nodes of a scene container, cells are skipped
+		*
+		*  @param[in]  cContainer
+		*    Scene container to collect the scene nodes of, child containers which are no cells are taken into account
+		*  @param[out] cGroup
+		*    Group to add the scene nodes to
+		*/
+		void CollectSceneNodes(PLScene::SceneContainer &cContainer, Group &cGroup);
+
+		/**
+		*  @brief
+		*    Adds the triangles of the scene nodes of a tree to a triangle list
+		*
+		*  @param[in]  cTree
+		*    Tree to add the triangles of
+		*  @param[out] lstVertices
+		*    Receives the vertex positions within the space of the scene container
+		*  @param[out] lstIndices
+		*    Receives the triangle list
+		*
+		*  @return
+		*    'true' if all went fine, 'false' if a scene node was destroyed
+		*/
+		bool GetTriangles(Tree &cTree, PLCore::Array<PLMath::Vector3> &lstVertices, PLCore::Array<PLCore::uint32> &lstIndices) const;
+
+		/**
+		*  @brief
+		*    Refits the hierarchy of a tree to the scene nodes which moved
+		*
+		*  @param[in] cTree
+		*    Tree to refit
+		*
+		*  @return
+		*    'true' if all went fine, 'false' if a scene node was destroyed
+		*/
+		bool RefitTree(Tree &cTree) const;
+
+		/**
+		*  @brief
+		*    Returns the scene node a triangle of a tree belongs to
+		*
+		*  @param[in] cTree
+		*    Tree the triangle is in
+		*  @param[in] nTriangle
+		*    Triangle index within the hierarchy of the tree
+		*
+		*  @return
+		*    The scene node, null pointer on error
+		*/
+		PLScene::SceneNode *GetSceneNode(const Tree &cTree, PLCore::uint32 nTriangle) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private static data                                   ]
+	//[-------------------------------------------------------]
+	private:
+		static RayQueryService *m_pCurrent;	/**< Current ray query service, can be a null pointer */
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLScene::SceneNodeHandler m_cContainer;		/**< Scene container with the physics bodies */
+		PLCore::Array<Group*>	  m_lstGroups;		/**< Groups, destroyed by this instance */
+		CollisionGeometryCache	  m_cGeometryCache;	/**< Collision geometries of the meshes */
+
+
+};
+
+
+#endif // __DUNGEON_RAYQUERYSERVICE_H__
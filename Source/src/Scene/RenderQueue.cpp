@@ -0,0 +1,509 @@
+/*********************************************************\
+ *  File: RenderQueue.cpp                                *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Core/MemoryManager.h>
+#include <PLCore/System/System.h>
+#include <PLMath/Math.h>
+#include <PLMath/Matrix3x4.h>
+#include <PLRenderer/Material/Material.h>
+#include <PLMesh/Mesh.h>
+#include <PLMesh/MeshHandler.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodes/SNMesh.h>
+#include "Tools/Trace.h"
+#include "Scene/LooseOctree.h"
+#include "Scene/PortalCuller.h"
+#include "Scene/RenderQueue.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLRenderer;
+using namespace PLMesh;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const float DepthRange = 256.0f;	/**< View depth mapped onto the depth buckets, farther items share the last bucket */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the transform of a scene node relative to one of its parent scene containers
+*/
+static Matrix3x4 GetRelativeTransform(SceneNode &cSceneNode, const SceneNode *pContainer)
+{
+	Matrix3x4 mTransform = cSceneNode.GetTransform().GetMatrix();
+	for (SceneContainer *pParent=cSceneNode.GetContainer(); pParent && pParent!=pContainer; pParent=pParent->GetContainer())
+		mTransform = pParent->GetTransform().GetMatrix()*mTransform;
+	return mTransform;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+RenderQueue::RenderQueue(uint32 nNumOfThreads) :
+	m_cWorkerPool(nNumOfThreads),
+	m_pPortalCuller(nullptr),
+	m_nNumOfMeshes(0),
+	m_pSortedItems(nullptr),
+	m_pSortSource(nullptr),
+	m_pSortDestination(nullptr),
+	m_nSortShift(0),
+	m_nNumOfChunks(0),
+	m_nSceneMaterialChanges(0),
+	m_nSceneMeshChanges(0),
+	m_nSortedMaterialChanges(0),
+	m_nSortedMeshChanges(0),
+	m_nNumOfSortPasses(0),
+	m_fSortTime(0.0f)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+RenderQueue::~RenderQueue()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Gathers the meshes and their materials within the cells of a portal culler
+*/
+uint32 RenderQueue::Build(const PortalCuller &cPortalCuller)
+{
+	TraceScope cTraceScope("RenderQueue::Build", "Scene");
+
+	// Remove the previous meshes
+	Clear();
+	m_pPortalCuller = &cPortalCuller;
+
+	// One draw per material of each mesh scene node within the octrees of the cells
+	for (uint32 nCell=0; nCell<cPortalCuller.GetNumOfCells(); nCell++) {
+		Cell *pCell = new Cell;
+		m_lstCells.Add(pCell);
+		const LooseOctree *pOctree = cPortalCuller.GetOctree(nCell);
+		const uint32 nNumOfEntries = pOctree ? pOctree->GetNumOfEntries() : 0;
+		pCell->lstFirstDraws.Resize(nNumOfEntries + 1, true, false);
+		for (uint32 nEntry=0; nEntry<nNumOfEntries; nEntry++) {
+			pCell->lstFirstDraws[nEntry] = pCell->lstDraws.GetNumOfElements();
+			SceneNode *pSceneNode = pOctree->GetSceneNode(nEntry);
+			if (pSceneNode && pSceneNode->IsInstanceOf("PLScene::SNMesh")) {
+				MeshHandler *pMeshHandler = static_cast<SNMesh*>(pSceneNode)->GetMeshHandler();
+				const Mesh *pMesh = pMeshHandler ? pMeshHandler->GetResource() : nullptr;
+				if (pMesh) {
+					const uint32 nMesh = GetId(m_mapMeshes, pMesh->GetName());
+					for (uint32 i=0; i<pMeshHandler->GetNumOfMaterials(); i++) {
+						const Material *pMaterial = pMeshHandler->GetMaterial(i);
+						Draw &sDraw = pCell->lstDraws.Add();
+						sDraw.nMaterial = GetId(m_mapMaterials, pMaterial ? pMaterial->GetName() : "");
+						sDraw.nMesh		= nMesh;
+						sDraw.nPass		= (pMaterial && pMaterial->GetBlend()) ? TransparentPass : OpaquePass;
+					}
+					m_nNumOfMeshes++;
+				}
+			}
+		}
+		pCell->lstFirstDraws[nNumOfEntries] = pCell->lstDraws.GetNumOfElements();
+	}
+
+	// Done
+	return m_nNumOfMeshes;
+}
+
+/**
+*  @brief
+*    Removes the meshes and the items
+*/
+void RenderQueue::Clear()
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+	m_mapMaterials.Clear();
+	m_mapMeshes.Clear();
+	m_lstItems.Clear();
+	m_lstSortBuffer.Clear();
+	m_lstChunkCounts.Clear();
+	m_pPortalCuller			 = nullptr;
+	m_nNumOfMeshes			 = 0;
+	m_pSortedItems			 = nullptr;
+	m_nSceneMaterialChanges	 = 0;
+	m_nSceneMeshChanges		 = 0;
+	m_nSortedMaterialChanges = 0;
+	m_nSortedMeshChanges	 = 0;
+	m_nNumOfSortPasses		 = 0;
+	m_fSortTime				 = 0.0f;
+}
+
+/**
+*  @brief
+*    Builds and sorts the queue of the visible meshes
+*/
+void RenderQueue::Update(SceneNode *pCamera)
+{
+	// Reset the results of the previous update
+	m_lstItems.Reset();
+	m_pSortedItems			 = nullptr;
+	m_nSceneMaterialChanges	 = 0;
+	m_nSceneMeshChanges		 = 0;
+	m_nSortedMaterialChanges = 0;
+	m_nSortedMeshChanges	 = 0;
+	m_nNumOfSortPasses		 = 0;
+	m_fSortTime				 = 0.0f;
+	if (!pCamera || !m_pPortalCuller)
+		return;
+
+	// Add the draws of the visible meshes in scene graph order, the camera looks along its z axis
+	const Matrix3x4 mCameraInverse = GetRelativeTransform(*pCamera, nullptr).GetInverted();
+	for (uint32 nCell=0; nCell<m_lstCells.GetNumOfElements(); nCell++) {
+		SceneContainer *pCell = m_pPortalCuller->GetCell(nCell);
+		if (pCell && m_pPortalCuller->IsCellVisible(nCell)) {
+			const Cell &cCell = *m_lstCells[nCell];
+			const LooseOctree &cOctree = *m_pPortalCuller->GetOctree(nCell);
+			const Matrix3x4 mTransform = mCameraInverse*GetRelativeTransform(*pCell, nullptr);
+			for (uint32 nEntry=0; nEntry+1<cCell.lstFirstDraws.GetNumOfElements(); nEntry++) {
+				if (cCell.lstFirstDraws[nEntry] < cCell.lstFirstDraws[nEntry + 1] && m_pPortalCuller->IsSceneNodeVisible(nCell, nEntry)) {
+					SceneNode *pSceneNode = cOctree.GetSceneNode(nEntry);
+					if (pSceneNode && pSceneNode->IsVisible()) {
+						// Get the depth bucket of the bounding box center
+						Vector3 vMin, vMax;
+						cOctree.GetBoundingBox(nEntry, vMin, vMax);
+						const float fDepth = (mTransform*((vMin + vMax)*0.5f)).z;
+						const uint64 nDepth = static_cast<uint64>(Math::Min(Math::Max(fDepth, 0.0f)/DepthRange, 1.0f)*MaxId);
+
+						// Add the draws
+						for (uint32 nDraw=cCell.lstFirstDraws[nEntry]; nDraw<cCell.lstFirstDraws[nEntry + 1]; nDraw++) {
+							const Draw &sDraw = cCell.lstDraws[nDraw];
+							Item &sItem = m_lstItems.Add();
+							sItem.nCell		= nCell;
+							sItem.nEntry	= nEntry;
+							sItem.nMaterial	= sDraw.nMaterial;
+							sItem.nMesh		= sDraw.nMesh;
+							if (sDraw.nPass == TransparentPass)
+								sItem.nKey = (static_cast<uint64>(sDraw.nPass) << (IdBits*3)) | ((MaxId - nDepth) << (IdBits*2)) | (static_cast<uint64>(sDraw.nMaterial) << IdBits) | sDraw.nMesh;
+							else
+								sItem.nKey = (static_cast<uint64>(sDraw.nPass) << (IdBits*3)) | (static_cast<uint64>(sDraw.nMaterial) << (IdBits*2)) | (static_cast<uint64>(sDraw.nMesh) << IdBits) | nDepth;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Sort the items and count the switches before and after
+	CountChanges(m_lstItems.GetData(), m_nSceneMaterialChanges, m_nSceneMeshChanges);
+	Sort();
+	CountChanges(m_pSortedItems, m_nSortedMaterialChanges, m_nSortedMeshChanges);
+}
+
+/**
+*  @brief
+*    Returns the number of items
+*/
+uint32 RenderQueue::GetNumOfItems() const
+{
+	return m_pSortedItems ? m_lstItems.GetNumOfElements() : 0;
+}
+
+/**
+*  @brief
+*    Returns the sort key of an item
+*/
+uint64 RenderQueue::GetKey(uint32 nIndex) const
+{
+	return m_pSortedItems[nIndex].nKey;
+}
+
+/**
+*  @brief
+*    Returns the scene node of an item
+*/
+SceneNode *RenderQueue::GetSceneNode(uint32 nIndex) const
+{
+	const Item &sItem = m_pSortedItems[nIndex];
+	const LooseOctree *pOctree = m_pPortalCuller->GetOctree(sItem.nCell);
+	return pOctree ? pOctree->GetSceneNode(sItem.nEntry) : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the cell of an item
+*/
+uint32 RenderQueue::GetCell(uint32 nIndex) const
+{
+	return m_pSortedItems[nIndex].nCell;
+}
+
+/**
+*  @brief
+*    Returns the octree entry of an item
+*/
+uint32 RenderQueue::GetEntry(uint32 nIndex) const
+{
+	return m_pSortedItems[nIndex].nEntry;
+}
+
+/**
+*  @brief
+*    Returns the material id of an item
+*/
+uint32 RenderQueue::GetMaterial(uint32 nIndex) const
+{
+	return m_pSortedItems[nIndex].nMaterial;
+}
+
+/**
+*  @brief
+*    Returns the mesh id of an item
+*/
+uint32 RenderQueue::GetMesh(uint32 nIndex) const
+{
+	return m_pSortedItems[nIndex].nMesh;
+}
+
+/**
+*  @brief
+*    Returns the counters of the last update as string
+*/
+String RenderQueue::ToString() const
+{
+	return String::Format("Items=\"%u\" Materials=\"%u\" Meshes=\"%u\" SceneMaterialChanges=\"%u\" SceneMeshChanges=\"%u\" SortedMaterialChanges=\"%u\" SortedMeshChanges=\"%u\" SortPasses=\"%u\" SortTime=\"%.3f\"",
+						  GetNumOfItems(), m_mapMaterials.GetNumOfElements(), m_mapMeshes.GetNumOfElements(), m_nSceneMaterialChanges, m_nSceneMeshChanges,
+						  m_nSortedMaterialChanges, m_nSortedMeshChanges, m_nNumOfSortPasses, m_fSortTime);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public RenderQueue::SortJob functions                 ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+RenderQueue::SortJob::SortJob(RenderQueue &cRenderQueue, uint32 nChunk, bool bScatter) :
+	m_pRenderQueue(&cRenderQueue),
+	m_nChunk(nChunk),
+	m_bScatter(bScatter)
+{
+}
+
+
+//[-------------------------------------------------------]
+//[ Public virtual WorkerPool::Job functions              ]
+//[-------------------------------------------------------]
+void RenderQueue::SortJob::Execute()
+{
+	if (m_bScatter)
+		m_pRenderQueue->ScatterChunk(m_nChunk);
+	else
+		m_pRenderQueue->CountChunk(m_nChunk);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+RenderQueue::RenderQueue(const RenderQueue &cSource) :
+	m_cWorkerPool(1),
+	m_pPortalCuller(nullptr),
+	m_nNumOfMeshes(0),
+	m_pSortedItems(nullptr),
+	m_pSortSource(nullptr),
+	m_pSortDestination(nullptr),
+	m_nSortShift(0),
+	m_nNumOfChunks(0),
+	m_nSceneMaterialChanges(0),
+	m_nSceneMeshChanges(0),
+	m_nSortedMaterialChanges(0),
+	m_nSortedMeshChanges(0),
+	m_nNumOfSortPasses(0),
+	m_fSortTime(0.0f)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+RenderQueue &RenderQueue::operator =(const RenderQueue &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the id of a name, new names get the next free id
+*/
+uint32 RenderQueue::GetId(HashMap<String, uint32> &mapIds, const String &sName)
+{
+	uint32 nId = mapIds.Get(sName);
+	if (!nId) {
+		nId = mapIds.GetNumOfElements() + 1;
+		mapIds.Add(sName, nId);
+	}
+	return Math::Min(nId, MaxId + 1) - 1;
+}
+
+/**
+*  @brief
+*    Counts the material and mesh switches of the items
+*/
+void RenderQueue::CountChanges(const Item *pItems, uint32 &nMaterialChanges, uint32 &nMeshChanges) const
+{
+	nMaterialChanges = 0;
+	nMeshChanges	 = 0;
+	for (uint32 i=0; i<m_lstItems.GetNumOfElements(); i++) {
+		if (!i || pItems[i].nMaterial != pItems[i - 1].nMaterial)
+			nMaterialChanges++;
+		if (!i || pItems[i].nMesh != pItems[i - 1].nMesh)
+			nMeshChanges++;
+	}
+}
+
+/**
+*  @brief
+*    Sorts the items by their keys
+*/
+void RenderQueue::Sort()
+{
+	TraceScope cTraceScope("RenderQueue::Sort", "Scene");
+	const uint64 nStartTime = System::GetInstance()->GetMicroseconds();
+
+	// Count the digits of all passes at once, a pass whose digit is equal for all keys keeps the order and is skipped
+	const uint32 nNumOfItems = m_lstItems.GetNumOfElements();
+	uint32 nCounts[8][256];
+	MemoryManager::Set(nCounts, 0, sizeof(nCounts));
+	for (uint32 i=0; i<nNumOfItems; i++) {
+		const uint64 nKey = m_lstItems[i].nKey;
+		for (uint32 nDigit=0; nDigit<8; nDigit++)
+			nCounts[nDigit][(nKey >> (nDigit*8)) & 0xFF]++;
+	}
+
+	// Sort from the least to the most significant digit, the items are moved between the two buffers
+	m_lstSortBuffer.Resize(nNumOfItems, true, false);
+	Item *pSource	   = m_lstItems.GetData();
+	Item *pDestination = m_lstSortBuffer.GetData();
+	const bool bParallel = (nNumOfItems >= ParallelThreshold && m_cWorkerPool.GetNumOfThreads() > 1);
+	for (uint32 nDigit=0; nDigit<8 && nNumOfItems; nDigit++) {
+		const uint32 nShift = nDigit*8;
+		if (nCounts[nDigit][(pSource[0].nKey >> nShift) & 0xFF] == nNumOfItems)
+			continue;
+		if (bParallel) {
+			// Count the digits of the chunks
+			m_pSortSource	   = pSource;
+			m_pSortDestination = pDestination;
+			m_nSortShift	   = nShift;
+			m_nNumOfChunks	   = m_cWorkerPool.GetNumOfThreads();
+			m_lstChunkCounts.Resize(m_nNumOfChunks*256, true, false);
+			for (uint32 nChunk=0; nChunk<m_nNumOfChunks; nChunk++)
+				m_cWorkerPool.AddJob(new SortJob(*this, nChunk, false));
+			m_cWorkerPool.WaitForAll();
+
+			// Turn the counts into offsets, the chunks of a digit follow each other in order so the sort stays stable
+			uint32 nOffset = 0;
+			for (uint32 nValue=0; nValue<256; nValue++) {
+				for (uint32 nChunk=0; nChunk<m_nNumOfChunks; nChunk++) {
+					uint32 &nCount = m_lstChunkCounts[nChunk*256 + nValue];
+					const uint32 nChunkCount = nCount;
+					nCount	 = nOffset;
+					nOffset += nChunkCount;
+				}
+			}
+
+			// Scatter the chunks
+			for (uint32 nChunk=0; nChunk<m_nNumOfChunks; nChunk++)
+				m_cWorkerPool.AddJob(new SortJob(*this, nChunk, true));
+			m_cWorkerPool.WaitForAll();
+		} else {
+			uint32 nOffsets[256];
+			uint32 nOffset = 0;
+			for (uint32 nValue=0; nValue<256; nValue++) {
+				nOffsets[nValue] = nOffset;
+				nOffset += nCounts[nDigit][nValue];
+			}
+			for (uint32 i=0; i<nNumOfItems; i++)
+				pDestination[nOffsets[(pSource[i].nKey >> nShift) & 0xFF]++] = pSource[i];
+		}
+		Item *pSwap  = pSource;
+		pSource		 = pDestination;
+		pDestination = pSwap;
+		m_nNumOfSortPasses++;
+	}
+	m_pSortedItems = pSource;
+	m_fSortTime = static_cast<float>(System::GetInstance()->GetMicroseconds() - nStartTime)/1000.0f;
+}
+
+/**
+*  @brief
+*    Counts the digits of a chunk of the current parallel sort pass
+*/
+void RenderQueue::CountChunk(uint32 nChunk)
+{
+	const uint32 nNumOfItems = m_lstItems.GetNumOfElements();
+	const uint32 nFirst		 = static_cast<uint32>(static_cast<uint64>(nNumOfItems)*nChunk/m_nNumOfChunks);
+	const uint32 nEnd		 = static_cast<uint32>(static_cast<uint64>(nNumOfItems)*(nChunk + 1)/m_nNumOfChunks);
+	uint32 *pnCounts = &m_lstChunkCounts[nChunk*256];
+	for (uint32 nValue=0; nValue<256; nValue++)
+		pnCounts[nValue] = 0;
+	for (uint32 i=nFirst; i<nEnd; i++)
+		pnCounts[(m_pSortSource[i].nKey >> m_nSortShift) & 0xFF]++;
+}
+
+/**
+*  @brief
+*    Scatters a chunk of the current parallel sort pass
+*/
+void RenderQueue::ScatterChunk(uint32 nChunk)
+{
+	const uint32 nNumOfItems = m_lstItems.GetNumOfElements();
+	const uint32 nFirst		 = static_cast<uint32>(static_cast<uint64>(nNumOfItems)*nChunk/m_nNumOfChunks);
+	const uint32 nEnd		 = static_cast<uint32>(static_cast<uint64>(nNumOfItems)*(nChunk + 1)/m_nNumOfChunks);
+	uint32 *pnOffsets = &m_lstChunkCounts[nChunk*256];
+	for (uint32 i=nFirst; i<nEnd; i++)
+		m_pSortDestination[pnOffsets[(m_pSortSource[i].nKey >> m_nSortShift) & 0xFF]++] = m_pSortSource[i];
+}
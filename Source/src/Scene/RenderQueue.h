@@ -0,0 +1,422 @@
+/*********************************************************\
+ *  File: RenderQueue.h                                  *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_RENDERQUEUE_H__
+#define __DUNGEON_RENDERQUEUE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/HashMap.h>
+#include "Tools/WorkerPool.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneNode;
+}
+class PortalCuller;
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Render queue of the visible meshes, sorted by render state once per frame
+*
+*  @remarks
+*    Once per frame, after the portal and occlusion culling, each material of each visible mesh becomes a queue item
+*    with a 64 bit sort key. Opaque items are keyed by pass, material, mesh and depth bucket (most significant first),
+*    so the material and mesh switches are minimized and the items sharing both are drawn front to back. Transparent
+*    items are keyed by pass, inverted depth bucket, material and mesh, so they are drawn back to front. The material
+*    and mesh ids are assigned once when the queue is built, the blend state of the materials as well.
+*
+*    The keys are sorted by a least significant digit radix sort with 8 bit digits. A pass whose digit is equal for
+*    all keys is skipped, so the sort usually takes far less than 8 passes. Queues with at least "ParallelThreshold"
+*    items are split into one chunk per worker thread, the chunks are counted and scattered in parallel.
+*
+*    The queue counts the material and mesh switches of the items in scene graph order and in sorted order. It's a
+*    measurement tool: The scene renderer of the engine still draws in scene graph order, nothing draws in the sorted
+*    order yet, so the queue is disabled by default (see "DungeonConfig::RenderQueue") and the switch counters only
+*    tell how much a sorted draw path would save.
+*/
+class RenderQueue {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 ParallelThreshold = 4096;		/**< Minimum number of items sorted in parallel */
+		static const PLCore::uint32 IdBits			  = 20;			/**< Number of key bits of the material, mesh and depth bucket */
+		static const PLCore::uint32 MaxId			  = 0xFFFFF;	/**< Maximum material, mesh and depth bucket, larger ones share this one */
+
+		/**
+		*  @brief
+		*    Render pass, the most significant 4 bits of a sort key
+		*/
+		enum EPass {
+			OpaquePass		= 0,	/**< Opaque materials, sorted by state and front to back */
+			TransparentPass = 1		/**< Blended materials, sorted back to front */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] nNumOfThreads
+		*    Number of worker threads sorting large queues
+		*/
+		explicit RenderQueue(PLCore::uint32 nNumOfThreads);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~RenderQueue();
+
+		/**
+		*  @brief
+		*    Gathers the meshes and their materials within the cells of a portal culler
+		*
+		*  @param[in] cPortalCuller
+		*    Portal culler providing the cells and the visible scene nodes, must stay valid as long as this queue is used
+		*
+		*  @return
+		*    The number of meshes
+		*/
+		PLCore::uint32 Build(const PortalCuller &cPortalCuller);
+
+		/**
+		*  @brief
+		*    Removes the meshes and the items
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Builds and sorts the queue of the visible meshes
+		*
+		*  @param[in] pCamera
+		*    Camera scene node, can be a null pointer
+		*
+		*  @note
+		*    - The portal culler (and the occlusion culler, if any) must have been updated for the same camera right before
+		*    - If there's no camera, the queue is empty
+		*/
+		void Update(PLScene::SceneNode *pCamera);
+
+		/**
+		*  @brief
+		*    Returns the number of items
+		*
+		*  @return
+		*    The number of items of the last update
+		*/
+		PLCore::uint32 GetNumOfItems() const;
+
+		/**
+		*  @brief
+		*    Returns the sort key of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The sort key
+		*/
+		PLCore::uint64 GetKey(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the scene node of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The scene node, null pointer if it was destroyed since the last update
+		*/
+		PLScene::SceneNode *GetSceneNode(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the cell of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The index of the cell within the portal culler
+		*/
+		PLCore::uint32 GetCell(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the octree entry of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The index of the octree entry within the cell
+		*/
+		PLCore::uint32 GetEntry(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the material id of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The material id, items with the same material share it
+		*/
+		PLCore::uint32 GetMaterial(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the mesh id of an item
+		*
+		*  @param[in] nIndex
+		*    Index of the item within the sorted order, must be valid
+		*
+		*  @return
+		*    The mesh id, items with the same mesh share it
+		*/
+		PLCore::uint32 GetMesh(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the counters of the last update as string
+		*
+		*  @return
+		*    The counters as string (e.g. "Items=\"420\" Materials=\"64\" Meshes=\"180\" SceneMaterialChanges=\"310\" SceneMeshChanges=\"380\" SortedMaterialChanges=\"52\" SortedMeshChanges=\"140\" SortPasses=\"5\" SortTime=\"0.041\"")
+		*/
+		PLCore::String ToString() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Draw of a material of a mesh scene node
+		*/
+		struct Draw {
+			PLCore::uint32 nMaterial;	/**< Material id */
+			PLCore::uint32 nMesh;		/**< Mesh id */
+			PLCore::uint32 nPass;		/**< Render pass (see "EPass") */
+		};
+
+		/**
+		*  @brief
+		*    Cell
+		*/
+		struct Cell {
+			PLCore::Array<PLCore::uint32> lstFirstDraws;	/**< Index of the first draw per octree entry, followed by the total number of draws */
+			PLCore::Array<Draw>			  lstDraws;			/**< Draws of the octree entries */
+		};
+
+		/**
+		*  @brief
+		*    Queue item
+		*/
+		struct Item {
+			PLCore::uint64 nKey;		/**< Sort key */
+			PLCore::uint32 nCell;		/**< Index of the cell */
+			PLCore::uint32 nEntry;		/**< Index of the octree entry within the cell */
+			PLCore::uint32 nMaterial;	/**< Material id */
+			PLCore::uint32 nMesh;		/**< Mesh id */
+		};
+
+		/**
+		*  @brief
+		*    Job counting or scattering a chunk of the items within a parallel radix sort pass
+		*/
+		class SortJob : public WorkerPool::Job {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Constructor
+				*
+				*  @param[in] cRenderQueue
+				*    Owner render queue
+				*  @param[in] nChunk
+				*    Index of the chunk
+				*  @param[in] bScatter
+				*    Scatter the chunk? (else the digits of the chunk are counted)
+				*/
+				SortJob(RenderQueue &cRenderQueue, PLCore::uint32 nChunk, bool bScatter);
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual WorkerPool::Job functions              ]
+			//[-------------------------------------------------------]
+			public:
+				virtual void Execute() override;
+
+
+			//[-------------------------------------------------------]
+			//[ Private data                                          ]
+			//[-------------------------------------------------------]
+			private:
+				RenderQueue	   *m_pRenderQueue;	/**< Owner render queue, always valid */
+				PLCore::uint32	m_nChunk;		/**< Index of the chunk */
+				bool			m_bScatter;		/**< Scatter the chunk? */
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		RenderQueue(const RenderQueue &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		RenderQueue &operator =(const RenderQueue &cSource);
+
+		/**
+		*  @brief
+		*    Returns the id of a name, new names get the next free id
+		*
+		*  @param[in] mapIds
+		*    Ids by name, incremented by one so a missing name can be told apart
+		*  @param[in] sName
+		*    Name to return the id of
+		*
+		*  @return
+		*    The id, at most "MaxId"
+		*/
+		static PLCore::uint32 GetId(PLCore::HashMap<PLCore::String, PLCore::uint32> &mapIds, const PLCore::String &sName);
+
+		/**
+		*  @brief
+		*    Counts the material and mesh switches of the items
+		*
+		*  @param[in]  pItems
+		*    Items in draw order
+		*  @param[out] nMaterialChanges
+		*    Receives the number of material switches, the first item counts as one
+		*  @param[out] nMeshChanges
+		*    Receives the number of mesh switches, the first item counts as one
+		*/
+		void CountChanges(const Item *pItems, PLCore::uint32 &nMaterialChanges, PLCore::uint32 &nMeshChanges) const;
+
+		/**
+		*  @brief
+		*    Sorts the items by their keys
+		*/
+		void Sort();
+
+		/**
+		*  @brief
+		*    Counts the digits of a chunk of the current parallel sort pass
+		*
+		*  @param[in] nChunk
+		*    Index of the chunk
+		*
+		*  @note
+		*    - Called by the worker threads, the chunks don't share any data which is written
+		*/
+		void CountChunk(PLCore::uint32 nChunk);
+
+		/**
+		*  @brief
+		*    Scatters a chunk of the current parallel sort pass
+		*
+		*  @param[in] nChunk
+		*    Index of the chunk
+		*
+		*  @note
+		*    - Called by the worker threads, the chunks don't share any data which is written
+		*/
+		void ScatterChunk(PLCore::uint32 nChunk);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		WorkerPool										 m_cWorkerPool;					/**< Worker threads sorting large queues */
+		const PortalCuller								*m_pPortalCuller;				/**< Portal culler providing the cells and the visible scene nodes, null pointer if not built */
+		PLCore::Array<Cell*>							 m_lstCells;					/**< Cells, same order as within the portal culler */
+		PLCore::HashMap<PLCore::String, PLCore::uint32>	 m_mapMaterials;				/**< Material ids plus one by material name */
+		PLCore::HashMap<PLCore::String, PLCore::uint32>	 m_mapMeshes;					/**< Mesh ids plus one by mesh name */
+		PLCore::uint32									 m_nNumOfMeshes;				/**< Number of mesh scene nodes within all cells */
+		PLCore::Array<Item>								 m_lstItems;					/**< Items, in scene graph order until sorted */
+		PLCore::Array<Item>								 m_lstSortBuffer;				/**< Second buffer of the radix sort */
+		const Item										*m_pSortedItems;				/**< Sorted items, points into one of the two buffers */
+		PLCore::Array<PLCore::uint32>					 m_lstChunkCounts;				/**< 256 digit counts, turned into scatter offsets, per chunk of a parallel sort pass */
+		const Item										*m_pSortSource;					/**< Items read by the current parallel sort pass */
+		Item											*m_pSortDestination;			/**< Items written by the current parallel sort pass */
+		PLCore::uint32									 m_nSortShift;					/**< Bit shift of the digit of the current parallel sort pass */
+		PLCore::uint32									 m_nNumOfChunks;				/**< Number of chunks of the current parallel sort pass */
+		PLCore::uint32									 m_nSceneMaterialChanges;		/**< Material switches of the last update in scene graph order */
+		PLCore::uint32									 m_nSceneMeshChanges;			/**< Mesh switches of the last update in scene graph order */
+		PLCore::uint32									 m_nSortedMaterialChanges;		/**< Material switches of the last update in sorted order */
+		PLCore::uint32									 m_nSortedMeshChanges;			/**< Mesh switches of the last update in sorted order */
+		PLCore::uint32									 m_nNumOfSortPasses;			/**< Radix sort passes of the last update which were not skipped */
+		float											 m_fSortTime;					/**< Duration of the sort of the last update (in milliseconds) */
+
+
+};
+
+
+#endif // __DUNGEON_RENDERQUEUE_H__
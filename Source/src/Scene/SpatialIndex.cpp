@@ -0,0 +1,280 @@
+/*********************************************************\
+ *  File: SpatialIndex.cpp                               *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/Base/Var/DynVar.h>
+#include <PLMath/Math.h>
+#include <PLMath/AABoundingBox.h>
+#include <PLScene/Scene/SceneContainer.h>
+#include <PLScene/Scene/SceneNodeModifier.h>
+#include "Scene/SpatialIndex.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+using namespace PLMath;
+using namespace PLScene;
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+SpatialIndex::SpatialIndex()
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+SpatialIndex::~SpatialIndex()
+{
+	Clear();
+}
+
+/**
+*  @brief
+*    Builds the octrees of a scene container
+*/
+void SpatialIndex::Build(SceneContainer &cContainer)
+{
+	Clear();
+	AddCells(cContainer);
+}
+
+/**
+*  @brief
+*    Destroys all octrees
+*/
+void SpatialIndex::Clear()
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		delete m_lstCells[i];
+	m_lstCells.Clear();
+}
+
+/**
+*  @brief
+*    Updates the bounding boxes of the movable scene nodes
+*/
+uint32 SpatialIndex::Refit()
+{
+	uint32 nNumOfChanged = 0;
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		Cell &cCell = *m_lstCells[i];
+
+		// Nothing moves within evicted cells
+		const SceneNode *pContainer = cCell.cContainer.GetElement();
+		if (pContainer && pContainer->IsActive()) {
+			for (uint32 j=0; j<cCell.lstMovable.GetNumOfElements(); j++) {
+				const uint32 nEntry = cCell.lstMovable[j];
+				SceneNode *pSceneNode = cCell.cOctree.GetSceneNode(nEntry);
+				if (pSceneNode) {
+					const AABoundingBox &cBox = pSceneNode->GetContainerAABoundingBox();
+					Vector3 vMin, vMax;
+					cCell.cOctree.GetBoundingBox(nEntry, vMin, vMax);
+					if (cBox.vMin != vMin || cBox.vMax != vMax) {
+						cCell.cOctree.Update(nEntry, cBox.vMin, cBox.vMax);
+						nNumOfChanged++;
+					}
+				}
+			}
+		}
+	}
+
+	// Done
+	return nNumOfChanged;
+}
+
+/**
+*  @brief
+*    Returns the number of octrees
+*/
+uint32 SpatialIndex::GetNumOfOctrees() const
+{
+	return m_lstCells.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Returns the scene container of an octree
+*/
+SceneContainer *SpatialIndex::GetContainer(uint32 nIndex) const
+{
+	return (nIndex < m_lstCells.GetNumOfElements()) ? static_cast<SceneContainer*>(m_lstCells[nIndex]->cContainer.GetElement()) : nullptr;
+}
+
+/**
+*  @brief
+*    Returns an octree
+*/
+const LooseOctree *SpatialIndex::GetOctree(uint32 nIndex) const
+{
+	return (nIndex < m_lstCells.GetNumOfElements()) ? &m_lstCells[nIndex]->cOctree : nullptr;
+}
+
+/**
+*  @brief
+*    Returns the octree of a cell
+*/
+const LooseOctree *SpatialIndex::GetOctree(const SceneContainer &cContainer) const
+{
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++) {
+		if (m_lstCells[i]->cContainer.GetElement() == &cContainer)
+			return &m_lstCells[i]->cOctree;
+	}
+
+	// Error!
+	return nullptr;
+}
+
+/**
+*  @brief
+*    Returns the number of indexed scene nodes
+*/
+uint32 SpatialIndex::GetNumOfSceneNodes() const
+{
+	uint32 nNumOfSceneNodes = 0;
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		nNumOfSceneNodes += m_lstCells[i]->cOctree.GetNumOfEntries();
+	return nNumOfSceneNodes;
+}
+
+/**
+*  @brief
+*    Returns the number of movable scene nodes
+*/
+uint32 SpatialIndex::GetNumOfMovableSceneNodes() const
+{
+	uint32 nNumOfSceneNodes = 0;
+	for (uint32 i=0; i<m_lstCells.GetNumOfElements(); i++)
+		nNumOfSceneNodes += m_lstCells[i]->lstMovable.GetNumOfElements();
+	return nNumOfSceneNodes;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+SpatialIndex::SpatialIndex(const SpatialIndex &cSource)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+SpatialIndex &SpatialIndex::operator =(const SpatialIndex &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Adds the octrees of a scene container and the cells within it
+*/
+void SpatialIndex::AddCells(SceneContainer &cContainer)
+{
+	Cell *pCell = new Cell;
+	pCell->cContainer.SetElement(&cContainer);
+	m_lstCells.Add(pCell);
+
+	// Gather the scene nodes, the region they're in and the scene nodes moved by anchors
+	Array<SceneNode*> lstSceneNodes;
+	Array<SceneNode*> lstAttached;
+	Vector3 vMin( Math::MaxFloat,  Math::MaxFloat,  Math::MaxFloat);
+	Vector3 vMax(-Math::MaxFloat, -Math::MaxFloat, -Math::MaxFloat);
+	for (uint32 i=0; i<cContainer.GetNumOfElements(); i++) {
+		SceneNode *pSceneNode = cContainer.GetByIndex(i);
+		if (pSceneNode) {
+			if (pSceneNode->IsInstanceOf("PLScene::SCCell")) {
+				AddCells(static_cast<SceneContainer&>(*pSceneNode));
+			} else {
+				lstSceneNodes.Add(pSceneNode);
+				const AABoundingBox &cBox = pSceneNode->GetContainerAABoundingBox();
+				vMin.x = Math::Min(vMin.x, cBox.vMin.x);
+				vMin.y = Math::Min(vMin.y, cBox.vMin.y);
+				vMin.z = Math::Min(vMin.z, cBox.vMin.z);
+				vMax.x = Math::Max(vMax.x, cBox.vMax.x);
+				vMax.y = Math::Max(vMax.y, cBox.vMax.y);
+				vMax.z = Math::Max(vMax.z, cBox.vMax.z);
+				for (uint32 j=0; j<pSceneNode->GetNumOfModifiers(); j++) {
+					const SceneNodeModifier *pSceneNodeModifier = pSceneNode->GetModifier("", j);
+					if (pSceneNodeModifier->IsInstanceOf("PLScene::SNMAnchor")) {
+						const DynVar *pAttachedNode = pSceneNodeModifier->GetAttribute("AttachedNode");
+						SceneNode *pAttachedSceneNode = pAttachedNode ? cContainer.GetByName(pAttachedNode->GetString()) : nullptr;
+						if (pAttachedSceneNode)
+							lstAttached.Add(pAttachedSceneNode);
+					}
+				}
+			}
+		}
+	}
+
+	// Build the octree
+	if (lstSceneNodes.GetNumOfElements())
+		pCell->cOctree.Reset(vMin, vMax);
+	for (uint32 i=0; i<lstSceneNodes.GetNumOfElements(); i++) {
+		SceneNode &cSceneNode = *lstSceneNodes[i];
+		const AABoundingBox &cBox = cSceneNode.GetContainerAABoundingBox();
+		const uint32 nEntry = pCell->cOctree.Add(cSceneNode, cBox.vMin, cBox.vMax);
+		if (IsMovable(cSceneNode) || lstAttached.IsElement(&cSceneNode))
+			pCell->lstMovable.Add(nEntry);
+	}
+}
+
+/**
+*  @brief
+*    Returns whether or not a scene node can move by itself
+*/
+bool SpatialIndex::IsMovable(SceneNode &cSceneNode)
+{
+	for (uint32 i=0; i<cSceneNode.GetNumOfModifiers(); i++) {
+		const SceneNodeModifier *pSceneNodeModifier = cSceneNode.GetModifier("", i);
+
+		// Massless bodies are static, everything else (bodies with mass, controllers, animations, scripts etc.) may move
+		if (pSceneNodeModifier->IsInstanceOf("PLPhysics::SNMPhysicsBody")) {
+			const DynVar *pMass = pSceneNodeModifier->GetAttribute("Mass");
+			if (pMass && pMass->GetFloat() > 0.0f)
+				return true;
+		} else {
+			return true;
+		}
+	}
+
+	// Done
+	return false;
+}
@@ -0,0 +1,242 @@
+/*********************************************************\
+ *  File: SpatialIndex.h                                 *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_SPATIALINDEX_H__
+#define __DUNGEON_SPATIALINDEX_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLScene/Scene/SceneNodeHandler.h>
+#include "Scene/LooseOctree.h"
+
+
+//[-------------------------------------------------------]
+//[ Forward declarations                                  ]
+//[-------------------------------------------------------]
+namespace PLScene {
+	class SceneContainer;
+}
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Spatial index of the scene nodes, one loose octree per cell
+*
+*  @remarks
+*    Shared by the subsystems which need to find the scene nodes within a region (culling, queries etc.) instead of
+*    walking all scene nodes of a cell. There's one octree (see "LooseOctree") per cell and one for the scene nodes
+*    directly within the scene container, each holding the bounding boxes of the scene nodes directly within it
+*    within the space of the cell. Scene containers which are no cells are indexed as a whole. The octrees are built
+*    at once, afterwards "Refit()" only looks at the movable scene nodes: Scene nodes having a physics body with mass,
+*    scene nodes having any other modifier than a massless physics body, and scene nodes attached to another scene
+*    node by an anchor modifier. Everything else is assumed to stay where it was loaded.
+*/
+class SpatialIndex {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		SpatialIndex();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~SpatialIndex();
+
+		/**
+		*  @brief
+		*    Builds the octrees of a scene container
+		*
+		*  @param[in] cContainer
+		*    Scene container to index, the cells within it get octrees of their own, must stay valid as long as
+		*    this index is used
+		*/
+		void Build(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Destroys all octrees
+		*/
+		void Clear();
+
+		/**
+		*  @brief
+		*    Updates the bounding boxes of the movable scene nodes
+		*
+		*  @return
+		*    The number of scene nodes which bounding box changed
+		*
+		*  @note
+		*    - Call this once per frame after the scene update, the octrees of inactive (evicted) cells are skipped
+		*/
+		PLCore::uint32 Refit();
+
+		/**
+		*  @brief
+		*    Returns the number of octrees
+		*
+		*  @return
+		*    The number of octrees
+		*/
+		PLCore::uint32 GetNumOfOctrees() const;
+
+		/**
+		*  @brief
+		*    Returns the scene container of an octree
+		*
+		*  @param[in] nIndex
+		*    Index of the octree
+		*
+		*  @return
+		*    The cell or the scene container itself, null pointer on error
+		*/
+		PLScene::SceneContainer *GetContainer(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns an octree
+		*
+		*  @param[in] nIndex
+		*    Index of the octree
+		*
+		*  @return
+		*    The octree, null pointer on error
+		*/
+		const LooseOctree *GetOctree(PLCore::uint32 nIndex) const;
+
+		/**
+		*  @brief
+		*    Returns the octree of a cell
+		*
+		*  @param[in] cContainer
+		*    Cell or the indexed scene container itself
+		*
+		*  @return
+		*    The octree, null pointer if the scene container has no octree
+		*/
+		const LooseOctree *GetOctree(const PLScene::SceneContainer &cContainer) const;
+
+		/**
+		*  @brief
+		*    Returns the number of indexed scene nodes
+		*
+		*  @return
+		*    The number of indexed scene nodes
+		*/
+		PLCore::uint32 GetNumOfSceneNodes() const;
+
+		/**
+		*  @brief
+		*    Returns the number of movable scene nodes
+		*
+		*  @return
+		*    The number of scene nodes looked at by "Refit()"
+		*/
+		PLCore::uint32 GetNumOfMovableSceneNodes() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Octree of a cell or the scene container
+		*/
+		struct Cell {
+			PLScene::SceneNodeHandler	  cContainer;	/**< Cell or the scene container itself */
+			LooseOctree					  cOctree;		/**< Octree of the scene nodes directly within the scene container */
+			PLCore::Array<PLCore::uint32> lstMovable;	/**< Octree entries of the movable scene nodes */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		SpatialIndex(const SpatialIndex &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		SpatialIndex &operator =(const SpatialIndex &cSource);
+
+		/**
+		*  @brief
+		*    Adds the octrees of a scene container and the cells within it
+		*
+		*  @param[in] cContainer
+		*    Scene container to add
+		*/
+		void AddCells(PLScene::SceneContainer &cContainer);
+
+		/**
+		*  @brief
+		*    Returns whether or not a scene node can move by itself
+		*
+		*  @param[in] cSceneNode
+		*    Scene node to check
+		*
+		*  @return
+		*    'true' if the scene node can move by itself, else 'false'
+		*/
+		static bool IsMovable(PLScene::SceneNode &cSceneNode);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Array<Cell*> m_lstCells;	/**< Octrees, the one of the scene container given to "Build()" is the first one */
+
+
+};
+
+
+#endif // __DUNGEON_SPATIALINDEX_H__
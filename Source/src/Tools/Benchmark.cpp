@@ -0,0 +1,358 @@
+/*********************************************************\
+ *  File: Benchmark.cpp                                  *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <stdlib.h>	// For "qsort()"
+#include <PLCore/File/File.h>
+#include <PLCore/System/System.h>
+#include "Tools/Benchmark.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    "qsort()" compare function for microsecond values
+*/
+static int CompareMicroseconds(const void *pFirst, const void *pSecond)
+{
+	const uint64 nFirst  = *static_cast<const uint64*>(pFirst);
+	const uint64 nSecond = *static_cast<const uint64*>(pSecond);
+	return (nFirst < nSecond) ? -1 : ((nFirst > nSecond) ? 1 : 0);
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+Benchmark::Benchmark(const String &sName, float fFramesPerSecond) :
+	m_sName(sName),
+	m_fFramesPerSecond(fFramesPerSecond),
+	m_bRecording(false),
+	m_nFrameStart(0)
+{
+	// Initialize the current frame
+	for (uint32 i=0; i<NumOfSections; i++) {
+		m_nSectionStart[i]				= 0;
+		m_sCurrentFrame.nSection[i]	= 0;
+	}
+	m_sCurrentFrame.nTotal = 0;
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+Benchmark::~Benchmark()
+{
+}
+
+/**
+*  @brief
+*    Returns the benchmark name
+*/
+const String &Benchmark::GetName() const
+{
+	return m_sName;
+}
+
+/**
+*  @brief
+*    Returns the simulated frames per second the benchmark is running with
+*/
+float Benchmark::GetFramesPerSecond() const
+{
+	return m_fFramesPerSecond;
+}
+
+/**
+*  @brief
+*    Returns whether or not the benchmark is currently recording
+*/
+bool Benchmark::IsRecording() const
+{
+	return m_bRecording;
+}
+
+/**
+*  @brief
+*    Starts the recording
+*/
+void Benchmark::Start()
+{
+	// Remove previously recorded frames
+	m_lstFrames.Clear();
+
+	// Reset the current frame
+	for (uint32 i=0; i<NumOfSections; i++)
+		m_sCurrentFrame.nSection[i] = 0;
+	m_sCurrentFrame.nTotal = 0;
+
+	// Start recording
+	m_nFrameStart = System::GetInstance()->GetMicroseconds();
+	m_bRecording  = true;
+}
+
+/**
+*  @brief
+*    Stops the recording
+*/
+void Benchmark::Stop()
+{
+	m_bRecording = false;
+}
+
+/**
+*  @brief
+*    Begins a section of the current frame
+*/
+void Benchmark::BeginSection(ESection nSection)
+{
+	m_nSectionStart[nSection] = System::GetInstance()->GetMicroseconds();
+}
+
+/**
+*  @brief
+*    Ends a section of the current frame
+*/
+uint64 Benchmark::EndSection(ESection nSection)
+{
+	const uint64 nTime = System::GetInstance()->GetMicroseconds() - m_nSectionStart[nSection];
+	AddTime(nSection, nTime);
+	return nTime;
+}
+
+/**
+*  @brief
+*    Adds time to a section of the current frame
+*/
+void Benchmark::AddTime(ESection nSection, uint64 nMicroseconds)
+{
+	if (m_bRecording)
+		m_sCurrentFrame.nSection[nSection] += nMicroseconds;
+}
+
+/**
+*  @brief
+*    Closes the current frame record
+*/
+void Benchmark::EndFrame()
+{
+	if (m_bRecording) {
+		// Make the scene update time exclusive
+		const uint64 nIncluded = m_sCurrentFrame.nSection[ModifierUpdate] + m_sCurrentFrame.nSection[PhysicsStep];
+		m_sCurrentFrame.nSection[SceneUpdate] = (m_sCurrentFrame.nSection[SceneUpdate] > nIncluded) ? m_sCurrentFrame.nSection[SceneUpdate] - nIncluded : 0;
+
+		// The frame total is the time between the start of this frame and the start of the next one
+		const uint64 nTime = System::GetInstance()->GetMicroseconds();
+		m_sCurrentFrame.nTotal = nTime - m_nFrameStart;
+		m_nFrameStart = nTime;
+
+		// Add the frame record
+		m_lstFrames.Add(m_sCurrentFrame);
+
+		// Reset the current frame
+		for (uint32 i=0; i<NumOfSections; i++)
+			m_sCurrentFrame.nSection[i] = 0;
+		m_sCurrentFrame.nTotal = 0;
+	}
+}
+
+/**
+*  @brief
+*    Returns the number of recorded frames
+*/
+uint32 Benchmark::GetNumOfFrames() const
+{
+	return m_lstFrames.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Writes the recorded frames into a CSV file
+*/
+bool Benchmark::SaveCSV(const String &sFilename) const
+{
+	// Open the file
+	File cFile(sFilename);
+	if (cFile.Open(File::FileCreate | File::FileWrite)) {
+		// Write the header, all times are in milliseconds
+		String sLine = "Frame";
+		for (uint32 i=0; i<NumOfSections; i++)
+			sLine += ',' + GetSectionName(static_cast<ESection>(i));
+		cFile.PutS(sLine + ",Total\n");
+
+		// Write one line per frame
+		for (uint32 nFrame=0; nFrame<m_lstFrames.GetNumOfElements(); nFrame++) {
+			const Frame &sFrame = m_lstFrames[nFrame];
+			sLine = String(nFrame);
+			for (uint32 i=0; i<NumOfSections; i++)
+				sLine += String::Format(",%.3f", sFrame.nSection[i]/1000.0);
+			cFile.PutS(sLine + String::Format(",%.3f\n", sFrame.nTotal/1000.0));
+		}
+
+		// Done
+		cFile.Close();
+		return true;
+	}
+
+	// Error!
+	return false;
+}
+
+/**
+*  @brief
+*    Writes the recorded frames and a summary into a JSON file
+*/
+bool Benchmark::SaveJSON(const String &sFilename) const
+{
+	// Open the file
+	File cFile(sFilename);
+	if (cFile.Open(File::FileCreate | File::FileWrite)) {
+		// General information
+		cFile.PutS("{\n");
+		cFile.PutS("\t\"name\": \"" + m_sName + "\",\n");
+		cFile.PutS(String::Format("\t\"framesPerSecond\": %g,\n", m_fFramesPerSecond));
+		cFile.PutS(String::Format("\t\"numOfFrames\": %d,\n", m_lstFrames.GetNumOfElements()));
+
+		// Summary, all times are in milliseconds
+		cFile.PutS("\t\"summary\": {\n");
+		for (uint32 i=0; i<=NumOfSections; i++) {
+			float fAverage, fMinimum, fMaximum, fPercentile95;
+			GetStatistics(i, fAverage, fMinimum, fMaximum, fPercentile95);
+			const String sName = (i < NumOfSections) ? GetSectionName(static_cast<ESection>(i)) : "Total";
+			cFile.PutS(String::Format("\t\t\"%s\": { \"average\": %.3f, \"minimum\": %.3f, \"maximum\": %.3f, \"percentile95\": %.3f }%s\n",
+									  sName.GetASCII(), fAverage, fMinimum, fMaximum, fPercentile95, (i < NumOfSections) ? "," : ""));
+		}
+		cFile.PutS("\t},\n");
+
+		// Frames, all times are in milliseconds
+		cFile.PutS("\t\"frames\": [\n");
+		for (uint32 nFrame=0; nFrame<m_lstFrames.GetNumOfElements(); nFrame++) {
+			const Frame &sFrame = m_lstFrames[nFrame];
+			String sLine = "\t\t{ ";
+			for (uint32 i=0; i<NumOfSections; i++)
+				sLine += String::Format("\"%s\": %.3f, ", GetSectionName(static_cast<ESection>(i)).GetASCII(), sFrame.nSection[i]/1000.0);
+			sLine += String::Format("\"Total\": %.3f }", sFrame.nTotal/1000.0);
+			cFile.PutS(sLine + ((nFrame+1 < m_lstFrames.GetNumOfElements()) ? ",\n" : "\n"));
+		}
+		cFile.PutS("\t]\n");
+		cFile.PutS("}\n");
+
+		// Done
+		cFile.Close();
+		return true;
+	}
+
+	// Error!
+	return false;
+}
+
+/**
+*  @brief
+*    Returns the name of a section
+*/
+String Benchmark::GetSectionName(ESection nSection)
+{
+	switch (nSection) {
+		case SceneUpdate:		return "SceneUpdate";
+		case ScriptUpdate:		return "ScriptUpdate";
+		case PhysicsStep:		return "PhysicsStep";
+		case ModifierUpdate:	return "ModifierUpdate";
+		case RenderSubmission:	return "RenderSubmission";
+		default:				return "";
+	}
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+Benchmark::Benchmark(const Benchmark &cSource) :
+	m_fFramesPerSecond(0.0f),
+	m_bRecording(false),
+	m_nFrameStart(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+Benchmark &Benchmark::operator =(const Benchmark &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the average, minimum, maximum and 95th percentile of a section over all recorded frames
+*/
+void Benchmark::GetStatistics(uint32 nSection, float &fAverage, float &fMinimum, float &fMaximum, float &fPercentile95) const
+{
+	const uint32 nNumOfFrames = m_lstFrames.GetNumOfElements();
+	if (nNumOfFrames) {
+		// Gather the section times
+		Array<uint64> lstTimes;
+		lstTimes.Resize(nNumOfFrames);
+		uint64 nSum = 0;
+		for (uint32 i=0; i<nNumOfFrames; i++) {
+			const Frame &sFrame = m_lstFrames[i];
+			const uint64 nTime = (nSection < NumOfSections) ? sFrame.nSection[nSection] : sFrame.nTotal;
+			lstTimes[i] = nTime;
+			nSum += nTime;
+		}
+
+		// Sort the section times
+		qsort(lstTimes.GetData(), nNumOfFrames, sizeof(uint64), CompareMicroseconds);
+
+		// Evaluate
+		fAverage	  = static_cast<float>(static_cast<double>(nSum)/nNumOfFrames/1000.0);
+		fMinimum	  = static_cast<float>(lstTimes[0]/1000.0);
+		fMaximum	  = static_cast<float>(lstTimes[nNumOfFrames-1]/1000.0);
+		fPercentile95 = static_cast<float>(lstTimes[(nNumOfFrames-1)*95/100]/1000.0);
+	} else {
+		fAverage	  = 0.0f;
+		fMinimum	  = 0.0f;
+		fMaximum	  = 0.0f;
+		fPercentile95 = 0.0f;
+	}
+}
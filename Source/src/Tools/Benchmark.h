@@ -0,0 +1,294 @@
+/*********************************************************\
+ *  File: Benchmark.h                                    *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_BENCHMARK_H__
+#define __DUNGEON_BENCHMARK_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+#include <PLCore/Container/Array.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Benchmark recorder collecting per-frame CPU timings
+*
+*  @remarks
+*    The recorder is fed by the application: "BeginSection()" and "EndSection()" bracket the measured
+*    parts of a frame, "EndFrame()" closes the current frame record after the frame was drawn. All timings
+*    are in microseconds and measured by using "PLCore::System::GetMicroseconds()". When the benchmark is
+*    finished, the recorded frames can be written into a CSV file (one line per frame) and a JSON file (frames and summary).
+*/
+class Benchmark {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Measured frame sections
+		*/
+		enum ESection {
+			SceneUpdate      = 0,	/**< Scene update, without the modifier updates and the physics step */
+			ScriptUpdate     = 1,	/**< Lua "OnUpdate" */
+			PhysicsStep      = 2,	/**< Physics simulation step */
+			ModifierUpdate   = 3,	/**< Scene node modifier updates */
+			RenderSubmission = 4,	/**< Render submission (drawing the frame) */
+			NumOfSections    = 5	/**< Number of sections */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] sName
+		*    Benchmark name (e.g. the name of the played camcorder record)
+		*  @param[in] fFramesPerSecond
+		*    Simulated frames per second the benchmark is running with
+		*/
+		Benchmark(const PLCore::String &sName, float fFramesPerSecond);
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~Benchmark();
+
+		/**
+		*  @brief
+		*    Returns the benchmark name
+		*
+		*  @return
+		*    The benchmark name
+		*/
+		const PLCore::String &GetName() const;
+
+		/**
+		*  @brief
+		*    Returns the simulated frames per second the benchmark is running with
+		*
+		*  @return
+		*    The simulated frames per second
+		*/
+		float GetFramesPerSecond() const;
+
+		/**
+		*  @brief
+		*    Returns whether or not the benchmark is currently recording
+		*
+		*  @return
+		*    'true' if the benchmark is currently recording, else 'false'
+		*/
+		bool IsRecording() const;
+
+		/**
+		*  @brief
+		*    Starts the recording
+		*
+		*  @note
+		*    - Previously recorded frames are removed
+		*/
+		void Start();
+
+		/**
+		*  @brief
+		*    Stops the recording
+		*/
+		void Stop();
+
+		/**
+		*  @brief
+		*    Begins a section of the current frame
+		*
+		*  @param[in] nSection
+		*    Section to begin
+		*/
+		void BeginSection(ESection nSection);
+
+		/**
+		*  @brief
+		*    Ends a section of the current frame
+		*
+		*  @param[in] nSection
+		*    Section to end, the time since the corresponding "BeginSection()"-call is added to the current frame
+		*
+		*  @return
+		*    The measured time in microseconds
+		*/
+		PLCore::uint64 EndSection(ESection nSection);
+
+		/**
+		*  @brief
+		*    Adds time to a section of the current frame
+		*
+		*  @param[in] nSection
+		*    Section to add the time to
+		*  @param[in] nMicroseconds
+		*    Time to add (in microseconds)
+		*/
+		void AddTime(ESection nSection, PLCore::uint64 nMicroseconds);
+
+		/**
+		*  @brief
+		*    Closes the current frame record
+		*
+		*  @remarks
+		*    The scene update is measured inclusive the modifier updates and the physics step, which
+		*    are emitted by the scene context update. Those are removed from the scene update time
+		*    when the frame record is closed.
+		*/
+		void EndFrame();
+
+		/**
+		*  @brief
+		*    Returns the number of recorded frames
+		*
+		*  @return
+		*    The number of recorded frames
+		*/
+		PLCore::uint32 GetNumOfFrames() const;
+
+		/**
+		*  @brief
+		*    Writes the recorded frames into a CSV file
+		*
+		*  @param[in] sFilename
+		*    Name of the file to write
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool SaveCSV(const PLCore::String &sFilename) const;
+
+		/**
+		*  @brief
+		*    Writes the recorded frames and a summary into a JSON file
+		*
+		*  @param[in] sFilename
+		*    Name of the file to write
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*/
+		bool SaveJSON(const PLCore::String &sFilename) const;
+
+		/**
+		*  @brief
+		*    Returns the name of a section
+		*
+		*  @param[in] nSection
+		*    Section to return the name from
+		*
+		*  @return
+		*    The name of the section
+		*/
+		static PLCore::String GetSectionName(ESection nSection);
+
+
+	//[-------------------------------------------------------]
+	//[ Private definitions                                   ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Timings of a single frame
+		*/
+		struct Frame {
+			PLCore::uint64 nSection[NumOfSections];	/**< Time spent within each section (in microseconds) */
+			PLCore::uint64 nTotal;					/**< Time between the start of this frame and the start of the next one (in microseconds) */
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		Benchmark(const Benchmark &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		Benchmark &operator =(const Benchmark &cSource);
+
+		/**
+		*  @brief
+		*    Returns the average, minimum, maximum and 95th percentile of a section over all recorded frames
+		*
+		*  @param[in]  nSection
+		*    Section to evaluate, "NumOfSections" for the frame total
+		*  @param[out] fAverage
+		*    Receives the average (in milliseconds)
+		*  @param[out] fMinimum
+		*    Receives the minimum (in milliseconds)
+		*  @param[out] fMaximum
+		*    Receives the maximum (in milliseconds)
+		*  @param[out] fPercentile95
+		*    Receives the 95th percentile (in milliseconds)
+		*/
+		void GetStatistics(PLCore::uint32 nSection, float &fAverage, float &fMinimum, float &fMaximum, float &fPercentile95) const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::String			m_sName;							/**< Benchmark name */
+		float					m_fFramesPerSecond;					/**< Simulated frames per second */
+		bool					m_bRecording;						/**< Currently recording? */
+		PLCore::uint64			m_nFrameStart;						/**< Start time of the current frame (in microseconds) */
+		PLCore::uint64			m_nSectionStart[NumOfSections];		/**< Start times of the currently open sections (in microseconds) */
+		Frame					m_sCurrentFrame;					/**< Timings of the current frame */
+		PLCore::Array<Frame>	m_lstFrames;						/**< Recorded frames */
+
+
+};
+
+
+#endif // __DUNGEON_BENCHMARK_H__
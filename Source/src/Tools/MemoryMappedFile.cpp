@@ -0,0 +1,236 @@
+/*********************************************************\
+ *  File: MemoryMappedFile.cpp                           *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#ifdef WIN32
+	#include <PLCore/PLCoreWindowsIncludes.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+#include "Tools/MemoryMappedFile.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns the time the file was last modified
+*/
+uint64 MemoryMappedFile::GetModificationTime(const String &sNativeFilename)
+{
+	#ifdef WIN32
+		WIN32_FILE_ATTRIBUTE_DATA sAttributeData;
+		if (GetFileAttributesExW(sNativeFilename.GetUnicode(), GetFileExInfoStandard, &sAttributeData))
+			return (static_cast<uint64>(sAttributeData.ftLastWriteTime.dwHighDateTime) << 32) | sAttributeData.ftLastWriteTime.dwLowDateTime;
+	#else
+		struct stat sStat;
+		if (!stat(sNativeFilename.GetUTF8(), &sStat))
+			return static_cast<uint64>(sStat.st_mtime);
+	#endif
+
+	// Error!
+	return 0;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+MemoryMappedFile::MemoryMappedFile() :
+	#ifdef WIN32
+		m_hFile(nullptr),
+		m_hMapping(nullptr),
+	#else
+		m_nFile(-1),
+	#endif
+	m_pnData(nullptr),
+	m_nSize(0)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+/**
+*  @brief
+*    Maps a file into memory
+*/
+bool MemoryMappedFile::Open(const String &sNativeFilename)
+{
+	// Unmap the previous file
+	Close();
+
+	#ifdef WIN32
+		// Open the file
+		HANDLE hFile = CreateFileW(sNativeFilename.GetUnicode(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile != INVALID_HANDLE_VALUE) {
+			// Map the file
+			const DWORD nSize = GetFileSize(hFile, nullptr);
+			if (nSize != INVALID_FILE_SIZE && nSize) {
+				HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (hMapping) {
+					void *pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+					if (pData) {
+						// Done
+						m_hFile    = hFile;
+						m_hMapping = hMapping;
+						m_pnData   = static_cast<uint8*>(pData);
+						m_nSize    = nSize;
+						return true;
+					}
+					CloseHandle(hMapping);
+				}
+			}
+			CloseHandle(hFile);
+		}
+	#else
+		// Open the file
+		const int nFile = open(sNativeFilename.GetUTF8(), O_RDONLY);
+		if (nFile != -1) {
+			// Map the file
+			struct stat sStat;
+			if (!fstat(nFile, &sStat) && sStat.st_size > 0) {
+				void *pData = mmap(nullptr, static_cast<size_t>(sStat.st_size), PROT_READ, MAP_PRIVATE, nFile, 0);
+				if (pData != MAP_FAILED) {
+					// Done
+					m_nFile  = nFile;
+					m_pnData = static_cast<uint8*>(pData);
+					m_nSize  = static_cast<uint32>(sStat.st_size);
+					return true;
+				}
+			}
+			close(nFile);
+		}
+	#endif
+
+	// Error!
+	return false;
+}
+
+/**
+*  @brief
+*    Unmaps the file
+*/
+void MemoryMappedFile::Close()
+{
+	#ifdef WIN32
+		if (m_pnData)
+			UnmapViewOfFile(m_pnData);
+		if (m_hMapping) {
+			CloseHandle(m_hMapping);
+			m_hMapping = nullptr;
+		}
+		if (m_hFile) {
+			CloseHandle(m_hFile);
+			m_hFile = nullptr;
+		}
+	#else
+		if (m_pnData)
+			munmap(m_pnData, m_nSize);
+		if (m_nFile != -1) {
+			close(m_nFile);
+			m_nFile = -1;
+		}
+	#endif
+	m_pnData = nullptr;
+	m_nSize  = 0;
+}
+
+/**
+*  @brief
+*    Returns whether or not a file is mapped
+*/
+bool MemoryMappedFile::IsOpen() const
+{
+	return (m_pnData != nullptr);
+}
+
+/**
+*  @brief
+*    Returns the mapped file content
+*/
+const uint8 *MemoryMappedFile::GetData() const
+{
+	return m_pnData;
+}
+
+/**
+*  @brief
+*    Returns the size of the mapped file content
+*/
+uint32 MemoryMappedFile::GetSize() const
+{
+	return m_nSize;
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+MemoryMappedFile::MemoryMappedFile(const MemoryMappedFile &cSource) :
+	#ifdef WIN32
+		m_hFile(nullptr),
+		m_hMapping(nullptr),
+	#else
+		m_nFile(-1),
+	#endif
+	m_pnData(nullptr),
+	m_nSize(0)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+MemoryMappedFile &MemoryMappedFile::operator =(const MemoryMappedFile &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
@@ -0,0 +1,174 @@
+/*********************************************************\
+ *  File: MemoryMappedFile.h                             *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_MEMORYMAPPEDFILE_H__
+#define __DUNGEON_MEMORYMAPPEDFILE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Read-only memory mapped file
+*
+*  @remarks
+*    The file content is mapped into the address space of the process, so it can be accessed without reading it
+*    into memory first - the operation system pages the content in on access. If the file can't be mapped (e.g.
+*    because it's within a virtual file system such as a ZIP archive), use the ordinary PLCore file functions instead.
+*/
+class MemoryMappedFile {
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Returns the time the file was last modified
+		*
+		*  @param[in] sNativeFilename
+		*    Native filename of the file
+		*
+		*  @return
+		*    The time the file was last modified (platform dependent unit, only useful for comparisons), 0 if the file doesn't exist
+		*/
+		static PLCore::uint64 GetModificationTime(const PLCore::String &sNativeFilename);
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*/
+		MemoryMappedFile();
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~MemoryMappedFile();
+
+		/**
+		*  @brief
+		*    Maps a file into memory
+		*
+		*  @param[in] sNativeFilename
+		*    Native filename of the file to map
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*
+		*  @note
+		*    - A previously mapped file is unmapped
+		*/
+		bool Open(const PLCore::String &sNativeFilename);
+
+		/**
+		*  @brief
+		*    Unmaps the file
+		*/
+		void Close();
+
+		/**
+		*  @brief
+		*    Returns whether or not a file is mapped
+		*
+		*  @return
+		*    'true' if a file is mapped, else 'false'
+		*/
+		bool IsOpen() const;
+
+		/**
+		*  @brief
+		*    Returns the mapped file content
+		*
+		*  @return
+		*    The mapped file content, null pointer if no file is mapped, don't destroy the returned memory
+		*/
+		const PLCore::uint8 *GetData() const;
+
+		/**
+		*  @brief
+		*    Returns the size of the mapped file content
+		*
+		*  @return
+		*    The size of the mapped file content (in bytes)
+		*/
+		PLCore::uint32 GetSize() const;
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		MemoryMappedFile(const MemoryMappedFile &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		MemoryMappedFile &operator =(const MemoryMappedFile &cSource);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		#ifdef WIN32
+			void *m_hFile;			/**< File handle, null pointer if no file is mapped */
+			void *m_hMapping;		/**< File mapping handle, null pointer if no file is mapped */
+		#else
+			int   m_nFile;			/**< File descriptor, -1 if no file is mapped */
+		#endif
+		PLCore::uint8  *m_pnData;	/**< Mapped file content, null pointer if no file is mapped */
+		PLCore::uint32  m_nSize;	/**< Size of the mapped file content (in bytes) */
+
+
+};
+
+
+#endif // __DUNGEON_MEMORYMAPPEDFILE_H__
@@ -0,0 +1,258 @@
+/*********************************************************\
+ *  File: Trace.cpp                                      *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/File/File.h>
+#include <PLCore/System/Mutex.h>
+#include <PLCore/System/Thread.h>
+#include <PLCore/System/System.h>
+#include <PLCore/Container/Array.h>
+#include "Tools/Trace.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Recorded scope
+*/
+struct TraceEvent {
+	String		 sName;			/**< Scope name */
+	const char	*pszCategory;	/**< Scope category */
+	String		 sDetail;		/**< Scope detail, can be empty */
+	uint32		 nThreadID;		/**< Identifier of the thread the scope was opened by */
+	uint64		 nStart;		/**< Start time relative to the trace start (in microseconds) */
+	uint64		 nDuration;		/**< Duration (in microseconds), "Unfinished" while the scope is still open */
+};
+static const uint64 Unfinished = static_cast<uint64>(-1);	/**< Duration of a scope which is still open */
+
+
+//[-------------------------------------------------------]
+//[ Global variables                                      ]
+//[-------------------------------------------------------]
+static volatile bool	 g_bTraceEnabled   = false;	/**< Is the recorder enabled? Read without locking, so disabled scopes are free */
+static uint64			 g_nTraceStartTime = 0;		/**< Trace start time (in microseconds) */
+static Mutex			 g_cTraceMutex;				/**< Mutex guarding the recorded scopes */
+static Array<TraceEvent> g_lstTraceEvents;			/**< Recorded scopes */
+
+
+//[-------------------------------------------------------]
+//[ Global functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Returns a string escaped for the usage within a JSON string
+*/
+static String EscapeJSON(const String &sString)
+{
+	String sEscaped;
+	for (uint32 i=0; i<sString.GetLength(); i++) {
+		const char nCharacter = sString.GetASCII()[i];
+		if (nCharacter == '\"' || nCharacter == '\\')
+			sEscaped += '\\';
+		sEscaped += nCharacter;
+	}
+	return sEscaped;
+}
+
+/**
+*  @brief
+*    Returns the identifier of the current thread
+*/
+static uint32 GetCurrentThreadID()
+{
+	const Thread *pThread = System::GetInstance()->GetCurrentThread();
+	return pThread ? static_cast<uint32>(pThread->GetID()) : 0;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public static functions                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Enables the recorder
+*/
+void Trace::Enable()
+{
+	g_cTraceMutex.Lock();
+	g_lstTraceEvents.Clear();
+	g_nTraceStartTime = System::GetInstance()->GetMicroseconds();
+	g_bTraceEnabled   = true;
+	g_cTraceMutex.Unlock();
+}
+
+/**
+*  @brief
+*    Disables the recorder and removes all recorded scopes
+*/
+void Trace::Disable()
+{
+	g_cTraceMutex.Lock();
+	g_bTraceEnabled = false;
+	g_lstTraceEvents.Clear();
+	g_cTraceMutex.Unlock();
+}
+
+/**
+*  @brief
+*    Returns whether or not the recorder is enabled
+*/
+bool Trace::IsEnabled()
+{
+	return g_bTraceEnabled;
+}
+
+/**
+*  @brief
+*    Opens a scope
+*/
+uint32 Trace::Begin(const String &sName, const char *pszCategory, const String &sDetail)
+{
+	if (!g_bTraceEnabled)
+		return InvalidScope;
+
+	// Add the scope
+	const uint32 nThreadID = GetCurrentThreadID();
+	g_cTraceMutex.Lock();
+	uint32 nScope = InvalidScope;
+	if (g_bTraceEnabled) {
+		TraceEvent &sEvent = g_lstTraceEvents.Add();
+		sEvent.sName	   = sName;
+		sEvent.pszCategory = pszCategory;
+		sEvent.sDetail	   = sDetail;
+		sEvent.nThreadID   = nThreadID;
+		sEvent.nStart	   = System::GetInstance()->GetMicroseconds() - g_nTraceStartTime;
+		sEvent.nDuration   = Unfinished;
+		nScope = g_lstTraceEvents.GetNumOfElements() - 1;
+	}
+	g_cTraceMutex.Unlock();
+
+	// Done
+	return nScope;
+}
+
+/**
+*  @brief
+*    Closes a scope
+*/
+void Trace::End(uint32 nScope)
+{
+	if (nScope != InvalidScope) {
+		g_cTraceMutex.Lock();
+		if (nScope < g_lstTraceEvents.GetNumOfElements()) {
+			TraceEvent &sEvent = g_lstTraceEvents[nScope];
+			sEvent.nDuration = System::GetInstance()->GetMicroseconds() - g_nTraceStartTime - sEvent.nStart;
+		}
+		g_cTraceMutex.Unlock();
+	}
+}
+
+/**
+*  @brief
+*    Writes the recorded scopes into a trace file in the Chrome trace event format
+*/
+bool Trace::Save(const String &sFilename)
+{
+	// Open the file
+	File cFile(sFilename);
+	if (cFile.Open(File::FileCreate | File::FileWrite)) {
+		g_cTraceMutex.Lock();
+		const uint64 nTime = System::GetInstance()->GetMicroseconds() - g_nTraceStartTime;
+
+		// Write one complete event per scope, all times are in microseconds
+		cFile.PutS("{\n\t\"traceEvents\": [\n");
+		for (uint32 i=0; i<g_lstTraceEvents.GetNumOfElements(); i++) {
+			const TraceEvent &sEvent = g_lstTraceEvents[i];
+			const uint64 nDuration = (sEvent.nDuration == Unfinished) ? nTime - sEvent.nStart : sEvent.nDuration;
+			String sLine = "\t\t{ \"name\": \"" + EscapeJSON(sEvent.sName) + "\", \"cat\": \"" + sEvent.pszCategory + "\", \"ph\": \"X\", " +
+						   String::Format("\"ts\": %llu, \"dur\": %llu, \"pid\": 1, \"tid\": %u", sEvent.nStart, nDuration, sEvent.nThreadID);
+			if (sEvent.sDetail.GetLength())
+				sLine += ", \"args\": { \"detail\": \"" + EscapeJSON(sEvent.sDetail) + "\" }";
+			cFile.PutS(sLine + ((i+1 < g_lstTraceEvents.GetNumOfElements()) ? " },\n" : " }\n"));
+		}
+		cFile.PutS("\t],\n\t\"displayTimeUnit\": \"ms\"\n}\n");
+
+		// Done
+		g_cTraceMutex.Unlock();
+		cFile.Close();
+		return true;
+	}
+
+	// Error!
+	return false;
+}
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+TraceScope::TraceScope(const String &sName, const char *pszCategory, const String &sDetail) :
+	m_nScope(Trace::Begin(sName, pszCategory, sDetail))
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+TraceScope::~TraceScope()
+{
+	Trace::End(m_nScope);
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+TraceScope::TraceScope(const TraceScope &cSource) :
+	m_nScope(Trace::InvalidScope)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+TraceScope &TraceScope::operator =(const TraceScope &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
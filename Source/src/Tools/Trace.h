@@ -0,0 +1,196 @@
+/*********************************************************\
+ *  File: Trace.h                                        *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_TRACE_H__
+#define __DUNGEON_TRACE_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/String/String.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Trace recorder collecting hierarchical timing scopes
+*
+*  @remarks
+*    A scope is opened by "Begin()" and closed by "End()", usually by using a "TraceScope" instance. Scopes
+*    can be opened by any thread, nested scopes of the same thread form the hierarchy. The recorded scopes
+*    can be written into a trace file in the Chrome trace event format, which can be opened by using
+*    "chrome://tracing" or the Perfetto UI. As long as the recorder is disabled, "Begin()" and "End()" return
+*    at once without any locking.
+*/
+class Trace {
+
+
+	//[-------------------------------------------------------]
+	//[ Public definitions                                    ]
+	//[-------------------------------------------------------]
+	public:
+		static const PLCore::uint32 InvalidScope = 0xFFFFFFFF;	/**< Scope identifier returned by "Begin()" if the recorder is disabled */
+
+
+	//[-------------------------------------------------------]
+	//[ Public static functions                               ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Enables the recorder
+		*
+		*  @note
+		*    - Previously recorded scopes are removed, the trace time starts now
+		*/
+		static void Enable();
+
+		/**
+		*  @brief
+		*    Disables the recorder and removes all recorded scopes
+		*/
+		static void Disable();
+
+		/**
+		*  @brief
+		*    Returns whether or not the recorder is enabled
+		*
+		*  @return
+		*    'true' if the recorder is enabled, else 'false'
+		*/
+		static bool IsEnabled();
+
+		/**
+		*  @brief
+		*    Opens a scope
+		*
+		*  @param[in] sName
+		*    Scope name (e.g. "Application::LoadScene")
+		*  @param[in] pszCategory
+		*    Scope category (e.g. "Scene"), must be a static string
+		*  @param[in] sDetail
+		*    Optional scope detail, shown as argument of the scope (e.g. the name of a loaded file)
+		*
+		*  @return
+		*    Identifier of the opened scope, "InvalidScope" if the recorder is disabled
+		*/
+		static PLCore::uint32 Begin(const PLCore::String &sName, const char *pszCategory, const PLCore::String &sDetail = "");
+
+		/**
+		*  @brief
+		*    Closes a scope
+		*
+		*  @param[in] nScope
+		*    Identifier of the scope to close as returned by "Begin()", "InvalidScope" is ignored
+		*/
+		static void End(PLCore::uint32 nScope);
+
+		/**
+		*  @brief
+		*    Writes the recorded scopes into a trace file in the Chrome trace event format
+		*
+		*  @param[in] sFilename
+		*    Name of the file to write
+		*
+		*  @return
+		*    'true' if all went fine, else 'false'
+		*
+		*  @note
+		*    - Scopes which are still open are written as if they were closed right now
+		*/
+		static bool Save(const PLCore::String &sFilename);
+
+
+};
+
+/**
+*  @brief
+*    Trace scope, opens a scope on construction and closes it on destruction
+*/
+class TraceScope {
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] sName
+		*    Scope name
+		*  @param[in] pszCategory
+		*    Scope category, must be a static string
+		*  @param[in] sDetail
+		*    Optional scope detail
+		*/
+		TraceScope(const PLCore::String &sName, const char *pszCategory, const PLCore::String &sDetail = "");
+
+		/**
+		*  @brief
+		*    Destructor
+		*/
+		~TraceScope();
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		TraceScope(const TraceScope &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		TraceScope &operator =(const TraceScope &cSource);
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::uint32 m_nScope;	/**< Identifier of the opened scope, "Trace::InvalidScope" if the recorder is disabled */
+
+
+};
+
+
+#endif // __DUNGEON_TRACE_H__
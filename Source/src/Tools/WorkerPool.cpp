@@ -0,0 +1,239 @@
+/*********************************************************\
+ *  File: WorkerPool.cpp                                 *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include "Tools/WorkerPool.h"
+
+
+//[-------------------------------------------------------]
+//[ Namespace                                             ]
+//[-------------------------------------------------------]
+using namespace PLCore;
+
+
+//[-------------------------------------------------------]
+//[ Global definitions                                    ]
+//[-------------------------------------------------------]
+static const uint32 MaxSemaphoreValue = 0x7FFFFFFF;	/**< Maximum value of the worker pool semaphores */
+
+
+//[-------------------------------------------------------]
+//[ Public functions                                      ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+WorkerPool::WorkerPool(uint32 nNumOfThreads) :
+	m_cJobSemaphore(0, MaxSemaphoreValue),
+	m_cIdleSemaphore(0, MaxSemaphoreValue),
+	m_nNumOfPendingJobs(0),
+	m_bShutdown(false)
+{
+	// Create and start the worker threads
+	if (!nNumOfThreads)
+		nNumOfThreads = 1;
+	for (uint32 i=0; i<nNumOfThreads; i++) {
+		WorkerThread *pWorkerThread = new WorkerThread(*this);
+		m_lstThreads.Add(pWorkerThread);
+		pWorkerThread->Start();
+	}
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+WorkerPool::~WorkerPool()
+{
+	// Tell the worker threads to shut down
+	m_cMutex.Lock();
+	m_bShutdown = true;
+	m_cMutex.Unlock();
+	for (uint32 i=0; i<m_lstThreads.GetNumOfElements(); i++)
+		m_cJobSemaphore.Unlock();
+
+	// Wait for the worker threads and destroy them
+	for (uint32 i=0; i<m_lstThreads.GetNumOfElements(); i++) {
+		m_lstThreads[i]->Join();
+		delete m_lstThreads[i];
+	}
+	m_lstThreads.Clear();
+
+	// Destroy the jobs which were never executed
+	Job *pJob = nullptr;
+	while (m_lstJobs.Pop(&pJob))
+		delete pJob;
+}
+
+/**
+*  @brief
+*    Returns the number of worker threads
+*/
+uint32 WorkerPool::GetNumOfThreads() const
+{
+	return m_lstThreads.GetNumOfElements();
+}
+
+/**
+*  @brief
+*    Adds a job
+*/
+void WorkerPool::AddJob(Job *pJob)
+{
+	if (pJob) {
+		// Add the job to the queue
+		m_cMutex.Lock();
+		m_lstJobs.Push(pJob);
+		m_nNumOfPendingJobs++;
+		m_cMutex.Unlock();
+
+		// Wake up a worker thread
+		m_cJobSemaphore.Unlock();
+	}
+}
+
+/**
+*  @brief
+*    Waits until all jobs were executed
+*/
+void WorkerPool::WaitForAll()
+{
+	for (;;) {
+		// Are there still pending jobs?
+		m_cMutex.Lock();
+		const uint32 nNumOfPendingJobs = m_nNumOfPendingJobs;
+		m_cMutex.Unlock();
+		if (!nNumOfPendingJobs)
+			return;	// Done
+
+		// Wait for the pool to become idle, the semaphore may still be unlocked by an earlier idle phase, so check again
+		m_cIdleSemaphore.Lock();
+	}
+}
+
+
+//[-------------------------------------------------------]
+//[ Private functions                                     ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Copy constructor
+*/
+WorkerPool::WorkerPool(const WorkerPool &cSource) :
+	m_cJobSemaphore(0, MaxSemaphoreValue),
+	m_cIdleSemaphore(0, MaxSemaphoreValue),
+	m_nNumOfPendingJobs(0),
+	m_bShutdown(false)
+{
+	// No implementation because the copy constructor is never used
+}
+
+/**
+*  @brief
+*    Copy operator
+*/
+WorkerPool &WorkerPool::operator =(const WorkerPool &cSource)
+{
+	// No implementation because the copy operator is never used
+	return *this;
+}
+
+/**
+*  @brief
+*    Returns the next job to execute
+*/
+WorkerPool::Job *WorkerPool::GetNextJob()
+{
+	// Wait for a job (or the shutdown)
+	m_cJobSemaphore.Lock();
+
+	// Get the next job
+	Job *pJob = nullptr;
+	m_cMutex.Lock();
+	if (!m_bShutdown)
+		m_lstJobs.Pop(&pJob);
+	m_cMutex.Unlock();
+
+	// Done
+	return pJob;
+}
+
+/**
+*  @brief
+*    Called by a worker thread when a job has been executed
+*/
+void WorkerPool::OnJobFinished()
+{
+	m_cMutex.Lock();
+	m_nNumOfPendingJobs--;
+	const bool bIdle = !m_nNumOfPendingJobs;
+	m_cMutex.Unlock();
+
+	// Wake up "WaitForAll()"
+	if (bIdle)
+		m_cIdleSemaphore.Unlock();
+}
+
+
+
+
+//[-------------------------------------------------------]
+//[ Public WorkerPool::WorkerThread functions             ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Constructor
+*/
+WorkerPool::WorkerThread::WorkerThread(WorkerPool &cWorkerPool) :
+	m_pWorkerPool(&cWorkerPool)
+{
+}
+
+/**
+*  @brief
+*    Destructor
+*/
+WorkerPool::WorkerThread::~WorkerThread()
+{
+}
+
+
+//[-------------------------------------------------------]
+//[ Public virtual PLCore::ThreadFunction functions       ]
+//[-------------------------------------------------------]
+int WorkerPool::WorkerThread::Run()
+{
+	// Execute jobs until the pool is shutting down
+	Job *pJob = m_pWorkerPool->GetNextJob();
+	while (pJob) {
+		pJob->Execute();
+		delete pJob;
+		m_pWorkerPool->OnJobFinished();
+		pJob = m_pWorkerPool->GetNextJob();
+	}
+
+	// Done
+	return 0;
+}
@@ -0,0 +1,254 @@
+/*********************************************************\
+ *  File: WorkerPool.h                                   *
+ *
+ *  Copyright (C) 2002-2012 The PixelLight Team (http://www.pixellight.org/)
+ *
+ *  This file is part of PixelLight.
+ *
+ *  PixelLight is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PixelLight is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with PixelLight. If not, see <http://www.gnu.org/licenses/>.
+\*********************************************************/
+
+
+#ifndef __DUNGEON_WORKERPOOL_H__
+#define __DUNGEON_WORKERPOOL_H__
+#pragma once
+
+
+//[-------------------------------------------------------]
+//[ Includes                                              ]
+//[-------------------------------------------------------]
+#include <PLCore/System/Mutex.h>
+#include <PLCore/System/Thread.h>
+#include <PLCore/System/Semaphore.h>
+#include <PLCore/Container/Array.h>
+#include <PLCore/Container/Queue.h>
+
+
+//[-------------------------------------------------------]
+//[ Classes                                               ]
+//[-------------------------------------------------------]
+/**
+*  @brief
+*    Fixed size pool of worker threads executing jobs
+*
+*  @remarks
+*    Jobs are executed in the order they were added, but because there are multiple worker threads,
+*    they may finish in any order. Jobs must not touch objects which are not thread-safe, such as
+*    the resource managers or anything which talks to the renderer - such work has to stay on the
+*    main thread.
+*/
+class WorkerPool {
+
+
+	//[-------------------------------------------------------]
+	//[ Public classes                                        ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Abstract job executed by a worker thread
+		*/
+		class Job {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Destructor
+				*/
+				virtual ~Job() {}
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual Job functions                          ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Executes the job
+				*
+				*  @note
+				*    - Called by a worker thread
+				*/
+				virtual void Execute() = 0;
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Public functions                                      ]
+	//[-------------------------------------------------------]
+	public:
+		/**
+		*  @brief
+		*    Constructor
+		*
+		*  @param[in] nNumOfThreads
+		*    Number of worker threads, at least one worker thread is created
+		*/
+		explicit WorkerPool(PLCore::uint32 nNumOfThreads);
+
+		/**
+		*  @brief
+		*    Destructor
+		*
+		*  @note
+		*    - Jobs which are still waiting are not executed but destroyed, currently running jobs are finished
+		*/
+		~WorkerPool();
+
+		/**
+		*  @brief
+		*    Returns the number of worker threads
+		*
+		*  @return
+		*    The number of worker threads
+		*/
+		PLCore::uint32 GetNumOfThreads() const;
+
+		/**
+		*  @brief
+		*    Adds a job
+		*
+		*  @param[in] pJob
+		*    Job to add, if null pointer this function does nothing, the pool takes over the control and destroys the job after it has been executed
+		*
+		*  @note
+		*    - Can be called by any thread, including the worker threads
+		*/
+		void AddJob(Job *pJob);
+
+		/**
+		*  @brief
+		*    Waits until all jobs were executed
+		*
+		*  @note
+		*    - Jobs added by jobs are waited for as well
+		*/
+		void WaitForAll();
+
+
+	//[-------------------------------------------------------]
+	//[ Private classes                                       ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Worker thread
+		*/
+		class WorkerThread : public PLCore::Thread {
+
+
+			//[-------------------------------------------------------]
+			//[ Public functions                                      ]
+			//[-------------------------------------------------------]
+			public:
+				/**
+				*  @brief
+				*    Constructor
+				*
+				*  @param[in] cWorkerPool
+				*    Owner worker pool
+				*/
+				explicit WorkerThread(WorkerPool &cWorkerPool);
+
+				/**
+				*  @brief
+				*    Destructor
+				*/
+				virtual ~WorkerThread();
+
+
+			//[-------------------------------------------------------]
+			//[ Public virtual PLCore::ThreadFunction functions       ]
+			//[-------------------------------------------------------]
+			public:
+				virtual int Run() override;
+
+
+			//[-------------------------------------------------------]
+			//[ Private data                                          ]
+			//[-------------------------------------------------------]
+			private:
+				WorkerPool *m_pWorkerPool;	/**< Owner worker pool, always valid */
+
+
+		};
+
+
+	//[-------------------------------------------------------]
+	//[ Private functions                                     ]
+	//[-------------------------------------------------------]
+	private:
+		/**
+		*  @brief
+		*    Copy constructor
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*/
+		WorkerPool(const WorkerPool &cSource);
+
+		/**
+		*  @brief
+		*    Copy operator
+		*
+		*  @param[in] cSource
+		*    Source to copy from
+		*
+		*  @return
+		*    Reference to this instance
+		*/
+		WorkerPool &operator =(const WorkerPool &cSource);
+
+		/**
+		*  @brief
+		*    Returns the next job to execute
+		*
+		*  @return
+		*    The next job to execute, null pointer if the pool is shutting down
+		*
+		*  @note
+		*    - Blocks until there's a job to execute
+		*/
+		Job *GetNextJob();
+
+		/**
+		*  @brief
+		*    Called by a worker thread when a job has been executed
+		*/
+		void OnJobFinished();
+
+
+	//[-------------------------------------------------------]
+	//[ Private data                                          ]
+	//[-------------------------------------------------------]
+	private:
+		PLCore::Mutex				 m_cMutex;			/**< Mutex guarding the job queue, the number of pending jobs and the shutdown flag */
+		PLCore::Semaphore			 m_cJobSemaphore;	/**< Counts the jobs within the queue (plus one per worker thread on shutdown) */
+		PLCore::Semaphore			 m_cIdleSemaphore;	/**< Unlocked when the last pending job has been finished */
+		PLCore::Queue<Job*>			 m_lstJobs;			/**< Jobs waiting for execution */
+		PLCore::uint32				 m_nNumOfPendingJobs;	/**< Number of jobs waiting or running */
+		bool						 m_bShutdown;		/**< Is the pool shutting down? */
+		PLCore::Array<WorkerThread*> m_lstThreads;		/**< Worker threads */
+
+
+};
+
+
+#endif // __DUNGEON_WORKERPOOL_H__